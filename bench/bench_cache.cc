@@ -0,0 +1,199 @@
+// Result cache benchmark.
+//
+// Checks hash64() against the reference XXH64 values and measures its
+// throughput on a still-sized buffer, then exercises ResultCache: hits
+// return exactly what was inserted, the LRU evicts the oldest entry, the
+// index file answers a fresh cache (a new run) and is discarded when the
+// configuration changes. Reports the cost of a hit, which replaces a decode
+// and an NPU run.
+//
+// Usage: bench_cache [--entries <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "metrics.h"
+#include "result_cache.h"
+
+namespace {
+
+object_detect_result_list make_results(int seed, int count)
+{
+    object_detect_result_list results;
+    for (int i = 0; i < count; i++) {
+        box_rect_t box = {seed + i, seed + 2 * i, seed + i + 40, seed + 2 * i + 80};
+        results.push_back(box, 0.5f + i * 0.001f, (seed + i) % OBJ_CLASS_NUM);
+    }
+    return results;
+}
+
+bool same_results(const object_detect_result_list &a, const object_detect_result_list &b)
+{
+    if (a.count != b.count) {
+        return false;
+    }
+    for (int i = 0; i < a.count; i++) {
+        if (memcmp(&a.boxes[i], &b.boxes[i], sizeof(box_rect_t)) != 0 || a.props[i] != b.props[i] ||
+            a.cls_ids[i] != b.cls_ids[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    int entries = 256;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--entries") == 0 && i + 1 < argc) {
+            entries = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--entries <n>]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (entries < 2) {
+        entries = 2;
+    }
+    int errors = 0;
+
+    // Reference values of XXH64 with seed 0
+    static const struct {
+        const char *text;
+        uint64_t hash;
+    } vectors[] = {
+        {"", 0xEF46DB3751D8E999ULL},
+        {"a", 0xD24EC4F1A98C6E5BULL},
+        {"abc", 0x44BC2CF5AD770999ULL},
+        {"Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL},
+    };
+    for (const auto &v : vectors) {
+        uint64_t h = hash64(v.text, strlen(v.text));
+        if (h != v.hash) {
+            fprintf(stderr, "hash64(\"%s\") = %016llx, expected %016llx\n", v.text, (unsigned long long)h,
+                    (unsigned long long)v.hash);
+            errors++;
+        }
+    }
+
+    std::vector<uint8_t> still(4 << 20);
+    for (size_t i = 0; i < still.size(); i++) {
+        still[i] = (uint8_t)(i * 2654435761u >> 24);
+    }
+    const int hash_runs = 20;
+    uint64_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < hash_runs; r++) {
+        sink ^= hash64(still.data(), still.size(), r);
+    }
+    double hash_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                     hash_runs;
+    printf("hash64 of a 4 MB still: %.2f ms (%.1f GB/s) [%llx]\n", hash_ms, still.size() / hash_ms / 1e6,
+           (unsigned long long)(sink & 0xff));
+
+    std::string index_path = "/tmp/bench_cache_" + std::to_string(getpid()) + ".idx";
+    ResultCacheOptions options;
+    options.capacity = entries;
+    options.index_path = index_path;
+    options.index_slots = entries * 4;
+    const uint64_t config = 0x1234;
+
+    {
+        ResultCache cache(options, config);
+        object_detect_result_list got;
+        if (cache.lookup(1, &got)) {
+            fprintf(stderr, "hit in an empty cache\n");
+            errors++;
+        }
+        for (int k = 0; k < entries; k++) {
+            cache.insert(k + 1, make_results(k, k % 20));
+        }
+        for (int k = 0; k < entries; k++) {
+            if (!cache.lookup(k + 1, &got) || !same_results(got, make_results(k, k % 20))) {
+                fprintf(stderr, "entry %d not returned as inserted\n", k);
+                errors++;
+                break;
+            }
+        }
+
+        // Cost of a hit, the whole price of a repeated image
+        const int lookups = 200000;
+        start = std::chrono::steady_clock::now();
+        for (int n = 0; n < lookups; n++) {
+            cache.lookup(n % entries + 1, &got);
+        }
+        double hit_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                        lookups;
+        printf("memory hit: %.3f us (%d entries, up to 19 detections)\n", hit_us, entries);
+
+        // Make entry 1 the most recently used, then push the cache past its capacity
+        cache.lookup(1, &got);
+        cache.insert(entries + 1, make_results(entries, 3));
+        if (!cache.lookup(1, &got)) {
+            fprintf(stderr, "recently used entry was evicted\n");
+            errors++;
+        }
+    }
+
+    // A new run: memory is empty, the index still knows the results
+    {
+        ResultCache cache(options, config);
+        object_detect_result_list got;
+        start = std::chrono::steady_clock::now();
+        int found = 0;
+        for (int k = 0; k < entries; k++) {
+            if (cache.lookup(k + 1, &got) && same_results(got, make_results(k, k % 20))) {
+                found++;
+            }
+        }
+        double index_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() /
+                          entries;
+        printf("index hits after reopening: %d/%d, %.3f us each\n", found, entries, index_us);
+        // Direct mapping may lose a few entries to slot collisions, never return wrong ones
+        if (found < entries * 3 / 4) {
+            fprintf(stderr, "index lost too many entries\n");
+            errors++;
+        }
+    }
+
+    // Another model or threshold must not see these results
+    {
+        ResultCache cache(options, config + 1);
+        object_detect_result_list got;
+        for (int k = 0; k < entries; k++) {
+            if (cache.lookup(k + 1, &got)) {
+                fprintf(stderr, "entry %d served to another configuration\n", k);
+                errors++;
+                break;
+            }
+        }
+    }
+
+    // Capacity 0 is a disabled cache
+    {
+        ResultCacheOptions disabled;
+        disabled.capacity = 0;
+        ResultCache cache(disabled, config);
+        object_detect_result_list got;
+        cache.insert(1, make_results(1, 1));
+        if (cache.lookup(1, &got)) {
+            fprintf(stderr, "disabled cache returned a result\n");
+            errors++;
+        }
+    }
+
+    unlink(index_path.c_str());
+    printf("%s", Metrics::instance().toPrometheus().find("bsext_result_cache_hits_total") != std::string::npos
+                     ? "hit/miss counters exported\n" : "");
+    log_flush();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+// Capture ring benchmark.
+//
+// Pulls frames from a CameraSource with a consumer of a given speed and
+// checks the latest-frame policy: a consumer slower than the camera must
+// always get the newest frame (sequence numbers only move forward, frame
+// age stays under about one frame interval plus the wait) while the older
+// ones are recycled. Each frame is letterboxed to the model input, the
+// work the inference thread does while it holds the buffer.
+//
+// The source is a V4L device, a raw YUYV/NV12 file or pipe, or, by default,
+// a generated raw file.
+//
+// Usage: bench_capture [--size <w>x<h>] [--format <yuyv|nv12>] [--fps <n>]
+//                      [--work-ms <ms>] [--frames <n>] [--dmabuf] [source]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera_source.h"
+#include "log.h"
+#include "metrics.h"
+
+namespace {
+
+// Frames of a moving gradient, written where the source will read them
+bool write_raw_file(const char *path, const CameraOptions &options, int frames)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    std::vector<uint8_t> frame(yuv_frame_size(options.format, options.width, options.height));
+    for (int f = 0; f < frames; f++) {
+        for (size_t i = 0; i < frame.size(); i++) {
+            frame[i] = (uint8_t)(i + f * 8);
+        }
+        fwrite(frame.data(), 1, frame.size(), fp);
+    }
+    fclose(fp);
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    CameraOptions options;
+    double work_ms = 50;
+    int max_frames = 60;
+    const char *source_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &options.width, &options.height);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc && parse_yuv_format(argv[i + 1], &options.format) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            options.fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--work-ms") == 0 && i + 1 < argc) {
+            work_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            max_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dmabuf") == 0) {
+            options.export_dmabuf = true;
+        } else if (argv[i][0] != '-' && !source_path) {
+            source_path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--size <w>x<h>] [--format <yuyv|nv12>] [--fps <n>] [--work-ms <ms>] "
+                    "[--frames <n>] [--dmabuf] [source]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    std::string generated;
+    if (!source_path) {
+        generated = "/tmp/bench_capture.yuv";
+        if (!write_raw_file(generated.c_str(), options, 30)) {
+            fprintf(stderr, "failed to write %s\n", generated.c_str());
+            return -1;
+        }
+        source_path = generated.c_str();
+    }
+
+    std::unique_ptr<CameraSource> source;
+    if (strncmp(source_path, "/dev/video", 10) == 0) {
+        source.reset(new V4l2CameraSource(source_path, options));
+    } else {
+        source.reset(new RawFileCameraSource(source_path, options));
+    }
+    if (!source->start()) {
+        log_flush();
+        return -1;
+    }
+
+    image_buffer_t model_input;
+    memset(&model_input, 0, sizeof(model_input));
+    std::vector<uint8_t> pixels(640 * 640 * 3);
+    model_input.width = 640;
+    model_input.height = 640;
+    model_input.format = IMAGE_FORMAT_RGB888;
+    model_input.size = (int)pixels.size();
+    model_input.virt_addr = pixels.data();
+    YuvLetterbox letterbox;
+
+    LatencyHistogram age;
+    int frames = 0;
+    int errors = 0;
+    uint64_t last_sequence = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto work = std::chrono::duration<double, std::milli>(work_ms);
+    while (frames < max_frames) {
+        FrameLease lease = source->acquire(std::chrono::milliseconds(1000));
+        if (!lease) {
+            if (source->finished()) {
+                break;
+            }
+            fprintf(stderr, "no frame within 1 s\n");
+            errors++;
+            break;
+        }
+        auto now = std::chrono::steady_clock::now();
+        age.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lease.timestamp()).count());
+        if (frames > 0 && lease.sequence() <= last_sequence) {
+            fprintf(stderr, "frame %llu after %llu\n", (unsigned long long)lease.sequence(),
+                    (unsigned long long)last_sequence);
+            errors++;
+        }
+        last_sequence = lease.sequence();
+
+        letterbox_t lb;
+        if (letterbox.convert(lease.frame(), &model_input, &lb) != 0) {
+            errors++;
+        }
+        std::this_thread::sleep_until(now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(work));
+        frames++;
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const CameraOptions &got = source->options();
+    printf("source: %s %dx%d %s, %d buffers, %d fps\n", source_path, got.width, got.height,
+           got.format == YuvFormat::YUYV ? "yuyv" : "nv12", got.buffers, got.fps);
+    printf("consumed %d frames in %.2f s (%.1f fps), captured %llu, recycled stale %llu\n", frames, elapsed_s,
+           frames / elapsed_s, (unsigned long long)source->capturedFrames(),
+           (unsigned long long)source->staleFrames());
+    printf("frame age at acquire: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", age.percentile(0.50) / 1e6,
+           age.percentile(0.99) / 1e6, age.max() / 1e6);
+
+    // The newest frame is at most one interval old when the consumer comes back
+    double limit_ms = 1000.0 / std::max(got.fps, 1) + 20.0;
+    if (age.percentile(0.99) / 1e6 > limit_ms) {
+        fprintf(stderr, "frames older than %.0f ms were handed out\n", limit_ms);
+        errors++;
+    }
+    source->stop();
+    if (!generated.empty()) {
+        unlink(generated.c_str());
+    }
+    log_flush();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+// Scaled JPEG decode benchmark.
+//
+// Times JpegDecoder on a large still at full size and at the DCT scale it
+// picks for a model input, and checks the reduced decode against a box
+// filtered full decode: the IDCT scaling must give the same picture, only
+// smaller, and never smaller than the letterbox.
+//
+// The input is a JPEG file or, by default, a generated 12 MP photo-like
+// image.
+//
+// Usage: bench_decode [--model <w>x<h>] [--iterations <n>] [file.jpg]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <jpeglib.h>
+
+#include "jpeg_decoder.h"
+#include "log.h"
+
+namespace {
+
+// Smooth gradients with some texture, roughly what a camera still costs to decode
+bool write_jpeg(const char *path, int width, int height)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        return false;
+    }
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_stdio_dest(&cinfo, fp);
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 90, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    std::vector<uint8_t> row(width * 3);
+    while (cinfo.next_scanline < cinfo.image_height) {
+        int y = cinfo.next_scanline;
+        for (int x = 0; x < width; x++) {
+            row[x * 3 + 0] = (uint8_t)(x * 255 / width);
+            row[x * 3 + 1] = (uint8_t)(y * 255 / height);
+            row[x * 3 + 2] = (uint8_t)(((x / 16 + y / 16) & 1) * 64 + ((x * y) & 31));
+        }
+        JSAMPROW ptr = row.data();
+        jpeg_write_scanlines(&cinfo, &ptr, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    fclose(fp);
+    return true;
+}
+
+// Mean absolute difference between small and a denom x denom box filter of full
+double compare_to_full(const std::vector<uint8_t> &small, const JpegDecodeInfo &info, const std::vector<uint8_t> &full)
+{
+    int denom = info.scale_denom;
+    double total = 0;
+    long samples = 0;
+    for (int y = 0; y < info.height && (y + 1) * denom <= info.full_height; y++) {
+        for (int x = 0; x < info.width && (x + 1) * denom <= info.full_width; x++) {
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int dy = 0; dy < denom; dy++) {
+                    for (int dx = 0; dx < denom; dx++) {
+                        sum += full[((size_t)(y * denom + dy) * info.full_width + x * denom + dx) * 3 + c];
+                    }
+                }
+                total += abs(sum / (denom * denom) - small[((size_t)y * info.width + x) * 3 + c]);
+                samples++;
+            }
+        }
+    }
+    return samples ? total / samples : 0.0;
+}
+
+double time_decode(JpegDecoder &decoder, const char *path, int min_width, int min_height, int iterations,
+                   std::vector<uint8_t> *rgb, JpegDecodeInfo *info)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        if (decoder.decode(path, min_width, min_height, rgb, info) != 0) {
+            return -1;
+        }
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    int model_width = 640;
+    int model_height = 640;
+    int iterations = 5;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+            sscanf(argv[++i], "%dx%d", &model_width, &model_height);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = std::max(atoi(argv[++i]), 1);
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [--model <w>x<h>] [--iterations <n>] [file.jpg]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    int errors = 0;
+
+    // Scale selection: never below the letterbox size
+    struct { int w, h, mw, mh, denom; } cases[] = {
+        {4000, 3000, 640, 640, 4},   // letterbox 640x480, 1/4 gives 1000x750
+        {4000, 3000, 320, 320, 8},   // 1/8 gives 500x375 >= 320x240
+        {1280, 720, 640, 640, 2},    // 1/2 gives exactly 640x360
+        {1281, 721, 640, 640, 2},    // rounded up to 641x361
+        {1000, 1000, 640, 640, 1},   // 1/2 would be 500x500
+        {640, 480, 640, 640, 1},
+    };
+    for (const auto &c : cases) {
+        int denom = jpeg_scale_denom(c.w, c.h, c.mw, c.mh);
+        if (denom != c.denom) {
+            fprintf(stderr, "jpeg_scale_denom(%dx%d for %dx%d) = %d, expected %d\n", c.w, c.h, c.mw, c.mh, denom,
+                    c.denom);
+            errors++;
+        }
+    }
+
+    std::string generated;
+    if (!path) {
+        generated = "/tmp/bench_decode.jpg";
+        if (!write_jpeg(generated.c_str(), 4000, 3000)) {
+            fprintf(stderr, "failed to write %s\n", generated.c_str());
+            return -1;
+        }
+        path = generated.c_str();
+    }
+
+    JpegDecoder decoder;
+    std::vector<uint8_t> full;
+    std::vector<uint8_t> scaled;
+    JpegDecodeInfo full_info;
+    JpegDecodeInfo scaled_info;
+    // A model as large as the image rules out any scaling
+    double full_ms = time_decode(decoder, path, 1 << 16, 1 << 16, iterations, &full, &full_info);
+    double scaled_ms = time_decode(decoder, path, model_width, model_height, iterations, &scaled, &scaled_info);
+    if (full_ms < 0 || scaled_ms < 0) {
+        fprintf(stderr, "%s: not a JPEG the scaled decoder handles\n", path);
+        errors++;
+    } else {
+        float scale = std::min((float)model_width / scaled_info.full_width,
+                               (float)model_height / scaled_info.full_height);
+        int letterbox_width = (int)(scaled_info.full_width * scale);
+        int letterbox_height = (int)(scaled_info.full_height * scale);
+        double diff = compare_to_full(scaled, scaled_info, full);
+        printf("%s: %dx%d for a %dx%d model\n", path, full_info.full_width, full_info.full_height, model_width,
+               model_height);
+        printf("full decode      %dx%d  %8.2f ms\n", full_info.width, full_info.height, full_ms);
+        printf("scaled 1/%d       %dx%d  %8.2f ms  (%.1fx faster, mean diff to box-filtered full %.2f)\n",
+               scaled_info.scale_denom, scaled_info.width, scaled_info.height, scaled_ms, full_ms / scaled_ms, diff);
+        if (scaled_info.width < letterbox_width || scaled_info.height < letterbox_height) {
+            fprintf(stderr, "scaled decode is smaller than the %dx%d letterbox\n", letterbox_width, letterbox_height);
+            errors++;
+        }
+        if (diff > 8.0) {
+            fprintf(stderr, "scaled decode differs from the full image\n");
+            errors++;
+        }
+    }
+
+    // Anything but a JPEG is left to the general decoder
+    const char *not_jpeg = "/tmp/bench_decode.png";
+    FILE *fp = fopen(not_jpeg, "wb");
+    if (fp) {
+        fwrite("\x89PNG\r\n\x1a\n", 1, 8, fp);
+        fclose(fp);
+        if (decoder.decode(not_jpeg, model_width, model_height, &scaled, &scaled_info) == 0) {
+            fprintf(stderr, "a PNG was taken for a JPEG\n");
+            errors++;
+        }
+        unlink(not_jpeg);
+    }
+
+    if (!generated.empty()) {
+        unlink(generated.c_str());
+    }
+    log_flush();
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,309 @@
+// Camera-format letterbox benchmark and check.
+//
+// Letterboxes YUYV and NV12 frames into a model input with YuvLetterbox and
+// compares it against a float reference that samples the source planes at
+// the same positions, and times it against the two-pass path it replaces
+// (whole frame to RGB, then an RGB letterbox resize). Frames come from raw
+// captures given on the command line or are synthesized.
+//
+// Usage: bench_letterbox [--size <w>x<h>] [--model <w>x<h>] [--min-time <seconds>]
+//                        [--save <dir>] [<yuyv|nv12> <frame.yuv> ...]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "yuv_letterbox.h"
+
+namespace {
+
+const int MIN_ITERATIONS = 5;
+const double MAX_MEAN_ERROR = 1.0;   // Mean absolute difference to the float reference, 0-255
+const int BG_COLOR = 114;
+
+struct Frame {
+    std::string name;
+    std::vector<uint8_t> data;
+    YuvFrame yuv;
+};
+
+// Gradients, color bars and fine detail, so chroma and edges are exercised
+void synthesize(YuvFormat format, int width, int height, Frame *frame)
+{
+    frame->name = format == YuvFormat::YUYV ? "synthetic/yuyv" : "synthetic/nv12";
+    frame->data.resize(format == YuvFormat::YUYV ? (size_t)width * height * 2 : (size_t)width * height * 3 / 2);
+    auto luma = [&](int x, int y) {
+        int v = 16 + (x * 219) / width;
+        if ((x / 8 + y / 8) % 2 == 0 && y > height * 3 / 4) {
+            v = 235 - v + 16;
+        }
+        return (uint8_t)v;
+    };
+    auto chroma_u = [&](int x, int y) { return (uint8_t)(16 + (((x / (width / 8)) * 37 + y / 4) % 224)); };
+    auto chroma_v = [&](int x, int y) { return (uint8_t)(16 + (((y * 224) / height + x / 16) % 224)); };
+
+    uint8_t *p = frame->data.data();
+    if (format == YuvFormat::YUYV) {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x += 2) {
+                uint8_t *q = p + ((size_t)y * width + x) * 2;
+                q[0] = luma(x, y);
+                q[1] = chroma_u(x, y);
+                q[2] = luma(x + 1, y);
+                q[3] = chroma_v(x, y);
+            }
+        }
+    } else {
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                p[(size_t)y * width + x] = luma(x, y);
+            }
+        }
+        uint8_t *uv = p + (size_t)width * height;
+        for (int y = 0; y < height / 2; y++) {
+            for (int x = 0; x < width / 2; x++) {
+                uv[(size_t)y * width + x * 2] = chroma_u(x * 2, y * 2);
+                uv[(size_t)y * width + x * 2 + 1] = chroma_v(x * 2, y * 2);
+            }
+        }
+    }
+    frame->yuv = YuvFrame();
+    frame->yuv.format = format;
+    frame->yuv.width = width;
+    frame->yuv.height = height;
+    frame->yuv.data = frame->data.data();
+}
+
+// Sample (plane, x, y) of the frame
+uint8_t sample(const YuvFrame &f, int plane, int x, int y)
+{
+    if (f.format == YuvFormat::YUYV) {
+        const uint8_t *row = f.data + (size_t)y * f.width * 2;
+        return plane == 0 ? row[x * 2] : row[x * 4 + (plane == 1 ? 1 : 3)];
+    }
+    if (plane == 0) {
+        return f.data[(size_t)y * f.width + x];
+    }
+    return f.data[(size_t)f.width * f.height + (size_t)y * f.width + x * 2 + plane - 1];
+}
+
+float bilinear(const YuvFrame &f, int plane, int w, int h, float sx, float sy)
+{
+    sx = std::min(std::max(sx, 0.0f), (float)(w - 1));
+    sy = std::min(std::max(sy, 0.0f), (float)(h - 1));
+    int x0 = std::min((int)sx, w - 2);
+    int y0 = std::min((int)sy, h - 2);
+    float fx = sx - x0;
+    float fy = sy - y0;
+    float top = sample(f, plane, x0, y0) * (1 - fx) + sample(f, plane, x0 + 1, y0) * fx;
+    float bottom = sample(f, plane, x0, y0 + 1) * (1 - fx) + sample(f, plane, x0 + 1, y0 + 1) * fx;
+    return top * (1 - fy) + bottom * fy;
+}
+
+// Size of the scaled image inside the bars
+void resized_size(const YuvFrame &f, const image_buffer_t *dst, const letterbox_t &lb, int *w, int *h)
+{
+    *w = std::min(dst->width, (int)(f.width * lb.scale + 0.5f));
+    *h = std::min(dst->height, (int)(f.height * lb.scale + 0.5f));
+}
+
+// The conversion in float, at the sample positions YuvLetterbox uses
+void reference_letterbox(const YuvFrame &f, image_buffer_t *dst, const letterbox_t &lb)
+{
+    int chroma_h = f.format == YuvFormat::NV12 ? f.height / 2 : f.height;
+    int resize_w, resize_h;
+    resized_size(f, dst, lb, &resize_w, &resize_h);
+    memset(dst->virt_addr, BG_COLOR, (size_t)dst->width * dst->height * 3);
+    for (int y = lb.y_pad; y < lb.y_pad + resize_h; y++) {
+        float sy = (y - lb.y_pad + 0.5f) / lb.scale - 0.5f;
+        float cy = f.format == YuvFormat::NV12 ? (sy + 0.5f) / 2 - 0.5f : sy;
+        for (int x = lb.x_pad; x < lb.x_pad + resize_w; x++) {
+            float sx = (x - lb.x_pad + 0.5f) / lb.scale - 0.5f;
+            float cx = (sx + 0.5f) / 2 - 0.5f;
+            float yy = 1.164f * (bilinear(f, 0, f.width, f.height, sx, sy) - 16);
+            float u = bilinear(f, 1, f.width / 2, chroma_h, cx, cy) - 128;
+            float v = bilinear(f, 2, f.width / 2, chroma_h, cx, cy) - 128;
+            float rgb[3] = {yy + 1.596f * v, yy - 0.391f * u - 0.813f * v, yy + 2.018f * u};
+            uint8_t *out = dst->virt_addr + ((size_t)y * dst->width + x) * 3;
+            for (int c = 0; c < 3; c++) {
+                out[c] = (uint8_t)std::min(std::max(lrintf(rgb[c]), 0L), 255L);
+            }
+        }
+    }
+}
+
+// The two-pass path: whole frame to RGB, then a bilinear letterbox resize
+void two_pass_letterbox(const YuvFrame &f, std::vector<uint8_t> *rgb, image_buffer_t *dst, const letterbox_t &lb)
+{
+    rgb->resize((size_t)f.width * f.height * 3);
+    int chroma_div = f.format == YuvFormat::NV12 ? 2 : 1;
+    for (int y = 0; y < f.height; y++) {
+        uint8_t *out = rgb->data() + (size_t)y * f.width * 3;
+        for (int x = 0; x < f.width; x++) {
+            int yy = (sample(f, 0, x, y) - 16) * 74 + 32;
+            int u = sample(f, 1, x / 2, y / chroma_div) - 128;
+            int v = sample(f, 2, x / 2, y / chroma_div) - 128;
+            out[x * 3] = (uint8_t)std::min(std::max((yy + 102 * v) >> 6, 0), 255);
+            out[x * 3 + 1] = (uint8_t)std::min(std::max((yy - 25 * u - 52 * v) >> 6, 0), 255);
+            out[x * 3 + 2] = (uint8_t)std::min(std::max((yy + 129 * u) >> 6, 0), 255);
+        }
+    }
+    int resize_w, resize_h;
+    resized_size(f, dst, lb, &resize_w, &resize_h);
+    memset(dst->virt_addr, BG_COLOR, (size_t)dst->width * dst->height * 3);
+    for (int y = 0; y < resize_h; y++) {
+        float sy = std::min(std::max((y + 0.5f) / lb.scale - 0.5f, 0.0f), (float)(f.height - 1));
+        int y0 = std::min((int)sy, f.height - 2);
+        int wy = (int)((sy - y0) * 128);
+        for (int x = 0; x < resize_w; x++) {
+            float sx = std::min(std::max((x + 0.5f) / lb.scale - 0.5f, 0.0f), (float)(f.width - 1));
+            int x0 = std::min((int)sx, f.width - 2);
+            int wx = (int)((sx - x0) * 128);
+            const uint8_t *p = rgb->data() + ((size_t)y0 * f.width + x0) * 3;
+            const uint8_t *q = p + (size_t)f.width * 3;
+            uint8_t *out = dst->virt_addr + ((size_t)(y + lb.y_pad) * dst->width + x + lb.x_pad) * 3;
+            for (int c = 0; c < 3; c++) {
+                int top = p[c] * (128 - wx) + p[c + 3] * wx;
+                int bottom = q[c] * (128 - wx) + q[c + 3] * wx;
+                out[c] = (uint8_t)((top * (128 - wy) + bottom * wy + 8192) >> 14);
+            }
+        }
+    }
+}
+
+template <typename Fn>
+double time_ns(double min_time_s, Fn fn)
+{
+    long iterations = 0;
+    double elapsed_s = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    while (iterations < MIN_ITERATIONS || elapsed_s < min_time_s) {
+        fn();
+        iterations++;
+        elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return elapsed_s * 1e9 / iterations;
+}
+
+void save_ppm(const char *path, const image_buffer_t &img)
+{
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "failed to write %s\n", path);
+        return;
+    }
+    fprintf(fp, "P6\n%d %d\n255\n", img.width, img.height);
+    fwrite(img.virt_addr, 1, (size_t)img.width * img.height * 3, fp);
+    fclose(fp);
+}
+
+bool parse_size(const char *s, int *w, int *h)
+{
+    return sscanf(s, "%dx%d", w, h) == 2 && *w > 0 && *h > 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    int width = 1920, height = 1080;
+    int model_w = 640, model_h = 640;
+    double min_time_s = 0.5;
+    const char *save_dir = NULL;
+    std::vector<std::pair<YuvFormat, const char *>> files;
+
+    for (int i = 1; i < argc; i++) {
+        YuvFormat format;
+        if (strcmp(argv[i], "--size") == 0 && i + 1 < argc && parse_size(argv[i + 1], &width, &height)) {
+            i++;
+        } else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc && parse_size(argv[i + 1], &model_w, &model_h)) {
+            i++;
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_dir = argv[++i];
+        } else if (argv[i][0] != '-' && i + 1 < argc && parse_yuv_format(argv[i], &format) == 0) {
+            files.push_back({format, argv[++i]});
+        } else {
+            fprintf(stderr, "Usage: %s [--size <w>x<h>] [--model <w>x<h>] [--min-time <seconds>] [--save <dir>] "
+                    "[<yuyv|nv12> <frame.yuv> ...]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    std::vector<Frame> frames;
+    if (files.empty()) {
+        frames.resize(2);
+        synthesize(YuvFormat::YUYV, width, height, &frames[0]);
+        synthesize(YuvFormat::NV12, width, height, &frames[1]);
+    }
+    for (const auto &file : files) {
+        Frame frame;
+        frame.name = file.second;
+        if (load_yuv_frame(file.second, file.first, width, height, &frame.data, &frame.yuv) != 0) {
+            fprintf(stderr, "failed to read a %dx%d frame from %s\n", width, height, file.second);
+            return -1;
+        }
+        frames.push_back(std::move(frame));
+    }
+    if (save_dir) {
+        mkdir(save_dir, 0755);
+    }
+
+    std::vector<uint8_t> fused_pixels((size_t)model_w * model_h * 3);
+    std::vector<uint8_t> reference_pixels(fused_pixels.size());
+    std::vector<uint8_t> rgb_frame;
+    image_buffer_t fused, reference;
+    memset(&fused, 0, sizeof(fused));
+    fused.width = model_w;
+    fused.height = model_h;
+    fused.format = IMAGE_FORMAT_RGB888;
+    fused.size = (int)fused_pixels.size();
+    fused.virt_addr = fused_pixels.data();
+    reference = fused;
+    reference.virt_addr = reference_pixels.data();
+
+    printf("%-32s %12s %12s %8s %8s\n", "frame", "fused ns", "2-pass ns", "mean err", "max err");
+    int failures = 0;
+    YuvLetterbox converter;
+    for (const Frame &frame : frames) {
+        letterbox_t lb;
+        if (converter.convert(frame.yuv, &fused, &lb, BG_COLOR) != 0) {
+            fprintf(stderr, "%s: convert failed\n", frame.name.c_str());
+            failures++;
+            continue;
+        }
+        reference_letterbox(frame.yuv, &reference, lb);
+        double total_error = 0;
+        int max_error = 0;
+        for (size_t i = 0; i < fused_pixels.size(); i++) {
+            int error = abs((int)fused_pixels[i] - (int)reference_pixels[i]);
+            total_error += error;
+            max_error = std::max(max_error, error);
+        }
+        double mean_error = total_error / fused_pixels.size();
+
+        double fused_ns = time_ns(min_time_s, [&] { converter.convert(frame.yuv, &fused, &lb, BG_COLOR); });
+        double two_pass_ns = time_ns(min_time_s, [&] { two_pass_letterbox(frame.yuv, &rgb_frame, &reference, lb); });
+        printf("%-32s %12.0f %12.0f %8.3f %8d\n", frame.name.c_str(), fused_ns, two_pass_ns, mean_error, max_error);
+        if (mean_error > MAX_MEAN_ERROR) {
+            fprintf(stderr, "%s: mean error %.3f above %.3f\n", frame.name.c_str(), mean_error, MAX_MEAN_ERROR);
+            failures++;
+        }
+
+        if (save_dir) {
+            std::string path = std::string(save_dir) + "/" + frame.name.substr(frame.name.find_last_of('/') + 1) +
+                               ".ppm";
+            converter.convert(frame.yuv, &fused, &lb, BG_COLOR);
+            save_ppm(path.c_str(), fused);
+        }
+    }
+    return failures ? 1 : 0;
+}
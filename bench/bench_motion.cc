@@ -0,0 +1,206 @@
+// Motion gate benchmark.
+//
+// Runs MotionGate over a generated 30 fps clip with sensor noise on a
+// textured background: a static stretch, a 16x16 px object crossing the
+// frame, then the object standing still. Checks that noise alone lets the
+// interval back off to the ceiling, that the small mover brings inference
+// straight back to every frame, and that the interval ramps up again once
+// it stops. The same clip as YUYV must gate identically. Then times
+// shouldInfer() on a 1080p frame.
+//
+// Usage: bench_motion
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "motion_gate.h"
+
+namespace {
+
+const int WIDTH = 1280;
+const int HEIGHT = 720;
+const int OBJECT = 16;
+const std::chrono::milliseconds FRAME(33);
+
+const int STATIC_FRAMES = 240;
+const int MOVING_FRAMES = 30;
+const int STOPPED_FRAMES = 240;
+
+struct Lcg {
+    uint32_t state;
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 24;
+    }
+};
+
+// Frame n of the clip: a gradient with a grid, +-3 of noise, and the object
+// once the static stretch is over
+void render(int n, Lcg &rng, std::vector<uint8_t> *luma)
+{
+    luma->resize((size_t)WIDTH * HEIGHT);
+    int moved = std::min(std::max(n - STATIC_FRAMES, 0), MOVING_FRAMES);
+    int ox = 200 + 6 * moved;
+    int oy = 300;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            int v = 60 + x * 100 / WIDTH + y * 40 / HEIGHT + ((x / 40 + y / 40) % 2) * 20;
+            if (n >= STATIC_FRAMES && x >= ox && x < ox + OBJECT && y >= oy && y < oy + OBJECT) {
+                v += 50;
+            }
+            v += (int)(rng.next() % 7) - 3;
+            (*luma)[(size_t)y * WIDTH + x] = (uint8_t)v;
+        }
+    }
+}
+
+// Which frames of the clip the gate sends to the NPU
+std::vector<bool> run_clip(bool yuyv)
+{
+    MotionGate gate;
+    Lcg rng = {1};
+    std::vector<uint8_t> luma;
+    std::vector<uint8_t> packed;
+    std::vector<bool> inferred;
+    MotionGate::Clock::time_point start;
+    for (int n = 0; n < STATIC_FRAMES + MOVING_FRAMES + STOPPED_FRAMES; n++) {
+        render(n, rng, &luma);
+        MotionGate::Clock::time_point now = start + n * FRAME;
+        if (yuyv) {
+            packed.resize(luma.size() * 2);
+            for (size_t i = 0; i < luma.size(); i++) {
+                packed[2 * i] = luma[i];
+                packed[2 * i + 1] = 128;
+            }
+            YuvFrame frame;
+            frame.format = YuvFormat::YUYV;
+            frame.width = WIDTH;
+            frame.height = HEIGHT;
+            frame.data = packed.data();
+            frame.stride = WIDTH * 2;
+            inferred.push_back(gate.shouldInfer(&frame, now));
+        } else {
+            image_buffer_t img;
+            memset(&img, 0, sizeof(img));
+            img.width = WIDTH;
+            img.height = HEIGHT;
+            img.format = IMAGE_FORMAT_GRAY8;
+            img.virt_addr = luma.data();
+            img.size = (int)luma.size();
+            inferred.push_back(gate.shouldInfer(&img, now));
+        }
+    }
+    return inferred;
+}
+
+// Frame gaps between inferences in [first, last)
+std::vector<int> gaps(const std::vector<bool> &inferred, int first, int last)
+{
+    std::vector<int> out;
+    int previous = -1;
+    for (int n = first; n < last; n++) {
+        if (inferred[n]) {
+            if (previous >= 0) {
+                out.push_back(n - previous);
+            }
+            previous = n;
+        }
+    }
+    return out;
+}
+
+void print_gaps(const char *name, const std::vector<int> &g)
+{
+    printf("%-40s", name);
+    for (int gap : g) {
+        printf(" %d", gap);
+    }
+    printf(" frames\n");
+}
+
+// Gaps never shrink and end near the 2 s ceiling
+bool backs_off(const std::vector<int> &g)
+{
+    if (g.size() < 3) {
+        return false;
+    }
+    for (size_t i = 1; i < g.size(); i++) {
+        if (g[i] < g[i - 1]) {
+            return false;
+        }
+    }
+    int ceiling = (int)(MotionGateOptions().max_interval_ms / FRAME.count());
+    return g.back() >= ceiling && g.back() <= ceiling + 1;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        fprintf(stderr, "Usage: %s\n", argv[0]);
+        return -1;
+    }
+    int errors = 0;
+
+    std::vector<bool> inferred = run_clip(false);
+    const int moving_end = STATIC_FRAMES + MOVING_FRAMES;
+    const int end = moving_end + STOPPED_FRAMES;
+
+    std::vector<int> still = gaps(inferred, 0, STATIC_FRAMES);
+    print_gaps("static scene, gaps", still);
+    if (!backs_off(still)) {
+        fprintf(stderr, "noise alone kept the gate from backing off\n");
+        errors++;
+    }
+
+    int moving = 0;
+    for (int n = STATIC_FRAMES; n < moving_end; n++) {
+        moving += inferred[n];
+    }
+    printf("%-40s %d of %d frames inferred\n", "16x16 px mover", moving, MOVING_FRAMES);
+    if (moving != MOVING_FRAMES) {
+        fprintf(stderr, "small mover missed\n");
+        errors++;
+    }
+
+    std::vector<int> stopped = gaps(inferred, moving_end - 1, end);
+    print_gaps("mover stopped, gaps", stopped);
+    if (!backs_off(stopped)) {
+        fprintf(stderr, "interval did not ramp up again after the motion\n");
+        errors++;
+    }
+
+    bool same = run_clip(true) == inferred;
+    printf("%-40s %s\n", "YUYV gates like gray", same ? "yes" : "no");
+    if (!same) {
+        errors++;
+    }
+
+    // Cost of the gate on a 1080p frame, which alternates so every call compares
+    {
+        const int runs = 200;
+        std::vector<uint8_t> a((size_t)1920 * 1080, 90);
+        std::vector<uint8_t> b((size_t)1920 * 1080, 110);
+        image_buffer_t img;
+        memset(&img, 0, sizeof(img));
+        img.width = 1920;
+        img.height = 1080;
+        img.format = IMAGE_FORMAT_GRAY8;
+        MotionGate gate;
+        MotionGate::Clock::time_point now;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; i++) {
+            img.virt_addr = (i & 1 ? b : a).data();
+            gate.shouldInfer(&img, now + i * FRAME);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / runs;
+        printf("%-40s %.1f us per frame\n", "shouldInfer() on 1920x1080", us);
+    }
+
+    printf("%s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,302 @@
+// Offline post-processing micro-benchmarks.
+//
+// Runs post_process() on synthetic YOLOX, YOLOv8 and NMS-free YOLOv10 outputs (empty, typical
+// and crowded scenes at several confidence thresholds) and on any recorded
+// output files given on the command line (see --record-outputs in the main
+// application). Reports time, heap allocations and detections per frame so
+// optimisations of the decode/sort/NMS path can be compared on a host
+// without an NPU.
+//
+// Usage: bench_postprocess [--filter <substring>] [--min-time <seconds>]
+//                          [--save-synthetic <dir>] [recording.rkt ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "postprocess.h"
+#include "synthetic_outputs.h"
+#include "tensor_file.h"
+#include "tensor_layout.h"
+
+static std::atomic<long> allocation_count(0);
+
+void *operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+namespace {
+
+const float NMS_THRESHOLD = 0.45f;
+const int MIN_ITERATIONS = 10;
+
+struct BenchResult {
+    double ns_per_frame;
+    double allocs_per_frame;
+    int detections;
+    long iterations;
+};
+
+// How the outputs of a case are decoded
+struct DecodeVariant {
+    const char *suffix;
+    bool integer_decode;
+    rknn_tensor_format layout;   // NCHW for standard outputs, else bound in this native layout
+    int threads;                 // set_decode_threads()
+};
+
+const DecodeVariant VARIANTS[] = {
+    {"", false, RKNN_TENSOR_NCHW, 0},
+    {"/int", true, RKNN_TENSOR_NCHW, 0},
+    {"/nc1hwc2", false, RKNN_TENSOR_NC1HWC2, 0},
+    {"/nc1hwc2/int", true, RKNN_TENSOR_NC1HWC2, 0},
+    {"/mt4", false, RKNN_TENSOR_NCHW, 3},
+    {"/int/mt4", true, RKNN_TENSOR_NCHW, 3},
+};
+
+// Integer decode is for quantized outputs, native layouts for int8 (RKNPU2).
+// End-to-end outputs have a single decode: no grid to band or relayout.
+bool variant_applies(const DecodeVariant &variant, rknn_tensor_type type, yolo_model_type_t model_type)
+{
+    if (model_type == YOLO_END2END) {
+        return !variant.integer_decode && variant.layout == RKNN_TENSOR_NCHW && variant.threads == 0;
+    }
+    if (type == RKNN_TENSOR_FLOAT32 && variant.integer_decode) {
+        return false;
+    }
+    return variant.layout == RKNN_TENSOR_NCHW || type == RKNN_TENSOR_INT8;
+}
+
+BenchResult run_case(const recorded_outputs_t *recorded, float conf_threshold, const DecodeVariant &variant,
+                     double min_time_s)
+{
+    rknn_app_context_t app_ctx;
+    std::vector<rknn_output> outputs(recorded->io_num.n_output);
+    recorded_outputs_to_context(recorded, &app_ctx, outputs.data());
+    app_ctx.max_detections = 0;
+    app_ctx.integer_decode = variant.integer_decode;
+    set_decode_threads(variant.threads);
+
+    // Outputs as the NPU would have written them to bound native buffers
+    std::vector<rknn_tensor_attr> native_attrs(recorded->io_num.n_output);
+    std::vector<std::vector<int8_t>> native_buffers(recorded->io_num.n_output);
+    if (variant.layout != RKNN_TENSOR_NCHW) {
+        for (uint32_t i = 0; i < recorded->io_num.n_output; i++) {
+            const rknn_tensor_attr *attr = &recorded->output_attrs[i];
+            native_output_attr(attr, variant.layout, &native_attrs[i]);
+            tensor_layout_t layout;
+            int channels, grid_h, grid_w;
+            output_shape(attr, &channels, &grid_h, &grid_w);
+            tensor_layout_init(&native_attrs[i], channels, grid_h, grid_w, &layout);
+            native_buffers[i].resize(native_attrs[i].size);
+            tensor_layout_from_nchw(&layout, recorded->buffers[i], native_buffers[i].data(), sizeof(int8_t));
+            outputs[i].buf = native_buffers[i].data();
+            outputs[i].size = native_attrs[i].size;
+        }
+        app_ctx.native_output_attrs = native_attrs.data();
+    }
+
+    letterbox_t letter_box;
+    memset(&letter_box, 0, sizeof(letter_box));
+    letter_box.scale = 1.0f;
+
+    object_detect_result_list od_results;
+    // Warm up so the result list capacity reflects steady state
+    post_process(&app_ctx, outputs.data(), &letter_box, conf_threshold, NMS_THRESHOLD, &od_results);
+
+    BenchResult result;
+    result.iterations = 0;
+    long allocations_before = allocation_count.load();
+    auto start = std::chrono::steady_clock::now();
+    double elapsed_s = 0.0;
+    while (result.iterations < MIN_ITERATIONS || elapsed_s < min_time_s) {
+        post_process(&app_ctx, outputs.data(), &letter_box, conf_threshold, NMS_THRESHOLD, &od_results);
+        result.iterations++;
+        elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    long allocations = allocation_count.load() - allocations_before;
+
+    result.ns_per_frame = elapsed_s * 1e9 / result.iterations;
+    result.allocs_per_frame = (double)allocations / result.iterations;
+    result.detections = od_results.count;
+    release_decode_tables(&app_ctx);
+    set_decode_threads(0);
+    return result;
+}
+
+void report(const std::string &name, const BenchResult &result)
+{
+    printf("%-44s %12.0f %10.1f %8d %10ld\n", name.c_str(), result.ns_per_frame, result.allocs_per_frame,
+           result.detections, result.iterations);
+}
+
+const char *type_name(rknn_tensor_type type)
+{
+    switch (type) {
+    case RKNN_TENSOR_INT8: return "i8";
+    case RKNN_TENSOR_UINT8: return "u8";
+    case RKNN_TENSOR_FLOAT32: return "fp32";
+    default: return "other";
+    }
+}
+
+// Keep a synthetic scene as a recording, e.g. for compare_postprocess.py
+void save_synthetic(const char *dir, const char *model, rknn_tensor_type type, const char *scene,
+                    const recorded_outputs_t *recorded)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s_%s_%s.rkt", dir, model, type_name(type), scene);
+
+    rknn_app_context_t app_ctx;
+    std::vector<rknn_output> outputs(recorded->io_num.n_output);
+    recorded_outputs_to_context(recorded, &app_ctx, outputs.data());
+    if (save_output_tensors(path, &app_ctx, outputs.data()) != 0) {
+        fprintf(stderr, "failed to write %s\n", path);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    const char *filter = NULL;
+    const char *save_dir = NULL;
+    double min_time_s = 0.5;
+    std::vector<const char *> recordings;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--save-synthetic") == 0 && i + 1 < argc) {
+            save_dir = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--filter <substring>] [--min-time <seconds>] [--save-synthetic <dir>] "
+                    "[recording.rkt ...]\n", argv[0]);
+            return -1;
+        } else {
+            recordings.push_back(argv[i]);
+        }
+    }
+
+    if (save_dir) {
+        mkdir(save_dir, 0755);
+    }
+
+    // Keep the per-frame max_detections warning and friends out of the timings
+    log_set_level(LOG_LEVEL_ERROR);
+
+    printf("%-44s %12s %10s %8s %10s\n", "case", "ns/frame", "allocs", "dets", "iters");
+
+    static const struct {
+        const char *name;
+        yolo_model_type_t model_type;
+        int input_size;
+    } models[] = {
+        {"yolox", YOLO_STANDARD, 640},
+        {"yolov8", YOLO_SIMPLIFIED, 640},
+        {"yolox-1280", YOLO_STANDARD, 1280},
+        {"yolov8-1280", YOLO_SIMPLIFIED, 1280},
+        {"yolov10", YOLO_END2END, 640},
+    };
+#ifdef RKNPU1
+    static const rknn_tensor_type types[] = {RKNN_TENSOR_UINT8, RKNN_TENSOR_FLOAT32};
+#else
+    static const rknn_tensor_type types[] = {RKNN_TENSOR_INT8, RKNN_TENSOR_FLOAT32};
+#endif
+    static const struct {
+        const char *name;
+        int objects;
+    } scenes[] = {
+        {"empty", 0},
+        {"typical", 8},
+        {"crowded", 200},
+    };
+    static const float thresholds[] = {0.1f, 0.25f, 0.5f};
+
+    for (const auto &model : models) {
+        for (rknn_tensor_type type : types) {
+            for (const auto &scene : scenes) {
+                recorded_outputs_t recorded;
+                bool built = false;
+                for (float threshold : thresholds) {
+                    // Quantized outputs also run with the integer-domain decode and native layouts
+                    for (const DecodeVariant &variant : VARIANTS) {
+                        if (!variant_applies(variant, type, model.model_type)) {
+                            continue;
+                        }
+                        char name[128];
+                        snprintf(name, sizeof(name), "%s/%s/%s/conf=%.2f%s", model.name, type_name(type), scene.name,
+                                 threshold, variant.suffix);
+                        if (filter && !strstr(name, filter)) {
+                            continue;
+                        }
+                        if (!built) {
+                            synthetic_spec_t spec = {model.model_type, type, model.input_size, scene.objects, 42};
+                            if (make_synthetic_outputs(&spec, &recorded) != 0) {
+                                break;
+                            }
+                            built = true;
+                            if (save_dir) {
+                                save_synthetic(save_dir, model.name, type, scene.name, &recorded);
+                            }
+                        }
+                        report(name, run_case(&recorded, threshold, variant, min_time_s));
+                    }
+                }
+                if (built) {
+                    release_output_tensors(&recorded);
+                }
+            }
+        }
+    }
+
+    for (const char *path : recordings) {
+        recorded_outputs_t recorded;
+        if (load_output_tensors(path, &recorded) != 0) {
+            fprintf(stderr, "failed to load %s\n", path);
+            continue;
+        }
+        for (float threshold : thresholds) {
+            char name[128];
+            snprintf(name, sizeof(name), "%s/conf=%.2f", path, threshold);
+            if (filter && !strstr(name, filter)) {
+                continue;
+            }
+            for (const DecodeVariant &variant : VARIANTS) {
+                if (variant_applies(variant, recorded.output_attrs[0].type, recorded.model_type)) {
+                    report(std::string(name) + variant.suffix, run_case(&recorded, threshold, variant, min_time_s));
+                }
+            }
+        }
+        release_output_tensors(&recorded);
+    }
+
+    log_flush();
+    return 0;
+}
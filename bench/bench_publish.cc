@@ -0,0 +1,390 @@
+// Change-only publishing check.
+//
+// Drives Publishers with scripted result sequences through a recording
+// transport and checks which results are sent and which are suppressed:
+// box and people-count changes against the hysteresis, box deltas against
+// the previous message, periodic keyframes on an idle stream, and a
+// ResultBroadcast handing the same stream to publishers that care about
+// different changes, sharing one set of detection aggregates between them and
+// counting each result once in the glass-to-publish latency.
+//
+// Usage: bench_publish
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_report.h"
+#include "log.h"
+#include "metrics.h"
+#include "publisher.h"
+
+namespace {
+
+class RecordingTransport : public Transport {
+public:
+    // Sends numbered from 1 that fail instead of being recorded
+    explicit RecordingTransport(std::vector<int> failing = {}) : failing(std::move(failing)) {}
+
+    bool send(const std::string &message) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (std::find(failing.begin(), failing.end(), ++attempts) != failing.end()) {
+            return false;
+        }
+        messages.push_back(message);
+        return true;
+    }
+    bool isConnected() const override { return true; }
+
+    std::vector<std::string> sent()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<int> failing;
+    int attempts = 0;
+    std::vector<std::string> messages;
+};
+
+struct ScriptBox {
+    box_rect_t box;
+    int cls_id;
+};
+
+InferenceResult make_result(const std::vector<ScriptBox> &boxes)
+{
+    InferenceResult result;
+    for (const ScriptBox &b : boxes) {
+        result.detections.push_back(b.box, 0.9f, b.cls_id);
+    }
+    result.timestamp = std::chrono::system_clock::now();
+    return result;
+}
+
+// Run a publisher over script, one result after another, and return what it sent
+std::vector<std::string> publish_script(std::shared_ptr<MessageFormatter> formatter, const ChangeOptions &options,
+                                        const std::vector<InferenceResult> &script, std::vector<int> failing = {})
+{
+    ThreadSafeQueue<InferenceResult> queue(script.size() + 1);
+    for (const InferenceResult &result : script) {
+        queue.push(result);
+    }
+    queue.signalShutdown();
+
+    std::atomic<bool> running{true};
+    auto transport = std::make_shared<RecordingTransport>(failing);
+    Publisher publisher(transport, queue, running, formatter, 1000);
+    publisher.setChangeOptions(options);
+    publisher();
+    return transport->sent();
+}
+
+int check_count(const char *name, const std::vector<std::string> &sent, size_t expected)
+{
+    printf("%-40s %zu sent of the script (expected %zu)\n", name, sent.size(), expected);
+    if (sent.size() != expected) {
+        for (const std::string &message : sent) {
+            fprintf(stderr, "  %s\n", message.c_str());
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int check_contains(const char *name, const std::string &message, const char *text, bool expected)
+{
+    if ((message.find(text) != std::string::npos) != expected) {
+        fprintf(stderr, "%s: '%s' %s in %s\n", name, text, expected ? "missing" : "unexpected", message.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+// Formatter that keeps the aggregates instance each message was built from
+template <typename Formatter>
+class AggregateProbe : public Formatter {
+public:
+    using Formatter::Formatter;
+
+    std::string formatMessage(const InferenceResult &result) override
+    {
+        result.detections.aggregates(this->aggregatesNeeded());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.push_back(result.detections.aggregates_cache);
+        }
+        return Formatter::formatMessage(result);
+    }
+
+    std::vector<std::shared_ptr<const DetectionAggregates>> instances()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return seen;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::shared_ptr<const DetectionAggregates>> seen;
+};
+
+box_rect_t shifted(box_rect_t box, int dx)
+{
+    return {box.left + dx, box.top, box.right + dx, box.bottom};
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        fprintf(stderr, "Usage: %s\n", argv[0]);
+        return -1;
+    }
+    int errors = 0;
+    const box_rect_t a = {10, 10, 50, 50};
+    const box_rect_t b = {100, 100, 150, 150};
+
+    ChangeOptions options;
+    options.enabled = true;
+    options.keyframe_interval_ms = 60000;
+
+    // Without change detection every result is sent
+    {
+        std::vector<InferenceResult> script(5, make_result({}));
+        errors += check_count("disabled", publish_script(std::make_shared<FacesBSMessageFormatter>(),
+                                                         ChangeOptions(), script), 5);
+    }
+
+    // An idle screen sends its first message only
+    {
+        std::vector<InferenceResult> script(100, make_result({}));
+        errors += check_count("idle faces", publish_script(std::make_shared<FacesBSMessageFormatter>(),
+                                                           options, script), 1);
+    }
+
+    // Faces sinks follow people counts and ignore movement
+    {
+        std::vector<InferenceResult> script = {
+            make_result({}),
+            make_result({}),
+            make_result({{a, PERSON_CLASS_ID}}),
+            make_result({{shifted(a, 30), PERSON_CLASS_ID}}),
+            make_result({{shifted(a, 30), PERSON_CLASS_ID}, {b, 2}}),   // Not a person
+            make_result({}),
+        };
+        std::vector<std::string> sent = publish_script(std::make_shared<FacesBSMessageFormatter>(), options, script);
+        errors += check_count("faces counts", sent, 3);
+        if (sent.size() == 3) {
+            errors += check_contains("faces counts", sent[1], "faces_in_frame_total:1", true);
+            errors += check_contains("faces counts", sent[2], "faces_in_frame_total:0", true);
+        }
+    }
+
+    // Count hysteresis is measured against the last message sent, so a slow
+    // drift still goes out once it adds up
+    {
+        ChangeOptions hysteresis = options;
+        hysteresis.count_hysteresis = 1;
+        std::vector<InferenceResult> script = {
+            make_result({}),
+            make_result({{a, PERSON_CLASS_ID}}),
+            make_result({{a, PERSON_CLASS_ID}, {b, PERSON_CLASS_ID}}),
+        };
+        errors += check_count("count hysteresis 1", publish_script(std::make_shared<FacesJsonMessageFormatter>(),
+                                                                   hysteresis, script), 2);
+    }
+
+    // JSON sink: boxes against box_hysteresis_px, sent as deltas
+    {
+        ChangeOptions deltas = options;
+        deltas.box_deltas = true;
+        std::vector<InferenceResult> script = {
+            make_result({{a, 0}}),
+            make_result({{shifted(a, 3), 0}}),                // Within 8 px: suppressed
+            make_result({{shifted(a, 12), 0}}),               // 12 px from the last message: sent
+            make_result({{shifted(a, 12), 0}}),
+            make_result({{shifted(a, 12), 0}, {b, 2}}),       // New box
+            make_result({{b, 2}}),                            // Box gone
+        };
+        std::vector<std::string> sent = publish_script(std::make_shared<JsonMessageFormatter>(), deltas, script);
+        errors += check_count("json boxes with deltas", sent, 4);
+        if (sent.size() == 4) {
+            errors += check_contains("keyframe", sent[0], "\"delta\"", false);
+            errors += check_contains("moved box", sent[1], "\"delta\":true", true);
+            errors += check_contains("moved box", sent[1], "\"prev\":0", true);
+            errors += check_contains("moved box", sent[1], "\"left\":12", true);
+            errors += check_contains("new box", sent[2], "\"class_id\":2", true);
+            errors += check_contains("box gone", sent[3], "\"count\":1", true);
+        }
+    }
+
+    // A change whose send failed is retried on the next frame, and deltas
+    // are against the last message that went out
+    {
+        ChangeOptions deltas = options;
+        deltas.box_deltas = true;
+        std::vector<InferenceResult> script = {
+            make_result({{a, 0}}),
+            make_result({{shifted(a, 12), 0}}),   // Send fails
+            make_result({{shifted(a, 12), 0}}),
+            make_result({{shifted(a, 12), 0}}),
+        };
+        std::vector<std::string> sent = publish_script(std::make_shared<JsonMessageFormatter>(), deltas, script, {2});
+        errors += check_count("failed send retried", sent, 2);
+        if (sent.size() == 2) {
+            errors += check_contains("failed send retried", sent[1], "\"left\":12", true);
+        }
+    }
+
+    // Keyframes go out on an idle stream for late joiners
+    {
+        ChangeOptions keyframes = options;
+        keyframes.keyframe_interval_ms = 100;
+        ThreadSafeQueue<InferenceResult> queue(1);
+        std::atomic<bool> running{true};
+        auto transport = std::make_shared<RecordingTransport>();
+        Publisher publisher(transport, queue, running, std::make_shared<FacesBSMessageFormatter>(), 1000);
+        publisher.setChangeOptions(keyframes);
+        std::thread thread(std::ref(publisher));
+        auto start = std::chrono::steady_clock::now();
+        int pushed = 0;
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(450)) {
+            queue.push(make_result({}));
+            pushed++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        queue.signalShutdown();
+        publisher.stop();
+        thread.join();
+        size_t sent = transport->sent().size();
+        printf("%-40s %zu sent of %d idle results (expected 4-5)\n", "keyframes every 100 ms", sent, pushed);
+        if (sent < 3 || sent > 6) {
+            errors++;
+        }
+    }
+
+    // One stream, two sinks: a box move reaches the JSON sink even though
+    // the faces sink suppresses it
+    {
+        ResultBroadcast broadcast;
+        std::atomic<bool> running{true};
+        auto json_transport = std::make_shared<RecordingTransport>();
+        auto faces_transport = std::make_shared<RecordingTransport>();
+        Publisher json_publisher(json_transport, broadcast, running, std::make_shared<JsonMessageFormatter>(), 1000);
+        Publisher faces_publisher(faces_transport, broadcast, running, std::make_shared<FacesBSMessageFormatter>(),
+                                  1000);
+        json_publisher.setChangeOptions(options);
+        faces_publisher.setChangeOptions(options);
+        std::thread json_thread(std::ref(json_publisher));
+        std::thread faces_thread(std::ref(faces_publisher));
+
+        std::vector<InferenceResult> script = {
+            make_result({}),
+            make_result({{a, PERSON_CLASS_ID}}),
+            make_result({{shifted(a, 20), PERSON_CLASS_ID}}),
+            make_result({{shifted(a, 20), PERSON_CLASS_ID}, {b, PERSON_CLASS_ID}}),
+        };
+        for (const InferenceResult &result : script) {
+            broadcast.publish(result);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        broadcast.signalShutdown();
+        json_publisher.stop();
+        faces_publisher.stop();
+        json_thread.join();
+        faces_thread.join();
+        errors += check_count("broadcast: json sink", json_transport->sent(), 4);
+        errors += check_count("broadcast: faces sink", faces_transport->sent(), 3);
+    }
+
+    // Sinks needing different aggregates read one instance per result,
+    // computed by the broadcast before fan-out
+    {
+        ResultBroadcast broadcast;
+        std::atomic<bool> running{true};
+        auto json_probe = std::make_shared<AggregateProbe<JsonMessageFormatter>>(true);
+        auto faces_probe = std::make_shared<AggregateProbe<FacesBSMessageFormatter>>();
+        Publisher json_publisher(std::make_shared<RecordingTransport>(), broadcast, running, json_probe, 1000);
+        Publisher faces_publisher(std::make_shared<RecordingTransport>(), broadcast, running, faces_probe, 1000);
+        std::thread json_thread(std::ref(json_publisher));
+        std::thread faces_thread(std::ref(faces_publisher));
+
+        const int results = 5;
+        for (int n = 0; n < results; n++) {
+            broadcast.publish(make_result({{shifted(a, 20 * n), PERSON_CLASS_ID}, {b, 2}}));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        broadcast.signalShutdown();
+        json_publisher.stop();
+        faces_publisher.stop();
+        json_thread.join();
+        faces_thread.join();
+
+        auto json_seen = json_probe->instances();
+        auto faces_seen = faces_probe->instances();
+        int shared = 0;
+        for (size_t n = 0; n < json_seen.size() && n < faces_seen.size(); n++) {
+            const DetectionAggregates *instance = json_seen[n].get();
+            if (instance && instance == faces_seen[n].get() && instance->has(AGGREGATE_PEOPLE | AGGREGATE_NONEMPTY)) {
+                shared++;
+            }
+        }
+        printf("%-40s %d of %d results (expected %d)\n", "broadcast: shared aggregates", shared, results, results);
+        if (shared != results) {
+            errors++;
+        }
+    }
+
+    // Three sinks at different rates: glass-to-publish counts each result once
+    {
+        ResultBroadcast broadcast;
+        std::atomic<bool> running{true};
+        Publisher publishers[] = {
+            {std::make_shared<RecordingTransport>(), broadcast, running, std::make_shared<JsonMessageFormatter>(), 1000},
+            {std::make_shared<RecordingTransport>(), broadcast, running, std::make_shared<FacesJsonMessageFormatter>(),
+             1000},
+            {std::make_shared<RecordingTransport>(), broadcast, running, std::make_shared<FacesBSMessageFormatter>(), 5},
+        };
+        std::vector<std::thread> threads;
+        for (Publisher &publisher : publishers) {
+            threads.emplace_back(std::ref(publisher));
+        }
+
+        const LatencyHistogram &latency = Metrics::instance().histogram(Stage::GlassToPublish);
+        uint64_t before = latency.count();
+        const int results = 10;
+        for (int n = 0; n < results; n++) {
+            InferenceResult result = make_result({{a, PERSON_CLASS_ID}});
+            result.detections.timing.capture_ns = monotonic_ns();
+            broadcast.publish(result);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        broadcast.signalShutdown();
+        for (Publisher &publisher : publishers) {
+            publisher.stop();
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        uint64_t recorded = latency.count() - before;
+        printf("%-40s %llu of %d results (expected %d)\n", "broadcast: latency samples", (unsigned long long)recorded,
+               results, results);
+        if (recorded != (uint64_t)results) {
+            errors++;
+        }
+    }
+
+    log_flush();
+    printf("%s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}
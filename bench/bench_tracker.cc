@@ -0,0 +1,245 @@
+// Tracker benchmark.
+//
+// Feeds ObjectTracker scripted detections and checks what the publishers
+// rely on: ids stay put while objects move, a track is born unconfirmed and
+// confirmed after min_hits matches, survives max_missed missed frames and
+// then dies, ages and dwell times follow the frame clock, detections only
+// match tracks of their own class, and predict() carries the tracks over
+// frames the motion gate kept from the NPU. Then times update() on a
+// crowded scene.
+//
+// Usage: bench_tracker [--objects <n>]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "tracker.h"
+
+namespace {
+
+using Clock = ObjectTracker::Clock;
+
+const std::chrono::milliseconds FRAME(100);
+
+box_rect_t box_at(int x, int y, int size)
+{
+    return {x, y, x + size, y + size};
+}
+
+// Index of the detection whose box starts closest to (x, y)
+int nearest(const object_detect_result_list &detections, int x, int y)
+{
+    int best = -1;
+    int best_distance = 0;
+    for (int i = 0; i < detections.count; i++) {
+        int distance = abs(detections.boxes[i].left - x) + abs(detections.boxes[i].top - y);
+        if (best < 0 || distance < best_distance) {
+            best = i;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+bool check(bool ok, const char *name, int *errors)
+{
+    printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok) {
+        (*errors)++;
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    int objects = 100;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc) {
+            objects = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--objects <n>]\n", argv[0]);
+            return -1;
+        }
+    }
+    if (objects < 1) {
+        objects = 1;
+    }
+    int errors = 0;
+    TrackerOptions options;
+    const Clock::time_point start = Clock::now();
+
+    // Two people walking towards each other on parallel lanes, 4 px a frame
+    {
+        ObjectTracker tracker(options);
+        object_detect_result_list detections;
+        int first_a = -1, first_b = -1;
+        bool stable = true;
+        for (int frame = 0; frame < 40; frame++) {
+            detections.clear();
+            detections.push_back(box_at(20 + 4 * frame, 100, 60), 0.9f, 0);
+            detections.push_back(box_at(400 - 4 * frame, 200, 60), 0.9f, 0);
+            tracker.update(detections, start + frame * FRAME);
+            if (frame == 0) {
+                first_a = detections.tracks[0].id;
+                first_b = detections.tracks[1].id;
+            } else if (detections.tracks[0].id != first_a || detections.tracks[1].id != first_b) {
+                stable = false;
+            }
+        }
+        check(stable && first_a != first_b, "ids stable while moving", &errors);
+        check(detections.tracks[0].age == 39 && detections.tracks[0].confirmed, "age counts frames", &errors);
+        float dwell = detections.tracks[0].dwell_s;
+        check(dwell > 3.89f && dwell < 3.91f, "dwell follows the frame clock", &errors);
+    }
+
+    // Birth, confirmation, a short gap, then death
+    {
+        ObjectTracker tracker(options);
+        object_detect_result_list detections;
+        std::vector<bool> confirmed;
+        int id = -1;
+        for (int frame = 0; frame < options.min_hits; frame++) {
+            detections.clear();
+            detections.push_back(box_at(100, 100, 50), 0.8f, 0);
+            tracker.update(detections, start + frame * FRAME);
+            confirmed.push_back(detections.tracks[0].confirmed);
+            id = detections.tracks[0].id;
+        }
+        bool born = !confirmed.front() && confirmed.back();
+        check(born, "confirmed after min_hits matches", &errors);
+
+        int frame = options.min_hits;
+        for (int gap = 0; gap < options.max_missed; gap++, frame++) {
+            detections.clear();
+            tracker.update(detections, start + frame * FRAME);
+        }
+        detections.clear();
+        detections.push_back(box_at(100, 100, 50), 0.8f, 0);
+        tracker.update(detections, start + frame++ * FRAME);
+        check(detections.tracks[0].id == id, "id kept over max_missed frames", &errors);
+
+        for (int gap = 0; gap <= options.max_missed; gap++, frame++) {
+            detections.clear();
+            tracker.update(detections, start + frame * FRAME);
+        }
+        detections.clear();
+        detections.push_back(box_at(100, 100, 50), 0.8f, 0);
+        tracker.update(detections, start + frame * FRAME);
+        check(detections.tracks[0].id != id && !detections.tracks[0].confirmed && detections.tracks[0].age == 0,
+              "new track after max_missed + 1 frames", &errors);
+    }
+
+    // A person and a bag on top of each other keep their own tracks, and a
+    // detection that changes class does not inherit the other's id
+    {
+        ObjectTracker tracker(options);
+        object_detect_result_list detections;
+        int person = -1, bag = -1;
+        bool kept = true;
+        for (int frame = 0; frame < 10; frame++) {
+            detections.clear();
+            detections.push_back(box_at(200, 200, 80), 0.9f, 0);
+            detections.push_back(box_at(204, 204, 76), 0.7f, 24);
+            tracker.update(detections, start + frame * FRAME);
+            if (frame == 0) {
+                person = detections.tracks[0].id;
+                bag = detections.tracks[1].id;
+            } else if (detections.tracks[0].id != person || detections.tracks[1].id != bag) {
+                kept = false;
+            }
+        }
+        check(kept && person != bag, "overlapping classes tracked apart", &errors);
+
+        detections.clear();
+        detections.push_back(box_at(200, 200, 80), 0.9f, 2);
+        tracker.update(detections, start + 10 * FRAME);
+        int switched = detections.tracks[0].id;
+        check(switched != person && switched != bag, "class change starts a new track", &errors);
+    }
+
+    // Frames the motion gate skipped: predictions move on at the tracked
+    // velocity under the same ids, and detection resumes on them
+    {
+        ObjectTracker tracker(options);
+        object_detect_result_list detections;
+        int frame = 0;
+        for (; frame < 20; frame++) {
+            detections.clear();
+            detections.push_back(box_at(20 + 5 * frame, 100, 60), 0.9f, 0);
+            detections.push_back(box_at(300, 300, 40), 0.6f, 0);
+            tracker.update(detections, start + frame * FRAME);
+        }
+        int walker = detections.tracks[0].id;
+        int still = detections.tracks[1].id;
+
+        bool predicted = true;
+        for (int skipped = 0; skipped < 5; skipped++, frame++) {
+            tracker.predict(detections, start + frame * FRAME);
+            int w = nearest(detections, 20 + 5 * frame, 100);
+            int s = nearest(detections, 300, 300);
+            if (detections.count != 2 || (int)detections.tracks.size() != 2 || w < 0 || s < 0 ||
+                detections.tracks[w].id != walker || detections.tracks[s].id != still ||
+                abs(detections.boxes[w].left - (20 + 5 * frame)) > 3 || abs(detections.boxes[s].left - 300) > 2) {
+                predicted = false;
+            }
+        }
+        check(predicted, "predict() follows the tracks", &errors);
+
+        detections.clear();
+        detections.push_back(box_at(20 + 5 * frame, 100, 60), 0.9f, 0);
+        detections.push_back(box_at(300, 300, 40), 0.6f, 0);
+        tracker.update(detections, start + frame * FRAME);
+        check(detections.tracks[0].id == walker && detections.tracks[1].id == still,
+              "detection resumes after predict()", &errors);
+
+        // A track still waiting for confirmation is carried over as well
+        ObjectTracker fresh(options);
+        detections.clear();
+        detections.push_back(box_at(50, 50, 40), 0.7f, 0);
+        fresh.update(detections, start);
+        int id = detections.tracks[0].id;
+        fresh.predict(detections, start + FRAME);
+        check(detections.count == 1 && detections.tracks[0].id == id && !detections.tracks[0].confirmed,
+              "predict() keeps unconfirmed tracks", &errors);
+    }
+
+    // Association cost on a crowded scene: a grid of objects drifting right
+    {
+        ObjectTracker tracker(options);
+        object_detect_result_list detections;
+        const int frames = 200;
+        int columns = 1;
+        while (columns * columns < objects) {
+            columns++;
+        }
+        bool stable = true;
+        std::vector<int> ids(objects, -1);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            detections.clear();
+            for (int i = 0; i < objects; i++) {
+                detections.push_back(box_at(2 * frame + (i % columns) * 70, (i / columns) * 70, 50), 0.8f, i % 3);
+            }
+            tracker.update(detections, start + frame * FRAME);
+            for (int i = 0; i < objects; i++) {
+                if (frame == 0) {
+                    ids[i] = detections.tracks[i].id;
+                } else if (detections.tracks[i].id != ids[i]) {
+                    stable = false;
+                }
+            }
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / frames;
+        printf("update() with %d objects: %.1f us per frame\n", objects, us);
+        check(stable, "crowd ids stable", &errors);
+    }
+
+    printf("%s\n", errors ? "FAILED" : "OK");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""
+Differential test of the C++ COCO bbox evaluator against pycocotools.
+
+Writes a synthetic ground truth file and a detection results file, scores
+them with golden_coco (CocoEvaluator) and with pycocotools COCOeval
+(iouType 'bbox', default parameters), and compares the twelve
+summarize() numbers.
+
+The synthetic set covers what the evaluator has to get right: boxes in
+all three area ranges, annotation areas that differ from w * h, crowd
+boxes, images without ground truth or without detections, duplicate and
+misplaced detections, more than 100 detections on one image, detections
+of categories without ground truth, and tied scores.
+
+Usage:
+    python3 compare_coco.py [--golden ./golden_coco] [--images 300]
+        [--seed 1] [--tol 1e-6] [--keep <dir>]
+
+Exit status is 1 when any number differs by more than the tolerance.
+"""
+
+import argparse
+import contextlib
+import io
+import json
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+STAT_NAMES = [
+    "AP @[.50:.95] all", "AP @.50 all", "AP @.75 all",
+    "AP small", "AP medium", "AP large",
+    "AR maxDets=1", "AR maxDets=10", "AR maxDets=100",
+    "AR small", "AR medium", "AR large",
+]
+
+CATEGORY_IDS = [1, 2, 3, 5, 7, 11]
+EMPTY_CATEGORY = 11   # Detections only
+
+
+def random_box(rng, width, height):
+    """A box whose side picks one of the small, medium and large area ranges."""
+    side = rng.choice([rng.uniform(4, 30), rng.uniform(34, 94), rng.uniform(100, 300)])
+    w = round(side * rng.uniform(0.6, 1.4), 2)
+    h = round(side * rng.uniform(0.6, 1.4), 2)
+    x = round(rng.uniform(0, max(1.0, width - w)), 2)
+    y = round(rng.uniform(0, max(1.0, height - h)), 2)
+    return [x, y, w, h]
+
+
+def jitter(rng, box, amount):
+    x, y, w, h = box
+    return [round(x + rng.uniform(-amount, amount) * w, 2), round(y + rng.uniform(-amount, amount) * h, 2),
+            round(w * rng.uniform(1 - amount, 1 + amount), 2), round(h * rng.uniform(1 - amount, 1 + amount), 2)]
+
+
+def make_dataset(rng, image_count):
+    images, annotations, results = [], [], []
+    for image_id in range(1, image_count + 1):
+        width, height = 640, 480
+        images.append({"id": image_id, "file_name": "%012d.jpg" % image_id, "width": width, "height": height})
+        gt_count = 0 if image_id % 17 == 0 else rng.randint(1, 12)
+        for _ in range(gt_count):
+            box = random_box(rng, width, height)
+            category = rng.choice(CATEGORY_IDS[:-1])
+            crowd = rng.random() < 0.05
+            annotations.append({
+                "id": len(annotations) + 1, "image_id": image_id, "category_id": category, "bbox": box,
+                # Segment areas are smaller than the box, sometimes across a range boundary
+                "area": round(box[2] * box[3] * rng.uniform(0.5, 1.0), 2),
+                "iscrowd": 1 if crowd else 0,
+            })
+            if image_id % 23 == 0:
+                continue   # No detections on this image
+            if rng.random() < 0.8:
+                results.append({"image_id": image_id, "category_id": category, "bbox": jitter(rng, box, 0.15),
+                                "score": round(rng.uniform(0.3, 1.0), 3)})
+            if rng.random() < 0.2:   # Duplicate
+                results.append({"image_id": image_id, "category_id": category, "bbox": jitter(rng, box, 0.1),
+                                "score": round(rng.uniform(0.05, 0.6), 3)})
+            if rng.random() < 0.1:   # Right place, wrong class
+                results.append({"image_id": image_id, "category_id": rng.choice(CATEGORY_IDS), "bbox": box,
+                                "score": round(rng.uniform(0.05, 0.9), 3)})
+        if image_id % 23 == 0:
+            continue
+        false_positives = 130 if image_id % 41 == 0 else rng.randint(0, 4)
+        for _ in range(false_positives):
+            results.append({"image_id": image_id, "category_id": rng.choice(CATEGORY_IDS),
+                            "bbox": random_box(rng, width, height),
+                            "score": round(rng.uniform(0.01, 0.7), 2)})   # Coarse scores tie
+    categories = [{"id": c, "name": "class%d" % c} for c in CATEGORY_IDS]
+    return {"images": images, "annotations": annotations, "categories": categories}, results
+
+
+def pycocotools_stats(gt_path, results_path):
+    from pycocotools.coco import COCO
+    from pycocotools.cocoeval import COCOeval
+
+    with contextlib.redirect_stdout(io.StringIO()):
+        gt = COCO(gt_path)
+        dt = gt.loadRes(results_path)
+        evaluation = COCOeval(gt, dt, "bbox")
+        evaluation.evaluate()
+        evaluation.accumulate()
+        evaluation.summarize()
+    return list(evaluation.stats)
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--golden", default=os.path.join(here, "golden_coco"))
+    parser.add_argument("--images", type=int, default=300)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--tol", type=float, default=1e-6)
+    parser.add_argument("--keep", help="write the generated files to this directory")
+    args = parser.parse_args()
+
+    try:
+        import pycocotools  # noqa: F401
+    except ImportError:
+        print("pycocotools is not installed (pip install pycocotools)", file=sys.stderr)
+        return 2
+
+    rng = random.Random(args.seed)
+    ground_truth, results = make_dataset(rng, args.images)
+    results = [r for r in results if r["bbox"][2] > 0 and r["bbox"][3] > 0]
+    empty_category = sum(1 for r in results if r["category_id"] == EMPTY_CATEGORY)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        out_dir = args.keep or tmp
+        os.makedirs(out_dir, exist_ok=True)
+        gt_path = os.path.join(out_dir, "instances_synthetic.json")
+        results_path = os.path.join(out_dir, "detections_synthetic.json")
+        with open(gt_path, "w") as f:
+            json.dump(ground_truth, f)
+        with open(results_path, "w") as f:
+            json.dump(results, f)
+
+        golden = subprocess.run([args.golden, gt_path, results_path], capture_output=True, text=True)
+        if golden.returncode != 0:
+            print(golden.stderr, file=sys.stderr)
+            print("FAIL golden_coco exited with %d" % golden.returncode)
+            return 1
+        cpp = json.loads(golden.stdout)
+        reference = pycocotools_stats(gt_path, results_path)
+
+    print("%d images, %d annotations, %d detections (%d of a category without ground truth)" %
+          (len(ground_truth["images"]), len(ground_truth["annotations"]), len(results), empty_category))
+    failed = 0
+    for name, ours, theirs in zip(STAT_NAMES, cpp, reference):
+        ok = abs(ours - theirs) <= args.tol
+        failed += not ok
+        print("%-4s %-20s pycocotools=%.6f cpp=%.6f" % ("OK" if ok else "FAIL", name, theirs, ours))
+    print("FAILED" if failed else "OK")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+"""
+Differential test of the C++ post-processing against the Python reference.
+
+Runs the YOLOX decoder from user-init/examples/test_yolox_npu.py
+(box_process, filter_boxes, nms_boxes) and every post_process() variant
+built into golden_postprocess on the same recorded output tensors, then
+reports box/score/class mismatches within tolerances and the speed ratio.
+NMS runs per class on both sides unless --agnostic-nms is given.
+
+The C++ decoder thresholds objectness and class score separately, the
+Python one thresholds their product, so C++ may keep extra boxes scoring
+below the threshold. Those, and exact score ties that NMS resolved
+differently, are counted as warnings and only fail the run with --strict.
+
+Recordings come from the main application (--record-outputs <dir>).
+
+Usage:
+    python3 compare_postprocess.py [--golden ./golden_postprocess]
+        [--box-tol 2] [--score-tol 0.01] recording.rkt ...
+
+Exit status is 1 when any variant disagrees with the reference.
+"""
+
+import argparse
+import json
+import os
+import struct
+import subprocess
+import sys
+import time
+import types
+
+import numpy as np
+
+EXAMPLES_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "user-init", "examples")
+
+RKNN_TENSOR_FLOAT32 = 0
+RKNN_TENSOR_INT8 = 2
+RKNN_TENSOR_UINT8 = 3
+
+
+def import_reference():
+    """Import test_yolox_npu without needing the NPU runtime or OpenCV."""
+    for name in ("cv2", "rknnlite", "rknnlite.api"):
+        try:
+            __import__(name)
+        except ImportError:
+            stub = types.ModuleType(name)
+            stub.RKNNLite = None
+            sys.modules[name] = stub
+    sys.path.insert(0, EXAMPLES_DIR)
+    import test_yolox_npu
+    return test_yolox_npu
+
+
+def load_recording(path):
+    """Read a tensor file written by save_output_tensors() (see tensor_file.h)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"RKNNOUT1":
+        raise ValueError(f"{path}: not a tensor recording")
+    n_output, width, height, model_type, is_quant = struct.unpack_from("<Iiiii", data, 8)
+    offset = 28
+
+    outputs = []
+    for _ in range(n_output):
+        n_dims, d0, d1, d2, d3, fmt, ttype, qnt_type, zp, scale, size = struct.unpack_from("<I4iiiiifI", data, offset)
+        offset += 44
+        raw = data[offset:offset + size]
+        offset += size
+
+        if ttype == RKNN_TENSOR_INT8:
+            values = (np.frombuffer(raw, dtype=np.int8).astype(np.float32) - zp) * scale
+        elif ttype == RKNN_TENSOR_UINT8:
+            values = (np.frombuffer(raw, dtype=np.uint8).astype(np.float32) - zp) * scale
+        elif ttype == RKNN_TENSOR_FLOAT32:
+            values = np.frombuffer(raw, dtype=np.float32).copy()
+        else:
+            raise ValueError(f"{path}: unsupported tensor type {ttype}")
+
+        # RKNPU1 reports dims innermost first ([W, H, C, N]); memory is NCHW either way
+        if d3 == 1 and d0 != 1:
+            shape = (d3, d2, d1, d0)
+        else:
+            shape = (d0, d1, d2, d3)
+        outputs.append(values.reshape(shape))
+
+    return {"width": width, "height": height, "outputs": outputs}
+
+
+def reference_post_process(ref, outputs, img_shape, class_aware_nms):
+    """test_yolox_npu.post_process() at ratio 1 / no padding, optionally
+    running nms_boxes() per class like the C++ decoder does."""
+    def sp_flatten(_in):
+        ch = _in.shape[1]
+        return _in.transpose(0, 2, 3, 1).reshape(-1, ch)
+
+    boxes = np.concatenate([sp_flatten(ref.box_process(o[:, :4, :, :])) for o in outputs])
+    scores = np.concatenate([sp_flatten(o[:, 4:5, :, :]) for o in outputs])
+    classes_conf = np.concatenate([sp_flatten(o[:, 5:, :, :]) for o in outputs])
+
+    boxes, classes, scores = ref.filter_boxes(boxes, scores, classes_conf)
+    if len(boxes) == 0:
+        return [], [], [], []
+    limits = [img_shape[1], img_shape[0], img_shape[1], img_shape[0]]
+    candidates = [{"cls": int(c), "score": float(s), "box": [float(min(max(v, 0), m)) for v, m in zip(b, limits)]}
+                  for b, c, s in zip(boxes, classes, scores)]
+
+    if class_aware_nms:
+        keep = []
+        for c in np.unique(classes):
+            index = np.where(classes == c)[0]
+            keep.extend(index[ref.nms_boxes(boxes[index], scores[index])])
+        keep = np.array(keep, dtype=np.int64)
+    else:
+        keep = ref.nms_boxes(boxes, scores)
+
+    boxes, classes, scores = boxes[keep], classes[keep], scores[keep]
+    boxes[:, 0::2] = np.clip(boxes[:, 0::2], 0, img_shape[1])
+    boxes[:, 1::2] = np.clip(boxes[:, 1::2], 0, img_shape[0])
+    return boxes, classes, scores, candidates
+
+
+def run_reference(ref, recording, conf, nms, repeat, class_aware_nms):
+    ref.OBJ_THRESH = conf
+    ref.NMS_THRESH = nms
+    ref.IMG_SIZE = (recording["height"], recording["width"])
+    img_shape = (recording["height"], recording["width"])
+
+    start = time.perf_counter()
+    for _ in range(repeat):
+        boxes, classes, scores, candidates = reference_post_process(
+            ref, [o.copy() for o in recording["outputs"]], img_shape, class_aware_nms)
+    ns_per_frame = (time.perf_counter() - start) * 1e9 / repeat
+
+    detections = [{"cls": int(c), "score": float(s), "box": [float(v) for v in b]}
+                  for b, c, s in zip(boxes, classes, scores)]
+    return detections, candidates, ns_per_frame
+
+
+def iou(a, b):
+    w = max(0.0, min(a[2], b[2]) - max(a[0], b[0]))
+    h = max(0.0, min(a[3], b[3]) - max(a[1], b[1]))
+    inter = w * h
+    union = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter
+    return inter / union if union > 0 else 0.0
+
+
+def box_error(a, b):
+    return max(abs(x - y) for x, y in zip(a, b))
+
+
+def compare(reference, ref_candidates, candidate, box_tol, score_tol, conf):
+    """One-to-one matching, same class first; returns (mismatches, warnings).
+
+    A box differing from the reference is only a warning when the reference
+    had a pre-NMS candidate with that box and the same score: both sides
+    resolved an exact score tie differently."""
+    problems = []
+    warnings = []
+    unmatched = set(range(len(candidate)))
+    pending = []
+
+    def closest(ref, same_class):
+        best = None
+        for k in unmatched:
+            if (candidate[k]["cls"] == ref["cls"]) != same_class or iou(ref["box"], candidate[k]["box"]) < 0.5:
+                continue
+            if best is None or box_error(ref["box"], candidate[k]["box"]) < box_error(ref["box"], candidate[best]["box"]):
+                best = k
+        return best
+
+    for ref in sorted(reference, key=lambda d: -d["score"]):
+        best = closest(ref, True)
+        if best is None:
+            pending.append(ref)
+            continue
+        unmatched.remove(best)
+        cand = candidate[best]
+        if box_error(ref["box"], cand["box"]) > box_tol:
+            line = f"box       cls={ref['cls']:2d} ref={fmt_box(ref['box'])} got={fmt_box(cand['box'])}"
+            tie = any(c["cls"] == ref["cls"] and abs(c["score"] - ref["score"]) < 1e-6 and
+                      box_error(c["box"], cand["box"]) <= box_tol for c in ref_candidates)
+            if tie:
+                warnings.append(line + " (score tie)")
+            else:
+                problems.append(line)
+        if abs(cand["score"] - ref["score"]) > score_tol:
+            problems.append(f"score     cls={ref['cls']:2d} ref={ref['score']:.4f} got={cand['score']:.4f}")
+
+    for ref in pending:
+        best = closest(ref, False)
+        if best is None:
+            problems.append(f"missing   cls={ref['cls']:2d} score={ref['score']:.3f} box={fmt_box(ref['box'])}")
+        else:
+            unmatched.remove(best)
+            problems.append(f"class     ref={ref['cls']} got={candidate[best]['cls']} box={fmt_box(ref['box'])}")
+
+    for k in sorted(unmatched):
+        cand = candidate[k]
+        line = f"extra     cls={cand['cls']:2d} score={cand['score']:.3f} box={fmt_box(cand['box'])}"
+        if cand["score"] < conf:
+            warnings.append(line + " (below reference threshold)")
+        else:
+            problems.append(line)
+    return problems, warnings
+
+
+def fmt_box(box):
+    return "[" + ", ".join(f"{v:.1f}" for v in box) + "]"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("recordings", nargs="+")
+    parser.add_argument("--golden", default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "golden_postprocess"))
+    parser.add_argument("--conf", type=float, default=0.25)
+    parser.add_argument("--nms", type=float, default=0.45)
+    parser.add_argument("--box-tol", type=float, default=2.0, help="max corner difference in pixels")
+    parser.add_argument("--score-tol", type=float, default=0.01)
+    parser.add_argument("--repeat", type=int, default=20)
+    parser.add_argument("--agnostic-nms", action="store_true",
+                        help="run the reference NMS across classes exactly as test_yolox_npu.py does "
+                             "(the C++ decoder suppresses per class)")
+    parser.add_argument("--strict", action="store_true",
+                        help="also fail on warnings (boxes below the threshold, score ties)")
+    parser.add_argument("--verbose", action="store_true", help="list every mismatch")
+    args = parser.parse_args()
+
+    ref = import_reference()
+
+    golden = subprocess.run([args.golden, "--conf", str(args.conf), "--nms", str(args.nms),
+                             "--repeat", str(args.repeat)] + args.recordings,
+                            stdout=subprocess.PIPE, check=False, text=True)
+    cpp_results = {}
+    for line in golden.stdout.splitlines():
+        result = json.loads(line)
+        cpp_results.setdefault(result["file"], []).append(result)
+
+    failed = False
+    for path in args.recordings:
+        recording = load_recording(path)
+        if len(recording["outputs"]) != 3:
+            print(f"{path}: skipped, the Python reference only decodes 3-output YOLOX models")
+            continue
+        reference, ref_candidates, py_ns = run_reference(ref, recording, args.conf, args.nms, args.repeat, not args.agnostic_nms)
+
+        for result in cpp_results.get(path, []):
+            problems, warnings = compare(reference, ref_candidates, result["detections"], args.box_tol, args.score_tol, args.conf)
+            if args.strict:
+                problems, warnings = problems + warnings, []
+            speedup = py_ns / result["ns_per_frame"] if result["ns_per_frame"] > 0 else 0.0
+            status = "OK  " if not problems else "FAIL"
+            print(f"{status} {path} [{result['variant']}] ref={len(reference)} cpp={len(result['detections'])} "
+                  f"mismatches={len(problems)} warnings={len(warnings)} python={py_ns / 1e6:.2f} ms "
+                  f"cpp={result['ns_per_frame'] / 1e6:.3f} ms speedup={speedup:.1f}x")
+            listed = problems + (warnings if args.verbose else [])
+            for line in listed if args.verbose else listed[:10]:
+                print(f"    {line}")
+            if not args.verbose and len(listed) > 10:
+                print(f"    ... {len(listed) - 10} more")
+            failed = failed or bool(problems)
+
+        if path not in cpp_results:
+            print(f"FAIL {path}: no output from {args.golden}")
+            failed = True
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,96 @@
+// COCO bbox evaluation dump for the pycocotools comparison in
+// compare_coco.py.
+//
+// Loads an instances_*.json ground truth file and a COCO results file
+// ([{"image_id", "category_id", "bbox", "score"}, ...]), runs every image of
+// the ground truth through CocoEvaluator and prints the twelve
+// COCOeval.summarize() numbers as a JSON list.
+//
+// Usage: golden_coco <instances.json> <detections.json>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "coco_eval.h"
+#include "log.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Detections of a results file, grouped by image id; -1 if it cannot be read
+int load_detections(const char *path, std::unordered_map<int, std::vector<CocoBox>> *detections)
+{
+    std::ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return -1;
+    }
+    try {
+        json doc = json::parse(in);
+        for (const auto &result : doc) {
+            const auto &bbox = result.at("bbox");
+            CocoBox box;
+            box.x = bbox.at(0).get<float>();
+            box.y = bbox.at(1).get<float>();
+            box.w = bbox.at(2).get<float>();
+            box.h = bbox.at(3).get<float>();
+            box.area = box.w * box.h;
+            box.category_id = result.at("category_id").get<int>();
+            box.score = result.at("score").get<float>();
+            (*detections)[result.at("image_id").get<int>()].push_back(box);
+        }
+    } catch (const json::exception &e) {
+        fprintf(stderr, "cannot read %s: %s\n", path, e.what());
+        return -1;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <instances.json> <detections.json>\n", argv[0]);
+        return -1;
+    }
+
+    log_set_stderr_only(true);   // stdout carries the stats only
+    CocoGroundTruth ground_truth;
+    if (loadCocoAnnotations(argv[1], &ground_truth) != 0) {
+        log_flush();
+        return -1;
+    }
+    std::unordered_map<int, std::vector<CocoBox>> detections;
+    if (load_detections(argv[2], &detections) != 0) {
+        return -1;
+    }
+
+    // Ascending image ids, the order COCOeval breaks score ties in
+    std::vector<int> image_ids;
+    for (const auto &image : ground_truth.boxes) {
+        image_ids.push_back(image.first);
+    }
+    std::sort(image_ids.begin(), image_ids.end());
+
+    CocoEvaluator evaluator(ground_truth.category_ids);
+    for (int id : image_ids) {
+        evaluator.evaluateImage(ground_truth.boxes[id], detections[id]);
+    }
+    CocoStats stats = evaluator.summarize();
+
+    printf("[");
+    for (int i = 0; i < 12; i++) {
+        printf("%s%.9f", i ? ", " : "", stats.stats[i]);
+    }
+    printf("]\n");
+    log_flush();
+    return 0;
+}
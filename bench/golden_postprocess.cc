@@ -0,0 +1,168 @@
+// Golden-output dump of post_process() for the differential test in
+// compare_postprocess.py.
+//
+// For every recording and every post-processing variant, prints one JSON
+// line with the detections (model input coordinates, identity letterbox)
+// and the mean time per frame.
+//
+// Usage: golden_postprocess [--conf <t>] [--nms <t>] [--repeat <n>] recording.rkt ...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "log.h"
+#include "postprocess.h"
+#include "tensor_file.h"
+#include "tensor_layout.h"
+
+namespace {
+
+typedef int (*post_process_fn)(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box,
+                               float conf_threshold, float nms_threshold, object_detect_result_list *od_results);
+
+// post_process() with the integer-domain decode of quantized outputs
+int post_process_integer_decode(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box,
+                                float conf_threshold, float nms_threshold, object_detect_result_list *od_results)
+{
+    app_ctx->integer_decode = app_ctx->is_quant;
+    int ret = post_process(app_ctx, outputs, letter_box, conf_threshold, nms_threshold, od_results);
+    app_ctx->integer_decode = false;
+    return ret;
+}
+
+// Every post-processing implementation that must agree with the Python
+// reference. Faster kernels get an entry here so the differential test
+// covers them. Native layouts only apply to int8 recordings.
+const struct {
+    const char *name;
+    post_process_fn fn;
+    rknn_tensor_format layout;
+    int threads;   // set_decode_threads()
+} variants[] = {
+    {"default", post_process, RKNN_TENSOR_NCHW, 0},
+    {"integer", post_process_integer_decode, RKNN_TENSOR_NCHW, 0},
+    {"nc1hwc2", post_process, RKNN_TENSOR_NC1HWC2, 0},
+    {"nc1hwc2-integer", post_process_integer_decode, RKNN_TENSOR_NC1HWC2, 0},
+    {"threads", post_process, RKNN_TENSOR_NCHW, 3},
+    {"threads-integer", post_process_integer_decode, RKNN_TENSOR_NCHW, 3},
+};
+
+// Point app_ctx and outputs at the recording rewritten in layout, as the NPU
+// writes outputs bound in its native format
+void convert_outputs(const recorded_outputs_t &recorded, rknn_tensor_format layout, rknn_app_context_t *app_ctx,
+                     rknn_output *outputs, std::vector<rknn_tensor_attr> *native_attrs,
+                     std::vector<std::vector<int8_t>> *native_buffers)
+{
+    native_attrs->resize(recorded.io_num.n_output);
+    native_buffers->resize(recorded.io_num.n_output);
+    for (uint32_t i = 0; i < recorded.io_num.n_output; i++) {
+        const rknn_tensor_attr *attr = &recorded.output_attrs[i];
+        rknn_tensor_attr *native = &(*native_attrs)[i];
+        native_output_attr(attr, layout, native);
+        tensor_layout_t tensor_layout;
+        int channels, grid_h, grid_w;
+        output_shape(attr, &channels, &grid_h, &grid_w);
+        tensor_layout_init(native, channels, grid_h, grid_w, &tensor_layout);
+        (*native_buffers)[i].resize(native->size);
+        tensor_layout_from_nchw(&tensor_layout, recorded.buffers[i], (*native_buffers)[i].data(), sizeof(int8_t));
+        outputs[i].buf = (*native_buffers)[i].data();
+        outputs[i].size = native->size;
+    }
+    app_ctx->native_output_attrs = native_attrs->data();
+}
+
+void print_json_line(const char *path, const char *variant, double ns_per_frame,
+                     const object_detect_result_list &results)
+{
+    printf("{\"file\":\"%s\",\"variant\":\"%s\",\"ns_per_frame\":%.0f,\"detections\":[", path, variant,
+           ns_per_frame);
+    for (int i = 0; i < results.count; i++) {
+        const box_rect_t &box = results.boxes[i];
+        printf("%s{\"cls\":%d,\"score\":%.6f,\"box\":[%d,%d,%d,%d]}", i ? "," : "", results.cls_ids[i],
+               results.props[i], box.left, box.top, box.right, box.bottom);
+    }
+    printf("]}\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    float conf_threshold = BOX_THRESH;
+    float nms_threshold = NMS_THRESH;
+    int repeat = 20;
+    std::vector<const char *> recordings;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--conf") == 0 && i + 1 < argc) {
+            conf_threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--nms") == 0 && i + 1 < argc) {
+            nms_threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--conf <t>] [--nms <t>] [--repeat <n>] recording.rkt ...\n", argv[0]);
+            return -1;
+        } else {
+            recordings.push_back(argv[i]);
+        }
+    }
+    if (repeat < 1) {
+        repeat = 1;
+    }
+    log_set_level(LOG_LEVEL_ERROR);
+
+    int failed = 0;
+    for (const char *path : recordings) {
+        recorded_outputs_t recorded;
+        if (load_output_tensors(path, &recorded) != 0) {
+            failed++;
+            continue;
+        }
+
+        rknn_app_context_t app_ctx;
+        std::vector<rknn_output> outputs(recorded.io_num.n_output);
+        recorded_outputs_to_context(&recorded, &app_ctx, outputs.data());
+        app_ctx.max_detections = 0;
+
+        letterbox_t letter_box;
+        memset(&letter_box, 0, sizeof(letter_box));
+        letter_box.scale = 1.0f;
+
+        for (const auto &variant : variants) {
+            std::vector<rknn_output> variant_outputs(outputs);
+            std::vector<rknn_tensor_attr> native_attrs;
+            std::vector<std::vector<int8_t>> native_buffers;
+            app_ctx.native_output_attrs = NULL;
+            if (variant.layout != RKNN_TENSOR_NCHW) {
+                if (recorded.output_attrs[0].type != RKNN_TENSOR_INT8) {
+                    continue;
+                }
+                convert_outputs(recorded, variant.layout, &app_ctx, variant_outputs.data(), &native_attrs,
+                                &native_buffers);
+            }
+
+            set_decode_threads(variant.threads);
+            object_detect_result_list results;
+            // Untimed first run builds lookup tables and grows buffers
+            variant.fn(&app_ctx, variant_outputs.data(), &letter_box, conf_threshold, nms_threshold, &results);
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeat; r++) {
+                variant.fn(&app_ctx, variant_outputs.data(), &letter_box, conf_threshold, nms_threshold, &results);
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            set_decode_threads(0);
+            print_json_line(path, variant.name, ns / repeat, results);
+        }
+        app_ctx.native_output_attrs = NULL;
+        release_decode_tables(&app_ctx);
+        release_output_tensors(&recorded);
+    }
+
+    log_flush();
+    return failed ? 1 : 0;
+}
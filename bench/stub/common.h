@@ -0,0 +1,24 @@
+// Host-side stand-in for the model zoo utils common.h (image types only)
+#ifndef _RKNN_MODEL_ZOO_COMMON_H_
+#define _RKNN_MODEL_ZOO_COMMON_H_
+
+typedef enum {
+    IMAGE_FORMAT_GRAY8,
+    IMAGE_FORMAT_RGB888,
+    IMAGE_FORMAT_RGBA8888,
+    IMAGE_FORMAT_YUV420SP_NV21,
+    IMAGE_FORMAT_YUV420SP_NV12,
+} image_format_t;
+
+typedef struct {
+    int width;
+    int height;
+    int width_stride;
+    int height_stride;
+    image_format_t format;
+    unsigned char *virt_addr;
+    int size;
+    int fd;
+} image_buffer_t;
+
+#endif //_RKNN_MODEL_ZOO_COMMON_H_
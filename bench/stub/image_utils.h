@@ -0,0 +1,13 @@
+// Host-side stand-in for the model zoo utils image_utils.h (letterbox only)
+#ifndef _RKNN_MODEL_ZOO_IMAGE_UTILS_H_
+#define _RKNN_MODEL_ZOO_IMAGE_UTILS_H_
+
+#include "common.h"
+
+typedef struct {
+    int x_pad;
+    int y_pad;
+    float scale;
+} letterbox_t;
+
+#endif //_RKNN_MODEL_ZOO_IMAGE_UTILS_H_
@@ -0,0 +1,15 @@
+// Host-side stand-in for the application's inference.h (result type only)
+#ifndef _BSEXT_INFERENCE_H_
+#define _BSEXT_INFERENCE_H_
+
+#include <chrono>
+
+#include "queue.h"
+#include "yolo.h"
+
+struct InferenceResult {
+    object_detect_result_list detections;
+    std::chrono::system_clock::time_point timestamp;
+};
+
+#endif //_BSEXT_INFERENCE_H_
@@ -0,0 +1,14 @@
+// Declarations from the application's postprocess.h used by the benchmarks
+#ifndef _RKNN_YOLO_DEMO_POSTPROCESS_H_
+#define _RKNN_YOLO_DEMO_POSTPROCESS_H_
+
+#include "image_utils.h"
+#include "yolo.h"
+
+int init_post_process();
+void deinit_post_process();
+char *coco_cls_to_name(int cls_id);
+int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box, float conf_threshold,
+                 float nms_threshold, object_detect_result_list *od_results);
+
+#endif //_RKNN_YOLO_DEMO_POSTPROCESS_H_
@@ -0,0 +1,53 @@
+// Host-side stand-in for the application's queue.h: a bounded blocking queue
+#ifndef _BSEXT_QUEUE_H_
+#define _BSEXT_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+template <typename T>
+class ThreadSafeQueue {
+public:
+    explicit ThreadSafeQueue(size_t max_size = 1) : max_size(max_size) {}
+
+    void push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [&] { return shutdown || items.size() < max_size; });
+        if (shutdown) {
+            return;
+        }
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+    }
+
+    // False once shut down and empty
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [&] { return shutdown || !items.empty(); });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    void signalShutdown() {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutdown = true;
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+private:
+    size_t max_size;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    bool shutdown = false;
+};
+
+#endif //_BSEXT_QUEUE_H_
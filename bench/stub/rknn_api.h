@@ -0,0 +1,105 @@
+// Host-side stand-in for the RKNN runtime header.
+//
+// Declares only the types and constants post-processing uses, with the same
+// names and member order as the runtime's rknn_api.h, so postprocess.cc and
+// tensor_file.cc build on any Linux box. The rknn_* functions are declared
+// but never defined; nothing built against this header may call them.
+#ifndef _RKNN_API_H
+#define _RKNN_API_H
+
+#include <stdint.h>
+
+typedef uint64_t rknn_context;
+
+#define RKNN_SUCC 0
+#define RKNN_ERR_FAIL -1
+#define RKNN_ERR_PARAM_INVALID -5
+#define RKNN_ERR_MODEL_INVALID -6
+#define RKNN_MAX_DIMS 16
+#define RKNN_MAX_NAME_LEN 256
+
+typedef enum _rknn_query_cmd {
+    RKNN_QUERY_IN_OUT_NUM = 0,
+    RKNN_QUERY_INPUT_ATTR = 1,
+    RKNN_QUERY_OUTPUT_ATTR = 2,
+    RKNN_QUERY_NATIVE_OUTPUT_ATTR = 9,
+    RKNN_QUERY_NATIVE_NHWC_OUTPUT_ATTR = 11,
+} rknn_query_cmd;
+
+typedef enum _rknn_tensor_type {
+    RKNN_TENSOR_FLOAT32 = 0,
+    RKNN_TENSOR_FLOAT16,
+    RKNN_TENSOR_INT8,
+    RKNN_TENSOR_UINT8,
+    RKNN_TENSOR_INT16,
+} rknn_tensor_type;
+
+typedef enum _rknn_tensor_qnt_type {
+    RKNN_TENSOR_QNT_NONE = 0,
+    RKNN_TENSOR_QNT_DFP,
+    RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC,
+} rknn_tensor_qnt_type;
+
+typedef enum _rknn_tensor_format {
+    RKNN_TENSOR_NCHW = 0,
+    RKNN_TENSOR_NHWC,
+    RKNN_TENSOR_NC1HWC2,
+    RKNN_TENSOR_UNDEFINED,
+} rknn_tensor_format;
+
+typedef struct _rknn_input_output_num {
+    uint32_t n_input;
+    uint32_t n_output;
+} rknn_input_output_num;
+
+typedef struct _rknn_tensor_attr {
+    uint32_t index;
+    uint32_t n_dims;
+    uint32_t dims[RKNN_MAX_DIMS];
+    char name[RKNN_MAX_NAME_LEN];
+    uint32_t n_elems;
+    uint32_t size;
+    rknn_tensor_format fmt;
+    rknn_tensor_type type;
+    rknn_tensor_qnt_type qnt_type;
+    int8_t fl;
+    int32_t zp;
+    float scale;
+    uint32_t w_stride;
+    uint32_t size_with_stride;
+    uint8_t pass_through;
+    uint32_t h_stride;
+} rknn_tensor_attr;
+
+typedef struct _rknn_input {
+    uint32_t index;
+    void *buf;
+    uint32_t size;
+    uint8_t pass_through;
+    rknn_tensor_type type;
+    rknn_tensor_format fmt;
+} rknn_input;
+
+typedef struct _rknn_output {
+    uint8_t want_float;
+    uint8_t is_prealloc;
+    uint32_t index;
+    void *buf;
+    uint32_t size;
+} rknn_output;
+
+typedef struct _rknn_tensor_memory {
+    void *virt_addr;
+    uint64_t phys_addr;
+    int32_t fd;
+    int32_t offset;
+    uint32_t size;
+    uint32_t flags;
+    void *priv_data;
+} rknn_tensor_mem;
+
+typedef struct _rknn_init_extend rknn_init_extend;
+typedef struct _rknn_run_extend rknn_run_extend;
+typedef struct _rknn_output_extend rknn_output_extend;
+
+#endif //_RKNN_API_H
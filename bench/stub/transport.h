@@ -0,0 +1,29 @@
+// Host-side stand-in for the application's transport.h; the concrete
+// transports accept every message and send nothing
+#ifndef _BSEXT_TRANSPORT_H_
+#define _BSEXT_TRANSPORT_H_
+
+#include <string>
+
+class Transport {
+public:
+    virtual ~Transport() = default;
+    virtual bool send(const std::string& message) = 0;
+    virtual bool isConnected() const = 0;
+};
+
+class UDPTransport : public Transport {
+public:
+    UDPTransport(const std::string& ip, int port) {}
+    bool send(const std::string& message) override { return true; }
+    bool isConnected() const override { return true; }
+};
+
+class FileTransport : public Transport {
+public:
+    explicit FileTransport(const std::string& path) {}
+    bool send(const std::string& message) override { return true; }
+    bool isConnected() const override { return true; }
+};
+
+#endif //_BSEXT_TRANSPORT_H_
@@ -0,0 +1,208 @@
+#include "synthetic_outputs.h"
+
+#include "tensor_layout.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+namespace {
+
+const float BACKGROUND_SCORE = 0.004f;
+const float OBJECT_SCORE = 0.9f;
+const float EDGE_SCORE = 0.6f;      // 4-connected neighbours
+const float CORNER_SCORE = 0.3f;    // diagonal neighbours
+
+struct Plane {
+    int channels;
+    int grid_h;
+    int grid_w;
+    float range_min;
+    float range_max;
+    std::vector<float> values;   // [channels, grid_h, grid_w]
+
+    Plane(int c, int h, int w, float lo, float hi, float fill)
+        : channels(c), grid_h(h), grid_w(w), range_min(lo), range_max(hi), values((size_t)c * h * w, fill) {}
+
+    float &at(int c, int i, int j) { return values[((size_t)c * grid_h + i) * grid_w + j]; }
+};
+
+// Quantize a plane into an output slot of the recording
+void store_plane(const Plane &plane, rknn_tensor_type type, int index, recorded_outputs_t *recorded)
+{
+    rknn_tensor_attr *attr = &recorded->output_attrs[index];
+    size_t n = plane.values.size();
+
+    attr->index = index;
+    attr->n_dims = 4;
+#ifdef RKNPU1
+    attr->dims[0] = plane.grid_w;
+    attr->dims[1] = plane.grid_h;
+    attr->dims[2] = plane.channels;
+    attr->dims[3] = 1;
+#else
+    attr->dims[0] = 1;
+    attr->dims[1] = plane.channels;
+    attr->dims[2] = plane.grid_h;
+    attr->dims[3] = plane.grid_w;
+#endif
+    attr->n_elems = n;
+    attr->fmt = RKNN_TENSOR_NCHW;
+    attr->type = type;
+
+    if (type == RKNN_TENSOR_FLOAT32) {
+        attr->qnt_type = RKNN_TENSOR_QNT_NONE;
+        attr->zp = 0;
+        attr->scale = 1.0f;
+        attr->size = n * sizeof(float);
+        recorded->buffers[index] = malloc(attr->size);
+        memcpy(recorded->buffers[index], plane.values.data(), attr->size);
+        return;
+    }
+
+    int qmin = type == RKNN_TENSOR_INT8 ? -128 : 0;
+    int qmax = type == RKNN_TENSOR_INT8 ? 127 : 255;
+    float scale = (plane.range_max - plane.range_min) / 255.0f;
+    int zp = qmin - (int)roundf(plane.range_min / scale);
+
+    attr->qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+    attr->zp = zp;
+    attr->scale = scale;
+    attr->size = n;
+    recorded->buffers[index] = malloc(n);
+    for (size_t k = 0; k < n; k++) {
+        int q = (int)roundf(plane.values[k] / scale) + zp;
+        q = q < qmin ? qmin : (q > qmax ? qmax : q);
+        if (type == RKNN_TENSOR_INT8) {
+            ((int8_t *)recorded->buffers[index])[k] = (int8_t)q;
+        } else {
+            ((uint8_t *)recorded->buffers[index])[k] = (uint8_t)q;
+        }
+    }
+}
+
+const int END2END_TOP_K = 300;
+
+int make_end2end_outputs(const synthetic_spec_t *spec, recorded_outputs_t *recorded)
+{
+    if (spec->type != RKNN_TENSOR_FLOAT32) {
+        return -1;
+    }
+    memset(recorded, 0, sizeof(*recorded));
+    recorded->model_width = spec->model_size;
+    recorded->model_height = spec->model_size;
+    recorded->model_type = spec->model_type;
+    recorded->is_quant = false;
+    recorded->io_num.n_input = 1;
+    recorded->io_num.n_output = 1;
+    recorded->output_attrs = (rknn_tensor_attr *)calloc(1, sizeof(rknn_tensor_attr));
+    recorded->buffers = (void **)calloc(1, sizeof(void *));
+
+    std::mt19937 rng(spec->seed);
+    Plane plane(1, END2END_TOP_K, END2END_FIELDS, 0.0f, (float)spec->model_size, 0.0f);
+    for (int n = 0; n < END2END_TOP_K; n++) {
+        float size = 8.0f + rng() % 120;
+        float x = rng() % (spec->model_size - 128);
+        float y = rng() % (spec->model_size - 128);
+        // Ranked like the head's top-K: objects first, then background
+        float score = n < spec->objects ? OBJECT_SCORE * (1.0f - (float)n / (2 * END2END_TOP_K)) : BACKGROUND_SCORE;
+        plane.at(0, n, 0) = x;
+        plane.at(0, n, 1) = y;
+        plane.at(0, n, 2) = x + size;
+        plane.at(0, n, 3) = y + size;
+        plane.at(0, n, 4) = score;
+        plane.at(0, n, 5) = (float)(rng() % OBJ_CLASS_NUM);
+    }
+    store_plane(plane, spec->type, 0, recorded);
+    return 0;
+}
+
+}  // namespace
+
+int make_synthetic_outputs(const synthetic_spec_t *spec, recorded_outputs_t *recorded)
+{
+    static const int strides[3] = {8, 16, 32};
+    if (spec->model_type == YOLO_END2END) {
+        return make_end2end_outputs(spec, recorded);
+    }
+    bool yolov8 = spec->model_type == YOLO_SIMPLIFIED;
+    int n_output = yolov8 ? 9 : 3;
+
+    memset(recorded, 0, sizeof(*recorded));
+    recorded->model_width = spec->model_size;
+    recorded->model_height = spec->model_size;
+    recorded->model_type = spec->model_type;
+    recorded->is_quant = spec->type != RKNN_TENSOR_FLOAT32;
+    recorded->io_num.n_input = 1;
+    recorded->io_num.n_output = n_output;
+    recorded->output_attrs = (rknn_tensor_attr *)calloc(n_output, sizeof(rknn_tensor_attr));
+    recorded->buffers = (void **)calloc(n_output, sizeof(void *));
+
+    std::mt19937 rng(spec->seed);
+    std::vector<Plane> planes;
+    for (int s = 0; s < 3; s++) {
+        int grid = spec->model_size / strides[s];
+        if (yolov8) {
+            planes.emplace_back(64, grid, grid, 0.0f, 8.0f, 0.0f);                      // DFL logits
+            planes.emplace_back(OBJ_CLASS_NUM, grid, grid, 0.0f, 1.0f, BACKGROUND_SCORE); // class scores
+            planes.emplace_back(1, grid, grid, 0.0f, 1.0f, BACKGROUND_SCORE);             // score sum
+        } else {
+            planes.emplace_back(5 + OBJ_CLASS_NUM, grid, grid, -0.5f, 1.5f, 0.0f);
+            for (int i = 0; i < grid; i++) {
+                for (int j = 0; j < grid; j++) {
+                    planes.back().at(4, i, j) = BACKGROUND_SCORE;
+                    for (int c = 0; c < OBJ_CLASS_NUM; c++) {
+                        planes.back().at(5 + c, i, j) = BACKGROUND_SCORE;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int o = 0; o < spec->objects; o++) {
+        int s = rng() % 3;
+        int grid = spec->model_size / strides[s];
+        int ci = 1 + rng() % (grid - 2);
+        int cj = 1 + rng() % (grid - 2);
+        int cls = rng() % OBJ_CLASS_NUM;
+        float log_size = logf(1.0f + (rng() % 300) / 100.0f);   // box 1-4 strides wide
+        int dfl_bin = 1 + rng() % 5;
+
+        for (int di = -1; di <= 1; di++) {
+            for (int dj = -1; dj <= 1; dj++) {
+                int i = ci + di;
+                int j = cj + dj;
+                float score = (di == 0 && dj == 0) ? OBJECT_SCORE : (di == 0 || dj == 0) ? EDGE_SCORE : CORNER_SCORE;
+                // Avoid exact score ties, which real outputs rarely have
+                score *= 1.0f - (rng() % 1000) / 20000.0f;
+                if (yolov8) {
+                    Plane &box = planes[s * 3 + 0];
+                    for (int coord = 0; coord < 4; coord++) {
+                        for (int d = 0; d < 16; d++) {
+                            box.at(coord * 16 + d, i, j) = (d == dfl_bin) ? 6.0f : 0.0f;
+                        }
+                    }
+                    planes[s * 3 + 1].at(cls, i, j) = score;
+                    planes[s * 3 + 2].at(0, i, j) = score;
+                } else {
+                    Plane &p = planes[s];
+                    // Neighbours predict nearly the same box as the centre cell
+                    p.at(0, i, j) = 0.5f - dj * 0.8f;
+                    p.at(1, i, j) = 0.5f - di * 0.8f;
+                    p.at(2, i, j) = log_size;
+                    p.at(3, i, j) = log_size;
+                    p.at(4, i, j) = score;
+                    p.at(5 + cls, i, j) = score;
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < n_output; k++) {
+        store_plane(planes[k], spec->type, k, recorded);
+    }
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef _BSEXT_SYNTHETIC_OUTPUTS_H_
+#define _BSEXT_SYNTHETIC_OUTPUTS_H_
+
+#include "tensor_file.h"
+
+// Synthetic model outputs for host-side benchmarks and tests.
+//
+// Builds the tensors a YOLOX (3 x 85-channel) or YOLOv8 (9-output DFL) head
+// would produce for a scene with `objects` objects at random positions and
+// classes. Every object also lights up its 8 neighbouring cells with lower
+// scores, so the result exercises sorting and NMS the way a real frame does.
+// On RKNPU1 builds dims are laid out as [W, H, C, N] like the runtime
+// reports them.
+//
+// YOLO_END2END builds the [1, 300, 6] top-K output of an NMS-free head: one
+// row per object, ranked by score, padded with low-score rows. It is float
+// only; a single int8 scale cannot hold both pixel coordinates and class ids.
+typedef struct {
+    yolo_model_type_t model_type;   // YOLO_STANDARD, YOLO_SIMPLIFIED or YOLO_END2END
+    rknn_tensor_type type;          // RKNN_TENSOR_INT8, RKNN_TENSOR_UINT8 or RKNN_TENSOR_FLOAT32
+    int model_size;                 // Square model input, e.g. 640
+    int objects;
+    unsigned seed;
+} synthetic_spec_t;
+
+// Returns -1 for a combination the model type does not come in
+int make_synthetic_outputs(const synthetic_spec_t *spec, recorded_outputs_t *recorded);
+
+#endif //_BSEXT_SYNTHETIC_OUTPUTS_H_
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "yolo.h"
+
+struct FrameWriterOptions {
+    std::string path = "/tmp/output.jpg";
+    bool suppress_empty = false;   // Do not write frames without detections
+    int max_fps = 2;               // Upper bound on written frames per second (0 = unlimited)
+    int width = 0;                 // Output width, height follows the aspect ratio (0 = source size)
+    int jpeg_quality = 85;
+    int workers = 1;               // Encoder threads
+};
+
+// Writes decorated (box-annotated) frames off the inference thread.
+//
+// writeFrame() never blocks: it copies the frame into a free slot and
+// returns, or drops the frame when every worker is busy or the output rate
+// limit has not elapsed. Workers draw, resize and JPEG-encode into buffers
+// reused across frames, then publish atomically by writing a temp file and
+// renaming it over the output path. A slower frame never overwrites a newer
+// one.
+class AsyncFrameWriter {
+public:
+    explicit AsyncFrameWriter(const FrameWriterOptions& options = FrameWriterOptions());
+    ~AsyncFrameWriter();
+
+    AsyncFrameWriter(const AsyncFrameWriter&) = delete;
+    AsyncFrameWriter& operator=(const AsyncFrameWriter&) = delete;
+
+    // Queue a BGR frame and its detections; returns false if it was dropped
+    bool writeFrame(const cv::Mat& frame, const object_detect_result_list& detections);
+
+    // False if writeFrame() would turn these detections away right now
+    // (empty frame suppressed, or rate limited), so a caller can skip
+    // preparing a BGR frame nobody will write
+    bool wantsFrame(const object_detect_result_list& detections);
+
+    uint64_t writtenFrames() const { return written; }
+    uint64_t droppedFrames() const { return dropped; }
+
+private:
+    struct Slot {
+        bool busy = false;
+        uint64_t sequence = 0;
+        cv::Mat frame;
+        object_detect_result_list detections;
+        cv::Mat scaled;
+        std::vector<unsigned char> encoded;
+        std::string temp_path;
+    };
+
+    void run(int worker);
+    void encode(Slot& slot);
+
+    FrameWriterOptions options;
+    std::vector<Slot> slots;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<int> pending;   // Slot indices waiting for a worker
+    bool stopping = false;
+
+    uint64_t next_sequence = 1;
+    uint64_t published_sequence = 0;
+    std::chrono::steady_clock::time_point last_accepted;
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "inference_backend.h"
+#include "rknn_api.h"
+
+struct AsyncRunnerOptions {
+    int contexts = 1;                 // Model instances, one worker thread each
+    int in_flight = 2;                // Requests submitted but not finished; submit() blocks beyond this
+    std::vector<uint32_t> core_masks; // NPU core mask per context (rknn_core_mask), empty = runtime default
+    bool want_float = true;           // Dequantize outputs to float32
+};
+
+// One submitted inference. Outputs are owned by the request once it is done.
+struct AsyncRequest {
+    uint64_t id = 0;
+    int status = RKNN_SUCC;                       // Negative RKNN error code on failure
+    std::vector<std::vector<uint8_t>> outputs;    // Raw output tensors, see outputAttrs()
+
+    bool done() const;
+    // Wait until done; returns false on timeout (timeout_ms < 0 waits forever)
+    bool wait(int timeout_ms) const;
+
+private:
+    friend class AsyncRknnRunner;
+    mutable std::mutex mutex;
+    mutable std::condition_variable finished;
+    bool complete = false;
+    int buffer = -1;   // Input buffer set until the worker has handed it to the runtime
+};
+
+// Pipelined inference over several NPU contexts.
+//
+// submit() copies the inputs into one of in_flight preallocated buffer sets
+// and returns at once, so the caller can prepare the next frame while the
+// NPU runs. Worker threads (one per context, optionally pinned to NPU cores)
+// take requests in submission order. A buffer set is recycled as soon as
+// the runtime has consumed it, before the run finishes.
+class AsyncRknnRunner {
+public:
+    explicit AsyncRknnRunner(const AsyncRunnerOptions& options = AsyncRunnerOptions());
+    ~AsyncRknnRunner();
+
+    AsyncRknnRunner(const AsyncRknnRunner&) = delete;
+    AsyncRknnRunner& operator=(const AsyncRknnRunner&) = delete;
+
+    // Create the contexts through create_inference_backend() and start the
+    // workers; returns 0 or a negative RKNN error code
+    int init(const char* model_path);
+
+    // Queue one inference. inputs[i] must hold inputAttrs()[i].n_elems bytes
+    // of uint8 NHWC data. Blocks while in_flight requests are outstanding.
+    // Returns NULL on a size mismatch or after shutdown().
+    std::shared_ptr<AsyncRequest> submit(const void* const* inputs, const size_t* sizes, uint32_t n_inputs);
+
+    // Finish queued requests and stop the workers
+    void shutdown();
+
+    const rknn_input_output_num& ioNum() const { return io_num; }
+    const std::vector<rknn_tensor_attr>& inputAttrs() const { return input_attrs; }
+    const std::vector<rknn_tensor_attr>& outputAttrs() const { return output_attrs; }
+    bool wantFloat() const { return options.want_float; }
+    int inFlight() const { return options.in_flight; }
+    int outstanding();
+
+private:
+    void run(int worker);
+    void execute(InferenceBackend& backend, AsyncRequest& request, std::vector<rknn_input>& inputs,
+                 std::vector<rknn_output>& outputs);
+    void finish(AsyncRequest& request, int status);
+
+    AsyncRunnerOptions options;
+    std::vector<std::unique_ptr<InferenceBackend>> backends;
+    std::vector<std::thread> threads;
+    rknn_input_output_num io_num = {};
+    std::vector<rknn_tensor_attr> input_attrs;
+    std::vector<rknn_tensor_attr> output_attrs;
+
+    std::vector<std::vector<std::vector<uint8_t>>> buffers;   // [buffer set][input]
+    std::vector<int> free_buffers;
+
+    std::mutex mutex;
+    std::condition_variable ready;      // Workers: a request was queued
+    std::condition_variable capacity;   // Submitters: a buffer set or in-flight slot was freed
+    std::deque<std::shared_ptr<AsyncRequest>> pending;
+    int running = 0;                    // Requests taken by a worker and not yet finished
+    uint64_t next_id = 1;
+    bool stopping = false;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Options for offline batch inference over many image files
+struct BatchOptions {
+    std::string model_path;
+    std::string source;                               // directory, glob pattern or list file
+    std::string output_path = "/tmp/results.jsonl";   // JSON Lines output, "-" for stdout (logging moves to stderr)
+    int decode_threads = 0;                           // 0 = one per hardware thread, minus the NPU feeder
+    bool suppress_empty = false;
+    bool scaled_decode = true;                        // Decode JPEGs at the 1/2, 1/4 or 1/8 scale closest above the model input
+    size_t cache_capacity = 1024;                     // Results of identical image files reused from memory, 0 = no cache
+    std::string cache_index;                          // Persistent result cache index file, empty for memory only
+    std::string coco_annotations;                     // instances_*.json: also report COCO mAP/AR
+};
+
+// Expand a batch source into image paths:
+//  - a directory yields every .jpg/.jpeg/.png file in it (sorted)
+//  - a pattern containing '*', '?' or '[' is expanded with glob(3)
+//  - any other file is read as a list of paths, one per line ('#' starts a comment)
+std::vector<std::string> expandBatchSource(const std::string& source);
+
+// Decode images on a thread pool and feed them to the NPU back to back,
+// streaming one JSON object per image to options.output_path. With
+// coco_annotations set, detections are scored against the ground truth of
+// each image (matched by file name) as they come out, and mAP/AR is
+// reported next to the throughput. Image files whose bytes were already
+// scored with the same model and thresholds are answered from the result
+// cache without decoding. Stops early when isRunning is cleared.
+// Returns 0 on success, -1 on setup failure.
+int runBatchInference(const BatchOptions& options, std::atomic<bool>& isRunning);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "async_frame_writer.h"
+#include "camera_source.h"
+#include "inference.h"
+#include "queue.h"
+
+// Capture and inference stage for a native camera source, a drop-in for
+// MLInferenceThread in the video pipeline. Frames are inferred straight from
+// the capture buffer (inference_yolo_model_yuv), which goes back to the
+// driver as soon as the frame has been inferred and, when the preview wants
+// it, converted for the frame writer. With RawFileCameraSource the pipeline
+// runs from a recorded raw stream or a pipe. Logs throughput and
+// capture-to-result latency when it stops, then calls onFinished.
+class CameraInferenceThread {
+public:
+    CameraInferenceThread(
+        const std::string& model_path,
+        std::unique_ptr<CameraSource> source,
+        ThreadSafeQueue<InferenceResult>& outputQueue,
+        std::atomic<bool>& isRunning,
+        std::shared_ptr<AsyncFrameWriter> frameWriter,
+        std::function<void()> onFinished = nullptr);
+
+    void operator()();
+
+private:
+    std::string model_path;
+    std::unique_ptr<CameraSource> source;
+    ThreadSafeQueue<InferenceResult>& outputQueue;
+    std::atomic<bool>& running;
+    std::shared_ptr<AsyncFrameWriter> frameWriter;
+    std::function<void()> onFinished;
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "yuv_letterbox.h"
+
+struct CameraOptions {
+    int width = 1280;                  // Requested size, the driver may pick the nearest it supports
+    int height = 720;
+    YuvFormat format = YuvFormat::YUYV;
+    int fps = 30;
+    int buffers = 4;                   // Capture ring size (at least 3: one filling, one leased, one spare)
+    bool export_dmabuf = false;        // Also export each V4L2 buffer as a DMABUF fd
+    bool loop = true;                  // Raw file source: start over at end of file
+};
+
+class CameraSource;
+
+// A captured frame on loan from a CameraSource ring. The frame points
+// straight into the capture buffer, which is handed back to the source when
+// the lease is reset or destroyed, so hold it exactly as long as the
+// pipeline needs the pixels. Leases must not outlive their source.
+class FrameLease {
+public:
+    FrameLease() = default;
+    ~FrameLease() { reset(); }
+    FrameLease(FrameLease&& other) noexcept { *this = std::move(other); }
+    FrameLease& operator=(FrameLease&& other) noexcept;
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    // Return the buffer to the source
+    void reset();
+    explicit operator bool() const { return source != nullptr; }
+
+    const YuvFrame& frame() const { return yuv; }
+    int dmabufFd() const { return dmabuf_fd; }   // -1 unless exported
+    uint64_t sequence() const { return seq; }
+    // When the frame was captured (driver timestamp when it has one)
+    std::chrono::steady_clock::time_point timestamp() const { return captured; }
+
+private:
+    friend class CameraSource;
+
+    CameraSource* source = nullptr;
+    int index = -1;
+    YuvFrame yuv;
+    int dmabuf_fd = -1;
+    uint64_t seq = 0;
+    std::chrono::steady_clock::time_point captured;
+};
+
+// Ring of capture buffers with a latest-frame policy.
+//
+// acquire() hands out the newest filled buffer and recycles any older ones
+// straight away, so a slow consumer always sees the most recent frame and
+// never works through a backlog. Stale frames are counted, not queued.
+class CameraSource {
+public:
+    virtual ~CameraSource() = default;
+
+    // Open and start streaming; false on error (already logged)
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    // Newest captured frame, waiting up to timeout for one. An empty lease
+    // means a timeout, or the end of the stream when finished() is true.
+    virtual FrameLease acquire(std::chrono::milliseconds timeout) = 0;
+
+    // End of a raw file, closed pipe or a device error
+    bool finished() const { return done; }
+
+    // Format actually negotiated, valid after start()
+    const CameraOptions& options() const { return format; }
+
+    uint64_t capturedFrames() const { return captured_frames; }
+    uint64_t staleFrames() const { return stale_frames; }
+
+protected:
+    explicit CameraSource(const CameraOptions& options) : format(options) {}
+
+    // Hand buffer index back to the capture side
+    virtual void release(int index) = 0;
+
+    FrameLease lease(int index, const YuvFrame& frame, int dmabuf_fd, uint64_t sequence,
+                     std::chrono::steady_clock::time_point captured);
+
+    // Count a frame recycled without being handed out (also Counter::DroppedFrames)
+    void dropFrame();
+
+    CameraOptions format;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> captured_frames{0};
+    std::atomic<uint64_t> stale_frames{0};
+
+    friend class FrameLease;
+};
+
+// V4L2 streaming capture from mmap'd driver buffers (VIDIOC_QBUF/DQBUF),
+// optionally exported as DMABUF fds for zero-copy consumers. Handles
+// single- and multi-planar (e.g. rkisp) capture nodes; NV12 must be
+// delivered in one plane.
+class V4l2CameraSource : public CameraSource {
+public:
+    V4l2CameraSource(const std::string& device, const CameraOptions& options);
+    ~V4l2CameraSource() override;
+
+    bool start() override;
+    void stop() override;
+    FrameLease acquire(std::chrono::milliseconds timeout) override;
+
+protected:
+    void release(int index) override;
+
+private:
+    struct Buffer {
+        void* start = nullptr;
+        size_t length = 0;
+        int dmabuf_fd = -1;
+    };
+
+    bool configure();
+    bool mapBuffers();
+    bool queue(int index);
+    // Dequeue one filled buffer without waiting; -1 when none is ready
+    int dequeue(uint32_t* bytes_used, uint32_t* sequence, std::chrono::steady_clock::time_point* captured);
+
+    std::string device;
+    int fd = -1;
+    uint32_t buf_type = 0;
+    bool multiplanar = false;
+    bool streaming = false;
+    int stride = 0;
+    size_t frame_size = 0;
+    std::vector<Buffer> buffers;
+    int queued = 0;     // Buffers owned by the driver
+    std::mutex mutex;   // release() may come from another thread
+};
+
+// Stand-in camera reading back-to-back raw YUYV/NV12 frames from a file or
+// named pipe, e.g. one recorded with `v4l2-ctl --stream-to`. A reader thread
+// fills a ring of buffers at options.fps (a pipe is read at the writer's
+// pace) and overwrites the oldest unread frame when the consumer falls
+// behind, as a camera driver does.
+class RawFileCameraSource : public CameraSource {
+public:
+    RawFileCameraSource(const std::string& path, const CameraOptions& options);
+    ~RawFileCameraSource() override;
+
+    bool start() override;
+    void stop() override;
+    FrameLease acquire(std::chrono::milliseconds timeout) override;
+
+protected:
+    void release(int index) override;
+
+private:
+    struct Buffer {
+        std::vector<uint8_t> data;
+        uint64_t sequence = 0;
+        std::chrono::steady_clock::time_point captured;
+    };
+
+    void readerLoop();
+    bool readFrame(uint8_t* data);
+
+    std::string path;
+    int fd = -1;
+    bool seekable = false;
+    size_t frame_size = 0;
+    std::vector<Buffer> buffers;
+    std::vector<int> free_buffers;
+    std::vector<int> filled;   // Oldest first
+    std::mutex mutex;
+    std::condition_variable frame_ready;
+    std::condition_variable buffer_free;
+    std::thread reader;
+    bool stopping = false;
+};
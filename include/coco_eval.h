@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "yolo.h"
+
+// One COCO box in image pixels, [x, y, w, h] like the annotation files
+struct CocoBox {
+    float x = 0, y = 0, w = 0, h = 0;
+    int category_id = 0;
+    float score = 1.0f;     // Detections only
+    float area = 0.0f;      // Ground truth: the annotation's area (segment area); detections use w * h
+    bool iscrowd = false;   // Ground truth only
+};
+
+// COCOeval.summarize() numbers: AP @[.5:.95], AP50, AP75, AP small/medium/large,
+// AR with 1/10/100 detections, AR small/medium/large. -1 where undefined.
+struct CocoStats {
+    double stats[12];
+
+    double ap() const { return stats[0]; }
+    double ap50() const { return stats[1]; }
+    // Line i (0-11) of the summary printed by pycocotools, without the newline
+    std::string line(int i) const;
+    // The twelve lines printed by pycocotools
+    std::string format() const;
+};
+
+// Bounding-box mAP/AR matching pycocotools COCOeval (iouType 'bbox',
+// default parameters) that streams over images.
+//
+// evaluateImage() matches one image's detections against its ground truth
+// at all ten IoU thresholds and four area ranges right away and keeps only
+// a compact record per counted detection (score, match and ignore bits), so
+// memory does not grow with the boxes, and nothing is serialized to JSON.
+// Only images passed to evaluateImage() are evaluated, so feed every image
+// of the set, including those without detections.
+class CocoEvaluator {
+public:
+    // Categories evaluated (the annotation file's category ids); detections
+    // of other categories are ignored
+    explicit CocoEvaluator(const std::vector<int>& category_ids);
+
+    void evaluateImage(const std::vector<CocoBox>& ground_truth, const std::vector<CocoBox>& detections);
+
+    // Add pipeline results, already in source image coordinates; class ids
+    // index category_map (e.g. coco80_to_coco91())
+    void evaluateImage(const std::vector<CocoBox>& ground_truth, const object_detect_result_list& results,
+                       const std::vector<int>& category_map);
+
+    CocoStats summarize() const;
+
+    size_t images() const { return image_count; }
+    size_t records() const;
+
+    // COCO category id of each of the 80 model classes
+    static const std::vector<int>& coco80_to_coco91();
+
+private:
+    static const int IOU_THRESHOLDS = 10;
+    static const int AREA_RANGES = 4;   // all, small, medium, large
+    static const int MAX_DETECTIONS = 100;
+
+    struct Record {
+        float score;
+        uint16_t matched;   // Bit t: true positive at IoU threshold t
+        uint16_t ignored;   // Bit t: neither true nor false positive at threshold t
+        uint8_t rank;       // Position among the image's detections of this category
+    };
+
+    struct Accumulator {
+        std::vector<Record> records;   // In evaluation order, which breaks score ties like pycocotools
+        uint64_t ground_truth = 0;     // Boxes not ignored
+    };
+
+    void evaluateCategory(int category, std::vector<const CocoBox*>& gts, std::vector<const CocoBox*>& dts);
+    // precision / recall for one category, area range, detection cap and threshold set
+    void accumulate(const Accumulator& acc, int max_dets, double* recall, double* precision) const;
+
+    std::vector<int> category_ids;
+    std::unordered_map<int, int> category_index;
+    std::vector<Accumulator> accumulators;   // [category][area range]
+    size_t image_count = 0;
+};
+
+// Ground truth of an instances_*.json file, grouped by image. Segmentation
+// polygons are skipped while parsing.
+struct CocoGroundTruth {
+    std::vector<int> category_ids;
+    std::unordered_map<std::string, int> image_ids;   // file_name -> image id
+    std::unordered_map<int, std::vector<CocoBox>> boxes;   // image id -> annotations
+};
+
+// Returns 0 on success, -1 if the file cannot be read or parsed
+int loadCocoAnnotations(const std::string& path, CocoGroundTruth* ground_truth);
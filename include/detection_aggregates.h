@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "yolo.h"
+
+#define PERSON_CLASS_ID 0
+
+// Aggregates a formatter can ask object_detect_result_list::aggregates() for
+enum AggregateFlags : unsigned {
+    AGGREGATE_PEOPLE = 1u << 0,         // People in frame, attending (confirmed tracks) and longest dwell
+    AGGREGATE_NONEMPTY = 1u << 1,       // Indices of detections kept by suppress_empty (score > 0, class != 0)
+};
+
+// Values derived from one detection list.
+//
+// Every formatter used to rescan the detections for what it reports (people
+// counts, the suppress_empty filter). The list now computes each aggregate
+// the first time one is asked for and keeps it behind a shared pointer, so
+// all copies of the result read the same instance. ResultBroadcast computes
+// the union of its subscribers' MessageFormatter::aggregatesNeeded() before
+// copying a result to them, so each scan happens once per result however
+// many sinks there are. Only the aggregates in the requested flags are
+// computed. Read-only once built.
+struct DetectionAggregates {
+    unsigned computed = 0;         // AggregateFlags present
+    int count = 0;                 // Detections and tracking state the values were built from
+    bool tracked = false;
+
+    int people_in_frame = 0;
+    int people_attending = 0;        // Confirmed tracks when tracked, else every person
+    float people_max_dwell_s = 0;
+    std::vector<int> nonempty;       // Indices into the list, in order
+
+    bool has(unsigned flags) const { return (computed & flags) == flags; }
+};
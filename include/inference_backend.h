@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rknn_api.h"
+#include "tensor_file.h"
+#include "tensor_layout.h"
+
+// NPU runtime used by init_yolo_model()/inference_yolo_model(). The methods
+// mirror the rknn_* calls they replace and return RKNN_SUCC or a negative
+// RKNN error code.
+class InferenceBackend {
+public:
+    virtual ~InferenceBackend() {}
+
+    virtual int init(const char* model_path) = 0;
+    virtual int query(rknn_query_cmd cmd, void* info, uint32_t size) = 0;
+    virtual int inputsSet(uint32_t n_inputs, rknn_input* inputs) = 0;
+    virtual int run() = 0;
+    virtual int outputsGet(uint32_t n_outputs, rknn_output* outputs) = 0;
+    virtual int outputsRelease(uint32_t n_outputs, rknn_output* outputs) = 0;
+
+    // Output buffers the NPU writes directly, bound with setIoMem() in the
+    // layout attr describes (e.g. RKNN_QUERY_NATIVE_OUTPUT_ATTR). Backends
+    // without them return NULL / RKNN_ERR_FAIL and outputsGet() is used.
+    virtual rknn_tensor_mem* createMem(uint32_t size) { return NULL; }
+    virtual int destroyMem(rknn_tensor_mem* mem) { return RKNN_ERR_FAIL; }
+    virtual int setIoMem(rknn_tensor_mem* mem, rknn_tensor_attr* attr) { return RKNN_ERR_FAIL; }
+    // Make what run() wrote to mem visible to the CPU
+    virtual int memSync(rknn_tensor_mem* mem) { return RKNN_SUCC; }
+
+    // Restrict run() to the NPU cores in core_mask (rknn_core_mask); a no-op
+    // where there is only one core
+    virtual int setCoreMask(uint32_t core_mask) { return RKNN_SUCC; }
+
+    // Underlying runtime context, 0 when there is none
+    virtual rknn_context context() const { return 0; }
+};
+
+#ifndef NO_RKNN_RUNTIME
+// The real NPU through librknnrt
+class RknnBackend : public InferenceBackend {
+public:
+    ~RknnBackend() override;
+
+    int init(const char* model_path) override;
+    int query(rknn_query_cmd cmd, void* info, uint32_t size) override;
+    int inputsSet(uint32_t n_inputs, rknn_input* inputs) override;
+    int run() override;
+    int outputsGet(uint32_t n_outputs, rknn_output* outputs) override;
+    int outputsRelease(uint32_t n_outputs, rknn_output* outputs) override;
+    rknn_tensor_mem* createMem(uint32_t size) override;
+    int destroyMem(rknn_tensor_mem* mem) override;
+    int setIoMem(rknn_tensor_mem* mem, rknn_tensor_attr* attr) override;
+    int memSync(rknn_tensor_mem* mem) override;
+    int setCoreMask(uint32_t core_mask) override;
+    rknn_context context() const override { return ctx; }
+
+private:
+    rknn_context ctx = 0;
+};
+#endif
+
+struct MockBackendOptions {
+    std::string recordings;    // .rkt file or directory of them (see --record-outputs)
+    float latency_ms = 30.0f;  // mean synthetic rknn_run() time
+    float jitter_ms = 3.0f;    // standard deviation of the run time
+    int max_frames = 200;      // recordings kept in memory, replayed in a loop
+    bool shared_npu = true;    // serialize run() across contexts like a single NPU core
+};
+
+// Replays recorded model outputs instead of running a model, so the whole
+// pipeline can be load tested on a machine without an NPU. Reports a
+// uint8 NHWC input of the recorded model size; the model file is ignored.
+// Quantized int8 outputs are also offered as NC1HWC2 native outputs, filled
+// from the recording by run() once bound with setIoMem().
+class MockRknnBackend : public InferenceBackend {
+public:
+    explicit MockRknnBackend(const MockBackendOptions& options);
+    ~MockRknnBackend() override;
+
+    int init(const char* model_path) override;
+    int query(rknn_query_cmd cmd, void* info, uint32_t size) override;
+    int inputsSet(uint32_t n_inputs, rknn_input* inputs) override;
+    int run() override;
+    int outputsGet(uint32_t n_outputs, rknn_output* outputs) override;
+    int outputsRelease(uint32_t n_outputs, rknn_output* outputs) override;
+    rknn_tensor_mem* createMem(uint32_t size) override;
+    int destroyMem(rknn_tensor_mem* mem) override;
+    int setIoMem(rknn_tensor_mem* mem, rknn_tensor_attr* attr) override;
+
+private:
+    struct BoundOutput {
+        rknn_tensor_mem* mem;
+        tensor_layout_t layout;
+    };
+
+    MockBackendOptions options;
+    std::vector<recorded_outputs_t> frames;
+    size_t next_frame = 0;
+    const recorded_outputs_t* current = nullptr;
+    std::vector<std::vector<float>> float_outputs;   // dequantized outputs for want_float
+    std::vector<BoundOutput> bound_outputs;          // by output index, mem NULL when unbound
+    std::mt19937 rng;
+
+    static std::mutex npu_mutex;
+};
+
+// Backend for contexts created by init_yolo_model(): the mock when one has
+// been configured, otherwise the real NPU. A NULL options pointer switches
+// back to the NPU.
+void set_default_mock_backend(const MockBackendOptions* options);
+std::unique_ptr<InferenceBackend> create_inference_backend();
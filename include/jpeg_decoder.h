@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct JpegDecodeInfo {
+    int width = 0;          // Decoded size
+    int height = 0;
+    int full_width = 0;     // Size stored in the file
+    int full_height = 0;
+    int scale_denom = 1;    // 1, 2, 4 or 8
+};
+
+// Decodes JPEG files straight to RGB888 at a reduced DCT scale.
+//
+// libjpeg can scale by 1/2, 1/4 or 1/8 inside the IDCT, which skips most of
+// the decode work for a large still that is letterboxed to a model input
+// anyway. decode() picks the smallest of those scales that still leaves the
+// image at least as large as its letterboxed size, so the resize that
+// follows never has to enlarge it. The decompressor and file buffer are
+// kept between images; use one decoder per thread.
+class JpegDecoder {
+public:
+    JpegDecoder();
+    ~JpegDecoder();
+
+    JpegDecoder(const JpegDecoder&) = delete;
+    JpegDecoder& operator=(const JpegDecoder&) = delete;
+
+    // Decode path for a min_width x min_height letterbox into rgb (resized,
+    // capacity reused). Returns -1 when the file is not a JPEG this path
+    // handles (other formats, CMYK, an EXIF orientation other than upright)
+    // or cannot be decoded; fall back to a general decoder then.
+    int decode(const std::string& path, int min_width, int min_height, std::vector<uint8_t>* rgb,
+               JpegDecodeInfo* info);
+
+    // The same for a file already read into memory
+    int decode(const uint8_t* data, size_t size, int min_width, int min_height, std::vector<uint8_t>* rgb,
+               JpegDecodeInfo* info);
+
+private:
+    struct State;
+    State* state;
+    std::vector<uint8_t> file;
+};
+
+// Largest of 1, 2, 4, 8 that keeps a width x height image at least as large
+// as its letterbox into min_width x min_height
+int jpeg_scale_denom(int width, int height, int min_width, int min_height);
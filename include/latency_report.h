@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+#include "metrics.h"
+#include "yolo.h"
+
+// steady_clock time as int64 nanoseconds, the clock of frame_timing_t
+inline int64_t monotonic_ns(std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now()) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+// Unix time in milliseconds
+inline int64_t wall_clock_ms(std::chrono::system_clock::time_point t = std::chrono::system_clock::now()) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+}
+
+// Wall clock milliseconds at a monotonic_ns() instant in the recent past
+int64_t wall_ms_at(int64_t monotonic);
+
+// Rolling glass-to-publish latency.
+//
+// ResultBroadcast::publish() records the frame_timing_t of every result as
+// it hands it to the publishers, so each frame counts once whatever the
+// number and rates of the sinks; formatting and sending per sink are the
+// Stage::Format and Stage::Send metrics. Each result's capture to publish
+// time goes into the cumulative
+// Stage::GlassToPublish histogram (Prometheus). It also goes into a
+// window that is logged and restarted every interval: percentiles of the
+// total and of its segments (capture to inference start, inference, and
+// inference end to publish, which covers tracking, queues and rate limits).
+// Results without a capture time are skipped. Safe to call from several
+// threads.
+class LatencyReport {
+public:
+    static LatencyReport& instance();
+
+    // Seconds between log reports, 0 to only feed the metrics registry
+    void setInterval(int interval_s);
+
+    void record(const frame_timing_t& timing);
+
+    // Log and restart the current window now
+    void report();
+
+private:
+    struct Window {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        LatencyHistogram total;
+        LatencyHistogram wait;
+        LatencyHistogram inference;
+        LatencyHistogram delivery;
+    };
+
+    std::unique_ptr<Window> swapWindow();
+    static void log(const Window& window);
+
+    std::mutex mutex;
+    int interval_s = 60;
+    std::unique_ptr<Window> window{new Window()};
+};
@@ -0,0 +1,67 @@
+#ifndef _BSEXT_LOG_H_
+#define _BSEXT_LOG_H_
+
+#include <stdint.h>
+#include <atomic>
+
+// Leveled, non-blocking logger.
+//
+// LOGx() formats into a slot of a fixed lock-free ring and returns; a
+// background thread drains the ring to stdout (debug/info) or stderr
+// (warn/error), so a slow console never stalls the inference thread. When
+// the ring is full messages are dropped and counted rather than waited for.
+// A call site repeating the same message is limited to LOG_SITE_BURST copies
+// per second; the number of suppressed repeats is reported with the next
+// message that gets through. Levels below LOG_MIN_LEVEL compile to nothing.
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#define LOG_SITE_BURST 5
+
+// Per call site rate-limit state, shared by every thread logging from the
+// site; relaxed atomics, so concurrent callers may let an extra copy through
+// but never race
+typedef struct log_site {
+    std::atomic<uint32_t> last_hash;
+    std::atomic<int64_t> window_start_ms;
+    std::atomic<int> count;
+    std::atomic<int> suppressed;
+} log_site_t;
+
+void log_write(int level, log_site_t *site, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+// Runtime threshold on top of LOG_MIN_LEVEL
+void log_set_level(int level);
+int log_parse_level(const char *name);   // "debug", "info", "warn", "error"; -1 if unknown
+
+// Write every level to stderr, keeping stdout for data (e.g. batch --output -)
+void log_set_stderr_only(bool enabled);
+
+// Block until everything queued so far has been written
+void log_flush();
+
+#define LOG_AT(level, fmt, ...)                                     \
+    do {                                                            \
+        if ((level) >= LOG_MIN_LEVEL) {                             \
+            static log_site_t _log_site;                            \
+            log_write((level), &_log_site, fmt, ##__VA_ARGS__);     \
+        }                                                           \
+    } while (0)
+
+#define LOGD(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOGI(fmt, ...) LOG_AT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOGW(fmt, ...) LOG_AT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOGE(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+#endif //_BSEXT_LOG_H_
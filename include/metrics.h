@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+
+// Pipeline stages with a latency histogram
+enum class Stage {
+    Capture,
+    Letterbox,
+    InputsSet,
+    Run,
+    OutputsGet,
+    Decode,
+    Sort,
+    Nms,
+    Format,
+    Send,
+    GlassToPublish,
+    Count
+};
+
+// Event counters
+enum class Counter {
+    Frames,             // Frames that went through inference_yolo_model
+    Candidates,         // Boxes above threshold before NMS
+    Detections,         // Boxes after NMS
+    DroppedFrames,      // Frames never inferred or shown: stale camera buffers, replay skips, preview drops
+    CacheHits,          // Results served from the result cache
+    CacheMisses,        // Result cache lookups that had to run inference
+    MessagesSent,       // Messages handed to a publisher transport
+    MessagesSuppressed, // Results a change-only publisher did not send
+    Count
+};
+
+// Instantaneous values
+enum class Gauge {
+    QueueDepth,         // Decoded images waiting in the batch pipeline
+    Count
+};
+
+// Lock-free log-linear latency histogram (HDR style).
+//
+// Values are nanoseconds. Each power of two is split into 16 linear
+// sub-buckets, giving ~6% relative precision from 1 ns to hours with a
+// fixed 1024-entry array. record() is a handful of relaxed atomic adds and
+// safe from any thread.
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKETS = 64 * SUB_BUCKETS;
+
+    void record(uint64_t ns);
+
+    uint64_t count() const { return total_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return total_sum.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_value.load(std::memory_order_relaxed); }
+
+    // Approximate value at quantile q (0..1), in nanoseconds
+    uint64_t percentile(double q) const;
+
+private:
+    static int bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperBound(int index);
+
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    std::atomic<uint64_t> total_count{0};
+    std::atomic<uint64_t> total_sum{0};
+    std::atomic<uint64_t> max_value{0};
+};
+
+// Process-wide metrics registry
+class Metrics {
+public:
+    static Metrics& instance();
+
+    void record(Stage stage, uint64_t ns) { stages[(int)stage].record(ns); }
+    void add(Counter counter, uint64_t n = 1) { counters[(int)counter].fetch_add(n, std::memory_order_relaxed); }
+    void set(Gauge gauge, int64_t value) { gauges[(int)gauge].store(value, std::memory_order_relaxed); }
+
+    const LatencyHistogram& histogram(Stage stage) const { return stages[(int)stage]; }
+
+    // Prometheus text exposition format
+    std::string toPrometheus() const;
+
+    static const char* stageName(Stage stage);
+
+private:
+    LatencyHistogram stages[(int)Stage::Count];
+    std::atomic<uint64_t> counters[(int)Counter::Count] = {};
+    std::atomic<int64_t> gauges[(int)Gauge::Count] = {};
+};
+
+// Records the lifetime of the enclosing scope into a stage histogram
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(Stage stage)
+        : stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer() {
+        Metrics::instance().record(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    Stage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Periodically publishes the registry as a Prometheus text file (written
+// atomically via rename) and/or a UDP datagram to 127.0.0.1:udp_port from
+// its own thread. Destruction stops the thread after a final export.
+class MetricsExporter {
+public:
+    MetricsExporter(const std::string& file_path, int udp_port, int interval_ms = 10000);
+    ~MetricsExporter();
+
+    void start();
+    void stop();
+
+private:
+    void run();
+    void exportOnce();
+
+    std::thread thread;
+
+    std::string file_path;
+    int udp_port;
+    int interval_ms;
+    int udp_socket = -1;
+
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
+};
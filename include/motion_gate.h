@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <vector>
+
+#include "common.h"
+#include "yolo.h"
+#include "yuv_letterbox.h"
+
+struct MotionGateOptions {
+    int thumb_width = 64;          // Downscaled luma thumbnail used for differencing; each
+    int thumb_height = 36;         // thumbnail pixel is the mean of one block of the frame
+    int threshold = 6;             // Change of a block's mean luma (0-255) that counts as motion there
+    int min_changed_blocks = 1;    // Blocks that must change for the frame to count as motion
+    int min_interval_ms = 0;       // Inference interval while there is motion (0 = every frame)
+    int max_interval_ms = 2000;    // Longest interval the gate backs off to on a static scene
+};
+
+// Cheap scene-change gate in front of the NPU.
+//
+// Each frame is reduced to a small luma thumbnail by averaging every block
+// of the frame, and compared (NEON or SSE2 when available) block by block
+// against the thumbnail of the last frame that was actually inferred. A
+// small mover shifts the mean of the few blocks it crosses well past the
+// sensor noise, which the averaging suppresses, so the gate counts changed
+// blocks rather than averaging the change over the whole frame.
+//
+// Motion runs inference at min_interval_ms; on a static scene the interval
+// doubles after every inference up to max_interval_ms, and the previous
+// results are reused for the skipped frames (flagged reused, so the tracker
+// predicts on them instead of re-matching).
+class MotionGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit MotionGate(const MotionGateOptions& options = MotionGateOptions());
+
+    // True if this frame should go to the NPU
+    bool shouldInfer(const image_buffer_t* img, Clock::time_point now);
+    bool shouldInfer(const YuvFrame* frame, Clock::time_point now);
+
+    // Record the results of an inferred frame, replayed on skipped frames
+    void remember(const object_detect_result_list& results) { last_results = results; }
+    const object_detect_result_list& lastResults() const { return last_results; }
+
+    // Blocks of the last frame that changed against the reference
+    int lastChangedBlocks() const { return last_changed; }
+
+private:
+    void makeThumbnail(const image_buffer_t* img, uint8_t* out);
+    void makeThumbnail(const YuvFrame* frame, uint8_t* out);
+    bool compare(Clock::time_point now);
+
+    MotionGateOptions options;
+    std::vector<uint8_t> reference;   // Thumbnail of the last inferred frame
+    std::vector<uint8_t> current;
+    std::vector<uint32_t> column_sums;   // Per-column luma totals of one thumbnail row
+    bool has_reference = false;
+    int interval_ms;
+    Clock::time_point last_inference;
+    int last_changed = 0;
+    object_detect_result_list last_results;
+};
+
+// Gate applied by init_yolo_model() to new contexts (NULL disables gating)
+void set_default_motion_gate(const MotionGateOptions* options);
+const MotionGateOptions* get_default_motion_gate();
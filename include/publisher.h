@@ -2,19 +2,58 @@
 
 #include <string>
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 
+#include "detection_aggregates.h"
 #include "inference.h"
+#include "result_broadcast.h"
 #include "transport.h"
 
 using json = nlohmann::json;
 
+// Serialize a detection list as {"count": N, "results": [...]}.
+// With suppress_empty, detections with a zero score or class id 0 are dropped.
+json detectionsToJson(const object_detect_result_list& detections, bool suppress_empty = false);
+
+// Change-only publishing: a Publisher with these options enabled sends a
+// result only when what its formatter reports changed beyond the hysteresis
+// since the last message it sent, plus a full keyframe at least every
+// keyframe_interval_ms so a consumer that joins late (or missed a datagram)
+// catches up. Unchanged results are dropped without waiting out the rate
+// limit, so a real change goes out on the next frame. Publishers using it
+// must each see the whole result stream: subscribe them to a
+// ResultBroadcast rather than sharing one queue.
+struct ChangeOptions {
+    bool enabled = false;
+    int keyframe_interval_ms = 10000;
+    int count_hysteresis = 0;      // Counts must move by more than this
+    int box_hysteresis_px = 8;     // A box edge must move by more than this
+    bool box_deltas = false;       // Between keyframes, send boxes as deltas against the last message
+};
+
 // Abstract message formatter interface
 class MessageFormatter {
 public:
     virtual ~MessageFormatter() = default;
     virtual std::string formatMessage(const InferenceResult& result) = 0;
+
+    // AggregateFlags this formatter reads through result.detections.aggregates()
+    virtual unsigned aggregatesNeeded() const { return 0; }
+
+    // True if the message for current differs from the one for previous
+    // beyond options' hysteresis. By default: the detection count.
+    virtual bool changed(const InferenceResult& previous, const InferenceResult& current,
+                         const ChangeOptions& options);
+
+    // Message for current encoded against previous, the last message sent.
+    // Formatters without a delta encoding send the full message.
+    virtual std::string formatDelta(const InferenceResult& previous, const InferenceResult& current) {
+        return formatMessage(current);
+    }
 };
 
 // Concrete implementation of MessageFormatter for JSON format
@@ -25,20 +64,38 @@ private:
 public:
     explicit JsonMessageFormatter(bool suppress_empty = false) : suppress_empty(suppress_empty) {}
     std::string formatMessage(const InferenceResult& result) override;
+    unsigned aggregatesNeeded() const override { return suppress_empty ? AGGREGATE_NONEMPTY : 0; }
+
+    // Changed when the count changes or any box appears, disappears,
+    // changes class or moves an edge by more than box_hysteresis_px
+    bool changed(const InferenceResult& previous, const InferenceResult& current,
+                 const ChangeOptions& options) override;
+
+    // {"delta": true, ...}: each result is either a full object or
+    // {"prev": i, "box_delta": {...}, "score": s} relative to result i of
+    // the previous message (matched by track id, else nearest box of the
+    // same class)
+    std::string formatDelta(const InferenceResult& previous, const InferenceResult& current) override;
 };
 
 // Concrete implementation of MessageFormatter for BrightScript variable format
-//  e.g. "faces_attending:0!!faces_in_frame_total:0!!timestamp:1746732409"
+//  e.g. "faces_attending:0!!faces_in_frame_total:0!!timestamp:1746732409!!timestamp_ms:1746732409123"
 class BSVariableMessageFormatter : public MessageFormatter {
 public:
     std::string formatMessage(const InferenceResult& result) override;
 };
 
 // Concrete implementation for faces JSON format (UDP port 5002)
-// Maps people count to faces_* properties
+// Maps people count to faces_* properties; with a TrackerStage upstream,
+// faces_attending counts only confirmed tracks and faces_dwell_max is reported
+// Changes are people counts only; faces_dwell_max grows on every frame and
+// is refreshed by keyframes
 class FacesJsonMessageFormatter : public MessageFormatter {
 public:
     std::string formatMessage(const InferenceResult& result) override;
+    unsigned aggregatesNeeded() const override { return AGGREGATE_PEOPLE; }
+    bool changed(const InferenceResult& previous, const InferenceResult& current,
+                 const ChangeOptions& options) override;
 };
 
 // Concrete implementation for faces BrightScript format (UDP port 5000)  
@@ -46,6 +103,9 @@ public:
 class FacesBSMessageFormatter : public MessageFormatter {
 public:
     std::string formatMessage(const InferenceResult& result) override;
+    unsigned aggregatesNeeded() const override { return AGGREGATE_PEOPLE; }
+    bool changed(const InferenceResult& previous, const InferenceResult& current,
+                 const ChangeOptions& options) override;
 };
 
 
@@ -58,17 +118,40 @@ public:
         std::atomic<bool>& isRunning,
         std::shared_ptr<MessageFormatter> formatter,
         int messages_per_second = 1);
+
+    // Take results from a subscription of broadcast
+    Publisher(
+        std::shared_ptr<Transport> transport,
+        ResultBroadcast& broadcast,
+        std::atomic<bool>& isRunning,
+        std::shared_ptr<MessageFormatter> formatter,
+        int messages_per_second = 1);
     
     ~Publisher() = default;
     
     void operator()();
 
+    // Return from operator() after this many messages have been sent (0 = unlimited)
+    void setMessageLimit(int limit) { message_limit = limit; }
+
+    // Send only changed results, see ChangeOptions
+    void setChangeOptions(const ChangeOptions& options) { change = options; }
+
+    // Interrupt the rate-limit wait so the publisher exits without delay
+    void stop();
+
 private:
     std::shared_ptr<Transport> transport;
-    ThreadSafeQueue<InferenceResult>& resultQueue;
+    std::function<bool(InferenceResult&)> nextResult;   // Blocks for the next result, false at shutdown
     std::atomic<bool>& running;
     int target_mps;
     std::shared_ptr<MessageFormatter> formatter;
+    int message_limit = 0;
+    ChangeOptions change;
+
+    std::mutex stop_mutex;
+    std::condition_variable stop_cv;
+    bool stopping = false;
 };
 
 // Backward compatibility: UDPPublisher using transport injection
@@ -81,4 +164,12 @@ public:
         std::atomic<bool>& isRunning,
         std::shared_ptr<MessageFormatter> formatter,
         int messages_per_second = 1);
+
+    UDPPublisher(
+        const std::string& ip,
+        const int port,
+        ResultBroadcast& broadcast,
+        std::atomic<bool>& isRunning,
+        std::shared_ptr<MessageFormatter> formatter,
+        int messages_per_second = 1);
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <opencv2/opencv.hpp>
+
+#include "async_frame_writer.h"
+#include "inference.h"
+#include "queue.h"
+
+struct ReplayOptions {
+    bool loop = true;       // Start over at the end of the file
+    bool realtime = true;   // Pace frames at the file's frame rate; false = as fast as inference allows
+    int max_frames = 0;     // Stop after this many frames (0 = until interrupted or end of file)
+};
+
+// Plays a recorded video file as if it were a live camera: frames arrive at
+// the recorded frame rate (frames that fall behind are skipped, like a
+// camera overwriting an unread buffer) and the file loops.
+class RecordedVideoSource {
+public:
+    RecordedVideoSource(const std::string& path, const ReplayOptions& options);
+
+    bool isOpened() const { return capture.isOpened(); }
+
+    // Next frame (BGR, as cv::VideoCapture returns it); false at end of
+    // file without loop, or on error
+    bool read(cv::Mat& frame);
+
+    uint64_t skippedFrames() const { return skipped; }
+
+private:
+    bool grab();
+
+    cv::VideoCapture capture;
+    ReplayOptions options;
+    std::chrono::steady_clock::duration frame_interval{0};
+    std::chrono::steady_clock::time_point next_due;
+    bool started = false;
+    uint64_t skipped = 0;
+};
+
+// Capture and inference stage for a recorded video, a drop-in for
+// MLInferenceThread in the video pipeline. Combined with the mock NPU
+// backend (set_default_mock_backend) the full capture-to-publish pipeline
+// runs on any Linux machine. Logs throughput and frame latency percentiles
+// when it finishes, then calls onFinished.
+class ReplayInferenceThread {
+public:
+    ReplayInferenceThread(
+        const std::string& model_path,
+        const std::string& video_path,
+        ThreadSafeQueue<InferenceResult>& outputQueue,
+        std::atomic<bool>& isRunning,
+        const ReplayOptions& options,
+        std::shared_ptr<AsyncFrameWriter> frameWriter,
+        std::function<void()> onFinished = nullptr);
+
+    void operator()();
+
+private:
+    std::string model_path;
+    std::string video_path;
+    ThreadSafeQueue<InferenceResult>& outputQueue;
+    std::atomic<bool>& running;
+    ReplayOptions options;
+    std::shared_ptr<AsyncFrameWriter> frameWriter;
+    std::function<void()> onFinished;
+};
+
+// True for file names with a common video container extension
+bool isVideoFile(const std::string& path);
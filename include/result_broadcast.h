@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "inference.h"
+#include "queue.h"
+
+// Hands every result to each of several publishers.
+//
+// Publishers popping one shared ThreadSafeQueue each get a different
+// result, so a change-only publisher would compare frames that are not
+// consecutive and never see a change another publisher popped. Each
+// subscriber here has its own latest-result slot: publish() copies the
+// result into every slot without blocking, replacing one the subscriber has
+// not taken yet (a rate-limited publisher samples the stream), and take()
+// waits for the next. Safe to use from several threads.
+//
+// publish() first computes the detection aggregates every subscriber asked
+// for, so the copies share one DetectionAggregates instead of each
+// publisher thread scanning the detections again. It also records the
+// result's glass-to-publish latency, once per result (see LatencyReport).
+class ResultBroadcast {
+public:
+    // Register a subscriber before results are published; returns its id.
+    // aggregates: the AggregateFlags its formatter reads
+    int subscribe(unsigned aggregates = 0);
+
+    void publish(const InferenceResult& result);
+
+    // Publish everything popped from queue until it shuts down
+    void pump(ThreadSafeQueue<InferenceResult>& queue);
+
+    // Block until a result subscriber has not taken yet arrives; false once
+    // signalShutdown() has been called
+    bool take(int subscriber, InferenceResult& result);
+
+    void signalShutdown();
+
+private:
+    struct Slot {
+        bool full = false;
+        InferenceResult result;
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<Slot> slots;
+    unsigned aggregates_needed = 0;   // Union over the subscribers
+    bool shutdown = false;
+};
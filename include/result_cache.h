@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "yolo.h"
+
+#define RESULT_CACHE_SLOT_BOXES 64   // Detections an on-disk index slot holds; larger results stay in memory only
+
+struct ResultCacheOptions {
+    size_t capacity = 1024;       // Results kept in memory (LRU), 0 disables the cache
+    std::string index_path;       // Persistent mmap'd index shared across runs, empty for memory only
+    int index_slots = 4096;       // Direct-mapped slots in the index file (about 1.5 KB each)
+};
+
+// Content-addressed cache of detection results.
+//
+// Results are keyed by a 64-bit hash of the image file's bytes combined
+// with a configuration id (model contents, thresholds, detection cap), so
+// an identical still submitted again skips decode, NPU and post-processing
+// and a different model or threshold never sees stale boxes. Lookups go to
+// an in-memory LRU first and then, when index_path is set, to a
+// direct-mapped index file mapped with mmap, which keeps results across
+// runs; a slot written by another configuration or an older entry that
+// hashed to the same slot is simply a miss. Hits and misses are counted in
+// the metrics registry. Safe to use from several threads.
+class ResultCache {
+public:
+    ResultCache(const ResultCacheOptions& options, uint64_t config_id);
+    ~ResultCache();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // Copy the results cached for content_hash into results; false on a miss
+    bool lookup(uint64_t content_hash, object_detect_result_list* results);
+    void insert(uint64_t content_hash, const object_detect_result_list& results);
+
+    uint64_t hits() const { return hit_count; }
+    uint64_t misses() const { return miss_count; }
+
+private:
+    struct IndexHeader;
+    struct IndexSlot;
+
+    uint64_t key(uint64_t content_hash) const;
+    void openIndex();
+    IndexSlot* slot(uint64_t key) const;
+    bool readSlot(uint64_t key, object_detect_result_list* results) const;
+    void writeSlot(uint64_t key, const object_detect_result_list& results);
+    void remember(uint64_t key, const object_detect_result_list& results);
+
+    ResultCacheOptions options;
+    uint64_t config_id;
+
+    std::mutex mutex;
+    std::list<std::pair<uint64_t, object_detect_result_list>> lru;   // Most recently used first
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, object_detect_result_list>>::iterator> entries;
+    uint64_t hit_count = 0;
+    uint64_t miss_count = 0;
+
+    void* index = nullptr;        // Mapped index file, NULL without one
+    size_t index_size = 0;
+};
+
+// 64-bit xxHash (XXH64) of data; several GB/s, so hashing a still costs far
+// less than decoding it
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+// hash64() of a file's contents, 0 if it cannot be read
+uint64_t hash_file(const std::string& path, uint64_t seed = 0);
@@ -0,0 +1,31 @@
+#pragma once
+
+// Event-driven process supervisor.
+//
+// SIGINT, SIGTERM and SIGHUP are blocked for the whole process and delivered
+// through a signalfd, so construct the Supervisor before any worker thread is
+// started (threads inherit the blocked mask). Worker threads wake the
+// supervisor through notify(), e.g. when a single-shot run has completed.
+class Supervisor {
+public:
+    Supervisor();
+    ~Supervisor();
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    bool isValid() const { return epoll_fd >= 0; }
+
+    // Wake up wait() from any thread
+    void notify();
+
+    // Block until a signal arrives, notify() is called or timeout_ms elapses
+    // (-1 waits forever). Returns the signal number, 0 for notify() and -1 on
+    // timeout or error.
+    int wait(int timeout_ms = -1);
+
+private:
+    int signal_fd = -1;
+    int event_fd = -1;
+    int epoll_fd = -1;
+};
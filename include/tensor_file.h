@@ -0,0 +1,36 @@
+#ifndef _BSEXT_TENSOR_FILE_H_
+#define _BSEXT_TENSOR_FILE_H_
+
+#include "rknn_api.h"
+#include "yolo.h"
+
+// Recorded model outputs: the tensor attributes needed by post_process()
+// plus the raw output buffers of one frame, so post-processing can be
+// replayed without an NPU.
+//
+// File layout (little endian):
+//   "RKNNOUT1" | u32 n_output | i32 model_width | i32 model_height |
+//   i32 model_type | i32 is_quant
+//   per output: u32 n_dims | u32 dims[4] | i32 fmt | i32 type |
+//               i32 qnt_type | i32 zp | f32 scale | u32 size | size bytes
+typedef struct {
+    int model_width;
+    int model_height;
+    yolo_model_type_t model_type;
+    bool is_quant;
+    rknn_input_output_num io_num;
+    rknn_tensor_attr *output_attrs;   // io_num.n_output entries
+    void **buffers;                   // io_num.n_output buffers, output_attrs[i].size bytes each
+} recorded_outputs_t;
+
+// Write one frame's outputs as returned by rknn_outputs_get()
+int save_output_tensors(const char *path, const rknn_app_context_t *app_ctx, const rknn_output *outputs);
+
+int load_output_tensors(const char *path, recorded_outputs_t *recorded);
+void release_output_tensors(recorded_outputs_t *recorded);
+
+// Fill an app context and rknn_output array (io_num.n_output entries) that
+// point into the recording, ready to pass to post_process()
+void recorded_outputs_to_context(const recorded_outputs_t *recorded, rknn_app_context_t *app_ctx, rknn_output *outputs);
+
+#endif //_BSEXT_TENSOR_FILE_H_
@@ -0,0 +1,54 @@
+#ifndef _BSEXT_TENSOR_LAYOUT_H_
+#define _BSEXT_TENSOR_LAYOUT_H_
+
+#include <stddef.h>
+
+#include "rknn_api.h"
+
+#define TENSOR_LAYOUT_MAX_CHANNELS 128
+#define END2END_FIELDS 6   // x1, y1, x2, y2, score, class
+
+// Element offsets of a [1, C, H, W] output in its memory layout: channel c of
+// grid cell (i * grid_w + j) is at plane[c] + cell * cell_step.
+//
+//   NCHW     plane[c] = c * H * W              cell_step = 1
+//   NHWC     plane[c] = c                      cell_step = C (padded)
+//   NC1HWC2  plane[c] = (c / C2) * H * W * C2 + c % C2
+//                                              cell_step = C2
+//
+// The NPU writes NC1HWC2 (RK3588) or NHWC natively; the interleaved layouts
+// keep all channels of a cell within a few cache lines.
+typedef struct {
+    rknn_tensor_format fmt;
+    int channels;
+    int grid_h;
+    int grid_w;
+    int cell_step;
+    int plane[TENSOR_LAYOUT_MAX_CHANNELS];
+} tensor_layout_t;
+
+// Channels and grid size of an output from its standard (NCHW) attributes
+void output_shape(const rknn_tensor_attr *attr, int *channels, int *grid_h, int *grid_w);
+
+// Detection count and element strides of an end-to-end output, [1, K, 6]
+// (box_step = 6, field_step = 1) or [1, 6, K] (box_step = 1, field_step = K),
+// with any further unit dims. Returns -1 for any other shape.
+int end2end_output_shape(const rknn_tensor_attr *attr, int *count, int *box_step, int *field_step);
+
+// Layout of a [1, channels, grid_h, grid_w] output stored as layout_attr
+// describes (from RKNN_QUERY_NATIVE_*_OUTPUT_ATTR), or NCHW when layout_attr
+// is NULL. Returns -1 for formats other than NCHW, NHWC and NC1HWC2, and for
+// native layouts whose rows or planes are padded (w_stride != grid_w or
+// h_stride != grid_h).
+int tensor_layout_init(const rknn_tensor_attr *layout_attr, int channels, int grid_h, int grid_w,
+                       tensor_layout_t *layout);
+
+// Attributes of attr's output stored as fmt, like the runtime reports for
+// native outputs (C2 = 16 for 8-bit types, 8 otherwise)
+void native_output_attr(const rknn_tensor_attr *attr, rknn_tensor_format fmt, rknn_tensor_attr *native);
+
+// Copy between NCHW order and the layout; padding channels are zeroed
+void tensor_layout_to_nchw(const tensor_layout_t *layout, const void *src, void *dst, size_t elem_size);
+void tensor_layout_from_nchw(const tensor_layout_t *layout, const void *src, void *dst, size_t elem_size);
+
+#endif //_BSEXT_TENSOR_LAYOUT_H_
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "inference.h"
+#include "queue.h"
+#include "yolo.h"
+
+struct TrackerOptions {
+    float iou_threshold = 0.3f;   // Minimum IoU between prediction and detection to associate
+    int min_hits = 3;             // Matched frames before a track is confirmed
+    int max_missed = 15;          // Frames a track survives without a match
+    int max_tracks = 256;         // Size of the preallocated track pool
+};
+
+// SORT-style multi-object tracker.
+//
+// Each track runs a constant-velocity Kalman filter on its box centre and a
+// smoothed size. Association is greedy on IoU: candidate (track, detection)
+// pairs are found with a sweep over box x-extents and sorted by IoU, so the
+// cost is O(n log n) plus the number of overlapping pairs. Tracks live in a
+// fixed pool allocated up front; nothing is allocated per frame once the
+// scratch vectors have grown.
+class ObjectTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ObjectTracker(const TrackerOptions& options = TrackerOptions());
+
+    // Associate detections with tracks and fill detections.tracks
+    void update(object_detect_result_list& detections, Clock::time_point now);
+
+    // Advance all tracks one frame without a detector pass and write the
+    // predicted boxes of those matched on the last pass to out. Used for
+    // frames the motion gate kept from the NPU.
+    void predict(object_detect_result_list& out, Clock::time_point now);
+
+private:
+    struct Axis {
+        float pos, vel;
+        float p00, p01, p11;   // 2x2 covariance
+    };
+
+    struct Track {
+        bool active = false;
+        int id = 0;
+        int cls_id = 0;
+        float prop = 0;
+        int age = 0;
+        int hits = 0;
+        int missed = 0;
+        Axis cx, cy;
+        float w = 0, h = 0;
+        Clock::time_point first_seen;
+    };
+
+    struct Candidate {
+        float iou;
+        int track;
+        int detection;
+    };
+
+    void predictTrack(Track& track);
+    void correctTrack(Track& track, const box_rect_t& box, float prop);
+    int startTrack(const box_rect_t& box, int cls_id, float prop, Clock::time_point now);
+    box_rect_t trackBox(const Track& track) const;
+    track_info_t trackInfo(const Track& track, Clock::time_point now) const;
+    void findCandidates(const object_detect_result_list& detections);
+
+    TrackerOptions options;
+    std::vector<Track> pool;
+    std::vector<int> free_slots;
+    int next_id = 1;
+
+    // Per-frame scratch, reused across frames
+    std::vector<box_rect_t> predicted;
+    std::vector<int> active;
+    std::vector<Candidate> candidates;
+    std::vector<int> track_match;
+    std::vector<int> detection_match;
+    std::vector<std::pair<int, int>> sweep;   // (left, index) with index < 0 for detections
+    std::vector<int> open_tracks;
+    std::vector<int> open_detections;
+};
+
+// Pipeline stage between inference and the publishers: pops raw results,
+// attaches track ids, ages and dwell times, and forwards them. Results the
+// motion gate reused are replaced by the tracks' predictions.
+class TrackerStage {
+public:
+    TrackerStage(
+        ThreadSafeQueue<InferenceResult>& input,
+        ThreadSafeQueue<InferenceResult>& output,
+        std::atomic<bool>& isRunning,
+        const TrackerOptions& options = TrackerOptions());
+
+    void operator()();
+
+private:
+    ThreadSafeQueue<InferenceResult>& inputQueue;
+    ThreadSafeQueue<InferenceResult>& outputQueue;
+    std::atomic<bool>& running;
+    ObjectTracker tracker;
+};
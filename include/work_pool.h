@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads for short data-parallel jobs such as decoding one
+// frame's outputs.
+//
+// run() hands each thread a contiguous share of the tasks and has the
+// calling thread work alongside the pool. A thread that runs out of its own
+// tasks steals from the back of another thread's queue, so one slow band of
+// rows does not leave the other cores idle. Threads sleep between jobs.
+class WorkPool {
+public:
+    explicit WorkPool(int threads);
+    ~WorkPool();
+
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    // Worker threads, not counting the thread calling run()
+    int threads() const { return (int)workers.size(); }
+
+    // Call fn(task, slot) for every task in [0, n_tasks) and return when all
+    // have finished. slot, in [0, threads()], identifies the thread running
+    // the task (threads() is the caller) for per-thread scratch buffers.
+    // Concurrent run() calls are serialized.
+    void run(int n_tasks, const std::function<void(int task, int slot)>& fn);
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(int slot);
+    bool runOne(int slot);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;   // One per slot
+    const std::function<void(int, int)>* job = nullptr;
+    std::atomic<int> pending{0};
+
+    std::mutex run_mutex;   // One job at a time
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
@@ -1,24 +1,37 @@
 #ifndef _RKNN_DEMO_MOBILENET_H_
 #define _RKNN_DEMO_MOBILENET_H_
 
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
 #include "rknn_api.h"
 #include "common.h"
 
 #define BOX_THRESH 0.25   // Default box confidence threshold
 #define NMS_THRESH 0.45   // Default NMS threshold
 #define OBJ_CLASS_NUM 80
-#define OBJ_NUMB_MAX_SIZE 128
+#define OBJ_NUMB_MAX_SIZE 128   // Default cap on detections per frame, see set_default_max_detections()
 #define OBJ_NAME_MAX_SIZE 64
 
+class InferenceBackend;
+class MotionGate;
+class YuvLetterbox;
+struct YuvFrame;
+struct DetectionAggregates;
+struct quant_decode_tables;
+
 // YOLO model type enumeration
 typedef enum {
     YOLO_STANDARD,    // Standard YOLO with DFL encoding and separate box/score tensors
     YOLO_SIMPLIFIED,  // Simplified YOLO with unified tensors and objectness scoring
+    YOLO_END2END,     // NMS-free head (YOLOv10 one-to-one) with a single float [1, K, 6] top-K output
     YOLO_UNKNOWN     // Unknown or unsupported model type
 } yolo_model_type_t;
 
 typedef struct {
-    rknn_context rknn_ctx;
+    rknn_context rknn_ctx;         // Runtime context of the real NPU backend, 0 for the mock
+    InferenceBackend *backend;     // Owns the model; all NPU calls go through it
     rknn_input_output_num io_num;
     rknn_tensor_attr *input_attrs;
     rknn_tensor_attr *output_attrs;
@@ -27,6 +40,13 @@ typedef struct {
     int model_height;
     bool is_quant;
     yolo_model_type_t model_type;  // Detected YOLO model type
+    int max_detections;            // Cap on detections kept per frame after NMS (0 = unlimited)
+    MotionGate *motion_gate;       // Skips NPU runs on static scenes, NULL when disabled
+    YuvLetterbox *yuv_letterbox;   // Camera-format preprocessing, created by the first inference_yolo_model_yuv()
+    bool integer_decode;           // Decode quantized outputs in the integer domain, see set_default_integer_decode()
+    quant_decode_tables *decode_tables;   // Lookup tables of the integer decode, built by post_process() on demand
+    rknn_tensor_attr *native_output_attrs;   // Layout of outputs bound in the NPU's native format, NULL when standard
+    rknn_tensor_mem **native_output_mems;    // Output buffers the NPU writes in that layout, see set_default_native_outputs()
 } rknn_app_context_t;
 
 typedef struct box_rect_t {
@@ -40,18 +60,141 @@ typedef struct object_detect_result {
     box_rect_t box;
     float prop;
     int cls_id;
-    char name[OBJ_NAME_MAX_SIZE];
+    const char *name;   ///< Resolved through the label table, never NULL
 } object_detect_result_t;
 
+// Tracker state for one detection, filled in by ObjectTracker
+typedef struct track_info {
+    int id;          ///< Stable id while the object stays in view
+    int age;         ///< Frames since the track was created
+    float dwell_s;   ///< Seconds since the track was created
+    bool confirmed;  ///< Matched in enough frames to be trusted
+} track_info_t;
+
+// When a frame went through the pipeline: steady_clock nanoseconds (see
+// latency_report.h), 0 where a stage did not record one
+typedef struct frame_timing {
+    int64_t capture_ns;           ///< Frame captured (driver timestamp when the camera has one)
+    int64_t inference_start_ns;   ///< Handed to inference_yolo_model()
+    int64_t inference_end_ns;     ///< Detections ready
+    int64_t publish_ns;           ///< Formatted for sending by a Publisher
+    int64_t capture_wall_ms;      ///< Wall clock (Unix ms) at capture, to correlate with video
+} frame_timing_t;
+
+// Variable-length detection results, stored as parallel arrays (boxes,
+// scores, class ids). Copying costs O(count) rather than a fixed-size array,
+// and clear() keeps the allocated capacity so a list reused across frames
+// stops allocating once it has grown to the scene's size.
+//
+// This replaced a POD with a results[OBJ_NUMB_MAX_SIZE] array of
+// object_detect_result_fixed_t. The list is no longer trivially copyable:
+// never memset() or memcpy() it. Code written against the old layout reads
+// at(i) (or boxes/props/cls_ids) instead of results[i], or converts with
+// export_detect_results().
 typedef struct object_detect_result_list {
-    int count;
-    object_detect_result_t results[OBJ_NUMB_MAX_SIZE];
+    int count = 0;
+    std::vector<box_rect_t> boxes;
+    std::vector<float> props;
+    std::vector<int> cls_ids;
+    std::vector<track_info_t> tracks;   // Empty, or one entry per detection once tracked
+    mutable std::shared_ptr<const DetectionAggregates> aggregates_cache;   // Shared by copies, see aggregates()
+    frame_timing_t timing = {};   // Set by the producer after inference; kept by clear() and the tracker
+    bool reused = false;          // Motion gate skipped the NPU; these are the last inferred frame's results
+
+    void clear() {
+        count = 0;
+        boxes.clear();
+        props.clear();
+        cls_ids.clear();
+        tracks.clear();
+        aggregates_cache.reset();
+        reused = false;
+    }
+
+    void reserve(int n) {
+        boxes.reserve(n);
+        props.reserve(n);
+        cls_ids.reserve(n);
+    }
+
+    void push_back(const box_rect_t &box, float prop, int cls_id) {
+        boxes.push_back(box);
+        props.push_back(prop);
+        cls_ids.push_back(cls_id);
+        count++;
+        aggregates_cache.reset();
+    }
+
+    // Per-class counts, filtered indices and extents (AggregateFlags, see
+    // detection_aggregates.h), computed on first use and then shared
+    // read-only by every formatter and every copy of the list. Code that
+    // edits boxes, classes or tracks in place calls invalidateAggregates().
+    const DetectionAggregates &aggregates(unsigned needed) const;
+    void invalidateAggregates() { aggregates_cache.reset(); }
+
+    // Detection i with its class name looked up in the label table
+    object_detect_result_t at(int i) const;
 } object_detect_result_list;
 
+// The fixed-size layout object_detect_result_list had before it became
+// variable length, for consumers that still memset, memcpy or index
+// results[] (model zoo style code, C interfaces)
+typedef struct object_detect_result_fixed {
+    box_rect_t box;
+    float prop;
+    int cls_id;
+    char name[OBJ_NAME_MAX_SIZE];
+} object_detect_result_fixed_t;
+
+typedef struct object_detect_result_array {
+    int count;
+    object_detect_result_fixed_t results[OBJ_NUMB_MAX_SIZE];
+} object_detect_result_array;
+
+// Copy list into the fixed layout, dropping detections past
+// OBJ_NUMB_MAX_SIZE; returns the number copied
+int export_detect_results(const object_detect_result_list *list, object_detect_result_array *out);
+
+// Detection cap applied by init_yolo_model() to new contexts (0 = unlimited)
+void set_default_max_detections(int max_detections);
+
+// Integer-domain decode of quantized outputs for contexts created by
+// init_yolo_model(): thresholds, scores and boxes are computed from the raw
+// int8/uint8 values through per-tensor lookup tables and fixed-point
+// arithmetic, and only the final detections are converted to float
+void set_default_integer_decode(bool enabled);
+
+// Bind the quantized outputs of contexts created by init_yolo_model() to
+// buffers in the NPU's native layout (NC1HWC2 on RK3588, NHWC on some
+// models) and decode them in place, instead of having rknn_outputs_get()
+// convert every frame to NCHW. Off by default; models or runtimes without
+// native outputs, or whose native outputs are padded, keep the standard ones.
+void set_default_native_outputs(bool enabled);
+
+// Decode the output branches of each frame in bands of grid rows on a pool
+// of threads worker threads plus the calling one (0, the default, decodes on
+// the calling thread only). Results are identical either way. Process-wide;
+// call before starting inference.
+void set_decode_threads(int threads);
+
+// Build app_ctx's integer decode tables for conf_threshold ahead of the first
+// frame. post_process() rebuilds them when the threshold or the output
+// quantization changes. Returns -1 if the outputs cannot be decoded this way.
+int prepare_decode_tables(rknn_app_context_t *app_ctx, float conf_threshold);
+void release_decode_tables(rknn_app_context_t *app_ctx);
+
+// Save the raw outputs of the next max_frames inferences to dir/frame_NNNNNN.rkt
+// (see tensor_file.h); a NULL or empty dir stops recording
+void set_output_recording(const char *dir, int max_frames);
+
 int init_yolo_model(const char *model_path, rknn_app_context_t *app_ctx);
 int release_yolo_model(rknn_app_context_t *app_ctx);
 int inference_yolo_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results);
 
+// inference_yolo_model() on a YUYV or NV12 camera frame, letterboxed straight
+// from the camera format (see yuv_letterbox.h) instead of through RGB
+int inference_yolo_model_yuv(rknn_app_context_t *app_ctx, const YuvFrame *frame, object_detect_result_list *od_results);
+
 // Model type detection function
 yolo_model_type_t detect_yolo_model_type(rknn_app_context_t *app_ctx);
 
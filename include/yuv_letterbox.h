@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "common.h"
+#include "image_utils.h"
+
+// Camera formats read by YuvLetterbox (V4L2_PIX_FMT_YUYV and V4L2_PIX_FMT_NV12)
+enum class YuvFormat {
+    YUYV,   // Packed 4:2:2, Y0 U Y1 V
+    NV12,   // Y plane, then interleaved UV at half width and height
+};
+
+// One camera frame as the driver delivers it. Strides are in bytes, 0 means
+// tightly packed.
+struct YuvFrame {
+    YuvFormat format = YuvFormat::NV12;
+    int width = 0;
+    int height = 0;
+    const uint8_t* data = nullptr;   // YUYV plane or NV12 Y plane
+    int stride = 0;
+    const uint8_t* uv = nullptr;     // NV12 UV plane, NULL when it follows the Y plane
+    int uv_stride = 0;
+};
+
+// Letterboxes a YUYV or NV12 frame at camera resolution straight into the
+// RGB888 model input, so the full-resolution frame is never converted to RGB.
+//
+// Each output row blends its two source rows (NEON or SSE2 when available),
+// resamples the blended row horizontally through precomputed bilinear taps,
+// and converts only the model-size pixels from BT.601 limited-range YUV to
+// RGB. The bars around the image are filled with bg_color, and letter_box
+// receives the same scale and padding convert_image_with_letterbox() reports.
+// Tables and row buffers are kept between frames of the same size.
+class YuvLetterbox {
+public:
+    // dst must be an allocated RGB888 buffer of the model input size.
+    // Returns -1 if a frame or buffer is unusable.
+    int convert(const YuvFrame& src, image_buffer_t* dst, letterbox_t* letter_box, int bg_color = 114);
+
+private:
+    // Bilinear tap: value = (a * (128 - weight) + b * weight + 64) >> 7
+    struct Tap {
+        int offset;   // Byte offset of a in the blended row, b is `step` bytes further
+        int weight;
+    };
+
+    void prepare(const YuvFrame& src, int dst_width, int dst_height);
+    static Tap verticalTap(int dst_row, float scale, int src_rows, int subsample);
+
+    int src_width = 0;
+    int src_height = 0;
+    YuvFormat src_format = YuvFormat::NV12;
+    int target_width = 0;
+    int target_height = 0;
+    int resize_width = 0;
+    int resize_height = 0;
+    float scale = 0;
+    std::vector<Tap> luma_taps;     // Per output column
+    std::vector<Tap> chroma_taps;   // Per output column, offset of the U sample
+    int chroma_step = 0;            // Bytes between horizontally adjacent chroma samples
+
+    std::vector<uint8_t> blended_luma;     // YUYV: the whole packed row
+    std::vector<uint8_t> blended_chroma;   // NV12 UV row
+    std::vector<uint8_t> row_y;
+    std::vector<uint8_t> row_u;
+    std::vector<uint8_t> row_v;
+};
+
+// Bytes of a tightly packed width x height frame
+size_t yuv_frame_size(YuvFormat format, int width, int height);
+
+// Parse "yuyv" or "nv12"; returns -1 for anything else
+int parse_yuv_format(const char* name, YuvFormat* format);
+
+// Read a raw width x height frame, e.g. captured with
+// `v4l2-ctl --stream-mmap --stream-count=1 --stream-to=frame.yuv`.
+// frame points into data, tightly packed.
+int load_yuv_frame(const char* path, YuvFormat format, int width, int height, std::vector<uint8_t>* data,
+                   YuvFrame* frame);
@@ -0,0 +1,305 @@
+// Python bindings for the C++ YOLO post-processor (post_process()) and the
+// streaming COCO evaluator (CocoEvaluator).
+//
+// RKNNLite output arrays are read in place through the buffer protocol and
+// decoding/NMS runs with the GIL released, so other Python threads (capture,
+// preprocessing of the next frame) keep running.
+//
+//   import bsext_postprocess
+//   decoder = bsext_postprocess.Decoder(640, 640)
+//   boxes, scores, classes = decoder.process(outputs, scale=ratio, pad=(dw, dh))
+//
+//   evaluator = bsext_postprocess.CocoEvaluator(category_ids)
+//   evaluator.evaluate_image(gt_boxes, gt_categories, gt_areas, gt_iscrowd, boxes, scores, categories)
+//   print(evaluator.summarize())
+
+#include <string.h>
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "coco_eval.h"
+#include "image_utils.h"
+#include "postprocess.h"
+#include "yolo.h"
+
+namespace py = pybind11;
+
+namespace {
+
+class Decoder {
+public:
+    Decoder(int model_width, int model_height, float conf_threshold, float nms_threshold, int max_detections,
+            bool integer_decode)
+        : model_width(model_width),
+          model_height(model_height),
+          conf_threshold(conf_threshold),
+          nms_threshold(nms_threshold),
+          max_detections(max_detections),
+          integer_decode(integer_decode) {}
+
+    ~Decoder() {
+        rknn_app_context_t app_ctx;
+        memset(&app_ctx, 0, sizeof(app_ctx));
+        app_ctx.decode_tables = decode_tables;
+        release_decode_tables(&app_ctx);
+    }
+
+    // outputs: the model outputs in order, 4-D NCHW arrays of float32, or
+    // int8/uint8 with per-output (zero_point, scale) in quantization. Without
+    // integer_decode, quantized outputs must be int8 (uint8 on RKNPU1)
+    py::tuple process(const std::vector<py::buffer>& outputs, float scale, std::pair<float, float> pad,
+                      const std::vector<std::pair<int32_t, float>>& quantization) {
+        size_t n = outputs.size();
+        if (n != 3 && n != 9) {
+            throw std::invalid_argument("expected 3 (YOLOX) or 9 (YOLOv8) outputs, got " + std::to_string(n));
+        }
+        if (!quantization.empty() && quantization.size() != n) {
+            throw std::invalid_argument("quantization needs one (zero_point, scale) pair per output");
+        }
+
+        // Keep the buffer views alive while the GIL is released
+        std::vector<py::buffer_info> views;
+        views.reserve(n);
+        std::vector<rknn_tensor_attr> attrs(n);
+        std::vector<rknn_output> rknn_outputs(n);
+        bool is_quant = false;
+
+        for (size_t i = 0; i < n; i++) {
+            views.push_back(outputs[i].request());
+            const py::buffer_info& view = views.back();
+            rknn_tensor_type type = tensorType(view);
+            if (view.ndim != 4) {
+                throw std::invalid_argument("output " + std::to_string(i) + " is not a 4-D NCHW array");
+            }
+            if (!isContiguous(view)) {
+                throw std::invalid_argument("output " + std::to_string(i) + " is not C-contiguous");
+            }
+            if (type != RKNN_TENSOR_FLOAT32 && quantization.empty()) {
+                throw std::invalid_argument("quantized outputs need quantization=[(zero_point, scale), ...]");
+            }
+            if (i > 0 && (type != RKNN_TENSOR_FLOAT32) != is_quant) {
+                throw std::invalid_argument("outputs mix float and quantized arrays");
+            }
+            is_quant = type != RKNN_TENSOR_FLOAT32;
+            if (is_quant && type != FLOAT_DECODE_QUANT_TYPE && !integer_decode) {
+                // The float decode reads quantized outputs in the NPU's own type only
+                throw std::invalid_argument(std::string(type == RKNN_TENSOR_UINT8 ? "uint8" : "int8") +
+                                            " outputs need integer_decode=True in this build");
+            }
+
+            rknn_tensor_attr& attr = attrs[i];
+            memset(&attr, 0, sizeof(attr));
+            attr.index = i;
+            attr.n_dims = 4;
+            for (int d = 0; d < 4; d++) {
+#ifdef RKNPU1
+                attr.dims[d] = view.shape[3 - d];   // RKNPU1 reports dims innermost first
+#else
+                attr.dims[d] = view.shape[d];
+#endif
+            }
+            attr.n_elems = view.size;
+            attr.size = view.size * view.itemsize;
+            attr.fmt = RKNN_TENSOR_NCHW;
+            attr.type = type;
+            if (is_quant) {
+                attr.qnt_type = RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC;
+                attr.zp = quantization[i].first;
+                attr.scale = quantization[i].second;
+            } else {
+                attr.scale = 1.0f;
+            }
+
+            memset(&rknn_outputs[i], 0, sizeof(rknn_outputs[i]));
+            rknn_outputs[i].index = i;
+            rknn_outputs[i].want_float = !is_quant;
+            rknn_outputs[i].buf = view.ptr;
+            rknn_outputs[i].size = attr.size;
+        }
+
+        rknn_app_context_t app_ctx;
+        memset(&app_ctx, 0, sizeof(app_ctx));
+        app_ctx.io_num.n_input = 1;
+        app_ctx.io_num.n_output = n;
+        app_ctx.output_attrs = attrs.data();
+        app_ctx.model_channel = 3;
+        app_ctx.model_width = model_width;
+        app_ctx.model_height = model_height;
+        app_ctx.is_quant = is_quant;
+        app_ctx.model_type = n == 9 ? YOLO_SIMPLIFIED : YOLO_STANDARD;
+        app_ctx.max_detections = max_detections;
+        app_ctx.integer_decode = integer_decode && is_quant;
+
+        letterbox_t letter_box;
+        memset(&letter_box, 0, sizeof(letter_box));
+        letter_box.x_pad = (int)pad.first;
+        letter_box.y_pad = (int)pad.second;
+        letter_box.scale = scale;
+
+        int count;
+        int ret;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(mutex);
+            // Lookup tables are rebuilt only when the threshold or quantization changes
+            app_ctx.decode_tables = decode_tables;
+            ret = post_process(&app_ctx, rknn_outputs.data(), &letter_box, conf_threshold, nms_threshold, &results);
+            decode_tables = app_ctx.decode_tables;
+            count = results.count;
+        }
+        if (ret < 0) {
+            throw std::runtime_error("post_process failed, ret=" + std::to_string(ret));
+        }
+
+        py::array_t<float> boxes({(py::ssize_t)count, (py::ssize_t)4});
+        py::array_t<float> scores((py::ssize_t)count);
+        py::array_t<int32_t> classes((py::ssize_t)count);
+        auto b = boxes.mutable_unchecked<2>();
+        auto s = scores.mutable_unchecked<1>();
+        auto c = classes.mutable_unchecked<1>();
+        for (int i = 0; i < count; i++) {
+            b(i, 0) = results.boxes[i].left;
+            b(i, 1) = results.boxes[i].top;
+            b(i, 2) = results.boxes[i].right;
+            b(i, 3) = results.boxes[i].bottom;
+            s(i) = results.props[i];
+            c(i) = results.cls_ids[i];
+        }
+        return py::make_tuple(boxes, scores, classes);
+    }
+
+    int model_width;
+    int model_height;
+    float conf_threshold;
+    float nms_threshold;
+    int max_detections;
+    bool integer_decode;   // Decode int8/uint8 outputs in the integer domain
+
+private:
+#ifdef RKNPU1
+    static constexpr rknn_tensor_type FLOAT_DECODE_QUANT_TYPE = RKNN_TENSOR_UINT8;
+#else
+    static constexpr rknn_tensor_type FLOAT_DECODE_QUANT_TYPE = RKNN_TENSOR_INT8;
+#endif
+
+    static rknn_tensor_type tensorType(const py::buffer_info& view) {
+        if (view.format == py::format_descriptor<float>::format()) {
+            return RKNN_TENSOR_FLOAT32;
+        }
+        if (view.format == py::format_descriptor<int8_t>::format()) {
+            return RKNN_TENSOR_INT8;
+        }
+        if (view.format == py::format_descriptor<uint8_t>::format()) {
+            return RKNN_TENSOR_UINT8;
+        }
+        throw std::invalid_argument("unsupported output dtype '" + view.format + "', expected float32, int8 or uint8");
+    }
+
+    static bool isContiguous(const py::buffer_info& view) {
+        py::ssize_t expected = view.itemsize;
+        for (py::ssize_t d = view.ndim - 1; d >= 0; d--) {
+            if (view.shape[d] > 1 && view.strides[d] != expected) {
+                return false;
+            }
+            expected *= view.shape[d];
+        }
+        return true;
+    }
+
+    std::mutex mutex;                     // results and decode_tables are reused across calls
+    object_detect_result_list results;
+    quant_decode_tables* decode_tables = nullptr;
+};
+
+typedef py::array_t<float, py::array::c_style | py::array::forcecast> FloatArray;
+typedef py::array_t<int32_t, py::array::c_style | py::array::forcecast> IntArray;
+
+// COCO boxes from an (N, 4) [x, y, w, h] array and per-box columns
+std::vector<CocoBox> toCocoBoxes(const FloatArray& boxes, const IntArray& categories, const FloatArray* values,
+                                 const IntArray* iscrowd, bool values_are_scores) {
+    py::ssize_t n = boxes.size() / 4;
+    if ((boxes.ndim() != 2 && boxes.size() != 0) || (boxes.ndim() == 2 && boxes.shape(1) != 4) ||
+        categories.size() != n || (values && values->size() != n) || (iscrowd && iscrowd->size() != n)) {
+        throw std::invalid_argument("expected (N, 4) [x, y, w, h] boxes and N-element columns");
+    }
+    std::vector<CocoBox> result(n);
+    const float* b = boxes.data();
+    for (py::ssize_t i = 0; i < n; i++) {
+        CocoBox& box = result[i];
+        box.x = b[i * 4];
+        box.y = b[i * 4 + 1];
+        box.w = b[i * 4 + 2];
+        box.h = b[i * 4 + 3];
+        box.category_id = categories.data()[i];
+        if (values_are_scores) {
+            box.score = values->data()[i];
+        } else {
+            box.area = values ? values->data()[i] : box.w * box.h;
+            box.iscrowd = iscrowd && iscrowd->data()[i] != 0;
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+PYBIND11_MODULE(bsext_postprocess, m) {
+    m.doc() = "C++ YOLOX/YOLOv8 decode and NMS for RKNNLite outputs, and COCO bbox evaluation";
+
+    py::class_<Decoder>(m, "Decoder")
+        .def(py::init<int, int, float, float, int, bool>(),
+             py::arg("model_width") = 640, py::arg("model_height") = 640,
+             py::arg("conf_threshold") = BOX_THRESH, py::arg("nms_threshold") = NMS_THRESH,
+             py::arg("max_detections") = OBJ_NUMB_MAX_SIZE, py::arg("integer_decode") = false)
+        .def("process", &Decoder::process,
+             py::arg("outputs"), py::arg("scale") = 1.0f, py::arg("pad") = std::make_pair(0.0f, 0.0f),
+             py::arg("quantization") = std::vector<std::pair<int32_t, float>>(),
+             "Decode model outputs into (boxes[N, 4] as x1, y1, x2, y2 in source image pixels,\n"
+             "scores[N], classes[N]). Arrays are read in place; the GIL is released while decoding.")
+        .def_readwrite("conf_threshold", &Decoder::conf_threshold)
+        .def_readwrite("nms_threshold", &Decoder::nms_threshold)
+        .def_readwrite("max_detections", &Decoder::max_detections)
+        .def_readwrite("integer_decode", &Decoder::integer_decode)
+        .def_readonly("model_width", &Decoder::model_width)
+        .def_readonly("model_height", &Decoder::model_height);
+
+    m.def("set_decode_threads", &set_decode_threads, py::arg("threads"),
+          "Decode output branches in row bands on this many extra threads (0 = calling thread only).\n"
+          "Process-wide; results do not depend on it.");
+
+    py::class_<CocoStats>(m, "CocoStats")
+        .def_property_readonly("stats", [](const CocoStats& s) { return std::vector<double>(s.stats, s.stats + 12); },
+                               "The 12 COCOeval.stats values")
+        .def_property_readonly("ap", &CocoStats::ap)
+        .def_property_readonly("ap50", &CocoStats::ap50)
+        .def("__str__", &CocoStats::format);
+
+    py::class_<CocoEvaluator>(m, "CocoEvaluator")
+        .def(py::init<const std::vector<int>&>(), py::arg("category_ids"),
+             "Bounding-box mAP/AR as pycocotools COCOeval computes it, one image at a time")
+        .def("evaluate_image",
+             [](CocoEvaluator& self, const FloatArray& gt_boxes, const IntArray& gt_categories,
+                const FloatArray& gt_areas, const IntArray& gt_iscrowd, const FloatArray& boxes,
+                const FloatArray& scores, const IntArray& categories) {
+                 std::vector<CocoBox> gts = toCocoBoxes(gt_boxes, gt_categories, &gt_areas, &gt_iscrowd, false);
+                 std::vector<CocoBox> dts = toCocoBoxes(boxes, categories, &scores, nullptr, true);
+                 py::gil_scoped_release release;
+                 self.evaluateImage(gts, dts);
+             },
+             py::arg("gt_boxes"), py::arg("gt_categories"), py::arg("gt_areas"), py::arg("gt_iscrowd"),
+             py::arg("boxes"), py::arg("scores"), py::arg("categories"),
+             "Match one image: boxes are (N, 4) [x, y, w, h] in image pixels, categories are COCO ids")
+        .def("summarize", &CocoEvaluator::summarize, py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("images", &CocoEvaluator::images)
+        .def_property_readonly("records", &CocoEvaluator::records)
+        .def_static("coco80_to_coco91", &CocoEvaluator::coco80_to_coco91,
+                    "COCO category id of each of the 80 model classes");
+}
@@ -0,0 +1,272 @@
+// Python bindings for AsyncRknnRunner: pipelined RKNN inference with a
+// submit/future API in place of the synchronous RKNNLite.inference().
+//
+//   import bsext_rknn
+//   runner = bsext_rknn.Runner("yolox_s.rknn", contexts=3, core_masks=[1, 2, 4])
+//   future = runner.submit(img)        # returns once img is copied
+//   next_img = preprocess(next_frame)  # overlaps with the NPU run
+//   outputs = future.result()          # list of numpy arrays, like inference()
+//
+// Inputs are uint8 HWC or NHWC arrays of the model input size. submit() and
+// result() release the GIL while they wait.
+
+#include <string.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "async_runner.h"
+#include "inference_backend.h"
+
+namespace py = pybind11;
+
+namespace {
+
+// Shape and dtype of each output as returned to Python
+struct OutputLayout {
+    std::vector<std::vector<py::ssize_t>> shapes;
+    std::vector<py::dtype> dtypes;
+};
+
+class Future {
+public:
+    Future(std::shared_ptr<AsyncRequest> request, std::shared_ptr<OutputLayout> layout)
+        : request(std::move(request)), layout(std::move(layout)) {}
+
+    uint64_t id() const { return request->id; }
+
+    bool done() const { return request->done(); }
+
+    bool wait(py::object timeout) {
+        int timeout_ms = timeout.is_none() ? -1 : (int)(timeout.cast<double>() * 1000.0);
+        py::gil_scoped_release release;
+        return request->wait(timeout_ms);
+    }
+
+    py::list result(py::object timeout) {
+        if (!outputs.is_none()) {
+            return outputs;
+        }
+        if (!wait(timeout)) {
+            PyErr_SetString(PyExc_TimeoutError, "inference not finished");
+            throw py::error_already_set();
+        }
+        if (request->status < 0) {
+            throw std::runtime_error("inference failed, ret=" + std::to_string(request->status));
+        }
+
+        py::list list;
+        for (size_t i = 0; i < request->outputs.size(); i++) {
+            // The array takes over the output buffer without copying it
+            auto* data = new std::vector<uint8_t>(std::move(request->outputs[i]));
+            py::capsule owner(data, [](void* p) { delete static_cast<std::vector<uint8_t>*>(p); });
+            list.append(py::array(layout->dtypes[i], layout->shapes[i], data->data(), owner));
+        }
+        request->outputs.clear();
+        outputs = list;
+        return list;
+    }
+
+private:
+    std::shared_ptr<AsyncRequest> request;
+    std::shared_ptr<OutputLayout> layout;
+    py::object outputs = py::none();
+};
+
+class Runner {
+public:
+    Runner(const std::string& model_path, int contexts, py::object in_flight, std::vector<uint32_t> core_masks,
+           bool want_float, py::object mock_recordings, float mock_latency_ms, float mock_jitter_ms) {
+        AsyncRunnerOptions options;
+        options.contexts = contexts;
+        options.in_flight = in_flight.is_none() ? contexts + 1 : in_flight.cast<int>();
+        options.core_masks = std::move(core_masks);
+        options.want_float = want_float;
+        runner.reset(new AsyncRknnRunner(options));
+
+        int ret;
+        {
+            py::gil_scoped_release release;
+            if (!mock_recordings.is_none()) {
+                MockBackendOptions mock;
+                mock.recordings = mock_recordings.cast<std::string>();
+                mock.latency_ms = mock_latency_ms;
+                mock.jitter_ms = mock_jitter_ms;
+                mock.shared_npu = false;   // one simulated core per context
+                set_default_mock_backend(&mock);
+                ret = runner->init(model_path.c_str());
+                set_default_mock_backend(nullptr);
+            } else {
+                ret = runner->init(model_path.c_str());
+            }
+        }
+        if (ret < 0) {
+            throw std::runtime_error("cannot load " + model_path + ", ret=" + std::to_string(ret));
+        }
+        layout = makeLayout();
+    }
+
+    ~Runner() {
+        py::gil_scoped_release release;
+        runner.reset();
+    }
+
+    // inputs: one array, or a list with one array per model input
+    Future submit(py::object inputs) {
+        std::vector<py::buffer> arrays;
+        if (py::isinstance<py::list>(inputs) || py::isinstance<py::tuple>(inputs)) {
+            for (auto item : inputs) {
+                arrays.push_back(py::reinterpret_borrow<py::buffer>(item));
+            }
+        } else {
+            arrays.push_back(inputs.cast<py::buffer>());
+        }
+
+        std::vector<py::buffer_info> views;
+        std::vector<const void*> data;
+        std::vector<size_t> sizes;
+        for (auto& array : arrays) {
+            views.push_back(array.request());
+            const py::buffer_info& view = views.back();
+            if (view.itemsize != 1 || !isContiguous(view)) {
+                throw std::invalid_argument("inputs must be C-contiguous uint8 arrays");
+            }
+            data.push_back(view.ptr);
+            sizes.push_back((size_t)view.size);
+        }
+
+        std::shared_ptr<AsyncRequest> request;
+        {
+            py::gil_scoped_release release;
+            request = runner->submit(data.data(), sizes.data(), (uint32_t)data.size());
+        }
+        if (!request) {
+            throw std::invalid_argument("inputs do not match the model inputs " + describeInputs() +
+                                        " or the runner is shut down");
+        }
+        return Future(request, layout);
+    }
+
+    py::list run(py::object inputs) {
+        return submit(inputs).result(py::none());
+    }
+
+    void shutdown() {
+        py::gil_scoped_release release;
+        runner->shutdown();
+    }
+
+    int inFlight() const { return runner->inFlight(); }
+    int outstanding() const { return runner->outstanding(); }
+
+    std::vector<std::vector<uint32_t>> inputShapes() const {
+        std::vector<std::vector<uint32_t>> shapes;
+        for (const auto& attr : runner->inputAttrs()) {
+            shapes.push_back(std::vector<uint32_t>(attr.dims, attr.dims + attr.n_dims));
+        }
+        return shapes;
+    }
+
+    // (zero_point, scale) per output, for decoding raw outputs (want_float=False)
+    std::vector<std::pair<int32_t, float>> outputQuantization() const {
+        std::vector<std::pair<int32_t, float>> quantization;
+        for (const auto& attr : runner->outputAttrs()) {
+            quantization.emplace_back(attr.zp, attr.scale);
+        }
+        return quantization;
+    }
+
+private:
+    std::shared_ptr<OutputLayout> makeLayout() const {
+        auto layout = std::make_shared<OutputLayout>();
+        for (const auto& attr : runner->outputAttrs()) {
+            std::vector<py::ssize_t> shape;
+            for (uint32_t d = 0; d < attr.n_dims; d++) {
+#ifdef RKNPU1
+                shape.push_back(attr.dims[attr.n_dims - 1 - d]);   // RKNPU1 reports dims innermost first
+#else
+                shape.push_back(attr.dims[d]);
+#endif
+            }
+            if (runner->wantFloat() || attr.type == RKNN_TENSOR_FLOAT32) {
+                layout->dtypes.push_back(py::dtype::of<float>());
+            } else if (attr.type == RKNN_TENSOR_INT8) {
+                layout->dtypes.push_back(py::dtype::of<int8_t>());
+            } else if (attr.type == RKNN_TENSOR_UINT8) {
+                layout->dtypes.push_back(py::dtype::of<uint8_t>());
+            } else {
+                // Other raw types come back as bytes
+                layout->dtypes.push_back(py::dtype::of<uint8_t>());
+                shape.assign(1, attr.size);
+            }
+            layout->shapes.push_back(shape);
+        }
+        return layout;
+    }
+
+    std::string describeInputs() const {
+        std::string text = "[";
+        for (const auto& attr : runner->inputAttrs()) {
+            text += (text.size() > 1 ? ", " : "") + std::to_string(attr.n_elems) + " bytes";
+        }
+        return text + "]";
+    }
+
+    static bool isContiguous(const py::buffer_info& view) {
+        py::ssize_t expected = view.itemsize;
+        for (py::ssize_t d = view.ndim - 1; d >= 0; d--) {
+            if (view.shape[d] > 1 && view.strides[d] != expected) {
+                return false;
+            }
+            expected *= view.shape[d];
+        }
+        return true;
+    }
+
+    std::unique_ptr<AsyncRknnRunner> runner;
+    std::shared_ptr<OutputLayout> layout;
+};
+
+}  // namespace
+
+PYBIND11_MODULE(bsext_rknn, m) {
+    m.doc() = "Pipelined RKNN inference over several NPU contexts";
+
+    py::class_<Future>(m, "Future")
+        .def_property_readonly("id", &Future::id, "Submission sequence number")
+        .def("done", &Future::done, "True once outputs (or an error) are available; never blocks")
+        .def("wait", &Future::wait, py::arg("timeout") = py::none(),
+             "Wait up to timeout seconds (None = forever); returns done()")
+        .def("result", &Future::result, py::arg("timeout") = py::none(),
+             "Output arrays, waiting up to timeout seconds; raises TimeoutError or RuntimeError");
+
+    py::class_<Runner>(m, "Runner")
+        .def(py::init<const std::string&, int, py::object, std::vector<uint32_t>, bool, py::object, float, float>(),
+             py::arg("model_path"), py::arg("contexts") = 1, py::arg("in_flight") = py::none(),
+             py::arg("core_masks") = std::vector<uint32_t>(), py::arg("want_float") = true,
+             py::arg("mock_recordings") = py::none(), py::arg("mock_latency_ms") = 30.0f,
+             py::arg("mock_jitter_ms") = 3.0f,
+             "contexts: model instances run concurrently (e.g. 3 on RK3588, with core_masks=[1, 2, 4]).\n"
+             "in_flight: requests submitted but not finished before submit() blocks (default contexts + 1).\n"
+             "mock_recordings: replay .rkt output recordings instead of using the NPU.")
+        .def("submit", &Runner::submit, py::arg("inputs"),
+             "Queue an inference and return a Future; blocks while in_flight requests are outstanding")
+        .def("run", &Runner::run, py::arg("inputs"), "Synchronous submit(inputs).result()")
+        .def("shutdown", &Runner::shutdown, "Finish queued requests and stop the workers")
+        .def("__enter__", [](Runner& self) -> Runner& { return self; }, py::return_value_policy::reference)
+        .def("__exit__", [](Runner& self, py::args) { self.shutdown(); })
+        .def_property_readonly("in_flight", &Runner::inFlight)
+        .def_property_readonly("outstanding", &Runner::outstanding)
+        .def_property_readonly("input_shapes", &Runner::inputShapes)
+        .def_property_readonly("output_quantization", &Runner::outputQuantization);
+
+    m.attr("NPU_CORE_0") = 1;
+    m.attr("NPU_CORE_1") = 2;
+    m.attr("NPU_CORE_2") = 4;
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""
+Build the native Python extensions:
+
+    bsext_postprocess  the application's C++ YOLO post-processor (src/postprocess.cc)
+                       and COCO bbox evaluator (src/coco_eval.cpp)
+    bsext_rknn         pipelined RKNN inference with futures (src/async_runner.cpp)
+
+On the player SDK / target, point RKNN_INCLUDE_DIRS at the RKNN runtime and
+model zoo utils headers and RKNN_LIB_DIRS at librknnrt (colon separated).
+Without them the host stand-ins in bench/stub are used, which is enough to
+build and test on a PC; bsext_rknn then only supports the mock NPU
+(Runner(..., mock_recordings=...)).
+
+    pip install pybind11
+    RKNN_INCLUDE_DIRS=/path/to/rknn/include:/path/to/utils RKNN_LIB_DIRS=/path/to/lib \
+        python3 setup.py build_ext --inplace
+
+Add -DRKNPU1 to CFLAGS for RK3568/RV1126-class (RKNPU1) builds.
+"""
+
+import os
+
+from pybind11.setup_helpers import Pybind11Extension, build_ext
+from setuptools import setup
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.join(HERE, "..")
+
+
+def env_dirs(name):
+    return [d for d in os.environ.get(name, "").split(":") if d]
+
+
+SDK_INCLUDE_DIRS = env_dirs("RKNN_INCLUDE_DIRS")
+INCLUDE_DIRS = [os.path.join(ROOT, "include")] + (SDK_INCLUDE_DIRS or [os.path.join(ROOT, "bench", "stub")])
+
+
+def runtime_options():
+    """Link librknnrt when building against the SDK, otherwise mock NPU only."""
+    if not SDK_INCLUDE_DIRS:
+        return {"define_macros": [("NO_RKNN_RUNTIME", None)]}
+    # RknnBackend loads models with the model zoo read_data_from_file()
+    utils = [os.path.join(d, "file_utils.c") for d in SDK_INCLUDE_DIRS
+             if os.path.exists(os.path.join(d, "file_utils.c"))]
+    return {"sources": utils[:1], "libraries": ["rknnrt"], "library_dirs": env_dirs("RKNN_LIB_DIRS")}
+
+
+postprocess_ext = Pybind11Extension(
+    "bsext_postprocess",
+    sources=[
+        os.path.join(HERE, "bsext_postprocess.cpp"),
+        os.path.join(ROOT, "src", "postprocess.cc"),
+        os.path.join(ROOT, "src", "tensor_layout.cc"),
+        os.path.join(ROOT, "src", "work_pool.cpp"),
+        os.path.join(ROOT, "src", "coco_eval.cpp"),
+        os.path.join(ROOT, "src", "log.cpp"),
+        os.path.join(ROOT, "src", "metrics.cpp"),
+    ],
+    include_dirs=INCLUDE_DIRS,
+    cxx_std=17,
+    extra_compile_args=["-O2"],
+)
+
+runtime = runtime_options()
+rknn_ext = Pybind11Extension(
+    "bsext_rknn",
+    sources=[
+        os.path.join(HERE, "bsext_rknn.cpp"),
+        os.path.join(ROOT, "src", "async_runner.cpp"),
+        os.path.join(ROOT, "src", "inference_backend.cpp"),
+        os.path.join(ROOT, "src", "tensor_layout.cc"),
+        os.path.join(ROOT, "src", "tensor_file.cc"),
+        os.path.join(ROOT, "src", "log.cpp"),
+        os.path.join(ROOT, "src", "metrics.cpp"),
+    ] + runtime.get("sources", []),
+    include_dirs=INCLUDE_DIRS,
+    define_macros=runtime.get("define_macros", []),
+    libraries=runtime.get("libraries", []),
+    library_dirs=runtime.get("library_dirs", []),
+    cxx_std=17,
+    extra_compile_args=["-O2"],
+)
+
+setup(
+    name="bsext_native",
+    version="0.2.0",
+    description="C++ YOLO post-processing and pipelined RKNN inference for Python",
+    ext_modules=[postprocess_ext, rknn_ext],
+    cmdclass={"build_ext": build_ext},
+)
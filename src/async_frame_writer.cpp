@@ -0,0 +1,145 @@
+#include "async_frame_writer.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+AsyncFrameWriter::AsyncFrameWriter(const FrameWriterOptions& options)
+    : options(options),
+      slots(std::max(1, options.workers)) {
+    for (size_t i = 0; i < slots.size(); i++) {
+        slots[i].temp_path = options.path + ".tmp" + std::to_string(i);
+    }
+    for (size_t i = 0; i < slots.size(); i++) {
+        threads.emplace_back(&AsyncFrameWriter::run, this, (int)i);
+    }
+}
+
+AsyncFrameWriter::~AsyncFrameWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+bool AsyncFrameWriter::wantsFrame(const object_detect_result_list& detections) {
+    if (options.suppress_empty && detections.count == 0) {
+        return false;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    return options.max_fps <= 0 || now - last_accepted >= std::chrono::milliseconds(1000 / options.max_fps);
+}
+
+bool AsyncFrameWriter::writeFrame(const cv::Mat& frame, const object_detect_result_list& detections) {
+    if (frame.empty() || (options.suppress_empty && detections.count == 0)) {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    if (options.max_fps > 0 && now - last_accepted < std::chrono::milliseconds(1000 / options.max_fps)) {
+        return false;   // Rate limited, not counted as a drop
+    }
+
+    Slot* slot = nullptr;
+    int index = 0;
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (!slots[i].busy) {
+            slot = &slots[i];
+            index = (int)i;
+            break;
+        }
+    }
+    if (!slot) {
+        dropped++;
+        Metrics::instance().add(Counter::DroppedFrames);
+        return false;
+    }
+    slot->busy = true;
+    slot->sequence = next_sequence++;
+    last_accepted = now;
+    lock.unlock();
+
+    // The slot is ours until a worker picks it up; copyTo reuses its buffer
+    frame.copyTo(slot->frame);
+    slot->detections = detections;
+
+    lock.lock();
+    pending.push_back(index);
+    lock.unlock();
+    ready.notify_one();
+    return true;
+}
+
+void AsyncFrameWriter::run(int /*worker*/) {
+    while (true) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                return;
+            }
+            index = pending.front();
+            pending.erase(pending.begin());
+        }
+
+        Slot& slot = slots[index];
+        encode(slot);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        slot.busy = false;
+    }
+}
+
+void AsyncFrameWriter::encode(Slot& slot) {
+    cv::Mat& canvas = slot.frame;
+    for (int i = 0; i < slot.detections.count; i++) {
+        object_detect_result_t det = slot.detections.at(i);
+        cv::rectangle(canvas, cv::Point(det.box.left, det.box.top), cv::Point(det.box.right, det.box.bottom),
+                      cv::Scalar(0, 255, 0), 2);
+        char label[96];
+        snprintf(label, sizeof(label), "%s %.1f%%", det.name, det.prop * 100);
+        cv::putText(canvas, label, cv::Point(det.box.left, det.box.top - 6),
+                    cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 255), 1);
+    }
+
+    const cv::Mat* out = &canvas;
+    if (options.width > 0 && options.width < canvas.cols) {
+        int height = canvas.rows * options.width / canvas.cols;
+        cv::resize(canvas, slot.scaled, cv::Size(options.width, height), 0, 0, cv::INTER_AREA);
+        out = &slot.scaled;
+    }
+
+    if (!cv::imencode(".jpg", *out, slot.encoded, {cv::IMWRITE_JPEG_QUALITY, options.jpeg_quality})) {
+        LOGE("AsyncFrameWriter: JPEG encode failed\n");
+        return;
+    }
+
+    FILE* fp = fopen(slot.temp_path.c_str(), "wb");
+    if (!fp) {
+        LOGE("AsyncFrameWriter: cannot open %s\n", slot.temp_path.c_str());
+        return;
+    }
+    size_t n = fwrite(slot.encoded.data(), 1, slot.encoded.size(), fp);
+    fclose(fp);
+    if (n != slot.encoded.size()) {
+        unlink(slot.temp_path.c_str());
+        return;
+    }
+
+    // Publish atomically, unless a newer frame already landed
+    std::lock_guard<std::mutex> lock(mutex);
+    if (slot.sequence < published_sequence || rename(slot.temp_path.c_str(), options.path.c_str()) != 0) {
+        unlink(slot.temp_path.c_str());
+        return;
+    }
+    published_sequence = slot.sequence;
+    written++;
+}
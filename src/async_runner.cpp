@@ -0,0 +1,262 @@
+#include "async_runner.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "log.h"
+#include "metrics.h"
+
+bool AsyncRequest::done() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return complete;
+}
+
+bool AsyncRequest::wait(int timeout_ms) const {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (timeout_ms < 0) {
+        finished.wait(lock, [this] { return complete; });
+        return true;
+    }
+    return finished.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return complete; });
+}
+
+AsyncRknnRunner::AsyncRknnRunner(const AsyncRunnerOptions& options)
+    : options(options) {
+    this->options.contexts = std::max(1, options.contexts);
+    this->options.in_flight = std::max(this->options.contexts, options.in_flight);
+}
+
+AsyncRknnRunner::~AsyncRknnRunner() {
+    shutdown();
+}
+
+int AsyncRknnRunner::init(const char* model_path) {
+    for (int i = 0; i < options.contexts; i++) {
+        std::unique_ptr<InferenceBackend> backend = create_inference_backend();
+        if (!backend) {
+            return RKNN_ERR_FAIL;
+        }
+        int ret = backend->init(model_path);
+        if (ret < 0) {
+            return ret;
+        }
+        if (i < (int)options.core_masks.size()) {
+            ret = backend->setCoreMask(options.core_masks[i]);
+            if (ret < 0) {
+                LOGE("AsyncRknnRunner: core mask 0x%x for context %d failed! ret=%d\n", options.core_masks[i], i, ret);
+                return ret;
+            }
+        }
+        backends.push_back(std::move(backend));
+    }
+
+    InferenceBackend& model = *backends[0];
+    int ret = model.query(RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
+    if (ret < 0) {
+        LOGE("rknn_query fail! ret=%d\n", ret);
+        return ret;
+    }
+    input_attrs.resize(io_num.n_input);
+    for (uint32_t i = 0; i < io_num.n_input; i++) {
+        memset(&input_attrs[i], 0, sizeof(rknn_tensor_attr));
+        input_attrs[i].index = i;
+        ret = model.query(RKNN_QUERY_INPUT_ATTR, &input_attrs[i], sizeof(rknn_tensor_attr));
+        if (ret < 0) {
+            LOGE("rknn_query fail! ret=%d\n", ret);
+            return ret;
+        }
+    }
+    output_attrs.resize(io_num.n_output);
+    for (uint32_t i = 0; i < io_num.n_output; i++) {
+        memset(&output_attrs[i], 0, sizeof(rknn_tensor_attr));
+        output_attrs[i].index = i;
+        ret = model.query(RKNN_QUERY_OUTPUT_ATTR, &output_attrs[i], sizeof(rknn_tensor_attr));
+        if (ret < 0) {
+            LOGE("rknn_query fail! ret=%d\n", ret);
+            return ret;
+        }
+    }
+
+    buffers.resize(options.in_flight);
+    for (int b = 0; b < options.in_flight; b++) {
+        buffers[b].resize(io_num.n_input);
+        for (uint32_t i = 0; i < io_num.n_input; i++) {
+            buffers[b][i].resize(input_attrs[i].n_elems);
+        }
+        free_buffers.push_back(b);
+    }
+
+    for (int i = 0; i < options.contexts; i++) {
+        threads.emplace_back(&AsyncRknnRunner::run, this, i);
+    }
+    LOGI("AsyncRknnRunner: %d context(s), %d request(s) in flight, %u input(s), %u output(s)\n",
+         options.contexts, options.in_flight, io_num.n_input, io_num.n_output);
+    return RKNN_SUCC;
+}
+
+std::shared_ptr<AsyncRequest> AsyncRknnRunner::submit(const void* const* inputs, const size_t* sizes,
+                                                      uint32_t n_inputs) {
+    if (threads.empty() || n_inputs != io_num.n_input) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < n_inputs; i++) {
+        if (sizes[i] != input_attrs[i].n_elems) {
+            LOGE("AsyncRknnRunner: input %u is %zu bytes, the model takes %u\n", i, sizes[i], input_attrs[i].n_elems);
+            return nullptr;
+        }
+    }
+
+    auto request = std::make_shared<AsyncRequest>();
+    std::unique_lock<std::mutex> lock(mutex);
+    capacity.wait(lock, [this] {
+        return stopping || ((int)(pending.size() + running) < options.in_flight && !free_buffers.empty());
+    });
+    if (stopping) {
+        return nullptr;
+    }
+    request->id = next_id++;
+    request->buffer = free_buffers.back();
+    free_buffers.pop_back();
+    lock.unlock();
+
+    // The buffer set is ours until a worker hands it to the runtime
+    for (uint32_t i = 0; i < n_inputs; i++) {
+        memcpy(buffers[request->buffer][i].data(), inputs[i], sizes[i]);
+    }
+
+    lock.lock();
+    pending.push_back(request);
+    lock.unlock();
+    ready.notify_one();
+    return request;
+}
+
+void AsyncRknnRunner::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready.notify_all();
+    capacity.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+int AsyncRknnRunner::outstanding() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)pending.size() + running;
+}
+
+void AsyncRknnRunner::run(int worker) {
+    InferenceBackend& backend = *backends[worker];
+    std::vector<rknn_input> inputs(io_num.n_input);
+    std::vector<rknn_output> outputs(io_num.n_output);
+
+    while (true) {
+        std::shared_ptr<AsyncRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) {
+                return;   // Stopping, and everything queued has been run
+            }
+            request = pending.front();
+            pending.pop_front();
+            running++;
+        }
+        execute(backend, *request, inputs, outputs);
+    }
+}
+
+void AsyncRknnRunner::execute(InferenceBackend& backend, AsyncRequest& request, std::vector<rknn_input>& inputs,
+                              std::vector<rknn_output>& outputs) {
+    for (uint32_t i = 0; i < io_num.n_input; i++) {
+        memset(&inputs[i], 0, sizeof(rknn_input));
+        inputs[i].index = i;
+        inputs[i].type = RKNN_TENSOR_UINT8;
+        inputs[i].fmt = RKNN_TENSOR_NHWC;
+        inputs[i].size = input_attrs[i].n_elems;
+        inputs[i].buf = buffers[request.buffer][i].data();
+    }
+
+    int ret;
+    {
+        ScopedStageTimer timer(Stage::InputsSet);
+        ret = backend.inputsSet(io_num.n_input, inputs.data());
+    }
+
+    // The runtime has its own copy now; let the next submit() use the buffers
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(request.buffer);
+        request.buffer = -1;
+    }
+    capacity.notify_one();
+
+    if (ret < 0) {
+        LOGE("rknn_input_set fail! ret=%d\n", ret);
+        finish(request, ret);
+        return;
+    }
+
+    {
+        ScopedStageTimer timer(Stage::Run);
+        ret = backend.run();
+    }
+    if (ret < 0) {
+        LOGE("rknn_run fail! ret=%d\n", ret);
+        finish(request, ret);
+        return;
+    }
+
+    // Outputs go straight into the request's buffers where the runtime allows it
+    request.outputs.resize(io_num.n_output);
+    for (uint32_t i = 0; i < io_num.n_output; i++) {
+        const rknn_tensor_attr& attr = output_attrs[i];
+        std::vector<uint8_t>& out = request.outputs[i];
+        out.resize(options.want_float ? attr.n_elems * sizeof(float) : attr.size);
+        memset(&outputs[i], 0, sizeof(rknn_output));
+        outputs[i].index = i;
+        outputs[i].want_float = options.want_float;
+        outputs[i].is_prealloc = 1;
+        outputs[i].buf = out.data();
+        outputs[i].size = out.size();
+    }
+    {
+        ScopedStageTimer timer(Stage::OutputsGet);
+        ret = backend.outputsGet(io_num.n_output, outputs.data());
+        if (ret >= 0) {
+            for (uint32_t i = 0; i < io_num.n_output; i++) {
+                std::vector<uint8_t>& out = request.outputs[i];
+                if (outputs[i].buf != out.data()) {
+                    memcpy(out.data(), outputs[i].buf, std::min((size_t)outputs[i].size, out.size()));
+                }
+            }
+            backend.outputsRelease(io_num.n_output, outputs.data());
+        }
+    }
+    if (ret < 0) {
+        LOGE("rknn_outputs_get fail! ret=%d\n", ret);
+    }
+    Metrics::instance().add(Counter::Frames);
+    finish(request, ret < 0 ? ret : RKNN_SUCC);
+}
+
+void AsyncRknnRunner::finish(AsyncRequest& request, int status) {
+    {
+        std::lock_guard<std::mutex> lock(request.mutex);
+        request.status = status;
+        request.complete = true;
+    }
+    request.finished.notify_all();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running--;
+    }
+    capacity.notify_one();
+}
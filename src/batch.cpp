@@ -0,0 +1,412 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <glob.h>
+#include <memory>
+#include <thread>
+
+#include <opencv2/opencv.hpp>
+
+#include "coco_eval.h"
+#include "image_utils.h"
+#include "jpeg_decoder.h"
+#include "log.h"
+#include "metrics.h"
+#include "postprocess.h"
+#include "publisher.h"
+#include "result_cache.h"
+#include "yolo.h"
+
+namespace {
+
+struct DecodedImage {
+    size_t index = 0;
+    std::string path;
+    std::vector<uint8_t> rgb;   // Packed RGB888, empty if decoding failed
+    int width = 0;
+    int height = 0;
+    int full_width = 0;         // Size in the file, larger than width x height after a scaled JPEG decode
+    int full_height = 0;
+    uint64_t content_hash = 0;  // hash64() of the file's bytes
+    bool cached = false;        // results came from the result cache, rgb is empty
+    object_detect_result_list results;
+};
+
+// Bounded blocking queue between the decode pool and the NPU feeder.
+// Unlike ThreadSafeQueue it never drops items: producers block when full.
+class DecodedQueue {
+public:
+    explicit DecodedQueue(size_t capacity) : capacity(capacity) {}
+
+    void push(DecodedImage&& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_full.wait(lock, [this] { return items.size() < capacity || closed; });
+        if (closed) {
+            return;
+        }
+        items.push_back(std::move(item));
+        Metrics::instance().set(Gauge::QueueDepth, items.size());
+        not_empty.notify_one();
+    }
+
+    bool pop(DecodedImage& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        not_empty.wait(lock, [this] { return !items.empty() || producers == 0 || closed; });
+        if (items.empty()) {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        Metrics::instance().set(Gauge::QueueDepth, items.size());
+        not_full.notify_one();
+        return true;
+    }
+
+    void setProducers(int count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        producers = count;
+    }
+
+    void producerDone() {
+        std::lock_guard<std::mutex> lock(mutex);
+        producers--;
+        not_empty.notify_all();
+    }
+
+    // Pixel buffers go back and forth between the decoders and the feeder
+    // so their capacity is reused instead of reallocated for every image
+    void recycle(std::vector<uint8_t>&& buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        spare.push_back(std::move(buffer));
+    }
+
+    std::vector<uint8_t> takeBuffer() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.empty()) {
+            return std::vector<uint8_t>();
+        }
+        std::vector<uint8_t> buffer = std::move(spare.back());
+        spare.pop_back();
+        return buffer;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    std::deque<DecodedImage> items;
+    std::vector<std::vector<uint8_t>> spare;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    size_t capacity;
+    int producers = 0;
+    bool closed = false;
+};
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    data.resize((size_t)in.tellg());
+    in.seekg(0);
+    return (bool)in.read((char*)data.data(), data.size());
+}
+
+// Decode a file's bytes into item.rgb: JPEGs straight to RGB at the DCT
+// scale that suits the model input, anything else (or any JPEG libjpeg
+// turns down) through OpenCV at full size
+void decodeImage(const std::vector<uint8_t>& file, const BatchOptions& options, int model_width, int model_height,
+                 JpegDecoder& jpeg, DecodedImage& item) {
+    JpegDecodeInfo info;
+    if (options.scaled_decode &&
+        jpeg.decode(file.data(), file.size(), model_width, model_height, &item.rgb, &info) == 0) {
+        item.width = info.width;
+        item.height = info.height;
+        item.full_width = info.full_width;
+        item.full_height = info.full_height;
+        return;
+    }
+
+    cv::Mat bgr = cv::imdecode(cv::Mat(1, (int)file.size(), CV_8UC1, (void*)file.data()), cv::IMREAD_COLOR);
+    if (bgr.empty()) {
+        item.rgb.clear();
+        return;
+    }
+    item.rgb.resize(bgr.total() * 3);
+    cv::Mat rgb(bgr.rows, bgr.cols, CV_8UC3, item.rgb.data());
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    item.width = item.full_width = bgr.cols;
+    item.height = item.full_height = bgr.rows;
+}
+
+// Boxes found on a reduced decode, in the pixel coordinates of the file
+void rescaleDetections(const DecodedImage& item, object_detect_result_list& results) {
+    if (item.width == item.full_width && item.height == item.full_height) {
+        return;
+    }
+    float sx = (float)item.full_width / item.width;
+    float sy = (float)item.full_height / item.height;
+    for (box_rect_t& box : results.boxes) {
+        box.left = std::min((int)(box.left * sx), item.full_width - 1);
+        box.right = std::min((int)(box.right * sx), item.full_width - 1);
+        box.top = std::min((int)(box.top * sy), item.full_height - 1);
+        box.bottom = std::min((int)(box.bottom * sy), item.full_height - 1);
+    }
+    results.invalidateAggregates();
+}
+
+// Results depend on the model and on every setting that changes its boxes
+uint64_t resultCacheConfig(const BatchOptions& options, const rknn_app_context_t& app_ctx) {
+    int32_t params[] = {
+        (int32_t)(BOX_THRESH * 1e6), (int32_t)(NMS_THRESH * 1e6), app_ctx.max_detections, (int32_t)app_ctx.model_type,
+        options.scaled_decode, app_ctx.integer_decode,
+    };
+    return hash64(params, sizeof(params), hash_file(options.model_path));
+}
+
+bool isImageFile(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png";
+}
+
+}  // namespace
+
+std::vector<std::string> expandBatchSource(const std::string& source) {
+    std::vector<std::string> paths;
+
+    if (std::filesystem::is_directory(source)) {
+        for (const auto& entry : std::filesystem::directory_iterator(source)) {
+            if (entry.is_regular_file() && isImageFile(entry.path())) {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+    } else if (source.find_first_of("*?[") != std::string::npos) {
+        glob_t matches;
+        memset(&matches, 0, sizeof(matches));
+        if (glob(source.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) {
+                paths.push_back(matches.gl_pathv[i]);
+            }
+        }
+        globfree(&matches);
+    } else {
+        std::ifstream list(source);
+        std::string line;
+        while (std::getline(list, line)) {
+            line.erase(0, line.find_first_not_of(" \t"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (!line.empty() && line[0] != '#') {
+                paths.push_back(line);
+            }
+        }
+    }
+    return paths;
+}
+
+int runBatchInference(const BatchOptions& options, std::atomic<bool>& isRunning) {
+    std::vector<std::string> paths = expandBatchSource(options.source);
+    if (paths.empty()) {
+        LOGE("Batch: no images found in '%s'\n", options.source.c_str());
+        return -1;
+    }
+
+    int decode_threads = options.decode_threads;
+    if (decode_threads <= 0) {
+        decode_threads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+    LOGI("Batch: %zu images, %d decode threads\n", paths.size(), decode_threads);
+
+    CocoGroundTruth ground_truth;
+    std::unique_ptr<CocoEvaluator> evaluator;
+    if (!options.coco_annotations.empty()) {
+        if (loadCocoAnnotations(options.coco_annotations, &ground_truth) != 0) {
+            return -1;
+        }
+        evaluator.reset(new CocoEvaluator(ground_truth.category_ids));
+    }
+    size_t unannotated = 0;
+
+    // Load the model and labels once for the whole batch
+    rknn_app_context_t app_ctx;
+    memset(&app_ctx, 0, sizeof(app_ctx));
+    if (init_yolo_model(options.model_path.c_str(), &app_ctx) != 0) {
+        LOGE("Batch: init_yolo_model fail! model_path=%s\n", options.model_path.c_str());
+        return -1;
+    }
+    init_post_process();
+
+    std::ofstream file_out;
+    if (options.output_path != "-") {
+        file_out.open(options.output_path, std::ios::out | std::ios::trunc);
+        if (!file_out) {
+            LOGE("Batch: cannot open output %s\n", options.output_path.c_str());
+            deinit_post_process();
+            release_yolo_model(&app_ctx);
+            return -1;
+        }
+    }
+    std::ostream& out = file_out.is_open() ? file_out : std::cout;
+
+    std::unique_ptr<ResultCache> cache;
+    if (options.cache_capacity > 0) {
+        ResultCacheOptions cache_options;
+        cache_options.capacity = options.cache_capacity;
+        cache_options.index_path = options.cache_index;
+        cache.reset(new ResultCache(cache_options, resultCacheConfig(options, app_ctx)));
+    }
+
+    // Keep a couple of decoded frames per worker ready so the NPU never waits
+    DecodedQueue decoded(decode_threads * 2);
+    decoded.setProducers(decode_threads);
+    std::atomic<size_t> next_index{0};
+    std::atomic<size_t> scaled_decodes{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < decode_threads; t++) {
+        workers.emplace_back([&]() {
+            JpegDecoder jpeg;
+            std::vector<uint8_t> file;
+            size_t i;
+            while (isRunning && (i = next_index++) < paths.size()) {
+                DecodedImage item;
+                item.index = i;
+                item.path = paths[i];
+                {
+                    ScopedStageTimer timer(Stage::Capture);
+                    if (readFile(paths[i], file)) {
+                        item.content_hash = hash64(file.data(), file.size());
+                        item.cached = cache && cache->lookup(item.content_hash, &item.results);
+                        if (!item.cached) {
+                            item.rgb = decoded.takeBuffer();
+                            decodeImage(file, options, app_ctx.model_width, app_ctx.model_height, jpeg, item);
+                        }
+                    }
+                }
+                if (item.width < item.full_width) {
+                    scaled_decodes++;
+                }
+                decoded.push(std::move(item));
+            }
+            decoded.producerDone();
+        });
+    }
+
+    size_t processed = 0;
+    size_t failed = 0;
+    size_t inferred = 0;
+    double inference_ms_total = 0;
+    auto batch_start = std::chrono::steady_clock::now();
+
+    DecodedImage item;
+    object_detect_result_list od_results;
+    while (isRunning && decoded.pop(item)) {
+        json line;
+        line["index"] = item.index;
+        line["file"] = item.path;
+
+        int ret = -1;
+        if (item.cached) {
+            std::swap(od_results, item.results);
+            ret = 0;
+        } else if (!item.rgb.empty()) {
+            image_buffer_t src_image;
+            memset(&src_image, 0, sizeof(src_image));
+            src_image.width = item.width;
+            src_image.height = item.height;
+            src_image.format = IMAGE_FORMAT_RGB888;
+            src_image.virt_addr = item.rgb.data();
+            src_image.size = (int)item.rgb.size();
+
+            auto start = std::chrono::steady_clock::now();
+            ret = inference_yolo_model(&app_ctx, &src_image, &od_results);
+            inference_ms_total += std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+            inferred++;
+            if (ret >= 0) {
+                rescaleDetections(item, od_results);
+                if (cache) {
+                    cache->insert(item.content_hash, od_results);
+                }
+            }
+        }
+
+        if (ret < 0) {
+            line["error"] = item.rgb.empty() ? "decode failed" : "inference failed";
+            failed++;
+        } else {
+            line["object_detect_result_list"] = detectionsToJson(od_results, options.suppress_empty);
+        }
+
+        if (evaluator) {
+            auto image = ground_truth.image_ids.find(std::filesystem::path(item.path).filename().string());
+            if (image == ground_truth.image_ids.end()) {
+                unannotated++;
+            } else {
+                // A failed image counts as one without detections
+                if (ret < 0) {
+                    od_results.clear();
+                }
+                evaluator->evaluateImage(ground_truth.boxes[image->second], od_results,
+                                         CocoEvaluator::coco80_to_coco91());
+                ground_truth.boxes.erase(image->second);
+            }
+        }
+        out << line.dump() << '\n';
+        processed++;
+        if (item.rgb.capacity() > 0) {
+            decoded.recycle(std::move(item.rgb));
+        }
+    }
+    out.flush();
+
+    decoded.close();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+    LOGI("Batch: %zu/%zu images (%zu failed) in %.2f s, %.1f images/s, mean inference %.1f ms\n",
+           processed, paths.size(), failed, elapsed_s,
+           elapsed_s > 0 ? processed / elapsed_s : 0.0,
+           inferred > 0 ? inference_ms_total / inferred : 0.0);
+    if (cache) {
+        LOGI("Batch: %llu results from the result cache, %llu lookups missed\n", (unsigned long long)cache->hits(),
+             (unsigned long long)cache->misses());
+    }
+    if (scaled_decodes > 0) {
+        LOGI("Batch: %zu JPEGs decoded at a reduced DCT scale\n", scaled_decodes.load());
+    }
+
+    if (evaluator) {
+        CocoStats stats = evaluator->summarize();
+        LOGI("Batch: COCO bbox evaluation of %zu images (%zu not in %s), %zu detection records\n",
+             evaluator->images(), unannotated, options.coco_annotations.c_str(), evaluator->records());
+        // One stat per message: the whole table does not fit a log slot
+        for (int i = 0; i < 12; i++) {
+            LOGI("Batch:%s\n", stats.line(i).c_str());
+        }
+        LOGI("Batch: mAP %.3f, mAP50 %.3f at %.1f images/s\n", stats.ap(), stats.ap50(),
+             elapsed_s > 0 ? processed / elapsed_s : 0.0);
+    }
+
+    deinit_post_process();
+    release_yolo_model(&app_ctx);
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "camera_inference.h"
+
+#include <string.h>
+
+#include "latency_report.h"
+#include "log.h"
+#include "metrics.h"
+#include "postprocess.h"
+#include "yolo.h"
+
+// How long acquire() waits before re-checking running
+static const std::chrono::milliseconds ACQUIRE_TIMEOUT(100);
+
+CameraInferenceThread::CameraInferenceThread(
+        const std::string& model_path,
+        std::unique_ptr<CameraSource> source,
+        ThreadSafeQueue<InferenceResult>& outputQueue,
+        std::atomic<bool>& isRunning,
+        std::shared_ptr<AsyncFrameWriter> frameWriter,
+        std::function<void()> onFinished)
+    : model_path(model_path),
+      source(std::move(source)),
+      outputQueue(outputQueue),
+      running(isRunning),
+      frameWriter(frameWriter),
+      onFinished(onFinished) {
+}
+
+void CameraInferenceThread::operator()() {
+    rknn_app_context_t app_ctx;
+    memset(&app_ctx, 0, sizeof(app_ctx));
+
+    if (!source->start()) {
+        LOGE("Camera: cannot start capture\n");
+    } else if (init_yolo_model(model_path.c_str(), &app_ctx) != 0) {
+        LOGE("Camera: init_yolo_model fail! model_path=%s\n", model_path.c_str());
+    } else {
+        init_post_process();
+
+        // Capture timestamp to result queued
+        LatencyHistogram frame_latency;
+        uint64_t frames = 0;
+        uint64_t failed = 0;
+        auto start = std::chrono::steady_clock::now();
+        cv::Mat bgr;
+
+        while (running) {
+            FrameLease lease;
+            {
+                ScopedStageTimer timer(Stage::Capture);
+                lease = source->acquire(ACQUIRE_TIMEOUT);
+            }
+            if (!lease) {
+                if (source->finished()) {
+                    break;
+                }
+                continue;
+            }
+
+            InferenceResult result;
+            int64_t inference_start = monotonic_ns();
+            if (inference_yolo_model_yuv(&app_ctx, &lease.frame(), &result.detections) < 0) {
+                failed++;
+                continue;
+            }
+            result.timestamp = std::chrono::system_clock::now();
+            frame_timing_t& timing = result.detections.timing;
+            timing.capture_ns = monotonic_ns(lease.timestamp());
+            timing.inference_start_ns = inference_start;
+            timing.inference_end_ns = monotonic_ns();
+            timing.capture_wall_ms = wall_ms_at(timing.capture_ns);
+            // Only convert the whole frame when the preview will take it
+            if (frameWriter && frameWriter->wantsFrame(result.detections)) {
+                const YuvFrame& frame = lease.frame();
+                if (frame.format == YuvFormat::YUYV) {
+                    cv::Mat yuyv(frame.height, frame.width, CV_8UC2, (void*)frame.data, frame.stride);
+                    cv::cvtColor(yuyv, bgr, cv::COLOR_YUV2BGR_YUYV);
+                } else {
+                    cv::Mat y(frame.height, frame.width, CV_8UC1, (void*)frame.data, frame.stride);
+                    cv::Mat uv(frame.height / 2, frame.width / 2, CV_8UC2, (void*)frame.uv, frame.uv_stride);
+                    cv::cvtColorTwoPlane(y, uv, bgr, cv::COLOR_YUV2BGR_NV12);
+                }
+                frameWriter->writeFrame(bgr, result.detections);
+            }
+            // Back to the driver before publishing
+            auto captured = lease.timestamp();
+            lease.reset();
+
+            outputQueue.push(std::move(result));
+            frame_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - captured).count());
+            frames++;
+        }
+
+        double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOGI("Camera: %llu frames inferred (%llu failed) of %llu captured, %llu stale frames recycled, "
+             "%.1f fps\n", (unsigned long long)frames, (unsigned long long)failed,
+             (unsigned long long)source->capturedFrames(), (unsigned long long)source->staleFrames(),
+             elapsed_s > 0 ? frames / elapsed_s : 0.0);
+        LOGI("Camera: capture to result p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+             frame_latency.percentile(0.50) / 1e6, frame_latency.percentile(0.90) / 1e6,
+             frame_latency.percentile(0.99) / 1e6, frame_latency.max() / 1e6);
+
+        deinit_post_process();
+        release_yolo_model(&app_ctx);
+    }
+    source->stop();
+
+    if (onFinished) {
+        onFinished();
+    }
+}
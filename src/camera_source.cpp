@@ -0,0 +1,593 @@
+#include "camera_source.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <linux/videodev2.h>
+
+#include "log.h"
+#include "metrics.h"
+
+// One filling, one leased to the pipeline, one spare
+static const int MIN_BUFFERS = 3;
+
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept {
+    if (this != &other) {
+        reset();
+        source = other.source;
+        index = other.index;
+        yuv = other.yuv;
+        dmabuf_fd = other.dmabuf_fd;
+        seq = other.seq;
+        captured = other.captured;
+        other.source = nullptr;
+        other.index = -1;
+    }
+    return *this;
+}
+
+void FrameLease::reset() {
+    if (source) {
+        source->release(index);
+        source = nullptr;
+        index = -1;
+    }
+}
+
+FrameLease CameraSource::lease(int index, const YuvFrame& frame, int dmabuf_fd, uint64_t sequence,
+                               std::chrono::steady_clock::time_point captured) {
+    FrameLease lease;
+    lease.source = this;
+    lease.index = index;
+    lease.yuv = frame;
+    lease.dmabuf_fd = dmabuf_fd;
+    lease.seq = sequence;
+    lease.captured = captured;
+    return lease;
+}
+
+void CameraSource::dropFrame() {
+    stale_frames++;
+    Metrics::instance().add(Counter::DroppedFrames);
+}
+
+static int xioctl(int fd, unsigned long request, void* arg) {
+    int ret;
+    do {
+        ret = ioctl(fd, request, arg);
+    } while (ret == -1 && errno == EINTR);
+    return ret;
+}
+
+V4l2CameraSource::V4l2CameraSource(const std::string& device, const CameraOptions& options)
+    : CameraSource(options), device(device) {
+}
+
+V4l2CameraSource::~V4l2CameraSource() {
+    stop();
+}
+
+bool V4l2CameraSource::configure() {
+    struct v4l2_capability cap;
+    memset(&cap, 0, sizeof(cap));
+    if (xioctl(fd, VIDIOC_QUERYCAP, &cap) < 0) {
+        LOGE("%s: VIDIOC_QUERYCAP: %s\n", device.c_str(), strerror(errno));
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (caps & V4L2_CAP_VIDEO_CAPTURE) {
+        buf_type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        multiplanar = false;
+    } else if (caps & V4L2_CAP_VIDEO_CAPTURE_MPLANE) {
+        buf_type = V4L2_BUF_TYPE_VIDEO_CAPTURE_MPLANE;
+        multiplanar = true;
+    } else {
+        LOGE("%s: not a video capture device\n", device.c_str());
+        return false;
+    }
+    if (!(caps & V4L2_CAP_STREAMING)) {
+        LOGE("%s: no streaming I/O\n", device.c_str());
+        return false;
+    }
+
+    uint32_t pixelformat = format.format == YuvFormat::YUYV ? V4L2_PIX_FMT_YUYV : V4L2_PIX_FMT_NV12;
+    struct v4l2_format fmt;
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = buf_type;
+    if (multiplanar) {
+        fmt.fmt.pix_mp.width = format.width;
+        fmt.fmt.pix_mp.height = format.height;
+        fmt.fmt.pix_mp.pixelformat = pixelformat;
+        fmt.fmt.pix_mp.field = V4L2_FIELD_NONE;
+        fmt.fmt.pix_mp.num_planes = 1;
+    } else {
+        fmt.fmt.pix.width = format.width;
+        fmt.fmt.pix.height = format.height;
+        fmt.fmt.pix.pixelformat = pixelformat;
+        fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    }
+    if (xioctl(fd, VIDIOC_S_FMT, &fmt) < 0) {
+        LOGE("%s: VIDIOC_S_FMT: %s\n", device.c_str(), strerror(errno));
+        return false;
+    }
+
+    // The driver adjusts what it cannot do
+    uint32_t got_format;
+    if (multiplanar) {
+        got_format = fmt.fmt.pix_mp.pixelformat;
+        format.width = fmt.fmt.pix_mp.width;
+        format.height = fmt.fmt.pix_mp.height;
+        stride = fmt.fmt.pix_mp.plane_fmt[0].bytesperline;
+        if (fmt.fmt.pix_mp.num_planes != 1) {
+            LOGE("%s: %d-plane buffers are not supported\n", device.c_str(), fmt.fmt.pix_mp.num_planes);
+            return false;
+        }
+    } else {
+        got_format = fmt.fmt.pix.pixelformat;
+        format.width = fmt.fmt.pix.width;
+        format.height = fmt.fmt.pix.height;
+        stride = fmt.fmt.pix.bytesperline;
+    }
+    if (got_format != pixelformat) {
+        LOGE("%s: %s is not supported\n", device.c_str(), format.format == YuvFormat::YUYV ? "YUYV" : "NV12");
+        return false;
+    }
+    int min_stride = format.format == YuvFormat::YUYV ? format.width * 2 : format.width;
+    stride = std::max(stride, min_stride);
+    frame_size = (size_t)stride * format.height;
+    if (format.format == YuvFormat::NV12) {
+        frame_size += frame_size / 2;
+    }
+
+    // Frame rate is best effort, many drivers only offer fixed rates
+    struct v4l2_streamparm parm;
+    memset(&parm, 0, sizeof(parm));
+    parm.type = buf_type;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = format.fps;
+    if (format.fps > 0 && xioctl(fd, VIDIOC_S_PARM, &parm) == 0 && parm.parm.capture.timeperframe.numerator > 0) {
+        format.fps = parm.parm.capture.timeperframe.denominator / parm.parm.capture.timeperframe.numerator;
+    }
+    return true;
+}
+
+bool V4l2CameraSource::mapBuffers() {
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = std::max(format.buffers, MIN_BUFFERS);
+    req.type = buf_type;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0) {
+        LOGE("%s: VIDIOC_REQBUFS: %s\n", device.c_str(), strerror(errno));
+        return false;
+    }
+    if ((int)req.count < MIN_BUFFERS) {
+        LOGE("%s: only %u capture buffers\n", device.c_str(), req.count);
+        return false;
+    }
+    format.buffers = req.count;
+    buffers.resize(req.count);
+
+    for (uint32_t i = 0; i < req.count; i++) {
+        struct v4l2_buffer buf;
+        struct v4l2_plane planes[VIDEO_MAX_PLANES];
+        memset(&buf, 0, sizeof(buf));
+        memset(planes, 0, sizeof(planes));
+        buf.type = buf_type;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (multiplanar) {
+            buf.m.planes = planes;
+            buf.length = VIDEO_MAX_PLANES;
+        }
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            LOGE("%s: VIDIOC_QUERYBUF: %s\n", device.c_str(), strerror(errno));
+            return false;
+        }
+        size_t length = multiplanar ? planes[0].length : buf.length;
+        off_t offset = multiplanar ? planes[0].m.mem_offset : buf.m.offset;
+        if (length < frame_size) {
+            LOGE("%s: buffer of %zu bytes for a %zu byte frame\n", device.c_str(), length, frame_size);
+            return false;
+        }
+        void* start = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+        if (start == MAP_FAILED) {
+            LOGE("%s: mmap: %s\n", device.c_str(), strerror(errno));
+            return false;
+        }
+        buffers[i].start = start;
+        buffers[i].length = length;
+
+        if (format.export_dmabuf) {
+            struct v4l2_exportbuffer expbuf;
+            memset(&expbuf, 0, sizeof(expbuf));
+            expbuf.type = buf_type;
+            expbuf.index = i;
+            expbuf.plane = 0;
+            expbuf.flags = O_CLOEXEC | O_RDONLY;
+            if (xioctl(fd, VIDIOC_EXPBUF, &expbuf) == 0) {
+                buffers[i].dmabuf_fd = expbuf.fd;
+            } else {
+                LOGW("%s: VIDIOC_EXPBUF: %s, continuing without DMABUF\n", device.c_str(), strerror(errno));
+                format.export_dmabuf = false;
+            }
+        }
+    }
+    return true;
+}
+
+bool V4l2CameraSource::queue(int index) {
+    struct v4l2_buffer buf;
+    struct v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buf, 0, sizeof(buf));
+    memset(planes, 0, sizeof(planes));
+    buf.type = buf_type;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = index;
+    if (multiplanar) {
+        buf.m.planes = planes;
+        buf.length = 1;
+    }
+    if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+        LOGE("%s: VIDIOC_QBUF: %s\n", device.c_str(), strerror(errno));
+        return false;
+    }
+    queued++;
+    return true;
+}
+
+int V4l2CameraSource::dequeue(uint32_t* bytes_used, uint32_t* sequence,
+                              std::chrono::steady_clock::time_point* captured) {
+    struct v4l2_buffer buf;
+    struct v4l2_plane planes[VIDEO_MAX_PLANES];
+    memset(&buf, 0, sizeof(buf));
+    memset(planes, 0, sizeof(planes));
+    buf.type = buf_type;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (multiplanar) {
+        buf.m.planes = planes;
+        buf.length = VIDEO_MAX_PLANES;
+    }
+    if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) {
+        if (errno != EAGAIN) {
+            LOGE("%s: VIDIOC_DQBUF: %s\n", device.c_str(), strerror(errno));
+            done = true;
+        }
+        return -1;
+    }
+    queued--;
+
+    *bytes_used = (buf.flags & V4L2_BUF_FLAG_ERROR) ? 0 : (multiplanar ? planes[0].bytesused : buf.bytesused);
+    *sequence = buf.sequence;
+    // Monotonic driver timestamps share steady_clock's epoch on Linux
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC &&
+        (buf.timestamp.tv_sec != 0 || buf.timestamp.tv_usec != 0)) {
+        *captured = std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::seconds(buf.timestamp.tv_sec) + std::chrono::microseconds(buf.timestamp.tv_usec)));
+    } else {
+        *captured = std::chrono::steady_clock::now();
+    }
+    return buf.index;
+}
+
+bool V4l2CameraSource::start() {
+    fd = open(device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("%s: %s\n", device.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = configure() && mapBuffers();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; ok && i < (int)buffers.size(); i++) {
+            ok = queue(i);
+        }
+    }
+    if (ok && xioctl(fd, VIDIOC_STREAMON, &buf_type) < 0) {
+        LOGE("%s: VIDIOC_STREAMON: %s\n", device.c_str(), strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        stop();
+        return false;
+    }
+    streaming = true;
+    LOGI("%s: %dx%d %s at %d fps, %d mmap buffers%s\n", device.c_str(), format.width, format.height,
+         format.format == YuvFormat::YUYV ? "YUYV" : "NV12", format.fps, format.buffers,
+         format.export_dmabuf ? " exported as DMABUF" : "");
+    return true;
+}
+
+void V4l2CameraSource::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+    if (streaming) {
+        xioctl(fd, VIDIOC_STREAMOFF, &buf_type);
+        streaming = false;
+    }
+    for (Buffer& buffer : buffers) {
+        if (buffer.dmabuf_fd >= 0) {
+            close(buffer.dmabuf_fd);
+        }
+        if (buffer.start) {
+            munmap(buffer.start, buffer.length);
+        }
+    }
+    buffers.clear();
+    queued = 0;
+
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.type = buf_type;
+    req.memory = V4L2_MEMORY_MMAP;
+    xioctl(fd, VIDIOC_REQBUFS, &req);
+    close(fd);
+    fd = -1;
+}
+
+FrameLease V4l2CameraSource::acquire(std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    int newest = -1;
+    uint32_t newest_sequence = 0;
+    std::chrono::steady_clock::time_point newest_captured;
+
+    while (!done) {
+        {
+            // Drain everything already captured, keeping only the newest frame
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!streaming) {
+                break;
+            }
+            uint32_t bytes_used, sequence;
+            std::chrono::steady_clock::time_point captured;
+            int index;
+            while ((index = dequeue(&bytes_used, &sequence, &captured)) >= 0) {
+                captured_frames++;
+                if (bytes_used < frame_size) {
+                    // Corrupt or short frame
+                    dropFrame();
+                    queue(index);
+                    continue;
+                }
+                if (newest >= 0) {
+                    dropFrame();
+                    queue(newest);
+                }
+                newest = index;
+                newest_sequence = sequence;
+                newest_captured = captured;
+            }
+            if (newest >= 0 || queued == 0) {
+                // With every buffer leased out there is nothing to wait for
+                break;
+            }
+        }
+
+        int wait_ms = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (wait_ms <= 0) {
+            break;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int ret = poll(&pfd, 1, wait_ms);
+        if (ret < 0 && errno != EINTR) {
+            LOGE("%s: poll: %s\n", device.c_str(), strerror(errno));
+            done = true;
+        } else if (ret > 0 && (pfd.revents & (POLLERR | POLLHUP))) {
+            LOGE("%s: device error, stopping capture\n", device.c_str());
+            done = true;
+        } else if (ret == 0) {
+            break;
+        }
+    }
+    if (newest < 0) {
+        return FrameLease();
+    }
+
+    YuvFrame frame;
+    frame.format = format.format;
+    frame.width = format.width;
+    frame.height = format.height;
+    frame.data = (const uint8_t*)buffers[newest].start;
+    frame.stride = stride;
+    if (format.format == YuvFormat::NV12) {
+        frame.uv = frame.data + (size_t)stride * format.height;
+        frame.uv_stride = stride;
+    }
+    return lease(newest, frame, buffers[newest].dmabuf_fd, newest_sequence, newest_captured);
+}
+
+void V4l2CameraSource::release(int index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (streaming) {
+        queue(index);
+    }
+}
+
+RawFileCameraSource::RawFileCameraSource(const std::string& path, const CameraOptions& options)
+    : CameraSource(options), path(path) {
+}
+
+RawFileCameraSource::~RawFileCameraSource() {
+    stop();
+}
+
+bool RawFileCameraSource::start() {
+    if (format.width <= 0 || format.height <= 0) {
+        LOGE("%s: frame size required\n", path.c_str());
+        return false;
+    }
+    // Opening a pipe waits for its writer
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    seekable = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    frame_size = yuv_frame_size(format.format, format.width, format.height);
+    if (seekable && (size_t)st.st_size < frame_size) {
+        LOGE("%s: smaller than one %dx%d frame\n", path.c_str(), format.width, format.height);
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    format.buffers = std::max(format.buffers, MIN_BUFFERS);
+    buffers.resize(format.buffers);
+    for (int i = 0; i < format.buffers; i++) {
+        buffers[i].data.resize(frame_size);
+        free_buffers.push_back(i);
+    }
+    stopping = false;
+    reader = std::thread(&RawFileCameraSource::readerLoop, this);
+    LOGI("%s: raw %dx%d %s frames%s\n", path.c_str(), format.width, format.height,
+         format.format == YuvFormat::YUYV ? "YUYV" : "NV12", seekable ? "" : " from a pipe");
+    return true;
+}
+
+void RawFileCameraSource::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frame_ready.notify_all();
+    buffer_free.notify_all();
+    if (reader.joinable()) {
+        reader.join();
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool RawFileCameraSource::readFrame(uint8_t* data) {
+    size_t got = 0;
+    bool rewound = false;
+    while (got < frame_size) {
+        if (!seekable) {
+            // Wake up now and then to notice stop()
+            struct pollfd pfd = {fd, POLLIN, 0};
+            int ret = poll(&pfd, 1, 100);
+            if (ret == 0 || (ret < 0 && errno == EINTR)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping) {
+                    return false;
+                }
+                continue;
+            }
+        }
+        ssize_t n = read(fd, data + got, frame_size - got);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            LOGE("%s: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+        if (n == 0) {
+            // A trailing partial frame is dropped
+            if (!seekable || !format.loop || rewound) {
+                return false;
+            }
+            lseek(fd, 0, SEEK_SET);
+            rewound = true;
+            got = 0;
+            continue;
+        }
+        got += n;
+    }
+    return true;
+}
+
+void RawFileCameraSource::readerLoop() {
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / std::max(format.fps, 1)));
+    auto next_due = std::chrono::steady_clock::now();
+    uint64_t sequence = 0;
+
+    while (true) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            buffer_free.wait(lock, [this] { return stopping || !free_buffers.empty() || !filled.empty(); });
+            if (stopping) {
+                return;
+            }
+            if (!free_buffers.empty()) {
+                index = free_buffers.back();
+                free_buffers.pop_back();
+            } else {
+                // Consumer behind: overwrite the oldest unread frame
+                index = filled.front();
+                filled.erase(filled.begin());
+                dropFrame();
+            }
+        }
+
+        if (seekable) {
+            auto now = std::chrono::steady_clock::now();
+            if (next_due + interval < now) {
+                next_due = now;
+            }
+            std::this_thread::sleep_until(next_due);
+            next_due += interval;
+        }
+        bool ok = readFrame(buffers[index].data.data());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!ok) {
+            free_buffers.push_back(index);
+            done = true;
+            frame_ready.notify_all();
+            return;
+        }
+        buffers[index].sequence = sequence++;
+        buffers[index].captured = std::chrono::steady_clock::now();
+        filled.push_back(index);
+        captured_frames++;
+        frame_ready.notify_all();
+    }
+}
+
+FrameLease RawFileCameraSource::acquire(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex);
+    frame_ready.wait_for(lock, timeout, [this] { return stopping || done || !filled.empty(); });
+    if (filled.empty()) {
+        return FrameLease();
+    }
+    int index = filled.back();
+    filled.pop_back();
+    for (int stale : filled) {
+        free_buffers.push_back(stale);
+        dropFrame();
+    }
+    filled.clear();
+    lock.unlock();
+    buffer_free.notify_one();
+
+    YuvFrame frame;
+    frame.format = format.format;
+    frame.width = format.width;
+    frame.height = format.height;
+    frame.data = buffers[index].data.data();
+    return lease(index, frame, -1, buffers[index].sequence, buffers[index].captured);
+}
+
+void RawFileCameraSource::release(int index) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(index);
+    }
+    buffer_free.notify_one();
+}
@@ -0,0 +1,65 @@
+#include "coco_eval.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <nlohmann/json.hpp>
+
+#include "log.h"
+
+using json = nlohmann::json;
+
+int loadCocoAnnotations(const std::string& path, CocoGroundTruth* ground_truth) {
+    std::ifstream in(path);
+    if (!in) {
+        LOGE("COCO: cannot open %s\n", path.c_str());
+        return -1;
+    }
+
+    // Polygons and RLE masks are most of the file and not needed for boxes
+    json::parser_callback_t skip_masks = [](int /*depth*/, json::parse_event_t event, json& parsed) {
+        return !(event == json::parse_event_t::key && parsed == "segmentation");
+    };
+    json doc;
+    try {
+        doc = json::parse(in, skip_masks);
+    } catch (const json::exception& e) {
+        LOGE("COCO: cannot parse %s: %s\n", path.c_str(), e.what());
+        return -1;
+    }
+
+    try {
+        for (const auto& category : doc.at("categories")) {
+            ground_truth->category_ids.push_back(category.at("id").get<int>());
+        }
+        std::sort(ground_truth->category_ids.begin(), ground_truth->category_ids.end());
+        for (const auto& image : doc.at("images")) {
+            int id = image.at("id").get<int>();
+            ground_truth->image_ids[image.at("file_name").get<std::string>()] = id;
+            ground_truth->boxes[id];   // Images without annotations still count
+        }
+        for (const auto& annotation : doc.at("annotations")) {
+            const auto& bbox = annotation.at("bbox");
+            CocoBox box;
+            box.x = bbox.at(0).get<float>();
+            box.y = bbox.at(1).get<float>();
+            box.w = bbox.at(2).get<float>();
+            box.h = bbox.at(3).get<float>();
+            box.category_id = annotation.at("category_id").get<int>();
+            box.area = annotation.value("area", box.w * box.h);
+            box.iscrowd = annotation.value("iscrowd", 0) != 0;
+            ground_truth->boxes[annotation.at("image_id").get<int>()].push_back(box);
+        }
+    } catch (const json::exception& e) {
+        LOGE("COCO: unexpected annotation format in %s: %s\n", path.c_str(), e.what());
+        return -1;
+    }
+
+    size_t annotations = 0;
+    for (const auto& image : ground_truth->boxes) {
+        annotations += image.second.size();
+    }
+    LOGI("COCO: %zu images, %zu annotations, %zu categories from %s\n", ground_truth->image_ids.size(), annotations,
+         ground_truth->category_ids.size(), path.c_str());
+    return 0;
+}
@@ -0,0 +1,321 @@
+#include "coco_eval.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+namespace {
+
+// Area ranges of COCOeval.Params: all, small, medium, large
+const double AREA_LO[] = {0.0, 0.0, 32.0 * 32.0, 96.0 * 96.0};
+const double AREA_HI[] = {1e5 * 1e5, 32.0 * 32.0, 96.0 * 96.0, 1e5 * 1e5};
+const int RECALL_POINTS = 101;
+
+// np.linspace(start, stop, num) element i, bit for bit
+double linspace(double start, double stop, int num, int i) {
+    if (i == num - 1) {
+        return stop;
+    }
+    return i * ((stop - start) / (num - 1)) + start;
+}
+
+double iou_threshold(int t) {
+    return linspace(0.5, 0.95, 10, t);
+}
+
+// maskUtils.iou() for boxes; a crowd ground truth is measured against the detection area only
+double box_iou(const CocoBox& dt, const CocoBox& gt) {
+    double w = std::min((double)dt.x + dt.w, (double)gt.x + gt.w) - std::max((double)dt.x, (double)gt.x);
+    double h = std::min((double)dt.y + dt.h, (double)gt.y + gt.h) - std::max((double)dt.y, (double)gt.y);
+    if (w <= 0 || h <= 0) {
+        return 0.0;
+    }
+    double inter = w * h;
+    double dt_area = (double)dt.w * dt.h;
+    double uni = gt.iscrowd ? dt_area : dt_area + (double)gt.w * gt.h - inter;
+    return uni > 0 ? inter / uni : 0.0;
+}
+
+}  // namespace
+
+std::string CocoStats::line(int i) const {
+    static const struct {
+        bool precision;
+        const char* iou;
+        const char* area;
+        int max_dets;
+    } lines[12] = {
+        {true, "0.50:0.95", "all", 100},   {true, "0.50", "all", 100},       {true, "0.75", "all", 100},
+        {true, "0.50:0.95", "small", 100}, {true, "0.50:0.95", "medium", 100}, {true, "0.50:0.95", "large", 100},
+        {false, "0.50:0.95", "all", 1},    {false, "0.50:0.95", "all", 10},    {false, "0.50:0.95", "all", 100},
+        {false, "0.50:0.95", "small", 100}, {false, "0.50:0.95", "medium", 100}, {false, "0.50:0.95", "large", 100},
+    };
+    char text[128];
+    snprintf(text, sizeof(text), " %-18s %s @[ IoU=%-9s | area=%6s | maxDets=%3d ] = %0.3f",
+             lines[i].precision ? "Average Precision" : "Average Recall", lines[i].precision ? "(AP)" : "(AR)",
+             lines[i].iou, lines[i].area, lines[i].max_dets, stats[i]);
+    return text;
+}
+
+std::string CocoStats::format() const {
+    std::string text;
+    for (int i = 0; i < 12; i++) {
+        text += line(i) + "\n";
+    }
+    return text;
+}
+
+CocoEvaluator::CocoEvaluator(const std::vector<int>& category_ids)
+    : category_ids(category_ids),
+      accumulators(category_ids.size() * AREA_RANGES) {
+    for (size_t i = 0; i < category_ids.size(); i++) {
+        category_index[category_ids[i]] = (int)i;
+    }
+}
+
+void CocoEvaluator::evaluateImage(const std::vector<CocoBox>& ground_truth, const std::vector<CocoBox>& detections) {
+    image_count++;
+
+    std::vector<std::vector<const CocoBox*>> gts(category_ids.size());
+    std::vector<std::vector<const CocoBox*>> dts(category_ids.size());
+    for (const CocoBox& box : ground_truth) {
+        auto it = category_index.find(box.category_id);
+        if (it != category_index.end()) {
+            gts[it->second].push_back(&box);
+        }
+    }
+    for (const CocoBox& box : detections) {
+        auto it = category_index.find(box.category_id);
+        if (it != category_index.end()) {
+            dts[it->second].push_back(&box);
+        }
+    }
+    for (size_t k = 0; k < category_ids.size(); k++) {
+        if (!gts[k].empty() || !dts[k].empty()) {
+            evaluateCategory((int)k, gts[k], dts[k]);
+        }
+    }
+}
+
+void CocoEvaluator::evaluateImage(const std::vector<CocoBox>& ground_truth, const object_detect_result_list& results,
+                                  const std::vector<int>& category_map) {
+    std::vector<CocoBox> detections;
+    detections.reserve(results.count);
+    for (int i = 0; i < results.count; i++) {
+        int cls = results.cls_ids[i];
+        if (cls < 0 || cls >= (int)category_map.size()) {
+            continue;
+        }
+        const box_rect_t& box = results.boxes[i];
+        CocoBox dt;
+        dt.x = box.left;
+        dt.y = box.top;
+        dt.w = box.right - box.left;
+        dt.h = box.bottom - box.top;
+        dt.category_id = category_map[cls];
+        dt.score = results.props[i];
+        detections.push_back(dt);
+    }
+    evaluateImage(ground_truth, detections);
+}
+
+// COCOeval.evaluateImg() for one image and category, all area ranges
+void CocoEvaluator::evaluateCategory(int category, std::vector<const CocoBox*>& gts,
+                                     std::vector<const CocoBox*>& dts) {
+    std::stable_sort(dts.begin(), dts.end(), [](const CocoBox* a, const CocoBox* b) { return a->score > b->score; });
+    if (dts.size() > MAX_DETECTIONS) {
+        dts.resize(MAX_DETECTIONS);
+    }
+    size_t n_dt = dts.size();
+    size_t n_gt = gts.size();
+
+    std::vector<int> order(n_gt);
+    std::vector<char> gt_ignored(n_gt);
+    std::vector<double> ious(n_dt * n_gt);
+    std::vector<int> gt_match(n_gt);
+    std::vector<int> dt_match(n_dt * IOU_THRESHOLDS);
+    std::vector<char> dt_ignored(n_dt * IOU_THRESHOLDS);
+
+    for (int a = 0; a < AREA_RANGES; a++) {
+        Accumulator& acc = accumulators[category * AREA_RANGES + a];
+
+        // Non-ignored ground truth first, ties in annotation order
+        for (size_t g = 0; g < n_gt; g++) {
+            gt_ignored[g] = gts[g]->iscrowd || gts[g]->area < AREA_LO[a] || gts[g]->area > AREA_HI[a];
+            order[g] = (int)g;
+            acc.ground_truth += !gt_ignored[g];
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int x, int y) { return gt_ignored[x] < gt_ignored[y]; });
+        for (size_t d = 0; d < n_dt; d++) {
+            for (size_t j = 0; j < n_gt; j++) {
+                ious[d * n_gt + j] = box_iou(*dts[d], *gts[order[j]]);
+            }
+        }
+
+        std::fill(dt_match.begin(), dt_match.end(), -1);
+        std::fill(dt_ignored.begin(), dt_ignored.end(), 0);
+        for (int t = 0; t < IOU_THRESHOLDS; t++) {
+            std::fill(gt_match.begin(), gt_match.end(), -1);
+            for (size_t d = 0; d < n_dt; d++) {
+                double best = std::min(iou_threshold(t), 1 - 1e-10);
+                int m = -1;
+                for (size_t j = 0; j < n_gt; j++) {
+                    int g = order[j];
+                    if (gt_match[j] >= 0 && !gts[g]->iscrowd) {
+                        continue;   // Already matched, and not a crowd
+                    }
+                    if (m > -1 && !gt_ignored[order[m]] && gt_ignored[g]) {
+                        break;      // Matched a regular box, only ignored ones are left
+                    }
+                    if (ious[d * n_gt + j] < best) {
+                        continue;
+                    }
+                    best = ious[d * n_gt + j];
+                    m = (int)j;
+                }
+                if (m == -1) {
+                    continue;
+                }
+                dt_ignored[t * n_dt + d] = gt_ignored[order[m]];
+                dt_match[t * n_dt + d] = m;
+                gt_match[m] = (int)d;
+            }
+        }
+
+        for (size_t d = 0; d < n_dt; d++) {
+            double area = (double)dts[d]->w * dts[d]->h;
+            bool outside = area < AREA_LO[a] || area > AREA_HI[a];
+            Record record;
+            record.score = dts[d]->score;
+            record.matched = 0;
+            record.ignored = 0;
+            record.rank = (uint8_t)d;
+            for (int t = 0; t < IOU_THRESHOLDS; t++) {
+                bool matched = dt_match[t * n_dt + d] >= 0;
+                if (matched) {
+                    record.matched |= 1 << t;
+                }
+                if (dt_ignored[t * n_dt + d] || (!matched && outside)) {
+                    record.ignored |= 1 << t;
+                }
+            }
+            // Ignored at every threshold: counts neither way
+            if (record.ignored != (1 << IOU_THRESHOLDS) - 1) {
+                acc.records.push_back(record);
+            }
+        }
+    }
+}
+
+// COCOeval.accumulate() for one category / area range / detection cap
+void CocoEvaluator::accumulate(const Accumulator& acc, int max_dets, double* recall, double* precision) const {
+    std::vector<const Record*> records;
+    records.reserve(acc.records.size());
+    for (const Record& record : acc.records) {
+        if (record.rank < max_dets) {
+            records.push_back(&record);
+        }
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const Record* a, const Record* b) { return a->score > b->score; });
+
+    size_t nd = records.size();
+    std::vector<double> rc(nd);
+    std::vector<double> pr(nd);
+    for (int t = 0; t < IOU_THRESHOLDS; t++) {
+        double tp = 0, fp = 0;
+        for (size_t i = 0; i < nd; i++) {
+            if (!(records[i]->ignored & (1 << t))) {
+                if (records[i]->matched & (1 << t)) {
+                    tp++;
+                } else {
+                    fp++;
+                }
+            }
+            rc[i] = tp / acc.ground_truth;
+            pr[i] = tp / (fp + tp + 2.220446049250313e-16);
+        }
+        recall[t] = nd ? rc[nd - 1] : 0.0;
+
+        for (size_t i = nd > 0 ? nd - 1 : 0; i > 0; i--) {
+            if (pr[i] > pr[i - 1]) {
+                pr[i - 1] = pr[i];
+            }
+        }
+        for (int r = 0; r < RECALL_POINTS; r++) {
+            size_t i = std::lower_bound(rc.begin(), rc.end(), linspace(0.0, 1.0, RECALL_POINTS, r)) - rc.begin();
+            precision[t * RECALL_POINTS + r] = i < nd ? pr[i] : 0.0;
+        }
+    }
+}
+
+CocoStats CocoEvaluator::summarize() const {
+    // Sums and counts of the defined values behind each of the 12 numbers
+    double sum[12] = {0};
+    double count[12] = {0};
+    double recall[IOU_THRESHOLDS];
+    std::vector<double> precision(IOU_THRESHOLDS * RECALL_POINTS);
+
+    auto add_precision = [&](int stat, int t_begin, int t_end) {
+        for (int t = t_begin; t < t_end; t++) {
+            for (int r = 0; r < RECALL_POINTS; r++) {
+                sum[stat] += precision[t * RECALL_POINTS + r];
+                count[stat]++;
+            }
+        }
+    };
+    auto add_recall = [&](int stat) {
+        for (int t = 0; t < IOU_THRESHOLDS; t++) {
+            sum[stat] += recall[t];
+            count[stat]++;
+        }
+    };
+
+    for (size_t k = 0; k < category_ids.size(); k++) {
+        for (int a = 0; a < AREA_RANGES; a++) {
+            const Accumulator& acc = accumulators[k * AREA_RANGES + a];
+            if (acc.ground_truth == 0) {
+                continue;   // Undefined (-1) in COCOeval, left out of the means
+            }
+            if (a == 0) {
+                accumulate(acc, 1, recall, precision.data());
+                add_recall(6);
+                accumulate(acc, 10, recall, precision.data());
+                add_recall(7);
+                accumulate(acc, MAX_DETECTIONS, recall, precision.data());
+                add_precision(0, 0, IOU_THRESHOLDS);
+                add_precision(1, 0, 1);
+                add_precision(2, 5, 6);
+                add_recall(8);
+            } else {
+                accumulate(acc, MAX_DETECTIONS, recall, precision.data());
+                add_precision(2 + a, 0, IOU_THRESHOLDS);
+                add_recall(8 + a);
+            }
+        }
+    }
+
+    CocoStats stats;
+    for (int i = 0; i < 12; i++) {
+        stats.stats[i] = count[i] > 0 ? sum[i] / count[i] : -1.0;
+    }
+    return stats;
+}
+
+size_t CocoEvaluator::records() const {
+    size_t total = 0;
+    for (const auto& acc : accumulators) {
+        total += acc.records.size();
+    }
+    return total;
+}
+
+const std::vector<int>& CocoEvaluator::coco80_to_coco91() {
+    static const std::vector<int> ids = {
+        1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 13, 14, 15, 16, 17, 18, 19, 20, 21,
+        22, 23, 24, 25, 27, 28, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44,
+        46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65,
+        67, 70, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 84, 85, 86, 87, 88, 89, 90,
+    };
+    return ids;
+}
@@ -0,0 +1,55 @@
+#include "detection_aggregates.h"
+
+#include <algorithm>
+
+// Add the aggregates in flags to a, in one pass over the detections
+static void compute(const object_detect_result_list& detections, unsigned flags, DetectionAggregates& a) {
+    flags &= ~a.computed;
+    if (!flags) {
+        return;
+    }
+
+    bool people = flags & AGGREGATE_PEOPLE;
+    bool nonempty = flags & AGGREGATE_NONEMPTY;
+    if (nonempty) {
+        a.nonempty.clear();
+    }
+
+    for (int i = 0; i < detections.count; i++) {
+        int cls = detections.cls_ids[i];
+        if (people && cls == PERSON_CLASS_ID) {
+            a.people_in_frame++;
+            if (!a.tracked) {
+                a.people_attending++;
+            } else if (detections.tracks[i].confirmed) {
+                a.people_attending++;
+                a.people_max_dwell_s = std::max(a.people_max_dwell_s, detections.tracks[i].dwell_s);
+            }
+        }
+        if (nonempty && detections.props[i] != 0.0f && cls != 0) {
+            a.nonempty.push_back(i);
+        }
+    }
+    a.computed |= flags;
+}
+
+const DetectionAggregates& object_detect_result_list::aggregates(unsigned needed) const {
+    bool tracked = (int)tracks.size() == count && count > 0;
+    const DetectionAggregates* cached = aggregates_cache.get();
+    if (cached && cached->count == count && cached->tracked == tracked && cached->has(needed)) {
+        return *cached;
+    }
+
+    // Copies of this list may share the cached instance, so extend a copy
+    std::shared_ptr<DetectionAggregates> next;
+    if (cached && cached->count == count && cached->tracked == tracked) {
+        next = std::make_shared<DetectionAggregates>(*cached);
+    } else {
+        next = std::make_shared<DetectionAggregates>();
+        next->count = count;
+        next->tracked = tracked;
+    }
+    compute(*this, needed, *next);
+    aggregates_cache = next;
+    return *next;
+}
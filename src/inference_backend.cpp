@@ -0,0 +1,365 @@
+#include "inference_backend.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "log.h"
+
+#ifndef NO_RKNN_RUNTIME
+#include "file_utils.h"
+#endif
+
+static bool default_mock_enabled = false;
+static MockBackendOptions default_mock_options;
+
+void set_default_mock_backend(const MockBackendOptions* options) {
+    default_mock_enabled = options != nullptr;
+    if (options) {
+        default_mock_options = *options;
+    }
+}
+
+std::unique_ptr<InferenceBackend> create_inference_backend() {
+    if (default_mock_enabled) {
+        return std::unique_ptr<InferenceBackend>(new MockRknnBackend(default_mock_options));
+    }
+#ifndef NO_RKNN_RUNTIME
+    return std::unique_ptr<InferenceBackend>(new RknnBackend());
+#else
+    LOGE("built without the RKNN runtime, only the mock backend is available\n");
+    return nullptr;
+#endif
+}
+
+#ifndef NO_RKNN_RUNTIME
+
+RknnBackend::~RknnBackend() {
+    if (ctx != 0) {
+        rknn_destroy(ctx);
+    }
+}
+
+int RknnBackend::init(const char* model_path) {
+    char* model = NULL;
+    int model_len = read_data_from_file(model_path, &model);
+    if (model == NULL) {
+        LOGE("load_model fail!\n");
+        return -1;
+    }
+
+    int ret = rknn_init(&ctx, model, model_len, 0, NULL);
+    free(model);
+    if (ret < 0) {
+        LOGE("rknn_init fail! ret=%d\n", ret);
+        ctx = 0;
+    }
+    return ret;
+}
+
+int RknnBackend::query(rknn_query_cmd cmd, void* info, uint32_t size) {
+    return rknn_query(ctx, cmd, info, size);
+}
+
+int RknnBackend::inputsSet(uint32_t n_inputs, rknn_input* inputs) {
+    return rknn_inputs_set(ctx, n_inputs, inputs);
+}
+
+int RknnBackend::run() {
+    return rknn_run(ctx, nullptr);
+}
+
+int RknnBackend::outputsGet(uint32_t n_outputs, rknn_output* outputs) {
+    return rknn_outputs_get(ctx, n_outputs, outputs, NULL);
+}
+
+int RknnBackend::outputsRelease(uint32_t n_outputs, rknn_output* outputs) {
+    return rknn_outputs_release(ctx, n_outputs, outputs);
+}
+
+rknn_tensor_mem* RknnBackend::createMem(uint32_t size) {
+#ifdef RKNPU1
+    (void)size;
+    return NULL;
+#else
+    return rknn_create_mem(ctx, size);
+#endif
+}
+
+int RknnBackend::destroyMem(rknn_tensor_mem* mem) {
+#ifdef RKNPU1
+    (void)mem;
+    return RKNN_ERR_FAIL;
+#else
+    return rknn_destroy_mem(ctx, mem);
+#endif
+}
+
+int RknnBackend::setIoMem(rknn_tensor_mem* mem, rknn_tensor_attr* attr) {
+#ifdef RKNPU1
+    (void)mem;
+    (void)attr;
+    return RKNN_ERR_FAIL;
+#else
+    return rknn_set_io_mem(ctx, mem, attr);
+#endif
+}
+
+int RknnBackend::memSync(rknn_tensor_mem* mem) {
+#ifdef RKNPU1
+    (void)mem;
+    return RKNN_SUCC;
+#else
+    return rknn_mem_sync(ctx, mem, RKNN_MEMORY_SYNC_FROM_DEVICE);
+#endif
+}
+
+int RknnBackend::setCoreMask(uint32_t core_mask) {
+#ifdef RKNPU1
+    (void)core_mask;
+    return RKNN_SUCC;
+#else
+    return rknn_set_core_mask(ctx, (rknn_core_mask)core_mask);
+#endif
+}
+
+#endif
+
+std::mutex MockRknnBackend::npu_mutex;
+
+MockRknnBackend::MockRknnBackend(const MockBackendOptions& options)
+    : options(options), rng(std::random_device{}()) {
+}
+
+MockRknnBackend::~MockRknnBackend() {
+    for (auto& bound : bound_outputs) {
+        destroyMem(bound.mem);
+    }
+    for (auto& frame : frames) {
+        release_output_tensors(&frame);
+    }
+}
+
+int MockRknnBackend::init(const char* model_path) {
+    std::vector<std::string> paths;
+    std::error_code ec;
+    if (std::filesystem::is_directory(options.recordings, ec)) {
+        for (const auto& entry : std::filesystem::directory_iterator(options.recordings, ec)) {
+            if (entry.path().extension() == ".rkt") {
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+    } else {
+        paths.push_back(options.recordings);
+    }
+    if (options.max_frames > 0 && (int)paths.size() > options.max_frames) {
+        paths.resize(options.max_frames);
+    }
+
+    for (const auto& path : paths) {
+        recorded_outputs_t frame;
+        if (load_output_tensors(path.c_str(), &frame) != 0) {
+            LOGW("mock NPU: skipping unreadable recording %s\n", path.c_str());
+            continue;
+        }
+        if (!frames.empty() && frame.io_num.n_output != frames[0].io_num.n_output) {
+            LOGW("mock NPU: skipping %s, recorded from a different model\n", path.c_str());
+            release_output_tensors(&frame);
+            continue;
+        }
+        frames.push_back(frame);
+    }
+    if (frames.empty()) {
+        LOGE("mock NPU: no recordings in '%s'\n", options.recordings.c_str());
+        return RKNN_ERR_MODEL_INVALID;
+    }
+
+    LOGI("mock NPU: replaying %zu recorded frames (model file %s ignored), latency %.1f +/- %.1f ms\n",
+         frames.size(), model_path, options.latency_ms, options.jitter_ms);
+    return RKNN_SUCC;
+}
+
+int MockRknnBackend::query(rknn_query_cmd cmd, void* info, uint32_t size) {
+    const recorded_outputs_t& model = frames[0];
+    switch (cmd) {
+    case RKNN_QUERY_IN_OUT_NUM:
+        if (size < sizeof(rknn_input_output_num)) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        *(rknn_input_output_num*)info = model.io_num;
+        return RKNN_SUCC;
+
+    case RKNN_QUERY_INPUT_ATTR: {
+        rknn_tensor_attr* attr = (rknn_tensor_attr*)info;
+        if (size < sizeof(rknn_tensor_attr) || attr->index >= model.io_num.n_input) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        uint32_t index = attr->index;
+        memset(attr, 0, sizeof(*attr));
+        attr->index = index;
+        attr->n_dims = 4;
+        attr->dims[0] = 1;
+        attr->dims[1] = model.model_height;
+        attr->dims[2] = model.model_width;
+        attr->dims[3] = 3;
+        attr->n_elems = model.model_width * model.model_height * 3;
+        attr->size = attr->n_elems;
+        attr->fmt = RKNN_TENSOR_NHWC;
+        attr->type = RKNN_TENSOR_UINT8;
+        attr->qnt_type = RKNN_TENSOR_QNT_NONE;
+        attr->scale = 1.0f;
+        snprintf(attr->name, sizeof(attr->name), "mock_input%u", index);
+        return RKNN_SUCC;
+    }
+
+    case RKNN_QUERY_OUTPUT_ATTR: {
+        rknn_tensor_attr* attr = (rknn_tensor_attr*)info;
+        if (size < sizeof(rknn_tensor_attr) || attr->index >= model.io_num.n_output) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        *attr = model.output_attrs[attr->index];
+        return RKNN_SUCC;
+    }
+
+    case RKNN_QUERY_NATIVE_OUTPUT_ATTR: {
+        rknn_tensor_attr* attr = (rknn_tensor_attr*)info;
+        if (size < sizeof(rknn_tensor_attr) || attr->index >= model.io_num.n_output) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        // Like RK3588: int8 outputs in NC1HWC2, the rest only as standard outputs
+        const rknn_tensor_attr& standard = model.output_attrs[attr->index];
+        if (standard.type != RKNN_TENSOR_INT8 || standard.n_dims != 4) {
+            return RKNN_ERR_PARAM_INVALID;
+        }
+        native_output_attr(&standard, RKNN_TENSOR_NC1HWC2, attr);
+        return RKNN_SUCC;
+    }
+
+    default:
+        return RKNN_ERR_PARAM_INVALID;
+    }
+}
+
+int MockRknnBackend::inputsSet(uint32_t n_inputs, rknn_input* inputs) {
+    const recorded_outputs_t& model = frames[0];
+    if (n_inputs != model.io_num.n_input || inputs[0].buf == NULL ||
+        inputs[0].size != (uint32_t)(model.model_width * model.model_height * 3)) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    return RKNN_SUCC;
+}
+
+int MockRknnBackend::run() {
+    std::normal_distribution<float> latency(options.latency_ms, options.jitter_ms);
+    auto duration = std::chrono::microseconds((int64_t)(std::max(0.0f, latency(rng)) * 1000.0f));
+
+    if (options.shared_npu) {
+        std::lock_guard<std::mutex> lock(npu_mutex);
+        std::this_thread::sleep_for(duration);
+    } else {
+        std::this_thread::sleep_for(duration);
+    }
+
+    current = &frames[next_frame];
+    next_frame = (next_frame + 1) % frames.size();
+
+    // The NPU writes bound outputs in their native layout
+    for (size_t i = 0; i < bound_outputs.size(); i++) {
+        if (bound_outputs[i].mem) {
+            tensor_layout_from_nchw(&bound_outputs[i].layout, current->buffers[i], bound_outputs[i].mem->virt_addr,
+                                    sizeof(int8_t));
+        }
+    }
+    return RKNN_SUCC;
+}
+
+int MockRknnBackend::outputsGet(uint32_t n_outputs, rknn_output* outputs) {
+    if (current == nullptr || n_outputs != current->io_num.n_output) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    float_outputs.resize(n_outputs);
+    for (uint32_t i = 0; i < n_outputs; i++) {
+        const rknn_tensor_attr& attr = current->output_attrs[i];
+        outputs[i].is_prealloc = 0;
+        if (!outputs[i].want_float || attr.type == RKNN_TENSOR_FLOAT32) {
+            outputs[i].buf = current->buffers[i];
+            outputs[i].size = attr.size;
+            continue;
+        }
+
+        // Dequantize like the runtime does for want_float
+        std::vector<float>& out = float_outputs[i];
+        out.resize(attr.n_elems);
+        for (uint32_t k = 0; k < attr.n_elems; k++) {
+            int32_t q = attr.type == RKNN_TENSOR_INT8 ? ((int8_t*)current->buffers[i])[k]
+                                                      : ((uint8_t*)current->buffers[i])[k];
+            out[k] = (q - attr.zp) * attr.scale;
+        }
+        outputs[i].buf = out.data();
+        outputs[i].size = attr.n_elems * sizeof(float);
+    }
+    return RKNN_SUCC;
+}
+
+int MockRknnBackend::outputsRelease(uint32_t n_outputs, rknn_output* outputs) {
+    for (uint32_t i = 0; i < n_outputs; i++) {
+        outputs[i].buf = NULL;
+    }
+    return RKNN_SUCC;
+}
+
+rknn_tensor_mem* MockRknnBackend::createMem(uint32_t size) {
+    rknn_tensor_mem* mem = (rknn_tensor_mem*)calloc(1, sizeof(rknn_tensor_mem));
+    if (mem == NULL) {
+        return NULL;
+    }
+    mem->virt_addr = calloc(1, size);
+    if (mem->virt_addr == NULL) {
+        free(mem);
+        return NULL;
+    }
+    mem->fd = -1;
+    mem->size = size;
+    return mem;
+}
+
+int MockRknnBackend::destroyMem(rknn_tensor_mem* mem) {
+    if (mem == NULL) {
+        return RKNN_SUCC;
+    }
+    for (auto& bound : bound_outputs) {
+        if (bound.mem == mem) {
+            bound.mem = NULL;
+        }
+    }
+    free(mem->virt_addr);
+    free(mem);
+    return RKNN_SUCC;
+}
+
+int MockRknnBackend::setIoMem(rknn_tensor_mem* mem, rknn_tensor_attr* attr) {
+    const recorded_outputs_t& model = frames[0];
+    if (mem == NULL || attr == NULL || attr->index >= model.io_num.n_output) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    const rknn_tensor_attr& standard = model.output_attrs[attr->index];
+    if (standard.type != RKNN_TENSOR_INT8 || mem->size < attr->size) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+
+    BoundOutput bound;
+    int channels, grid_h, grid_w;
+    output_shape(&standard, &channels, &grid_h, &grid_w);
+    if (tensor_layout_init(attr, channels, grid_h, grid_w, &bound.layout) != 0) {
+        return RKNN_ERR_PARAM_INVALID;
+    }
+    bound.mem = mem;
+    bound_outputs.resize(model.io_num.n_output, BoundOutput{NULL, {}});
+    bound_outputs[attr->index] = bound;
+    return RKNN_SUCC;
+}
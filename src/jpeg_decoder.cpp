@@ -0,0 +1,173 @@
+#include "jpeg_decoder.h"
+
+#include <algorithm>
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <jpeglib.h>
+
+#include "log.h"
+
+// Turns libjpeg's fatal errors into a longjmp back to decode()
+struct JpegErrorManager {
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+};
+
+struct JpegDecoder::State {
+    struct jpeg_decompress_struct cinfo;
+    JpegErrorManager err;
+};
+
+static void jpeg_error_exit(j_common_ptr cinfo) {
+    char message[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, message);
+    LOGD("libjpeg: %s\n", message);
+    longjmp(((JpegErrorManager*)cinfo->err)->jump, 1);
+}
+
+// Warnings such as a truncated file go to the debug log instead of stderr
+static void jpeg_output_message(j_common_ptr cinfo) {
+    char message[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, message);
+    LOGD("libjpeg: %s\n", message);
+}
+
+// Orientation tag (1-8) of an Exif APP1 payload, 1 when there is none
+static int exif_orientation(const uint8_t* data, size_t len) {
+    if (len < 6 + 8 || memcmp(data, "Exif\0\0", 6) != 0) {
+        return 1;
+    }
+    const uint8_t* tiff = data + 6;
+    size_t size = len - 6;
+    bool little_endian;
+    if (tiff[0] == 'I' && tiff[1] == 'I') {
+        little_endian = true;
+    } else if (tiff[0] == 'M' && tiff[1] == 'M') {
+        little_endian = false;
+    } else {
+        return 1;
+    }
+    auto u16 = [&](size_t offset) -> uint32_t {
+        return little_endian ? tiff[offset] | tiff[offset + 1] << 8 : tiff[offset] << 8 | tiff[offset + 1];
+    };
+    auto u32 = [&](size_t offset) -> uint32_t {
+        return little_endian ? u16(offset) | u16(offset + 2) << 16 : u16(offset) << 16 | u16(offset + 2);
+    };
+
+    size_t ifd = u32(4);
+    if (ifd + 2 > size) {
+        return 1;
+    }
+    int entries = u16(ifd);
+    for (int i = 0; i < entries; i++) {
+        size_t entry = ifd + 2 + (size_t)i * 12;
+        if (entry + 12 > size) {
+            break;
+        }
+        if (u16(entry) == 0x0112) {
+            return (int)u16(entry + 8);
+        }
+    }
+    return 1;
+}
+
+int jpeg_scale_denom(int width, int height, int min_width, int min_height) {
+    if (width <= 0 || height <= 0 || min_width <= 0 || min_height <= 0) {
+        return 1;
+    }
+    float scale = std::min((float)min_width / width, (float)min_height / height);
+    int letterbox_width = (int)ceilf(width * scale);
+    int letterbox_height = (int)ceilf(height * scale);
+    for (int denom = 8; denom > 1; denom /= 2) {
+        // libjpeg rounds the scaled size up
+        if ((width + denom - 1) / denom >= letterbox_width && (height + denom - 1) / denom >= letterbox_height) {
+            return denom;
+        }
+    }
+    return 1;
+}
+
+JpegDecoder::JpegDecoder() : state(new State()) {
+    state->cinfo.err = jpeg_std_error(&state->err.pub);
+    state->err.pub.error_exit = jpeg_error_exit;
+    state->err.pub.output_message = jpeg_output_message;
+    jpeg_create_decompress(&state->cinfo);
+}
+
+JpegDecoder::~JpegDecoder() {
+    jpeg_destroy_decompress(&state->cinfo);
+    delete state;
+}
+
+int JpegDecoder::decode(const std::string& path, int min_width, int min_height, std::vector<uint8_t>* rgb,
+                        JpegDecodeInfo* info) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    file.resize(size > 0 ? size : 0);
+    size_t got = fread(file.data(), 1, file.size(), fp);
+    fclose(fp);
+    if (got != file.size()) {
+        return -1;
+    }
+    return decode(file.data(), file.size(), min_width, min_height, rgb, info);
+}
+
+int JpegDecoder::decode(const uint8_t* data, size_t size, int min_width, int min_height, std::vector<uint8_t>* rgb,
+                        JpegDecodeInfo* info) {
+    // Anything but a JPEG (SOI marker) is for the general decoder
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return -1;
+    }
+
+    struct jpeg_decompress_struct* cinfo = &state->cinfo;
+    if (setjmp(state->err.jump)) {
+        jpeg_abort_decompress(cinfo);
+        return -1;
+    }
+    jpeg_mem_src(cinfo, data, size);
+    jpeg_save_markers(cinfo, JPEG_APP0 + 1, 0xFFFF);
+    jpeg_read_header(cinfo, TRUE);
+
+    bool handled = cinfo->jpeg_color_space != JCS_CMYK && cinfo->jpeg_color_space != JCS_YCCK;
+    for (jpeg_saved_marker_ptr marker = cinfo->marker_list; marker && handled; marker = marker->next) {
+        // A rotated photo must come out upright, as the general decoder does it
+        if (marker->marker == JPEG_APP0 + 1 && exif_orientation(marker->data, marker->data_length) != 1) {
+            handled = false;
+        }
+    }
+    if (!handled) {
+        jpeg_abort_decompress(cinfo);
+        return -1;
+    }
+
+    info->full_width = cinfo->image_width;
+    info->full_height = cinfo->image_height;
+    info->scale_denom = jpeg_scale_denom(cinfo->image_width, cinfo->image_height, min_width, min_height);
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = info->scale_denom;
+    cinfo->out_color_space = JCS_RGB;
+    jpeg_start_decompress(cinfo);
+    if (cinfo->output_components != 3) {
+        jpeg_abort_decompress(cinfo);
+        return -1;
+    }
+
+    info->width = cinfo->output_width;
+    info->height = cinfo->output_height;
+    size_t row_bytes = (size_t)info->width * 3;
+    rgb->resize(row_bytes * info->height);
+    while (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW row = rgb->data() + row_bytes * cinfo->output_scanline;
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+    jpeg_finish_decompress(cinfo);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include "latency_report.h"
+
+#include "log.h"
+
+int64_t wall_ms_at(int64_t monotonic) {
+    int64_t age_ns = monotonic_ns() - monotonic;
+    return wall_clock_ms() - age_ns / 1000000;
+}
+
+LatencyReport& LatencyReport::instance() {
+    static LatencyReport report;
+    return report;
+}
+
+void LatencyReport::setInterval(int seconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    interval_s = seconds > 0 ? seconds : 0;
+}
+
+static void recordSpan(LatencyHistogram& histogram, int64_t from, int64_t to) {
+    if (from > 0 && to >= from) {
+        histogram.record(to - from);
+    }
+}
+
+void LatencyReport::record(const frame_timing_t& timing) {
+    if (timing.capture_ns <= 0 || timing.publish_ns < timing.capture_ns) {
+        return;
+    }
+    Metrics::instance().record(Stage::GlassToPublish, timing.publish_ns - timing.capture_ns);
+
+    std::unique_ptr<Window> full;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (interval_s == 0) {
+            return;
+        }
+        window->total.record(timing.publish_ns - timing.capture_ns);
+        recordSpan(window->wait, timing.capture_ns, timing.inference_start_ns);
+        recordSpan(window->inference, timing.inference_start_ns, timing.inference_end_ns);
+        recordSpan(window->delivery, timing.inference_end_ns, timing.publish_ns);
+        if (std::chrono::steady_clock::now() - window->start >= std::chrono::seconds(interval_s)) {
+            full = swapWindow();
+        }
+    }
+    if (full) {
+        log(*full);
+    }
+}
+
+void LatencyReport::report() {
+    std::unique_ptr<Window> full;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full = swapWindow();
+    }
+    log(*full);
+}
+
+std::unique_ptr<LatencyReport::Window> LatencyReport::swapWindow() {
+    std::unique_ptr<Window> full(new Window());
+    full.swap(window);
+    return full;
+}
+
+void LatencyReport::log(const Window& w) {
+    if (w.total.count() == 0) {
+        return;
+    }
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - w.start).count();
+    LOGI("Latency: %llu results in %.0f s, glass to publish p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+         (unsigned long long)w.total.count(), elapsed_s, w.total.percentile(0.50) / 1e6,
+         w.total.percentile(0.90) / 1e6, w.total.percentile(0.99) / 1e6, w.total.max() / 1e6);
+    LOGI("Latency: capture to inference p50 %.1f ms, p99 %.1f ms; inference p50 %.1f ms, p99 %.1f ms; "
+         "to publish p50 %.1f ms, p99 %.1f ms\n",
+         w.wait.percentile(0.50) / 1e6, w.wait.percentile(0.99) / 1e6,
+         w.inference.percentile(0.50) / 1e6, w.inference.percentile(0.99) / 1e6,
+         w.delivery.percentile(0.50) / 1e6, w.delivery.percentile(0.99) / 1e6);
+}
@@ -0,0 +1,229 @@
+#include "log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+namespace {
+
+const int RING_SIZE = 256;          // Power of two
+const int MESSAGE_SIZE = 240;
+
+struct Slot {
+    std::atomic<uint64_t> sequence;
+    int level;
+    char text[MESSAGE_SIZE];
+};
+
+// Bounded MPSC ring (Vyukov): producers claim a slot with a CAS on the tail
+// and publish it by bumping its sequence; the single consumer follows head.
+class Logger {
+public:
+    Logger() {
+        for (uint64_t i = 0; i < RING_SIZE; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        worker = std::thread(&Logger::drain, this);
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        worker.join();
+    }
+
+    bool push(int level, const char* text, size_t length) {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[pos & (RING_SIZE - 1)];
+            uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            int64_t diff = (int64_t)seq - (int64_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;   // Full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        length = std::min(length, (size_t)MESSAGE_SIZE - 1);
+        memcpy(slot->text, text, length);
+        slot->text[length] = '\0';
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        wakeup.notify_one();
+        return true;
+    }
+
+    void flush() {
+        uint64_t target = tail.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.notify_one();
+        drained.wait_for(lock, std::chrono::seconds(2), [&] { return head.load(std::memory_order_acquire) >= target; });
+    }
+
+    std::atomic<int> level{LOG_LEVEL_DEBUG};
+    std::atomic<bool> stderr_only{false};
+
+private:
+    // Write out everything published so far; returns false if nothing was pending
+    bool drainOnce() {
+        bool wrote = false;
+        uint64_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Slot* slot = &slots[pos & (RING_SIZE - 1)];
+            if (slot->sequence.load(std::memory_order_acquire) != pos + 1) {
+                break;
+            }
+            bool to_stderr = slot->level >= LOG_LEVEL_WARN || stderr_only.load(std::memory_order_relaxed);
+            FILE* out = to_stderr ? stderr : stdout;
+            fputs(slot->text, out);
+            slot->sequence.store(pos + RING_SIZE, std::memory_order_release);
+            pos++;
+            head.store(pos, std::memory_order_release);
+            wrote = true;
+        }
+
+        uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+        if (lost > 0) {
+            fprintf(stderr, "[WARN] log ring full, dropped %llu messages\n", (unsigned long long)lost);
+        }
+        if (wrote) {
+            fflush(stdout);
+            fflush(stderr);
+        }
+        return wrote;
+    }
+
+    void drain() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            lock.unlock();
+            drainOnce();
+            lock.lock();
+            drained.notify_all();
+            if (stopping) {
+                break;
+            }
+            // Timed wait covers notifications that race with going to sleep
+            wakeup.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        lock.unlock();
+        drainOnce();
+    }
+
+    Slot slots[RING_SIZE];
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> head{0};   // Only advanced by the drain thread
+    std::atomic<uint64_t> dropped{0};
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable drained;
+    bool stopping = false;
+};
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+const char* level_prefix(int level) {
+    switch (level) {
+        case LOG_LEVEL_DEBUG: return "[DEBUG] ";
+        case LOG_LEVEL_WARN:  return "[WARN] ";
+        case LOG_LEVEL_ERROR: return "[ERROR] ";
+        default:              return "";
+    }
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+void log_write(int level, log_site_t *site, const char *fmt, ...)
+{
+    Logger& log = logger();
+    if (level < log.level.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    char text[MESSAGE_SIZE];
+    int len = snprintf(text, sizeof(text), "%s", level_prefix(level));
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text + len, sizeof(text) - len, fmt, args);
+    va_end(args);
+
+    // Rate limit identical repeats per call site over one-second windows. The
+    // site is shared by every thread logging from that line; threads racing
+    // on a window reset may let a few extra copies through.
+    if (site) {
+        const std::memory_order relaxed = std::memory_order_relaxed;
+        uint32_t hash = 2166136261u;   // FNV-1a
+        for (const char *p = text; *p; p++) {
+            hash = (hash ^ (uint8_t)*p) * 16777619u;
+        }
+        int64_t now = now_ms();
+        if (hash != site->last_hash.load(relaxed) || now - site->window_start_ms.load(relaxed) >= 1000) {
+            site->last_hash.store(hash, relaxed);
+            site->window_start_ms.store(now, relaxed);
+            site->count.store(0, relaxed);
+        }
+        if (site->count.fetch_add(1, relaxed) + 1 > LOG_SITE_BURST) {
+            site->suppressed.fetch_add(1, relaxed);
+            return;
+        }
+        int suppressed = site->suppressed.exchange(0, relaxed);
+        if (suppressed > 0) {
+            size_t used = strlen(text);
+            if (used > 0 && text[used - 1] == '\n') {
+                used--;
+            }
+            snprintf(text + used, sizeof(text) - used, " (%d similar suppressed)\n", suppressed);
+        }
+    }
+    log.push(level, text, strnlen(text, sizeof(text)));
+}
+
+void log_set_level(int level)
+{
+    logger().level.store(level, std::memory_order_relaxed);
+}
+
+void log_set_stderr_only(bool enabled)
+{
+    logger().stderr_only.store(enabled, std::memory_order_relaxed);
+}
+
+int log_parse_level(const char *name)
+{
+    if (strcmp(name, "debug") == 0) return LOG_LEVEL_DEBUG;
+    if (strcmp(name, "info") == 0) return LOG_LEVEL_INFO;
+    if (strcmp(name, "warn") == 0) return LOG_LEVEL_WARN;
+    if (strcmp(name, "error") == 0) return LOG_LEVEL_ERROR;
+    return -1;
+}
+
+void log_flush()
+{
+    logger().flush();
+}
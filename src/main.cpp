@@ -4,16 +4,29 @@
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <future>
 #include <stdio.h>
 #include <string>
 #include <thread>
+#include <cstdlib>
 #include <cstring>
-#include <signal.h>
 
+#include "async_frame_writer.h"
+#include "batch.h"
+#include "camera_inference.h"
+#include "camera_source.h"
 #include "image_utils.h"
 #include "inference.h"
+#include "inference_backend.h"
+#include "latency_report.h"
+#include "log.h"
+#include "metrics.h"
+#include "motion_gate.h"
 #include "publisher.h"
 #include "queue.h"
+#include "replay.h"
+#include "supervisor.h"
+#include "tracker.h"
 #include "transport.h"
 #include "utils.h"
 #include "yolo.h"
@@ -23,24 +36,84 @@
 
 std::atomic<bool> running{true};
 ThreadSafeQueue<InferenceResult> resultQueue(1);
+ThreadSafeQueue<InferenceResult> detectionQueue(1);   // inference -> tracker
 
-void signalHandler(int signum) {
-    std::cout << "Interrupt signal (" << signum << ") received.\n";
-
-    // Cleanup and shutdown
-    running = false;
-    resultQueue.signalShutdown();
-}
+// Upper bound on publishing the result of a single-shot run
+static const int SINGLE_SHOT_TIMEOUT_MS = 10000;
 
 int main(int argc, char **argv) {
+    log_set_level(LOG_LEVEL_INFO);
     char *model_name = NULL;
     bool suppress_empty = false;
     bool is_file_input = false;
+    bool is_replay = false;
     
-    if (argc < 3 || argc > 4) {
-        printf("Usage: %s <rknn model> <source> [--suppress-empty]\n", argv[0]);
-        printf("  <source>: V4L device (e.g. /dev/video0) or image file (e.g. /tmp/bus.jpg)\n");
-        printf("  --suppress-empty: suppress output when no detections (optional)\n");
+    bool is_batch = false;
+    bool tracking = true;
+    bool motion_gate = false;
+    MotionGateOptions gate_options;
+    FrameWriterOptions frame_options;
+    BatchOptions batch_options;
+    bool mock_npu = false;
+    MockBackendOptions mock_options;
+    ReplayOptions replay_options;
+    CameraOptions camera_options;
+    bool raw_camera = false;
+    bool opencv_capture = false;
+    std::string metrics_file = "/tmp/metrics.prom";
+    int metrics_port = 0;
+    int publish_rate = 1;
+    int latency_report_s = 60;
+    ChangeOptions change_options;
+
+    if (argc < 3) {
+        LOGI("Usage: %s <rknn model> <source> [options]\n", argv[0]);
+        LOGI("  <source>: V4L device (e.g. /dev/video0), video file to replay (e.g. /tmp/store.mp4) or image file (e.g. /tmp/bus.jpg)\n");
+        LOGI("  --suppress-empty: suppress output when no detections (optional)\n");
+        LOGI("  --max-detections <n>: detections kept per frame (default %d, 0 = unlimited)\n", OBJ_NUMB_MAX_SIZE);
+        LOGI("  --int-decode: decode quantized model outputs in the integer domain (lookup tables, fixed-point boxes)\n");
+        LOGI("  --native-outputs: decode quantized outputs in the NPU's native layout instead of having the runtime convert them to NCHW\n");
+        LOGI("  --postprocess-threads <n>: extra threads decoding model outputs in parallel (default 0, 3 suits RK3588)\n");
+        LOGI("  --no-tracking: publish raw per-frame detections from a video source\n");
+        LOGI("  --preview-fps <n>: max rate of %s updates (default %d, 0 = every frame)\n", frame_options.path.c_str(), frame_options.max_fps);
+        LOGI("  --preview-width <px>: scale %s down to this width (default: source size)\n", frame_options.path.c_str());
+        LOGI("  --motion-gate: skip inference on a static scene, reusing the last results\n");
+        LOGI("  --motion-threshold <t>: mean luma change of one block of the %dx%d motion thumbnail that counts as motion (default %d)\n",
+             gate_options.thumb_width, gate_options.thumb_height, gate_options.threshold);
+        LOGI("  --motion-min-blocks <n>: changed blocks that make a frame count as motion (default %d)\n",
+             gate_options.min_changed_blocks);
+        LOGI("  --motion-max-interval <ms>: longest gap between inferences on a static scene (default %d)\n", gate_options.max_interval_ms);
+        LOGI("  --publish-rate <n>: max messages per second of each publisher (default %d)\n", publish_rate);
+        LOGI("  --publish-on-change: publish only results whose counts or boxes changed, plus keyframes\n");
+        LOGI("  --keyframe-interval <ms>: with --publish-on-change, longest gap between full messages (default %d, 0 = none)\n", change_options.keyframe_interval_ms);
+        LOGI("  --count-hysteresis <n>: with --publish-on-change, count change ignored (default %d)\n", change_options.count_hysteresis);
+        LOGI("  --box-hysteresis <px>: with --publish-on-change, box edge movement ignored (default %d)\n", change_options.box_hysteresis_px);
+        LOGI("  --box-deltas: with --publish-on-change, send JSON boxes as deltas against the previous message between keyframes\n");
+        LOGI("  --latency-report <s>: log glass-to-publish latency percentiles every s seconds (default %d, 0 = off)\n", latency_report_s);
+        LOGI("  --metrics-file <file>: Prometheus text metrics, rewritten every 10 s (default %s, \"\" to disable)\n", metrics_file.c_str());
+        LOGI("  --metrics-port <port>: also send metrics as UDP datagrams to 127.0.0.1:<port>\n");
+        LOGI("  --record-outputs <dir>: save raw model outputs of the first 1000 frames for offline benchmarks\n");
+        LOGI("  --mock-npu <dir|file>: replay outputs recorded with --record-outputs instead of using the NPU\n");
+        LOGI("  --mock-latency <ms>: mean synthetic NPU run time (default %.0f)\n", mock_options.latency_ms);
+        LOGI("  --mock-jitter <ms>: standard deviation of the NPU run time (default %.0f)\n", mock_options.jitter_ms);
+        LOGI("  --camera-size <w>x<h>: V4L2 capture size (default %dx%d)\n", camera_options.width, camera_options.height);
+        LOGI("  --camera-format <yuyv|nv12>: V4L2 pixel format (default yuyv)\n");
+        LOGI("  --camera-fps <n>: V4L2 frame rate (default %d)\n", camera_options.fps);
+        LOGI("  --camera-buffers <n>: V4L2 capture ring size (default %d)\n", camera_options.buffers);
+        LOGI("  --camera-dmabuf: export the V4L2 capture buffers as DMABUF\n");
+        LOGI("  --raw-camera: treat <source> as a file or pipe of raw frames in --camera-format/--camera-size\n");
+        LOGI("  --opencv-capture: capture V4L devices through OpenCV instead of V4L2 streaming I/O\n");
+        LOGI("  --replay-fast: feed a video file as fast as inference allows instead of at its frame rate\n");
+        LOGI("  --replay-once: stop at the end of a video file instead of looping\n");
+        LOGI("  --replay-frames <n>: stop after n video file frames, then exit\n");
+        LOGI("  --log-level <level>: debug, info, warn or error (default info)\n");
+        LOGI("  --batch: treat <source> as a directory, glob pattern or list file of images\n");
+        LOGI("  --output <file>: batch JSON Lines output (default %s, \"-\" for stdout)\n", batch_options.output_path.c_str());
+        LOGI("  --decode-threads <n>: batch image decode threads (default: cores - 1)\n");
+        LOGI("  --full-decode: batch: decode JPEGs at full resolution instead of a reduced DCT scale\n");
+        LOGI("  --result-cache-size <n>: batch: results of identical images kept in memory (default %zu, 0 = no cache)\n", batch_options.cache_capacity);
+        LOGI("  --result-cache <file>: batch: also keep results in this index file across runs\n");
+        LOGI("  --coco-annotations <instances.json>: batch: report COCO bbox mAP/AR against these annotations\n");
         return -1;
     }
 
@@ -48,40 +121,193 @@ int main(int argc, char **argv) {
     model_name = (char *)argv[1];
     char *source_name = argv[2];
     
-    // Check for suppress-empty flag
-    if (argc == 4 && strcmp(argv[3], "--suppress-empty") == 0) {
-        suppress_empty = true;
-        printf("Suppress-empty mode enabled\n");
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--suppress-empty") == 0) {
+            suppress_empty = true;
+            LOGI("Suppress-empty mode enabled\n");
+        } else if (strcmp(argv[i], "--max-detections") == 0 && i + 1 < argc) {
+            set_default_max_detections(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--int-decode") == 0) {
+            set_default_integer_decode(true);
+        } else if (strcmp(argv[i], "--native-outputs") == 0) {
+            set_default_native_outputs(true);
+        } else if (strcmp(argv[i], "--postprocess-threads") == 0 && i + 1 < argc) {
+            set_decode_threads(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--no-tracking") == 0) {
+            tracking = false;
+        } else if (strcmp(argv[i], "--preview-fps") == 0 && i + 1 < argc) {
+            frame_options.max_fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--preview-width") == 0 && i + 1 < argc) {
+            frame_options.width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--motion-gate") == 0) {
+            motion_gate = true;
+        } else if (strcmp(argv[i], "--motion-threshold") == 0 && i + 1 < argc) {
+            gate_options.threshold = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--motion-min-blocks") == 0 && i + 1 < argc) {
+            gate_options.min_changed_blocks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--motion-max-interval") == 0 && i + 1 < argc) {
+            gate_options.max_interval_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--publish-rate") == 0 && i + 1 < argc) {
+            publish_rate = atoi(argv[++i]);
+            if (publish_rate < 1) {
+                publish_rate = 1;
+            }
+        } else if (strcmp(argv[i], "--publish-on-change") == 0) {
+            change_options.enabled = true;
+        } else if (strcmp(argv[i], "--keyframe-interval") == 0 && i + 1 < argc) {
+            change_options.keyframe_interval_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--count-hysteresis") == 0 && i + 1 < argc) {
+            change_options.count_hysteresis = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--box-hysteresis") == 0 && i + 1 < argc) {
+            change_options.box_hysteresis_px = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--box-deltas") == 0) {
+            change_options.box_deltas = true;
+        } else if (strcmp(argv[i], "--latency-report") == 0 && i + 1 < argc) {
+            latency_report_s = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics-file") == 0 && i + 1 < argc) {
+            metrics_file = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metrics_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record-outputs") == 0 && i + 1 < argc) {
+            set_output_recording(argv[++i], 1000);
+        } else if (strcmp(argv[i], "--mock-npu") == 0 && i + 1 < argc) {
+            mock_npu = true;
+            mock_options.recordings = argv[++i];
+        } else if (strcmp(argv[i], "--mock-latency") == 0 && i + 1 < argc) {
+            mock_options.latency_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--mock-jitter") == 0 && i + 1 < argc) {
+            mock_options.jitter_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--camera-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &camera_options.width, &camera_options.height) != 2) {
+                LOGE("bad camera size '%s'\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--camera-format") == 0 && i + 1 < argc) {
+            if (parse_yuv_format(argv[++i], &camera_options.format) != 0) {
+                LOGE("unknown camera format '%s'\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--camera-fps") == 0 && i + 1 < argc) {
+            camera_options.fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--camera-buffers") == 0 && i + 1 < argc) {
+            camera_options.buffers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--camera-dmabuf") == 0) {
+            camera_options.export_dmabuf = true;
+        } else if (strcmp(argv[i], "--raw-camera") == 0) {
+            raw_camera = true;
+        } else if (strcmp(argv[i], "--opencv-capture") == 0) {
+            opencv_capture = true;
+        } else if (strcmp(argv[i], "--replay-fast") == 0) {
+            replay_options.realtime = false;
+        } else if (strcmp(argv[i], "--replay-once") == 0) {
+            replay_options.loop = false;
+        } else if (strcmp(argv[i], "--replay-frames") == 0 && i + 1 < argc) {
+            replay_options.max_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            int level = log_parse_level(argv[++i]);
+            if (level < 0) {
+                LOGE("unknown log level '%s'\n", argv[i]);
+                return -1;
+            }
+            log_set_level(level);
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            is_batch = true;
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            batch_options.output_path = argv[++i];
+            // JSON Lines on stdout must not be interleaved with log messages
+            log_set_stderr_only(batch_options.output_path == "-");
+        } else if (strcmp(argv[i], "--decode-threads") == 0 && i + 1 < argc) {
+            batch_options.decode_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--full-decode") == 0) {
+            batch_options.scaled_decode = false;
+        } else if (strcmp(argv[i], "--result-cache-size") == 0 && i + 1 < argc) {
+            int capacity = atoi(argv[++i]);
+            batch_options.cache_capacity = capacity > 0 ? capacity : 0;
+        } else if (strcmp(argv[i], "--result-cache") == 0 && i + 1 < argc) {
+            batch_options.cache_index = argv[++i];
+        } else if (strcmp(argv[i], "--coco-annotations") == 0 && i + 1 < argc) {
+            batch_options.coco_annotations = argv[++i];
+        } else {
+            LOGE("unknown option '%s'\n", argv[i]);
+            return -1;
+        }
     }
     
-    // Set up signal handler
-    signal(SIGINT, signalHandler);
-    signal(SIGTERM, signalHandler);
+    // Route SIGINT/SIGTERM/SIGHUP through the supervisor. This must happen
+    // before any thread is started so every thread inherits the signal mask.
+    Supervisor supervisor;
+    if (!supervisor.isValid()) {
+        LOGE("failed to set up signal handling\n");
+        return -1;
+    }
+
+    LatencyReport::instance().setInterval(latency_report_s);
+    MetricsExporter metrics(metrics_file, metrics_port);
+    metrics.start();
+
+    if (mock_npu) {
+        set_default_mock_backend(&mock_options);
+    }
     
+    if (is_batch) {
+        batch_options.model_path = model_name;
+        batch_options.source = source_name;
+        batch_options.suppress_empty = suppress_empty;
+
+        std::future<int> batch = std::async(std::launch::async, [&]() {
+            int ret = runBatchInference(batch_options, running);
+            supervisor.notify();
+            return ret;
+        });
+
+        int signum = supervisor.wait();
+        if (signum > 0) {
+            LOGI("Interrupt signal (%d) received.\n", signum);
+        }
+        running = false;
+        return batch.get();
+    }
+
     // Determine if source is a file or device
-    if (strstr(source_name, "/dev/video") == source_name) {
+    bool is_camera = false;
+    if (raw_camera) {
+        is_camera = true;
+        LOGI("Using raw %s frames from: %s\n", camera_options.format == YuvFormat::YUYV ? "YUYV" : "NV12", source_name);
+    } else if (strstr(source_name, "/dev/video") == source_name && !opencv_capture) {
+        is_camera = true;
+        LOGI("Using V4L device: %s (V4L2 streaming)\n", source_name);
+    } else if (strstr(source_name, "/dev/video") == source_name) {
         is_file_input = false;
-        printf("Using V4L device: %s\n", source_name);
+        LOGI("Using V4L device: %s\n", source_name);
+    } else if (std::filesystem::exists(source_name) && isVideoFile(source_name)) {
+        is_replay = true;
+        LOGI("Replaying video file: %s\n", source_name);
     } else if (std::filesystem::exists(source_name)) {
         is_file_input = true;
-        printf("Using image file: %s\n", source_name);
+        LOGI("Using image file: %s\n", source_name);
     } else {
-        printf("Error: Source '%s' is neither a valid V4L device nor an existing file\n", source_name);
+        LOGE("Source '%s' is neither a valid V4L device nor an existing file\n", source_name);
         return -1;
     }
 
-    // Create frame writer for decorated output
-    auto frameWriter = std::make_shared<DecoratedFrameWriter>("/tmp/output.jpg", suppress_empty);
+    // Decorated output. The camera and replay threads hand frames to an
+    // AsyncFrameWriter, which draws and JPEG-encodes them on its own worker so
+    // they never stall the inference loop. MLInferenceThread (image files and
+    // --opencv-capture) takes the synchronous DecoratedFrameWriter, without
+    // the --preview-* options.
+    frame_options.suppress_empty = suppress_empty;
     
     if (is_file_input) {
-        // Single-shot inference mode for file input
+        // Single-shot inference mode for file input. The result goes through
+        // its own queue so a run that produced none is noticed right away.
+        ThreadSafeQueue<InferenceResult> inferenceOutput(1);
         MLInferenceThread mlThread(
             model_name,
             source_name,
-            resultQueue, 
+            inferenceOutput,
             running,
             1, // Single frame
-            frameWriter);
+            std::make_shared<DecoratedFrameWriter>(frame_options.path, suppress_empty));
         
         // Create formatters
         auto json_formatter = std::make_shared<JsonMessageFormatter>(suppress_empty);
@@ -95,72 +321,166 @@ int main(int argc, char **argv) {
             json_formatter,
             1);
         
-        // Run single inference and exit
+        // Publish exactly one result, then wake the supervisor
+        file_publisher.setMessageLimit(1);
+        std::future<void> published = std::async(std::launch::async, [&]() {
+            file_publisher();
+            supervisor.notify();
+        });
+
+        // Run single inference and exit as soon as the result is written
         mlThread.runSingleInference();
-        
-        // Process result if any
-        std::thread file_publisherThread(std::ref(file_publisher));
-        std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Give time for processing
+
+        InferenceResult result;
+        inferenceOutput.signalShutdown();
+        if (inferenceOutput.pop(result)) {
+            resultQueue.push(std::move(result));
+            int signum = supervisor.wait(SINGLE_SHOT_TIMEOUT_MS);
+            if (signum > 0) {
+                LOGI("Interrupt signal (%d) received.\n", signum);
+            } else if (signum < 0) {
+                LOGW("Timed out writing inference result\n");
+            }
+        } else {
+            LOGW("Inference produced no result\n");
+        }
+
         running = false;
         resultQueue.signalShutdown();
-        file_publisherThread.join();
+        file_publisher.stop();
+        published.get();
         
     } else {
-        // Continuous inference mode for video device
-        MLInferenceThread mlThread(
-            model_name,
-            source_name,
-            resultQueue, 
-            running,
-            30,
-            frameWriter);
+        // Gating only makes sense on a live stream of related frames
+        if (motion_gate) {
+            set_default_motion_gate(&gate_options);
+        }
+
+        // Continuous inference mode for video device or replayed video file.
+        // With tracking, results pass through the tracker stage before
+        // reaching the publishers.
+        ThreadSafeQueue<InferenceResult>& inferenceOutput = tracking ? detectionQueue : resultQueue;
+        std::unique_ptr<MLInferenceThread> mlThread;
+        std::unique_ptr<ReplayInferenceThread> replayThread;
+        std::unique_ptr<CameraInferenceThread> cameraThread;
+        std::shared_ptr<AsyncFrameWriter> frameWriter;
+        if (is_camera || is_replay) {
+            frameWriter = std::make_shared<AsyncFrameWriter>(frame_options);
+        }
+        if (is_camera) {
+            std::unique_ptr<CameraSource> source;
+            if (raw_camera) {
+                source.reset(new RawFileCameraSource(source_name, camera_options));
+            } else {
+                source.reset(new V4l2CameraSource(source_name, camera_options));
+            }
+            cameraThread.reset(new CameraInferenceThread(
+                model_name,
+                std::move(source),
+                inferenceOutput,
+                running,
+                frameWriter));
+        } else if (is_replay) {
+            replayThread.reset(new ReplayInferenceThread(
+                model_name,
+                source_name,
+                inferenceOutput,
+                running,
+                replay_options,
+                frameWriter));
+        } else {
+            mlThread.reset(new MLInferenceThread(
+                model_name,
+                source_name,
+                inferenceOutput,
+                running,
+                30,
+                std::make_shared<DecoratedFrameWriter>(frame_options.path, suppress_empty)));
+        }
+        TrackerStage trackerStage(detectionQueue, resultQueue, running);
 
         // Create formatters
         auto json_formatter = std::make_shared<JsonMessageFormatter>(suppress_empty);
         auto faces_json_formatter = std::make_shared<FacesJsonMessageFormatter>();
         auto faces_bs_formatter = std::make_shared<FacesBSMessageFormatter>();
         
+        // Every publisher sees the whole result stream, which change-only
+        // publishing needs to compare consecutive results
+        ResultBroadcast broadcast;
+
         // Create file publisher using transport injection
         auto file_transport = std::make_shared<FileTransport>("/tmp/results.json");
         Publisher file_publisher(
             file_transport,
-            resultQueue,
+            broadcast,
             running,
             json_formatter,
-            1); // Write to file once per second
+            publish_rate); // Write to file once per second by default
 
         // Create UDP publishers for faces data
         UDPPublisher udp_json_publisher(
             "127.0.0.1", 5002,
-            resultQueue,
+            broadcast,
             running,
             faces_json_formatter,
-            1); // Send JSON to port 5002
+            publish_rate); // Send JSON to port 5002
 
         UDPPublisher udp_bs_publisher(
             "127.0.0.1", 5000,
-            resultQueue,
+            broadcast,
             running,
             faces_bs_formatter,
-            1); // Send BrightScript to port 5000
+            publish_rate); // Send BrightScript to port 5000
+
+        file_publisher.setChangeOptions(change_options);
+        udp_json_publisher.setChangeOptions(change_options);
+        udp_bs_publisher.setChangeOptions(change_options);
 
-        std::thread inferenceThread(std::ref(mlThread));
+        // The inference thread wakes the supervisor when it stops, whether
+        // the source ended or it failed
+        std::thread inferenceThread([&]() {
+            if (is_camera) {
+                (*cameraThread)();
+            } else if (is_replay) {
+                (*replayThread)();
+            } else {
+                (*mlThread)();
+            }
+            supervisor.notify();
+        });
+        std::thread trackerThread;
+        if (tracking) {
+            trackerThread = std::thread(std::ref(trackerStage));
+        }
+        std::thread broadcastThread([&]() { broadcast.pump(resultQueue); });
         std::thread file_publisherThread(std::ref(file_publisher));
         std::thread udp_json_publisherThread(std::ref(udp_json_publisher));
         std::thread udp_bs_publisherThread(std::ref(udp_bs_publisher));
 
-        while (running) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+        // Sleep until a termination signal arrives or the inference thread stops
+        int signum = supervisor.wait();
+        if (signum > 0) {
+            LOGI("Interrupt signal (%d) received.\n", signum);
         }
 
-        // Cleanup and shutdown
+        // Cleanup and shutdown: drain every stage at once
         running = false;
+        detectionQueue.signalShutdown();
         resultQueue.signalShutdown();
+        broadcast.signalShutdown();
+        file_publisher.stop();
+        udp_json_publisher.stop();
+        udp_bs_publisher.stop();
 
         inferenceThread.join();
+        if (trackerThread.joinable()) {
+            trackerThread.join();
+        }
+        broadcastThread.join();
         file_publisherThread.join();
         udp_json_publisherThread.join();
         udp_bs_publisherThread.join();
+        LatencyReport::instance().report();
     }
 
     return 0;
@@ -0,0 +1,190 @@
+#include "metrics.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns < (uint64_t)SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - SUB_BUCKET_BITS;
+    return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + (int)((ns >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    int exponent = index / SUB_BUCKETS;
+    uint64_t mantissa = SUB_BUCKETS + index % SUB_BUCKETS;
+    return ((mantissa + 1) << (exponent - 1)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    total_count.fetch_add(1, std::memory_order_relaxed);
+    total_sum.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = max_value.load(std::memory_order_relaxed);
+    while (ns > prev && !max_value.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(q * n);
+    if (target >= n) {
+        target = n - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen > target) {
+            uint64_t bound = bucketUpperBound(i);
+            return bound < max() ? bound : max();
+        }
+    }
+    return max();
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+const char* Metrics::stageName(Stage stage) {
+    switch (stage) {
+        case Stage::Capture:    return "capture";
+        case Stage::Letterbox:  return "letterbox";
+        case Stage::InputsSet:  return "rknn_inputs_set";
+        case Stage::Run:        return "rknn_run";
+        case Stage::OutputsGet: return "rknn_outputs_get";
+        case Stage::Decode:     return "decode";
+        case Stage::Sort:       return "sort";
+        case Stage::Nms:        return "nms";
+        case Stage::Format:     return "format";
+        case Stage::Send:       return "send";
+        case Stage::GlassToPublish: return "glass_to_publish";
+        default:                return "unknown";
+    }
+}
+
+std::string Metrics::toPrometheus() const {
+    static const double quantiles[] = {0.5, 0.9, 0.99};
+    static const char* counter_names[] = {
+        "bsext_frames_total",
+        "bsext_candidates_total",
+        "bsext_detections_total",
+        "bsext_dropped_frames_total",
+        "bsext_result_cache_hits_total",
+        "bsext_result_cache_misses_total",
+        "bsext_messages_sent_total",
+        "bsext_messages_suppressed_total",
+    };
+    static const char* gauge_names[] = {
+        "bsext_queue_depth",
+    };
+
+    std::string out;
+    char line[256];
+
+    out += "# TYPE bsext_stage_latency_seconds summary\n";
+    for (int s = 0; s < (int)Stage::Count; s++) {
+        const LatencyHistogram& h = stages[s];
+        const char* name = stageName((Stage)s);
+        for (double q : quantiles) {
+            snprintf(line, sizeof(line), "bsext_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+                     name, q, h.percentile(q) / 1e9);
+            out += line;
+        }
+        snprintf(line, sizeof(line), "bsext_stage_latency_seconds_sum{stage=\"%s\"} %.9f\n", name, h.sum() / 1e9);
+        out += line;
+        snprintf(line, sizeof(line), "bsext_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+                 name, (unsigned long long)h.count());
+        out += line;
+    }
+
+    for (int c = 0; c < (int)Counter::Count; c++) {
+        snprintf(line, sizeof(line), "# TYPE %s counter\n%s %llu\n", counter_names[c], counter_names[c],
+                 (unsigned long long)counters[c].load(std::memory_order_relaxed));
+        out += line;
+    }
+    for (int g = 0; g < (int)Gauge::Count; g++) {
+        snprintf(line, sizeof(line), "# TYPE %s gauge\n%s %lld\n", gauge_names[g], gauge_names[g],
+                 (long long)gauges[g].load(std::memory_order_relaxed));
+        out += line;
+    }
+    return out;
+}
+
+MetricsExporter::MetricsExporter(const std::string& file_path, int udp_port, int interval_ms)
+    : file_path(file_path),
+      udp_port(udp_port),
+      interval_ms(interval_ms) {
+    if (udp_port > 0) {
+        udp_socket = socket(AF_INET, SOCK_DGRAM, 0);
+    }
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+    if (udp_socket >= 0) {
+        close(udp_socket);
+    }
+}
+
+void MetricsExporter::start() {
+    if (!thread.joinable() && (!file_path.empty() || udp_socket >= 0)) {
+        thread = std::thread(&MetricsExporter::run, this);
+    }
+}
+
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(stop_mutex);
+    while (!stop_cv.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return stopping; })) {
+        exportOnce();
+    }
+    // Final snapshot so short runs still leave their numbers behind
+    exportOnce();
+}
+
+void MetricsExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void MetricsExporter::exportOnce() {
+    std::string text = Metrics::instance().toPrometheus();
+
+    if (!file_path.empty()) {
+        std::string temp_path = file_path + ".tmp";
+        FILE* fp = fopen(temp_path.c_str(), "w");
+        if (fp) {
+            fwrite(text.data(), 1, text.size(), fp);
+            fclose(fp);
+            rename(temp_path.c_str(), file_path.c_str());
+        }
+    }
+
+    if (udp_socket >= 0) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(udp_port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sendto(udp_socket, text.data(), text.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+    }
+}
@@ -0,0 +1,231 @@
+#include "motion_gate.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static bool default_gate_enabled = false;
+static MotionGateOptions default_gate_options;
+
+void set_default_motion_gate(const MotionGateOptions* options) {
+    default_gate_enabled = options != nullptr;
+    if (options) {
+        default_gate_options = *options;
+    }
+}
+
+const MotionGateOptions* get_default_motion_gate() {
+    return default_gate_enabled ? &default_gate_options : nullptr;
+}
+
+// Number of positions where two byte arrays differ by threshold or more
+static int count_changed_u8(const uint8_t* a, const uint8_t* b, int len, uint8_t threshold) {
+    int count = 0;
+    int i = 0;
+#if defined(__ARM_NEON)
+    uint8x16_t limit = vdupq_n_u8(threshold);
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        uint8x16_t changed = vshrq_n_u8(vcgeq_u8(diff, limit), 7);
+        acc = vpadalq_u16(acc, vpaddlq_u8(changed));
+    }
+    count = (int)(vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3));
+#elif defined(__SSE2__)
+    __m128i limit = _mm_set1_epi8((char)threshold);
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        // diff >= limit exactly where max(diff, limit) == diff
+        __m128i changed = _mm_cmpeq_epi8(_mm_max_epu8(diff, limit), diff);
+        count += __builtin_popcount(_mm_movemask_epi8(changed));
+    }
+#endif
+    for (; i < len; i++) {
+        count += abs((int)a[i] - (int)b[i]) >= threshold;
+    }
+    return count;
+}
+
+// Add the luma of one row to per-column totals. step is 1 for a Y plane or
+// gray, 2 for the Y bytes of YUYV.
+static void add_luma_row(const uint8_t* row, int width, int step, uint32_t* sums) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    if (step == 1) {
+        for (; x + 16 <= width; x += 16) {
+            uint8x16_t v = vld1q_u8(row + x);
+            uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+            uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+            vst1q_u32(sums + x, vaddw_u16(vld1q_u32(sums + x), vget_low_u16(lo)));
+            vst1q_u32(sums + x + 4, vaddw_u16(vld1q_u32(sums + x + 4), vget_high_u16(lo)));
+            vst1q_u32(sums + x + 8, vaddw_u16(vld1q_u32(sums + x + 8), vget_low_u16(hi)));
+            vst1q_u32(sums + x + 12, vaddw_u16(vld1q_u32(sums + x + 12), vget_high_u16(hi)));
+        }
+    } else if (step == 2) {
+        for (; x + 8 <= width; x += 8) {
+            uint16x8_t y = vmovl_u8(vld2_u8(row + 2 * x).val[0]);
+            vst1q_u32(sums + x, vaddw_u16(vld1q_u32(sums + x), vget_low_u16(y)));
+            vst1q_u32(sums + x + 4, vaddw_u16(vld1q_u32(sums + x + 4), vget_high_u16(y)));
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    if (step == 1) {
+        for (; x + 16 <= width; x += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(row + x));
+            __m128i lo = _mm_unpacklo_epi8(v, zero);
+            __m128i hi = _mm_unpackhi_epi8(v, zero);
+            __m128i* s = (__m128i*)(sums + x);
+            _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(lo, zero)));
+            _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(lo, zero)));
+            _mm_storeu_si128(s + 2, _mm_add_epi32(_mm_loadu_si128(s + 2), _mm_unpacklo_epi16(hi, zero)));
+            _mm_storeu_si128(s + 3, _mm_add_epi32(_mm_loadu_si128(s + 3), _mm_unpackhi_epi16(hi, zero)));
+        }
+    } else if (step == 2) {
+        const __m128i low_bytes = _mm_set1_epi16(0x00ff);
+        for (; x + 8 <= width; x += 8) {
+            __m128i y = _mm_and_si128(_mm_loadu_si128((const __m128i*)(row + 2 * x)), low_bytes);
+            __m128i* s = (__m128i*)(sums + x);
+            _mm_storeu_si128(s, _mm_add_epi32(_mm_loadu_si128(s), _mm_unpacklo_epi16(y, zero)));
+            _mm_storeu_si128(s + 1, _mm_add_epi32(_mm_loadu_si128(s + 1), _mm_unpackhi_epi16(y, zero)));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        sums[x] += row[(size_t)x * step];
+    }
+}
+
+// Add (R + 2G + B), four times the approximate luma, of one packed RGB/RGBA
+// row to per-column totals
+static void add_rgb_row(const uint8_t* row, int width, int bpp, uint32_t* sums) {
+    for (int x = 0; x < width; x++, row += bpp) {
+        sums[x] += row[0] + 2 * row[1] + row[2];
+    }
+}
+
+// Fill out (thumb_width x thumb_height) with the mean luma of each block of a
+// width x height frame, so an object smaller than a block still moves that
+// block's value. add_row(y, sums) adds row y to the per-column totals, scaled
+// by luma_scale to stay in integers; every pixel is read once.
+template <typename AddRow>
+static void average_blocks(int width, int height, int thumb_width, int thumb_height, uint32_t luma_scale,
+                           const AddRow& add_row, uint32_t* sums, uint8_t* out) {
+    for (int ty = 0; ty < thumb_height; ty++) {
+        int y0 = ty * height / thumb_height;
+        int y1 = std::max((ty + 1) * height / thumb_height, y0 + 1);
+        std::fill(sums, sums + width, 0);
+        for (int y = y0; y < y1; y++) {
+            add_row(y, sums);
+        }
+        for (int tx = 0; tx < thumb_width; tx++) {
+            int x0 = tx * width / thumb_width;
+            int x1 = std::max((tx + 1) * width / thumb_width, x0 + 1);
+            uint32_t sum = 0;
+            for (int x = x0; x < x1; x++) {
+                sum += sums[x];
+            }
+            uint32_t area = (uint32_t)(x1 - x0) * (y1 - y0) * luma_scale;
+            out[ty * thumb_width + tx] = (uint8_t)((sum + area / 2) / area);
+        }
+    }
+}
+
+MotionGate::MotionGate(const MotionGateOptions& options)
+    : options(options),
+      reference(options.thumb_width * options.thumb_height),
+      current(options.thumb_width * options.thumb_height),
+      interval_ms(options.min_interval_ms) {
+}
+
+void MotionGate::makeThumbnail(const image_buffer_t* img, uint8_t* out) {
+    // For packed RGB/RGBA the luma is approximated as (R + 2G + B) / 4; for
+    // NV12/NV21 and gray the Y plane is read directly.
+    int bpp = 0;
+    if (img->format == IMAGE_FORMAT_RGB888) {
+        bpp = 3;
+    } else if (img->format == IMAGE_FORMAT_RGBA8888) {
+        bpp = 4;
+    }
+    int width = img->width;
+    int stride = img->width_stride > 0 ? img->width_stride : width;
+    const uint8_t* data = img->virt_addr;
+    column_sums.resize(std::max((int)column_sums.size(), width));
+
+    if (bpp > 0) {
+        average_blocks(width, img->height, options.thumb_width, options.thumb_height, 4,
+                       [&](int y, uint32_t* sums) { add_rgb_row(data + (size_t)y * stride * bpp, width, bpp, sums); },
+                       column_sums.data(), out);
+    } else {
+        average_blocks(width, img->height, options.thumb_width, options.thumb_height, 1,
+                       [&](int y, uint32_t* sums) { add_luma_row(data + (size_t)y * stride, width, 1, sums); },
+                       column_sums.data(), out);
+    }
+}
+
+void MotionGate::makeThumbnail(const YuvFrame* frame, uint8_t* out) {
+    // Y of YUYV is every other byte; NV12 starts with the Y plane
+    int step = frame->format == YuvFormat::YUYV ? 2 : 1;
+    int width = frame->width;
+    int stride = frame->stride > 0 ? frame->stride : width * step;
+    const uint8_t* data = frame->data;
+    column_sums.resize(std::max((int)column_sums.size(), width));
+
+    average_blocks(width, frame->height, options.thumb_width, options.thumb_height, 1,
+                   [&](int y, uint32_t* sums) { add_luma_row(data + (size_t)y * stride, width, step, sums); },
+                   column_sums.data(), out);
+}
+
+bool MotionGate::shouldInfer(const image_buffer_t* img, Clock::time_point now) {
+    if (!img || !img->virt_addr || img->width <= 0 || img->height <= 0) {
+        return true;
+    }
+    makeThumbnail(img, current.data());
+    return compare(now);
+}
+
+bool MotionGate::shouldInfer(const YuvFrame* frame, Clock::time_point now) {
+    if (!frame || !frame->data || frame->width <= 0 || frame->height <= 0) {
+        return true;
+    }
+    makeThumbnail(frame, current.data());
+    return compare(now);
+}
+
+// Decide on the thumbnail in current against the reference
+bool MotionGate::compare(Clock::time_point now) {
+    if (!has_reference) {
+        reference.swap(current);
+        has_reference = true;
+        last_inference = now;
+        return true;
+    }
+
+    uint8_t threshold = (uint8_t)std::min(std::max(options.threshold, 1), 255);
+    last_changed = count_changed_u8(current.data(), reference.data(), (int)current.size(), threshold);
+    bool motion = last_changed >= std::max(options.min_changed_blocks, 1);
+    auto since_last = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_inference).count();
+
+    if (motion) {
+        // Ramp straight back up to the full rate
+        interval_ms = options.min_interval_ms;
+    }
+    if (since_last < interval_ms) {
+        return false;
+    }
+
+    if (!motion) {
+        // Static scene: back off, but still refresh periodically
+        interval_ms = std::min(std::max(interval_ms * 2, 100), options.max_interval_ms);
+    }
+    reference.swap(current);
+    last_inference = now;
+    return true;
+}
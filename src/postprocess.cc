@@ -14,6 +14,10 @@
 
 #include "yolo.h"
 #include "image_utils.h"
+#include "log.h"
+#include "metrics.h"
+#include "tensor_layout.h"
+#include "work_pool.h"
 
 #include <math.h>
 #include <stdint.h>
@@ -22,7 +26,11 @@
 #include <string.h>
 #include <sys/time.h>
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <type_traits>
 #include <vector>
 #define LABEL_NALE_TXT_PATH "model/coco_80_labels_list.txt"
 
@@ -79,7 +87,7 @@ static int readLines(const char *fileName, char *lines[], int max_line)
 
     if (file == NULL)
     {
-        printf("Open %s fail!\n", fileName);
+        LOGE("Open %s fail!\n", fileName);
         return -1;
     }
 
@@ -95,7 +103,7 @@ static int readLines(const char *fileName, char *lines[], int max_line)
 
 static int loadLabelName(const char *locationFilename, char *label[])
 {
-    printf("load lable %s\n", locationFilename);
+    LOGI("load lable %s\n", locationFilename);
     readLines(locationFilename, label, OBJ_CLASS_NUM);
     return 0;
 }
@@ -181,54 +189,183 @@ static int quick_sort_indice_inverse(std::vector<float> &input, int left, int ri
     return low;
 }
 
-static float sigmoid(float x) { return 1.0 / (1.0 + expf(-x)); }
-
-static float unsigmoid(float y) { return -1.0 * logf((1.0 / y) - 1.0); }
-
 inline static int32_t __clip(float val, float min, float max)
 {
     float f = val <= min ? min : (val >= max ? max : val);
     return f;
 }
 
+#if !defined(RKNPU1)
 static int8_t qnt_f32_to_affine(float f32, int32_t zp, float scale)
 {
     float dst_val = (f32 / scale) + zp;
     int8_t res = (int8_t)__clip(dst_val, -128, 127);
     return res;
 }
+#endif
 
+#ifdef RKNPU1
 static uint8_t qnt_f32_to_affine_u8(float f32, int32_t zp, float scale)
 {
     float dst_val = (f32 / scale) + zp;
     uint8_t res = (uint8_t)__clip(dst_val, 0, 255);
     return res;
 }
+#endif
 
+#if !defined(RKNPU1)
 static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale) { return ((float)qnt - (float)zp) * scale; }
-
+#else
 static float deqnt_affine_u8_to_f32(uint8_t qnt, int32_t zp, float scale) { return ((float)qnt - (float)zp) * scale; }
+#endif
+
+// Attributes describing how output i is laid out in memory: the native ones
+// when outputs are bound in the NPU's native layout, else the standard ones
+static const rknn_tensor_attr *layout_attr(const rknn_app_context_t *app_ctx, int i)
+{
+    return app_ctx->native_output_attrs ? &app_ctx->native_output_attrs[i] : &app_ctx->output_attrs[i];
+}
+
+static int output_layout(const rknn_app_context_t *app_ctx, int i, int channels, int grid_h, int grid_w,
+                         tensor_layout_t *layout)
+{
+    const rknn_tensor_attr *native = app_ctx->native_output_attrs ? &app_ctx->native_output_attrs[i] : NULL;
+    return tensor_layout_init(native, channels, grid_h, grid_w, layout);
+}
+
+// Parallel decoding: each output branch is split into bands of grid rows
+// that the pool decodes concurrently. Every thread appends to its own
+// candidate buffer; the buffers are then merged in band order, so the
+// candidates, and everything sorted and suppressed after them, are the
+// same as decoding the bands one after another.
+
+#define DECODE_BAND_MIN_CELLS 1600   // Smaller bands cost more to hand out than to decode
+
+struct decode_band {
+    int branch;
+    int row_begin;
+    int row_end;
+};
+
+// Candidate boxes (x, y, w, h), scores and classes
+template <typename Box, typename Score>
+struct candidate_buffer {
+    std::vector<Box> boxes;
+    std::vector<Score> scores;
+    std::vector<int> class_ids;
+
+    int size() const { return (int)class_ids.size(); }
+
+    void clear()
+    {
+        boxes.clear();
+        scores.clear();
+        class_ids.clear();
+    }
 
-static void compute_dfl(float* tensor, int dfl_len, float* box){
-    for (int b=0; b<4; b++){
-        float exp_t[dfl_len];
-        float exp_sum=0;
-        float acc_sum=0;
-        for (int i=0; i< dfl_len; i++){
-            exp_t[i] = exp(tensor[i+b*dfl_len]);
-            exp_sum += exp_t[i];
+    void append(const candidate_buffer &other, int begin, int end)
+    {
+        boxes.insert(boxes.end(), other.boxes.begin() + begin * 4, other.boxes.begin() + end * 4);
+        scores.insert(scores.end(), other.scores.begin() + begin, other.scores.begin() + end);
+        class_ids.insert(class_ids.end(), other.class_ids.begin() + begin, other.class_ids.begin() + end);
+    }
+};
+
+static std::unique_ptr<WorkPool> decode_pool;
+static std::mutex decode_pool_mutex;   // Guards the pool and the per-thread buffers of decode_bands()
+
+void set_decode_threads(int threads)
+{
+    std::lock_guard<std::mutex> lock(decode_pool_mutex);
+    decode_pool.reset(threads > 0 ? new WorkPool(threads) : NULL);
+}
+
+// Bands of each branch for slots threads: whole branches on one thread,
+// else up to two bands per thread so stealing can even out uneven rows
+static void plan_decode_bands(const int *grid_h, const int *grid_w, int branches, int slots,
+                              std::vector<decode_band> &bands)
+{
+    bands.clear();
+    for (int b = 0; b < branches; b++) {
+        int n = slots > 1 ? std::min(2 * slots, grid_h[b] * grid_w[b] / DECODE_BAND_MIN_CELLS) : 1;
+        n = std::max(1, std::min(n, grid_h[b]));
+        for (int k = 0; k < n; k++) {
+            bands.push_back({b, grid_h[b] * k / n, grid_h[b] * (k + 1) / n});
         }
-        
-        for (int i=0; i< dfl_len; i++){
-            acc_sum += exp_t[i]/exp_sum *i;
+    }
+}
+
+// Decode the branches (grid_h x grid_w cells each) into candidates, in band
+// order whichever thread ran each band. decode(band, buffer) appends the
+// band's candidates to buffer and returns how many, or -1 on error, which
+// fails the whole decode. Runs on the calling thread when there is no pool
+// or another frame is using it.
+template <typename Buffer, typename Decode>
+static int decode_bands(const int *grid_h, const int *grid_w, int branches, std::vector<decode_band> &bands,
+                        Buffer &candidates, const Decode &decode)
+{
+    std::unique_lock<std::mutex> lock(decode_pool_mutex, std::try_to_lock);
+    bool parallel = lock.owns_lock() && decode_pool && decode_pool->threads() > 0;
+    plan_decode_bands(grid_h, grid_w, branches, parallel ? decode_pool->threads() + 1 : 1, bands);
+    if (!parallel || bands.size() < 2) {
+        int validCount = 0;
+        for (const decode_band &band : bands) {
+            int count = decode(band, candidates);
+            if (count < 0) {
+                return -1;
+            }
+            validCount += count;
+        }
+        return validCount;
+    }
+
+    struct span {
+        int slot;
+        int begin;
+        int end;
+        int count;
+    };
+    struct job_state {
+        const std::vector<decode_band> *bands;
+        const Decode *decode;
+        std::vector<Buffer> *thread_candidates;
+        std::vector<span> *spans;
+    };
+    // Reused across frames under decode_pool_mutex
+    static std::vector<Buffer> thread_candidates;
+    static std::vector<span> spans;
+    thread_candidates.resize(decode_pool->threads() + 1);
+    for (Buffer &buffer : thread_candidates) {
+        buffer.clear();
+    }
+    spans.resize(bands.size());
+
+    // A single pointer capture keeps std::function from allocating
+    job_state job = {&bands, &decode, &thread_candidates, &spans};
+    const job_state *state = &job;
+    decode_pool->run((int)bands.size(), [state](int task, int slot) {
+        Buffer &local = (*state->thread_candidates)[slot];
+        span &out = (*state->spans)[task];
+        out.slot = slot;
+        out.begin = local.size();
+        out.count = (*state->decode)((*state->bands)[task], local);
+        out.end = local.size();
+    });
+
+    int before = candidates.size();
+    for (const span &out : spans) {
+        if (out.count < 0) {
+            return -1;
         }
-        box[b] = acc_sum;
+        candidates.append(thread_candidates[out.slot], out.begin, out.end);
     }
+    return candidates.size() - before;
 }
 
+#ifdef RKNPU1
 static int process_u8(uint8_t *input, int32_t zp, float scale, uint8_t *unused1, int32_t unused2, float unused3,
                       uint8_t *unused4, int32_t unused5, float unused6,
-                      int grid_h, int grid_w, int stride, int unused_dfl_len,
+                      int grid_h, int grid_w, int row_begin, int row_end, int stride, int unused_dfl_len,
                       std::vector<float> &boxes,
                       std::vector<float> &objProbs,
                       std::vector<int> &classId,
@@ -238,7 +375,7 @@ static int process_u8(uint8_t *input, int32_t zp, float scale, uint8_t *unused1,
     int grid_len = grid_h * grid_w;
     uint8_t thres_u8 = qnt_f32_to_affine_u8(threshold, zp, scale);
 
-    for (int i = 0; i < grid_h; ++i)
+    for (int i = row_begin; i < row_end; ++i)
     {
         for (int j = 0; j < grid_w; ++j)
         {
@@ -287,30 +424,32 @@ static int process_u8(uint8_t *input, int32_t zp, float scale, uint8_t *unused1,
     return validCount;
 }
 
+#endif
+
+#if !defined(RKNPU1) && !defined(RV1106_1103)
 static int process_i8(int8_t *input, int32_t zp, float scale, int8_t *unused1, int32_t unused2, float unused3,
                       int8_t *unused4, int32_t unused5, float unused6,
-                      int grid_h, int grid_w, int stride, int unused_dfl_len,
+                      int grid_h, int grid_w, int row_begin, int row_end, int stride, int unused_dfl_len,
                       std::vector<float> &boxes, 
                       std::vector<float> &objProbs, 
                       std::vector<int> &classId, 
-                      float threshold)
+                      float threshold, const tensor_layout_t &layout)
 {
     int validCount = 0;
-    int grid_len = grid_h * grid_w;
     int8_t thres_i8 = qnt_f32_to_affine(threshold, zp, scale);
 
-    for (int i = 0; i < grid_h; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
         for (int j = 0; j < grid_w; ++j) {
-            int8_t box_confidence = input[4 * grid_len + i * grid_w + j];
+            int8_t box_confidence = input[layout.plane[4] + (i * grid_w + j) * layout.cell_step];
             if (box_confidence >= thres_i8) {
-                int offset = i * grid_w + j;
+                int offset = (i * grid_w + j) * layout.cell_step;
                 int8_t *in_ptr = input + offset;
 
-                int8_t maxClassProbs = in_ptr[5 * grid_len];
+                int8_t maxClassProbs = in_ptr[layout.plane[5]];
                 int maxClassId = 0;
                 for (int k = 1; k < OBJ_CLASS_NUM; ++k)
                 {
-                    int8_t prob = in_ptr[(5 + k) * grid_len];
+                    int8_t prob = in_ptr[layout.plane[5 + k]];
                     if (prob > maxClassProbs)
                     {
                         maxClassId = k;
@@ -320,10 +459,10 @@ static int process_i8(int8_t *input, int32_t zp, float scale, int8_t *unused1, i
 
                 if (maxClassProbs > thres_i8)
                 {
-                    float box_x = (deqnt_affine_to_f32(*in_ptr, zp, scale));
-                    float box_y = (deqnt_affine_to_f32(in_ptr[grid_len], zp, scale));
-                    float box_w = (deqnt_affine_to_f32(in_ptr[2 * grid_len], zp, scale));
-                    float box_h = (deqnt_affine_to_f32(in_ptr[3 * grid_len], zp, scale));
+                    float box_x = (deqnt_affine_to_f32(in_ptr[layout.plane[0]], zp, scale));
+                    float box_y = (deqnt_affine_to_f32(in_ptr[layout.plane[1]], zp, scale));
+                    float box_w = (deqnt_affine_to_f32(in_ptr[layout.plane[2]], zp, scale));
+                    float box_h = (deqnt_affine_to_f32(in_ptr[layout.plane[3]], zp, scale));
                     box_x = (box_x + j) * (float)stride;
                     box_y = (box_y + i) * (float)stride;
                     box_w = exp(box_w) * stride;
@@ -345,8 +484,11 @@ static int process_i8(int8_t *input, int32_t zp, float scale, int8_t *unused1, i
     return validCount;
 }
 
+#endif
+
+#if !defined(RV1106_1103)
 static int process_fp32(float *input, float *unused1, float *unused2, 
-                        int grid_h, int grid_w, int stride, int unused_dfl_len,
+                        int grid_h, int grid_w, int row_begin, int row_end, int stride, int unused_dfl_len,
                         std::vector<float> &boxes, 
                         std::vector<float> &objProbs, 
                         std::vector<int> &classId, 
@@ -355,7 +497,7 @@ static int process_fp32(float *input, float *unused1, float *unused2,
     int validCount = 0;
     int grid_len = grid_h * grid_w;
 
-    for (int i = 0; i < grid_h; i++)
+    for (int i = row_begin; i < row_end; i++)
     {
         for (int j = 0; j < grid_w; j++)
         {
@@ -401,22 +543,22 @@ static int process_fp32(float *input, float *unused1, float *unused2,
     }
     return validCount;
 }
+#endif
 
 
 #if defined(RV1106_1103)
 static int process_i8_rv1106(int8_t *input, int32_t zp, float scale, int8_t *unused1, int32_t unused2, float unused3,
                              int8_t *unused4, int32_t unused5, float unused6,
-                             int grid_h, int grid_w, int stride, int unused_dfl_len,
+                             int grid_h, int grid_w, int row_begin, int row_end, int stride, int unused_dfl_len,
                              std::vector<float> &boxes,
                              std::vector<float> &objProbs,
                              std::vector<int> &classId,
                              float threshold) {
     int validCount = 0;
-    int grid_len = grid_h * grid_w;
     int8_t thres_i8 = qnt_f32_to_affine(threshold, zp, scale);
     const int PROP_BOX_SIZE = 5 + OBJ_CLASS_NUM; // 85 for COCO
 
-    for (int i = 0; i < grid_h; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
         for (int j = 0; j < grid_w; ++j) {
             int8_t box_confidence = input[4 + (i * grid_w + j) * PROP_BOX_SIZE];
             if (box_confidence >= thres_i8) {
@@ -459,37 +601,37 @@ static int process_i8_rv1106(int8_t *input, int32_t zp, float scale, int8_t *unu
             }
         }
     }
-    printf("validCount=%d\n", validCount);
-    printf("grid h-%d, w-%d, stride %d\n", grid_h, grid_w, stride);
     return validCount;
 }
 #endif
 
 // Simplified YOLO processing functions (unified tensor format)
 // YoloV8-specific processing functions (9-output structure)
+#if !defined(RKNPU1)
 static int process_yolov8_scale_i8(int8_t *box_input, int32_t box_zp, float box_scale,
                                    int8_t *cls_input, int32_t cls_zp, float cls_scale,
                                    int8_t *obj_input, int32_t obj_zp, float obj_scale,
-                                   int grid_h, int grid_w, int stride,
+                                   int grid_h, int grid_w, int row_begin, int row_end, int stride,
                                    std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId,
-                                   float threshold)
+                                   float threshold, const tensor_layout_t &box_layout,
+                                   const tensor_layout_t &cls_layout, const tensor_layout_t &obj_layout)
 {
     int validCount = 0;
     int8_t thres_i8 = qnt_f32_to_affine(threshold, obj_zp, obj_scale);
 
-    for (int i = 0; i < grid_h; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
         for (int j = 0; j < grid_w; ++j) {
             int grid_idx = i * grid_w + j;
             
             // Get objectness confidence from obj_input [1, 1, H, W]
-            int8_t box_confidence = obj_input[grid_idx];
+            int8_t box_confidence = obj_input[obj_layout.plane[0] + grid_idx * obj_layout.cell_step];
             if (box_confidence >= thres_i8) {
                 
                 // Find max class probability from cls_input [1, 80, H, W]
-                int8_t maxClassProbs = cls_input[grid_idx]; // class 0
+                int8_t maxClassProbs = cls_input[cls_layout.plane[0] + grid_idx * cls_layout.cell_step]; // class 0
                 int maxClassId = 0;
                 for (int k = 1; k < OBJ_CLASS_NUM; ++k) {
-                    int8_t prob = cls_input[k * grid_h * grid_w + grid_idx];
+                    int8_t prob = cls_input[cls_layout.plane[k] + grid_idx * cls_layout.cell_step];
                     if (prob > maxClassProbs) {
                         maxClassId = k;
                         maxClassProbs = prob;
@@ -508,7 +650,7 @@ static int process_yolov8_scale_i8(int8_t *box_input, int32_t box_zp, float box_
                         float acc_sum = 0;
                         
                         for (int d = 0; d < dfl_len; d++) {
-                            int dfl_idx = (coord * dfl_len + d) * grid_h * grid_w + grid_idx;
+                            int dfl_idx = box_layout.plane[coord * dfl_len + d] + grid_idx * box_layout.cell_step;
                             float exp_val = exp(deqnt_affine_to_f32(box_input[dfl_idx], box_zp, box_scale));
                             exp_sum += exp_val;
                             acc_sum += exp_val * d;
@@ -522,10 +664,6 @@ static int process_yolov8_scale_i8(int8_t *box_input, int32_t box_zp, float box_
                     float box_y = (i + 0.5f - box_coords[1]) * stride;
                     float box_w = (j + 0.5f + box_coords[2]) * stride - box_x;
                     float box_h = (i + 0.5f + box_coords[3]) * stride - box_y;
-                    
-                    // Convert to corner coordinates
-                    box_x = box_x - box_w / 2.0f;
-                    box_y = box_y - box_h / 2.0f;
 
                     // Calculate final confidence score
                     float obj_score = deqnt_affine_to_f32(box_confidence, obj_zp, obj_scale);
@@ -545,17 +683,20 @@ static int process_yolov8_scale_i8(int8_t *box_input, int32_t box_zp, float box_
     return validCount;
 }
 
+#endif
+
+#ifdef RKNPU1
 static int process_yolov8_scale_u8(uint8_t *box_input, int32_t box_zp, float box_scale,
                                    uint8_t *cls_input, int32_t cls_zp, float cls_scale,
                                    uint8_t *obj_input, int32_t obj_zp, float obj_scale,
-                                   int grid_h, int grid_w, int stride,
+                                   int grid_h, int grid_w, int row_begin, int row_end, int stride,
                                    std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId,
                                    float threshold)
 {
     int validCount = 0;
     uint8_t thres_u8 = qnt_f32_to_affine_u8(threshold, obj_zp, obj_scale);
 
-    for (int i = 0; i < grid_h; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
         for (int j = 0; j < grid_w; ++j) {
             int grid_idx = i * grid_w + j;
             
@@ -600,10 +741,6 @@ static int process_yolov8_scale_u8(uint8_t *box_input, int32_t box_zp, float box
                     float box_y = (i + 0.5f - box_coords[1]) * stride;
                     float box_w = (j + 0.5f + box_coords[2]) * stride - box_x;
                     float box_h = (i + 0.5f + box_coords[3]) * stride - box_y;
-                    
-                    // Convert to corner coordinates
-                    box_x = box_x - box_w / 2.0f;
-                    box_y = box_y - box_h / 2.0f;
 
                     // Calculate final confidence score
                     float obj_score = deqnt_affine_u8_to_f32(box_confidence, obj_zp, obj_scale);
@@ -623,14 +760,17 @@ static int process_yolov8_scale_u8(uint8_t *box_input, int32_t box_zp, float box
     return validCount;
 }
 
+#endif
+
+#if !defined(RV1106_1103)
 static int process_yolov8_scale_fp32(float *box_input, float *cls_input, float *obj_input,
-                                     int grid_h, int grid_w, int stride,
+                                     int grid_h, int grid_w, int row_begin, int row_end, int stride,
                                      std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId,
                                      float threshold)
 {
     int validCount = 0;
 
-    for (int i = 0; i < grid_h; i++) {
+    for (int i = row_begin; i < row_end; i++) {
         for (int j = 0; j < grid_w; j++) {
             int grid_idx = i * grid_w + j;
             
@@ -674,10 +814,6 @@ static int process_yolov8_scale_fp32(float *box_input, float *cls_input, float *
                     float box_y = (i + 0.5f - box_coords[1]) * stride;
                     float box_w = (j + 0.5f + box_coords[2]) * stride - box_x;
                     float box_h = (i + 0.5f + box_coords[3]) * stride - box_y;
-                    
-                    // Convert to corner coordinates
-                    box_x = box_x - box_w / 2.0f;
-                    box_y = box_y - box_h / 2.0f;
 
                     // Calculate final confidence score
                     objProbs.push_back(box_confidence * maxClassProbs);
@@ -693,8 +829,10 @@ static int process_yolov8_scale_fp32(float *box_input, float *cls_input, float *
     }
     return validCount;
 }
+#endif
 
-static int process_simplified_yolo_u8(uint8_t *input, int grid_h, int grid_w, int height, int width, int stride,
+#ifdef RKNPU1
+static int process_simplified_yolo_u8(uint8_t *input, int grid_h, int grid_w, int row_begin, int row_end, int height, int width, int stride,
                                       std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId, 
                                       float threshold, int32_t zp, float scale)
 {
@@ -702,7 +840,7 @@ static int process_simplified_yolo_u8(uint8_t *input, int grid_h, int grid_w, in
     int grid_len = grid_h * grid_w;
     uint8_t thres_u8 = qnt_f32_to_affine_u8(threshold, zp, scale);
 
-    for (int i = 0; i < grid_h; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
         for (int j = 0; j < grid_w; ++j) {
             uint8_t box_confidence = input[4 * grid_len + i * grid_w + j];
             if (box_confidence >= thres_u8) {
@@ -749,25 +887,28 @@ static int process_simplified_yolo_u8(uint8_t *input, int grid_h, int grid_w, in
     return validCount;
 }
 
-static int process_simplified_yolo_i8(int8_t *input, int grid_h, int grid_w, int height, int width, int stride,
+#endif
+
+#if !defined(RKNPU1)
+static int process_simplified_yolo_i8(int8_t *input, int grid_h, int grid_w, int row_begin, int row_end, int height, int width, int stride,
                                       std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId, 
-                                      float threshold, int32_t zp, float scale)
+                                      float threshold, int32_t zp, float scale,
+                                      const tensor_layout_t &layout)
 {
     int validCount = 0;
-    int grid_len = grid_h * grid_w;
     int8_t thres_i8 = qnt_f32_to_affine(threshold, zp, scale);
 
-    for (int i = 0; i < grid_h; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
         for (int j = 0; j < grid_w; ++j) {
-            int8_t box_confidence = input[4 * grid_len + i * grid_w + j];
+            int8_t box_confidence = input[layout.plane[4] + (i * grid_w + j) * layout.cell_step];
             if (box_confidence >= thres_i8) {
-                int offset = i * grid_w + j;
+                int offset = (i * grid_w + j) * layout.cell_step;
                 int8_t *in_ptr = input + offset;
 
-                int8_t maxClassProbs = in_ptr[5 * grid_len];
+                int8_t maxClassProbs = in_ptr[layout.plane[5]];
                 int maxClassId = 0;
                 for (int k = 1; k < OBJ_CLASS_NUM; ++k) {
-                    int8_t prob = in_ptr[(5 + k) * grid_len];
+                    int8_t prob = in_ptr[layout.plane[5 + k]];
                     if (prob > maxClassProbs) {
                         maxClassId = k;
                         maxClassProbs = prob;
@@ -775,10 +916,10 @@ static int process_simplified_yolo_i8(int8_t *input, int grid_h, int grid_w, int
                 }
 
                 if (maxClassProbs > thres_i8) {
-                    float box_x = deqnt_affine_to_f32(*in_ptr, zp, scale);
-                    float box_y = deqnt_affine_to_f32(in_ptr[grid_len], zp, scale);
-                    float box_w = deqnt_affine_to_f32(in_ptr[2 * grid_len], zp, scale);
-                    float box_h = deqnt_affine_to_f32(in_ptr[3 * grid_len], zp, scale);
+                    float box_x = deqnt_affine_to_f32(in_ptr[layout.plane[0]], zp, scale);
+                    float box_y = deqnt_affine_to_f32(in_ptr[layout.plane[1]], zp, scale);
+                    float box_w = deqnt_affine_to_f32(in_ptr[layout.plane[2]], zp, scale);
+                    float box_h = deqnt_affine_to_f32(in_ptr[layout.plane[3]], zp, scale);
                     
                     // Simplified YOLO coordinate transformation
                     box_x = (box_x + j) * (float)stride;
@@ -804,14 +945,17 @@ static int process_simplified_yolo_i8(int8_t *input, int grid_h, int grid_w, int
     return validCount;
 }
 
-static int process_simplified_yolo_fp32(float *input, int grid_h, int grid_w, int height, int width, int stride,
+#endif
+
+#if !defined(RV1106_1103)
+static int process_simplified_yolo_fp32(float *input, int grid_h, int grid_w, int row_begin, int row_end, int height, int width, int stride,
                                         std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId, 
                                         float threshold)
 {
     int validCount = 0;
     int grid_len = grid_h * grid_w;
 
-    for (int i = 0; i < grid_h; i++) {
+    for (int i = row_begin; i < row_end; i++) {
         for (int j = 0; j < grid_w; j++) {
             float box_confidence = input[4 * grid_len + i * grid_w + j];
             if (box_confidence >= threshold) {
@@ -856,34 +1000,738 @@ static int process_simplified_yolo_fp32(float *input, int grid_h, int grid_w, in
     }
     return validCount;
 }
+#endif
+
+// Integer-domain decode of quantized outputs (rknn_app_context_t::integer_decode)
+//
+// Each threshold becomes the smallest passing quantized value of its tensor,
+// objectness x class score is read from a table indexed by the two quantized
+// values, and boxes are decoded in 1/16 pixel fixed point through per-tensor
+// tables (grid offset and exp() for YOLOX, softmax weights for the YOLOv8
+// DFL). NMS runs on the fixed-point boxes; scores and coordinates only become
+// float when written to od_results. The grid scans compare and select whole
+// rows, so the compiler can vectorize them in int8 lanes.
+
+#define QDEC_FRAC_BITS 4                   // Box coordinates in 1/16 pixel
+#define QDEC_ONE (1 << QDEC_FRAC_BITS)
+#define QDEC_SCORE_ONE 65535               // Score table value of 1.0
+#define QDEC_DFL_LEN 16
+#define QDEC_NONE 256                      // Threshold index when no value passes
+#define QDEC_LANES 16                      // Cells per block of the row scans, one 128-bit int8 vector
+
+// Tables of one output scale, indexed by quantized value (int8 shifted by 128)
+struct quant_scale_tables {
+    int grid_h;
+    int grid_w;
+    int stride;
+    int obj_min;                   // Smallest index with objectness >= threshold
+    int cls_min;                   // Smallest index with class score > threshold
+    int cls_count;                 // 256 - cls_min
+    std::vector<uint16_t> score;   // obj * cls, [(obj - obj_min) * cls_count + cls - cls_min]
+    int32_t offset[256];           // YOLOX: x/y offset * stride, fixed point
+    int32_t size[256];             // YOLOX: exp(w/h) * stride, fixed point
+    uint32_t dfl_weight[256];      // YOLOv8: exp(-d * box scale) in Q16, d = max - value
+};
+
+// Output quantization and layout the tables were built for
+struct quant_output_key {
+    int32_t zp;
+    float scale;
+    rknn_tensor_type type;
+    rknn_tensor_format fmt;
+    uint32_t dims[5];
+};
+
+struct quant_decode_tables {
+    float threshold;
+    int model_height;
+    std::vector<quant_output_key> outputs;
+    quant_scale_tables scales[3];
+    tensor_layout_t layouts[9];
+
+    // Per-frame scratch, reused so steady state does not allocate
+    candidate_buffer<int32_t, uint16_t> candidates;   // Boxes in fixed point
+    std::vector<decode_band> bands;
+    std::vector<int> order;
+};
+
+template <typename T> static inline int quant_index(T q)
+{
+    return std::is_signed<T>::value ? (int)q + 128 : (int)q;
+}
+
+template <typename T> static inline T quant_from_index(int index)
+{
+    return (T)(std::is_signed<T>::value ? index - 128 : index);
+}
+
+// Same arithmetic as deqnt_affine_to_f32() so thresholds agree exactly
+static float quant_index_to_f32(int index, bool is_signed, int32_t zp, float scale)
+{
+    return ((float)(is_signed ? index - 128 : index) - (float)zp) * scale;
+}
+
+static int quant_threshold_index(bool is_signed, int32_t zp, float scale, float threshold, bool inclusive)
+{
+    for (int index = 0; index < 256; index++) {
+        float value = quant_index_to_f32(index, is_signed, zp, scale);
+        if (inclusive ? value >= threshold : value > threshold) {
+            return index;
+        }
+    }
+    return QDEC_NONE;
+}
+
+static void build_scale_tables(quant_scale_tables *t, bool is_signed, const rknn_tensor_attr *box,
+                               const rknn_tensor_attr *cls, const rknn_tensor_attr *obj, bool dfl, float threshold)
+{
+    t->obj_min = quant_threshold_index(is_signed, obj->zp, obj->scale, threshold, true);
+    t->cls_min = quant_threshold_index(is_signed, cls->zp, cls->scale, threshold, false);
+    t->cls_count = 256 - t->cls_min;
+    t->score.assign((size_t)(256 - t->obj_min) * t->cls_count, 0);
+    for (int o = t->obj_min; o < 256; o++) {
+        float obj_score = quant_index_to_f32(o, is_signed, obj->zp, obj->scale);
+        for (int c = t->cls_min; c < 256; c++) {
+            float score = obj_score * quant_index_to_f32(c, is_signed, cls->zp, cls->scale);
+            long q = lrintf(score * QDEC_SCORE_ONE);
+            t->score[(o - t->obj_min) * t->cls_count + c - t->cls_min] =
+                (uint16_t)std::min(std::max(q, 0L), (long)QDEC_SCORE_ONE);
+        }
+    }
+
+    for (int index = 0; index < 256; index++) {
+        if (dfl) {
+            t->dfl_weight[index] = (uint32_t)lrint(exp(-index * (double)box->scale) * 65536.0);
+        } else {
+            double value = quant_index_to_f32(index, is_signed, box->zp, box->scale);
+            t->offset[index] = (int32_t)lrint(value * t->stride * QDEC_ONE);
+            t->size[index] = (int32_t)lrint(std::min(exp(value) * t->stride, (double)(1 << 20)) * QDEC_ONE);
+        }
+    }
+}
+
+static bool decode_tables_match(const quant_decode_tables *tables, const rknn_app_context_t *app_ctx, float threshold)
+{
+    if (tables->threshold != threshold || tables->model_height != app_ctx->model_height ||
+        tables->outputs.size() != app_ctx->io_num.n_output) {
+        return false;
+    }
+    for (uint32_t i = 0; i < app_ctx->io_num.n_output; i++) {
+        const rknn_tensor_attr &attr = *layout_attr(app_ctx, i);
+        const quant_output_key &key = tables->outputs[i];
+        if (key.zp != attr.zp || key.scale != attr.scale || key.type != attr.type || key.fmt != attr.fmt ||
+            memcmp(key.dims, attr.dims, sizeof(key.dims)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int prepare_decode_tables(rknn_app_context_t *app_ctx, float conf_threshold)
+{
+    int n_output = app_ctx->io_num.n_output;
+#if defined(RV1106_1103)
+    // NHWC outputs, decoded by the float path
+    return -1;
+#endif
+    if (!app_ctx->is_quant || (n_output != 3 && n_output != 9)) {
+        return -1;
+    }
+    rknn_tensor_type type = app_ctx->output_attrs[0].type;
+    for (int i = 0; i < n_output; i++) {
+        if (app_ctx->output_attrs[i].type != type || app_ctx->output_attrs[i].scale <= 0.0f) {
+            return -1;
+        }
+    }
+    if (type != RKNN_TENSOR_INT8 && type != RKNN_TENSOR_UINT8) {
+        return -1;
+    }
+    if (app_ctx->decode_tables && decode_tables_match(app_ctx->decode_tables, app_ctx, conf_threshold)) {
+        return 0;
+    }
+
+    tensor_layout_t layouts[9];
+    for (int i = 0; i < n_output; i++) {
+        int channels, grid_h, grid_w;
+        output_shape(&app_ctx->output_attrs[i], &channels, &grid_h, &grid_w);
+        if (output_layout(app_ctx, i, channels, grid_h, grid_w, &layouts[i]) != 0) {
+            return -1;
+        }
+    }
+
+    quant_decode_tables *tables = app_ctx->decode_tables ? app_ctx->decode_tables : new quant_decode_tables();
+    tables->threshold = conf_threshold;
+    tables->model_height = app_ctx->model_height;
+    tables->outputs.resize(n_output);
+    for (int i = 0; i < n_output; i++) {
+        const rknn_tensor_attr &attr = *layout_attr(app_ctx, i);
+        quant_output_key &key = tables->outputs[i];
+        key.zp = attr.zp;
+        key.scale = attr.scale;
+        key.type = attr.type;
+        key.fmt = attr.fmt;
+        memcpy(key.dims, attr.dims, sizeof(key.dims));
+    }
+    memcpy(tables->layouts, layouts, n_output * sizeof(tensor_layout_t));
+
+    // YOLOv8: box, class and objectness tensors per scale; YOLOX: one tensor per scale
+    bool yolov8 = n_output == 9;
+    for (int s = 0; s < 3; s++) {
+        quant_scale_tables *t = &tables->scales[s];
+        const rknn_tensor_attr *box = &app_ctx->output_attrs[yolov8 ? s * 3 : s];
+        int channels;
+        output_shape(box, &channels, &t->grid_h, &t->grid_w);
+        t->stride = t->grid_h > 0 ? app_ctx->model_height / t->grid_h : 0;
+        build_scale_tables(t, type == RKNN_TENSOR_INT8, box, yolov8 ? box + 1 : box, yolov8 ? box + 2 : box, yolov8,
+                           conf_threshold);
+    }
+    app_ctx->decode_tables = tables;
+    LOGD("integer decode tables built for threshold %.3f\n", conf_threshold);
+    return 0;
+}
+
+void release_decode_tables(rknn_app_context_t *app_ctx)
+{
+    delete app_ctx->decode_tables;
+    app_ctx->decode_tables = NULL;
+}
+
+// Cells of a grid row at or above the objectness threshold. The row scans
+// work in fixed blocks of QDEC_LANES cells so they vectorize even under the
+// -O2 cost model.
+template <typename T>
+static int count_passing_q(const T *__restrict obj_row, int grid_w, T obj_thres)
+{
+    int passing = 0;
+    int j = 0;
+    for (; j + QDEC_LANES <= grid_w; j += QDEC_LANES) {
+        uint8_t block = 0;
+        for (int l = 0; l < QDEC_LANES; l++) {
+            block += obj_row[j + l] >= obj_thres;
+        }
+        passing += block;
+    }
+    for (; j < grid_w; j++) {
+        passing += obj_row[j] >= obj_thres;
+    }
+    return passing;
+}
+
+// Class argmax of a whole grid row. Ties keep the lowest class id, like the
+// per-cell loops.
+template <typename T>
+static void class_argmax_row_q(const T *__restrict cls_row, int grid_len, int grid_w, T *__restrict max_prob,
+                               uint8_t *__restrict max_class)
+{
+    memcpy(max_prob, cls_row, grid_w * sizeof(T));
+    memset(max_class, 0, grid_w);
+    for (int k = 1; k < OBJ_CLASS_NUM; k++) {
+        const T *__restrict prob = cls_row + k * grid_len;
+        int j = 0;
+        for (; j + QDEC_LANES <= grid_w; j += QDEC_LANES) {
+            for (int l = 0; l < QDEC_LANES; l++) {
+                bool greater = prob[j + l] > max_prob[j + l];
+                max_prob[j + l] = greater ? prob[j + l] : max_prob[j + l];
+                max_class[j + l] = greater ? (uint8_t)k : max_class[j + l];
+            }
+        }
+        for (; j < grid_w; j++) {
+            if (prob[j] > max_prob[j]) {
+                max_prob[j] = prob[j];
+                max_class[j] = k;
+            }
+        }
+    }
+}
+
+template <typename T>
+static inline void class_argmax_cell_q(const T *cls, int grid_len, T *max_prob, uint8_t *max_class)
+{
+    T best = cls[0];
+    int best_class = 0;
+    for (int k = 1; k < OBJ_CLASS_NUM; k++) {
+        if (cls[k * grid_len] > best) {
+            best = cls[k * grid_len];
+            best_class = k;
+        }
+    }
+    *max_prob = best;
+    *max_class = best_class;
+}
+
+// Class argmax of the cells of a grid row that pass the objectness
+// threshold, a whole row at a time once enough of them pass. Returns false
+// when none passes.
+template <typename T>
+static bool scan_row_q(const T *obj_row, const T *cls_row, int grid_len, int grid_w, T obj_thres, T *max_prob,
+                       uint8_t *max_class)
+{
+    int passing = count_passing_q(obj_row, grid_w, obj_thres);
+    if (passing == 0) {
+        return false;
+    }
+    if (passing * 4 >= grid_w) {
+        class_argmax_row_q(cls_row, grid_len, grid_w, max_prob, max_class);
+        return true;
+    }
+    for (int j = 0; j < grid_w; j++) {
+        if (obj_row[j] >= obj_thres) {
+            class_argmax_cell_q(cls_row + j, grid_len, &max_prob[j], &max_class[j]);
+        }
+    }
+    return true;
+}
+
+static inline uint16_t quant_score(const quant_scale_tables &t, int obj_index, int cls_index)
+{
+    return t.score[(obj_index - t.obj_min) * t.cls_count + cls_index - t.cls_min];
+}
+
+// Class argmax of one cell in an interleaved layout (NHWC, NC1HWC2), where the
+// classes of a cell are a few cache lines rather than one line per class
+template <typename T>
+static inline void class_argmax_layout_q(const T *cell, const int *planes, T *max_prob, uint8_t *max_class)
+{
+    T best = cell[planes[0]];
+    int best_class = 0;
+    for (int k = 1; k < OBJ_CLASS_NUM; k++) {
+        if (cell[planes[k]] > best) {
+            best = cell[planes[k]];
+            best_class = k;
+        }
+    }
+    *max_prob = best;
+    *max_class = best_class;
+}
+
+// Largest of n values step elements apart; branch-free so rows of
+// interleaved layouts without a candidate are skipped quickly
+template <typename T>
+static inline T strided_max_q(const T *values, int n, size_t step)
+{
+    T best = values[0];
+    for (int j = 1; j < n; j++) {
+        best = std::max(best, values[j * step]);
+    }
+    return best;
+}
+
+// YOLOX / unified tensor [1, 85, H, W] in any layout
+template <typename T>
+static int decode_yolox_scale_q(const T *input, const tensor_layout_t &layout, const quant_scale_tables &t,
+                                int row_begin, int row_end, std::vector<int32_t> &boxes, std::vector<uint16_t> &scores, std::vector<int> &classId)
+{
+    if (t.obj_min == QDEC_NONE || t.cls_min == QDEC_NONE) {
+        return 0;
+    }
+    const int grid_w = t.grid_w;
+    const int grid_len = t.grid_h * grid_w;
+    const int step = layout.cell_step;
+    const int *plane = layout.plane;
+    const bool planar = step == 1;
+    const T obj_thres = quant_from_index<T>(t.obj_min);
+    const T cls_thres = quant_from_index<T>(t.cls_min);
+    T max_prob[grid_w];
+    uint8_t max_class[grid_w];
+    int validCount = 0;
+
+    for (int i = row_begin; i < row_end; i++) {
+        int row = i * grid_w;
+        if (planar ? !scan_row_q(input + plane[4] + row, input + plane[5] + row, grid_len, grid_w, obj_thres,
+                                 max_prob, max_class)
+                   : strided_max_q(input + plane[4] + (size_t)row * step, grid_w, step) < obj_thres) {
+            continue;
+        }
+        for (int j = 0; j < grid_w; j++) {
+            const T *cell = input + (size_t)(row + j) * step;
+            T box_confidence = cell[plane[4]];
+            if (box_confidence < obj_thres) {
+                continue;
+            }
+            if (!planar) {
+                class_argmax_layout_q(cell, plane + 5, &max_prob[j], &max_class[j]);
+            }
+            if (max_prob[j] < cls_thres) {
+                continue;
+            }
+            int32_t w = t.size[quant_index(cell[plane[2]])];
+            int32_t h = t.size[quant_index(cell[plane[3]])];
+            boxes.push_back(((j * t.stride) << QDEC_FRAC_BITS) + t.offset[quant_index(cell[plane[0]])] - w / 2);
+            boxes.push_back(((i * t.stride) << QDEC_FRAC_BITS) + t.offset[quant_index(cell[plane[1]])] - h / 2);
+            boxes.push_back(w);
+            boxes.push_back(h);
+            scores.push_back(quant_score(t, quant_index(box_confidence), quant_index(max_prob[j])));
+            classId.push_back(max_class[j]);
+            validCount++;
+        }
+    }
+    return validCount;
+}
+
+// Expected DFL distance of one box side times stride, fixed point
+template <typename T>
+static inline int32_t dfl_distance_q(const T *cell, const int *planes, const quant_scale_tables &t)
+{
+    int values[QDEC_DFL_LEN];
+    int max_value = 0;
+    for (int d = 0; d < QDEC_DFL_LEN; d++) {
+        values[d] = quant_index(cell[planes[d]]);
+        max_value = std::max(max_value, values[d]);
+    }
+    uint32_t sum = 0;
+    uint32_t acc = 0;
+    for (int d = 0; d < QDEC_DFL_LEN; d++) {
+        uint32_t weight = t.dfl_weight[max_value - values[d]];
+        sum += weight;
+        acc += weight * d;
+    }
+    return (int32_t)(((int64_t)acc * t.stride * QDEC_ONE + sum / 2) / sum);
+}
+
+// YOLOv8 box [1, 64, H, W], class [1, 80, H, W] and objectness [1, 1, H, W] in any layout
+template <typename T>
+static int decode_yolov8_scale_q(const T *box_input, const tensor_layout_t &box_layout, const T *cls_input,
+                                 const tensor_layout_t &cls_layout, const T *obj_input,
+                                 const tensor_layout_t &obj_layout, const quant_scale_tables &t, int row_begin,
+                                 int row_end,
+                                 std::vector<int32_t> &boxes, std::vector<uint16_t> &scores,
+                                 std::vector<int> &classId)
+{
+    if (t.obj_min == QDEC_NONE || t.cls_min == QDEC_NONE) {
+        return 0;
+    }
+    const int grid_w = t.grid_w;
+    const int grid_len = t.grid_h * grid_w;
+    const bool planar = cls_layout.cell_step == 1 && obj_layout.cell_step == 1;
+    const size_t box_step = box_layout.cell_step;
+    const size_t cls_step = cls_layout.cell_step;
+    const size_t obj_step = obj_layout.cell_step;
+    const T obj_thres = quant_from_index<T>(t.obj_min);
+    const T cls_thres = quant_from_index<T>(t.cls_min);
+    obj_input += obj_layout.plane[0];
+    T max_prob[grid_w];
+    uint8_t max_class[grid_w];
+    int validCount = 0;
+
+    for (int i = row_begin; i < row_end; i++) {
+        int row = i * grid_w;
+        if (planar ? !scan_row_q(obj_input + row, cls_input + row, grid_len, grid_w, obj_thres, max_prob,
+                                 max_class)
+                   : strided_max_q(obj_input + row * obj_step, grid_w, obj_step) < obj_thres) {
+            continue;
+        }
+        for (int j = 0; j < grid_w; j++) {
+            T box_confidence = obj_input[(row + j) * obj_step];
+            if (box_confidence < obj_thres) {
+                continue;
+            }
+            if (!planar) {
+                class_argmax_layout_q(cls_input + (row + j) * cls_step, cls_layout.plane,
+                                      &max_prob[j], &max_class[j]);
+            }
+            if (max_prob[j] < cls_thres) {
+                continue;
+            }
+            const T *cell = box_input + (row + j) * box_step;
+            int32_t left = dfl_distance_q(cell, box_layout.plane, t);
+            int32_t top = dfl_distance_q(cell, box_layout.plane + QDEC_DFL_LEN, t);
+            int32_t right = dfl_distance_q(cell, box_layout.plane + 2 * QDEC_DFL_LEN, t);
+            int32_t bottom = dfl_distance_q(cell, box_layout.plane + 3 * QDEC_DFL_LEN, t);
+            // Anchor at the cell centre
+            int32_t cx = ((2 * j + 1) * t.stride) << (QDEC_FRAC_BITS - 1);
+            int32_t cy = ((2 * i + 1) * t.stride) << (QDEC_FRAC_BITS - 1);
+            boxes.push_back(cx - left);
+            boxes.push_back(cy - top);
+            boxes.push_back(left + right);
+            boxes.push_back(top + bottom);
+            scores.push_back(quant_score(t, quant_index(box_confidence), quant_index(max_prob[j])));
+            classId.push_back(max_class[j]);
+            validCount++;
+        }
+    }
+    return validCount;
+}
+
+template <typename T>
+static int decode_outputs_q(rknn_app_context_t *app_ctx, rknn_output *outputs, quant_decode_tables *tables)
+{
+    typedef candidate_buffer<int32_t, uint16_t> buffer_t;
+    const tensor_layout_t *layouts = tables->layouts;
+    const bool yolov8 = app_ctx->io_num.n_output == 9;
+    int grid_h[3], grid_w[3];
+    for (int s = 0; s < 3; s++) {
+        grid_h[s] = tables->scales[s].grid_h;
+        grid_w[s] = tables->scales[s].grid_w;
+    }
+    auto decode = [&](const decode_band &band, buffer_t &out) {
+        int s = band.branch;
+        if (yolov8) {
+            int b = s * 3;
+            return decode_yolov8_scale_q((const T *)outputs[b].buf, layouts[b], (const T *)outputs[b + 1].buf,
+                                         layouts[b + 1], (const T *)outputs[b + 2].buf, layouts[b + 2],
+                                         tables->scales[s], band.row_begin, band.row_end, out.boxes, out.scores,
+                                         out.class_ids);
+        }
+        return decode_yolox_scale_q((const T *)outputs[s].buf, layouts[s], tables->scales[s], band.row_begin,
+                                    band.row_end, out.boxes, out.scores, out.class_ids);
+    };
+    return decode_bands(grid_h, grid_w, 3, tables->bands, tables->candidates, decode);
+}
+
+// IoU > threshold with the same +1 pixel convention as CalculateOverlap()
+static bool overlaps_q(const int32_t *a, const int32_t *b, float threshold)
+{
+    int64_t w = std::max(0, std::min(a[0] + a[2], b[0] + b[2]) - std::max(a[0], b[0]) + QDEC_ONE);
+    int64_t h = std::max(0, std::min(a[1] + a[3], b[1] + b[3]) - std::max(a[1], b[1]) + QDEC_ONE);
+    int64_t inter = w * h;
+    int64_t uni = (int64_t)(a[2] + QDEC_ONE) * (a[3] + QDEC_ONE) + (int64_t)(b[2] + QDEC_ONE) * (b[3] + QDEC_ONE) -
+                  inter;
+    return uni > 0 && (double)inter > (double)threshold * (double)uni;
+}
+
+static int post_process_integer(rknn_app_context_t *app_ctx, rknn_output *outputs, letterbox_t *letter_box,
+                                float nms_threshold, object_detect_result_list *od_results)
+{
+    quant_decode_tables *tables = app_ctx->decode_tables;
+    std::vector<int32_t> &boxes = tables->candidates.boxes;
+    std::vector<uint16_t> &scores = tables->candidates.scores;
+    std::vector<int> &classId = tables->candidates.class_ids;
+    std::vector<int> &order = tables->order;
+    tables->candidates.clear();
+    int validCount;
+
+    {
+        ScopedStageTimer timer(Stage::Decode);
+        if (app_ctx->output_attrs[0].type == RKNN_TENSOR_INT8) {
+            validCount = decode_outputs_q<int8_t>(app_ctx, outputs, tables);
+        } else {
+            validCount = decode_outputs_q<uint8_t>(app_ctx, outputs, tables);
+        }
+    }
+    if (validCount <= 0) {
+        return 0;
+    }
+    Metrics::instance().add(Counter::Candidates, validCount);
+
+    {
+        ScopedStageTimer timer(Stage::Sort);
+        order.resize(validCount);
+        for (int i = 0; i < validCount; i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(),
+                  [&scores](int a, int b) { return scores[a] != scores[b] ? scores[a] > scores[b] : a < b; });
+    }
+
+    {
+        // Greedy NMS within each class
+        ScopedStageTimer timer(Stage::Nms);
+        for (int i = 0; i < validCount; i++) {
+            int n = order[i];
+            if (n == -1) {
+                continue;
+            }
+            for (int j = i + 1; j < validCount; j++) {
+                int m = order[j];
+                if (m != -1 && classId[m] == classId[n] && overlaps_q(&boxes[n * 4], &boxes[m * 4], nms_threshold)) {
+                    order[j] = -1;
+                }
+            }
+        }
+    }
+
+    int model_in_w = app_ctx->model_width;
+    int model_in_h = app_ctx->model_height;
+    int max_detections = app_ctx->max_detections;
+    int dropped = 0;
+    od_results->reserve(max_detections > 0 ? std::min(validCount, max_detections) : validCount);
+
+    for (int i = 0; i < validCount; i++) {
+        int n = order[i];
+        if (n == -1) {
+            continue;
+        }
+        if (max_detections > 0 && od_results->count >= max_detections) {
+            dropped++;
+            continue;
+        }
+        float x1 = boxes[n * 4 + 0] / (float)QDEC_ONE - letter_box->x_pad;
+        float y1 = boxes[n * 4 + 1] / (float)QDEC_ONE - letter_box->y_pad;
+        float x2 = x1 + boxes[n * 4 + 2] / (float)QDEC_ONE;
+        float y2 = y1 + boxes[n * 4 + 3] / (float)QDEC_ONE;
+
+        box_rect_t box;
+        box.left = (int)(clamp(x1, 0, model_in_w) / letter_box->scale);
+        box.top = (int)(clamp(y1, 0, model_in_h) / letter_box->scale);
+        box.right = (int)(clamp(x2, 0, model_in_w) / letter_box->scale);
+        box.bottom = (int)(clamp(y2, 0, model_in_h) / letter_box->scale);
+        od_results->push_back(box, scores[n] / (float)QDEC_SCORE_ONE, classId[n]);
+    }
+    Metrics::instance().add(Counter::Detections, od_results->count);
+    if (dropped > 0) {
+        LOGW("post_process: kept %d detections, dropped %d over max_detections\n", od_results->count, dropped);
+    }
+    return 0;
+}
+
+// End-to-end (NMS-free) heads such as YOLOv10's one-to-one branch already
+// output the model's top-K detections as (x1, y1, x2, y2, score, class) in
+// model input pixels, ranked by score. Decoding them is a threshold and the
+// letterbox mapping; there is nothing to sort or suppress, so the frame time
+// no longer grows with the number of overlapping candidates.
+//
+// Only float outputs are decoded: a quantized output has one zero point and
+// scale for all six fields, so a scale that spans the box coordinates leaves
+// scores and class ids a handful of levels.
+
+static int decode_end2end(const float *input, int count, int box_step, int field_step, int model_in_w,
+                          int model_in_h, letterbox_t *letter_box, float conf_threshold, int max_detections,
+                          object_detect_result_list *od_results)
+{
+    int candidates = 0;
+    int dropped = 0;
+    for (int n = 0; n < count; n++) {
+        size_t base = (size_t)n * box_step;
+        float score = input[base + 4 * field_step];
+        if (score < conf_threshold) {
+            continue;
+        }
+        int id = (int)roundf(input[base + 5 * field_step]);
+        if (id < 0 || id >= OBJ_CLASS_NUM) {
+            continue;
+        }
+        candidates++;
+        if (max_detections > 0 && od_results->count >= max_detections) {
+            dropped++;
+            continue;
+        }
+        float x1 = input[base + 0 * field_step] - letter_box->x_pad;
+        float y1 = input[base + 1 * field_step] - letter_box->y_pad;
+        float x2 = input[base + 2 * field_step] - letter_box->x_pad;
+        float y2 = input[base + 3 * field_step] - letter_box->y_pad;
+
+        box_rect_t box;
+        box.left = (int)(clamp(x1, 0, model_in_w) / letter_box->scale);
+        box.top = (int)(clamp(y1, 0, model_in_h) / letter_box->scale);
+        box.right = (int)(clamp(x2, 0, model_in_w) / letter_box->scale);
+        box.bottom = (int)(clamp(y2, 0, model_in_h) / letter_box->scale);
+        od_results->push_back(box, score, id);
+    }
+    Metrics::instance().add(Counter::Candidates, candidates);
+    if (dropped > 0) {
+        LOGW("post_process: kept %d detections, dropped %d over max_detections\n", od_results->count, dropped);
+    }
+    return 0;
+}
+
+static int post_process_end2end(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box,
+                                float conf_threshold, object_detect_result_list *od_results)
+{
+    const rknn_tensor_attr *attr = &app_ctx->output_attrs[0];
+    int count, box_step, field_step;
+    if (end2end_output_shape(attr, &count, &box_step, &field_step) != 0) {
+        LOGE("post_process: output 0 is not a [1, K, %d] end-to-end output\n", END2END_FIELDS);
+        return -1;
+    }
+    if (app_ctx->is_quant) {
+        LOGE("post_process: quantized end-to-end outputs are not supported, convert the model with a float output\n");
+        return -1;
+    }
+#if defined(RV1106_1103)
+    void *input = ((rknn_tensor_mem **)outputs)[0]->virt_addr;
+#else
+    void *input = ((rknn_output *)outputs)[0].buf;
+#endif
+    int max_detections = app_ctx->max_detections;
+    od_results->reserve(max_detections > 0 ? std::min(count, max_detections) : count);
+
+    int ret;
+    {
+        ScopedStageTimer timer(Stage::Decode);
+        ret = decode_end2end((const float *)input, count, box_step, field_step, app_ctx->model_width,
+                             app_ctx->model_height, letter_box, conf_threshold, max_detections, od_results);
+    }
+    Metrics::instance().add(Counter::Detections, od_results->count);
+    return ret;
+}
 
 // Forward declarations for different processing paths
-static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs, 
+static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs, const decode_band &band,
                                          std::vector<float> &filterBoxes, std::vector<float> &objProbs, 
                                          std::vector<int> &classId, float conf_threshold);
 
-static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs,
+static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs, const decode_band &band,
                                            std::vector<float> &filterBoxes, std::vector<float> &objProbs,
                                            std::vector<int> &classId, float conf_threshold);
 
+// Grid of each output branch, in the order the process_*_outputs() take them
+static void branch_grids(const rknn_app_context_t *app_ctx, int *grid_h, int *grid_w)
+{
+    bool yolov8 = app_ctx->model_type == YOLO_SIMPLIFIED && app_ctx->io_num.n_output == 9;
+    for (int b = 0; b < 3; b++) {
+        const rknn_tensor_attr *attr = &app_ctx->output_attrs[yolov8 ? b * 3 : b];
+#if defined(RV1106_1103)
+        grid_h[b] = attr->dims[1];
+        grid_w[b] = attr->dims[2];
+#else
+        int channels;
+        output_shape(attr, &channels, &grid_h[b], &grid_w[b]);
+#endif
+    }
+}
+
 int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter_box, float conf_threshold, float nms_threshold, object_detect_result_list *od_results)
 {
-    std::vector<float> filterBoxes;
-    std::vector<float> objProbs;
-    std::vector<int> classId;
+    candidate_buffer<float, float> candidates;
+    std::vector<float> &filterBoxes = candidates.boxes;
+    std::vector<float> &objProbs = candidates.scores;
+    std::vector<int> &classId = candidates.class_ids;
+    static thread_local std::vector<decode_band> bands;   // Reused across frames
     int validCount = 0;
     int model_in_w = app_ctx->model_width;
     int model_in_h = app_ctx->model_height;
 
-    memset(od_results, 0, sizeof(object_detect_result_list));
+    od_results->clear();
+
+    if (app_ctx->model_type == YOLO_END2END) {
+        return post_process_end2end(app_ctx, outputs, letter_box, conf_threshold, od_results);
+    }
+
+    if (app_ctx->integer_decode) {
+        if (prepare_decode_tables(app_ctx, conf_threshold) == 0) {
+            return post_process_integer(app_ctx, (rknn_output *)outputs, letter_box, nms_threshold, od_results);
+        }
+        LOGW("post_process: outputs cannot be decoded in the integer domain, using the float decode\n");
+        app_ctx->integer_decode = false;
+    }
+
+    // The float decode reads quantized outputs in the NPU's own type only
+#ifdef RKNPU1
+    if (app_ctx->is_quant && app_ctx->output_attrs[0].type != RKNN_TENSOR_UINT8) {
+        LOGE("post_process: the float decode expects uint8 outputs on RKNPU1\n");
+        return -1;
+    }
+#else
+    if (app_ctx->is_quant && app_ctx->output_attrs[0].type != RKNN_TENSOR_INT8) {
+        LOGE("post_process: the float decode expects int8 outputs, use integer_decode for uint8\n");
+        return -1;
+    }
+#endif
 
     // Dispatch to appropriate processing function based on model type
-    if (app_ctx->model_type == YOLO_SIMPLIFIED) {
-        printf("Processing Simplified YOLO outputs\n");
-        validCount = process_simplified_yolo_outputs(app_ctx, outputs, filterBoxes, objProbs, classId, conf_threshold);
-    } else {
-        printf("Processing Standard YOLO outputs\n");
-        validCount = process_standard_yolo_outputs(app_ctx, outputs, filterBoxes, objProbs, classId, conf_threshold);
+    {
+        ScopedStageTimer timer(Stage::Decode);
+        int grid_h[3], grid_w[3];
+        branch_grids(app_ctx, grid_h, grid_w);
+        auto decode = [&](const decode_band &band, candidate_buffer<float, float> &out) {
+            if (app_ctx->model_type == YOLO_SIMPLIFIED) {
+                return process_simplified_yolo_outputs(app_ctx, outputs, band, out.boxes, out.scores, out.class_ids,
+                                                       conf_threshold);
+            }
+            return process_standard_yolo_outputs(app_ctx, outputs, band, out.boxes, out.scores, out.class_ids,
+                                                 conf_threshold);
+        };
+        validCount = decode_bands(grid_h, grid_w, 3, bands, candidates, decode);
     }
 
     // no object detect
@@ -891,28 +1739,42 @@ int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter
     {
         return 0;
     }
+    Metrics::instance().add(Counter::Candidates, validCount);
+
     std::vector<int> indexArray;
     for (int i = 0; i < validCount; ++i)
     {
         indexArray.push_back(i);
     }
-    quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
-
-    std::set<int> class_set(std::begin(classId), std::end(classId));
+    {
+        ScopedStageTimer timer(Stage::Sort);
+        quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
+    }
 
-    for (auto c : class_set)
     {
-        nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
+        ScopedStageTimer timer(Stage::Nms);
+        std::set<int> class_set(std::begin(classId), std::end(classId));
+
+        for (auto c : class_set)
+        {
+            nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
+        }
     }
 
-    int last_count = 0;
-    od_results->count = 0;
+    int max_detections = app_ctx->max_detections;
+    int dropped = 0;
+    od_results->reserve(max_detections > 0 ? std::min(validCount, max_detections) : validCount);
 
     /* box valid detect target */
     for (int i = 0; i < validCount; ++i)
     {
-        if (indexArray[i] == -1 || last_count >= OBJ_NUMB_MAX_SIZE)
+        if (indexArray[i] == -1)
+        {
+            continue;
+        }
+        if (max_detections > 0 && od_results->count >= max_detections)
         {
+            dropped++;
             continue;
         }
         int n = indexArray[i];
@@ -924,30 +1786,23 @@ int post_process(rknn_app_context_t *app_ctx, void *outputs, letterbox_t *letter
         int id = classId[n];
         float obj_conf = objProbs[i];
 
-        od_results->results[last_count].box.left = (int)(clamp(x1, 0, model_in_w) / letter_box->scale);
-        od_results->results[last_count].box.top = (int)(clamp(y1, 0, model_in_h) / letter_box->scale);
-        od_results->results[last_count].box.right = (int)(clamp(x2, 0, model_in_w) / letter_box->scale);
-        od_results->results[last_count].box.bottom = (int)(clamp(y2, 0, model_in_h) / letter_box->scale);
-        od_results->results[last_count].prop = obj_conf;
-        od_results->results[last_count].cls_id = id;
-        
-        // Set the class name
-        char *class_name = coco_cls_to_name(id);
-        if (class_name) {
-            strncpy(od_results->results[last_count].name, class_name, OBJ_NAME_MAX_SIZE - 1);
-            od_results->results[last_count].name[OBJ_NAME_MAX_SIZE - 1] = '\0';  // Ensure null termination
-        } else {
-            strcpy(od_results->results[last_count].name, "unknown");
-        }
-        
-        last_count++;
+        box_rect_t box;
+        box.left = (int)(clamp(x1, 0, model_in_w) / letter_box->scale);
+        box.top = (int)(clamp(y1, 0, model_in_h) / letter_box->scale);
+        box.right = (int)(clamp(x2, 0, model_in_w) / letter_box->scale);
+        box.bottom = (int)(clamp(y2, 0, model_in_h) / letter_box->scale);
+        od_results->push_back(box, obj_conf, id);
+    }
+    Metrics::instance().add(Counter::Detections, od_results->count);
+    if (dropped > 0)
+    {
+        LOGW("post_process: kept %d detections, dropped %d over max_detections\n", od_results->count, dropped);
     }
-    od_results->count = last_count;
     return 0;
 }
 
 // Standard YOLO processing function (DFL-based implementation)
-static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs, 
+static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs, const decode_band &band,
                                          std::vector<float> &filterBoxes, std::vector<float> &objProbs, 
                                          std::vector<int> &classId, float conf_threshold)
 {
@@ -962,25 +1817,9 @@ static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outp
     int grid_w = 0;
     int model_in_h = app_ctx->model_height;
 
-    // default 3 branch
-#ifdef RKNPU1
-    int dfl_len = app_ctx->output_attrs[0].dims[2] / 4;
-#else
-    int dfl_len = app_ctx->output_attrs[0].dims[1] /4;
-#endif
-    int output_per_branch = app_ctx->io_num.n_output / 3;
-    for (int i = 0; i < 3; i++)
+    int i = band.branch;
     {
 #if defined(RV1106_1103)
-        dfl_len = app_ctx->output_attrs[0].dims[3] /4;
-        void *score_sum = nullptr;
-        int32_t score_sum_zp = 0;
-        float score_sum_scale = 1.0;
-        if (output_per_branch == 3) {
-            score_sum = _outputs[i * output_per_branch + 2]->virt_addr;
-            score_sum_zp = app_ctx->output_attrs[i * output_per_branch + 2].zp;
-            score_sum_scale = app_ctx->output_attrs[i * output_per_branch + 2].scale;
-        }
         grid_h = app_ctx->output_attrs[i].dims[1];
         grid_w = app_ctx->output_attrs[i].dims[2];
         stride = model_in_h / grid_h;
@@ -988,23 +1827,15 @@ static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outp
         if (app_ctx->is_quant) {
             validCount += process_i8_rv1106((int8_t *)_outputs[i]->virt_addr, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale,
                                 nullptr, 0, 0.0, nullptr, 0, 0.0,
-                                grid_h, grid_w, stride, 0, filterBoxes, objProbs, classId, conf_threshold);
+                                grid_h, grid_w, band.row_begin, band.row_end, stride, 0, filterBoxes, objProbs, classId, conf_threshold);
         }
         else
         {
-            printf("RV1106/1103 only support quantization mode\n");
+            LOGE("RV1106/1103 only support quantization mode\n");
             return -1;
         }
 
 #else
-        void *score_sum = nullptr;
-        int32_t score_sum_zp = 0;
-        float score_sum_scale = 1.0;
-        if (output_per_branch == 3){
-            score_sum = _outputs[i*output_per_branch + 2].buf;
-            score_sum_zp = app_ctx->output_attrs[i*output_per_branch + 2].zp;
-            score_sum_scale = app_ctx->output_attrs[i*output_per_branch + 2].scale;
-        }
 #ifdef RKNPU1
         grid_h = app_ctx->output_attrs[i].dims[1];
         grid_w = app_ctx->output_attrs[i].dims[0];
@@ -1019,19 +1850,24 @@ static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outp
 #ifdef RKNPU1
             validCount += process_u8((uint8_t *)_outputs[i].buf, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale,
                                      nullptr, 0, 0.0, nullptr, 0, 0.0,
-                                     grid_h, grid_w, stride, 0,
+                                     grid_h, grid_w, band.row_begin, band.row_end, stride, 0,
                                      filterBoxes, objProbs, classId, conf_threshold);
 #else
+            tensor_layout_t layout;
+            if (output_layout(app_ctx, i, 5 + OBJ_CLASS_NUM, grid_h, grid_w, &layout) != 0) {
+                LOGE("unsupported layout for output %d\n", i);
+                return -1;
+            }
             validCount += process_i8((int8_t *)_outputs[i].buf, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale,
                                      nullptr, 0, 0.0, nullptr, 0, 0.0,
-                                     grid_h, grid_w, stride, 0, 
-                                     filterBoxes, objProbs, classId, conf_threshold);
+                                     grid_h, grid_w, band.row_begin, band.row_end, stride, 0, 
+                                     filterBoxes, objProbs, classId, conf_threshold, layout);
 #endif
         }
         else
         {
             validCount += process_fp32((float *)_outputs[i].buf, nullptr, nullptr,
-                                       grid_h, grid_w, stride, 0, 
+                                       grid_h, grid_w, band.row_begin, band.row_end, stride, 0, 
                                        filterBoxes, objProbs, classId, conf_threshold);
         }
 #endif
@@ -1040,7 +1876,7 @@ static int process_standard_yolo_outputs(rknn_app_context_t *app_ctx, void *outp
 }
 
 // Simplified YOLO processing function (unified tensor implementation)
-static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs,
+static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *outputs, const decode_band &band,
                                            std::vector<float> &filterBoxes, std::vector<float> &objProbs,
                                            std::vector<int> &classId, float conf_threshold)
 {
@@ -1057,8 +1893,9 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
     // Handle different Simplified YOLO structures
     if (n_outputs == 9) {
         // YoloV8 structure: 9 outputs in groups of 3 (box, class, objectness)
-        // Process each scale level (3 scales)
-        for (int scale = 0; scale < 3; scale++) {
+        // One band of one scale level
+        int scale = band.branch;
+        {
             int box_idx = scale * 3 + 0;    // Box regression output
             int cls_idx = scale * 3 + 1;    // Class prediction output  
             int obj_idx = scale * 3 + 2;    // Objectness output
@@ -1075,15 +1912,26 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
 #endif
             int stride = model_in_h / grid_h;
 
+#if !defined(RKNPU1)
+            tensor_layout_t box_layout, cls_layout, obj_layout;
+            if (output_layout(app_ctx, box_idx, 64, grid_h, grid_w, &box_layout) != 0 ||
+                output_layout(app_ctx, cls_idx, OBJ_CLASS_NUM, grid_h, grid_w, &cls_layout) != 0 ||
+                output_layout(app_ctx, obj_idx, 1, grid_h, grid_w, &obj_layout) != 0) {
+                LOGE("unsupported layout for scale %d outputs\n", scale);
+                return -1;
+            }
+#endif
+
 #if defined(RV1106_1103)
             if (app_ctx->is_quant) {
                 validCount += process_yolov8_scale_i8(
                     (int8_t *)_outputs[box_idx]->virt_addr, app_ctx->output_attrs[box_idx].zp, app_ctx->output_attrs[box_idx].scale,
                     (int8_t *)_outputs[cls_idx]->virt_addr, app_ctx->output_attrs[cls_idx].zp, app_ctx->output_attrs[cls_idx].scale,
                     (int8_t *)_outputs[obj_idx]->virt_addr, app_ctx->output_attrs[obj_idx].zp, app_ctx->output_attrs[obj_idx].scale,
-                    grid_h, grid_w, stride, filterBoxes, objProbs, classId, conf_threshold);
+                    grid_h, grid_w, band.row_begin, band.row_end, stride, filterBoxes, objProbs, classId, conf_threshold,
+                    box_layout, cls_layout, obj_layout);
             } else {
-                printf("RV1106/1103 only support quantization mode\n");
+                LOGE("RV1106/1103 only support quantization mode\n");
                 return -1;
             }
 #elif defined(RKNPU1)
@@ -1092,11 +1940,11 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
                     (uint8_t *)_outputs[box_idx].buf, app_ctx->output_attrs[box_idx].zp, app_ctx->output_attrs[box_idx].scale,
                     (uint8_t *)_outputs[cls_idx].buf, app_ctx->output_attrs[cls_idx].zp, app_ctx->output_attrs[cls_idx].scale,
                     (uint8_t *)_outputs[obj_idx].buf, app_ctx->output_attrs[obj_idx].zp, app_ctx->output_attrs[obj_idx].scale,
-                    grid_h, grid_w, stride, filterBoxes, objProbs, classId, conf_threshold);
+                    grid_h, grid_w, band.row_begin, band.row_end, stride, filterBoxes, objProbs, classId, conf_threshold);
             } else {
                 validCount += process_yolov8_scale_fp32(
                     (float *)_outputs[box_idx].buf, (float *)_outputs[cls_idx].buf, (float *)_outputs[obj_idx].buf,
-                    grid_h, grid_w, stride, filterBoxes, objProbs, classId, conf_threshold);
+                    grid_h, grid_w, band.row_begin, band.row_end, stride, filterBoxes, objProbs, classId, conf_threshold);
             }
 #else
             if (app_ctx->is_quant) {
@@ -1104,27 +1952,32 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
                     (int8_t *)_outputs[box_idx].buf, app_ctx->output_attrs[box_idx].zp, app_ctx->output_attrs[box_idx].scale,
                     (int8_t *)_outputs[cls_idx].buf, app_ctx->output_attrs[cls_idx].zp, app_ctx->output_attrs[cls_idx].scale,
                     (int8_t *)_outputs[obj_idx].buf, app_ctx->output_attrs[obj_idx].zp, app_ctx->output_attrs[obj_idx].scale,
-                    grid_h, grid_w, stride, filterBoxes, objProbs, classId, conf_threshold);
+                    grid_h, grid_w, band.row_begin, band.row_end, stride, filterBoxes, objProbs, classId, conf_threshold,
+                    box_layout, cls_layout, obj_layout);
             } else {
                 validCount += process_yolov8_scale_fp32(
                     (float *)_outputs[box_idx].buf, (float *)_outputs[cls_idx].buf, (float *)_outputs[obj_idx].buf,
-                    grid_h, grid_w, stride, filterBoxes, objProbs, classId, conf_threshold);
+                    grid_h, grid_w, band.row_begin, band.row_end, stride, filterBoxes, objProbs, classId, conf_threshold);
             }
 #endif
         }
     } else {
         // Legacy 3-output Simplified YOLO structure (like YOLOX with unified tensors)
-        for (int i = 0; i < 3; i++) {
+        int i = band.branch;
+        {
 #if defined(RV1106_1103)
             int grid_h = app_ctx->output_attrs[i].dims[1];
             int grid_w = app_ctx->output_attrs[i].dims[2];
             int stride = model_in_h / grid_h;
             
             if (app_ctx->is_quant) {
-                validCount += process_simplified_yolo_i8((int8_t *)_outputs[i]->virt_addr, grid_h, grid_w, model_in_h, model_in_w, stride, filterBoxes, objProbs,
-                                                        classId, conf_threshold, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale);
+                tensor_layout_t layout;
+                tensor_layout_init(NULL, 5 + OBJ_CLASS_NUM, grid_h, grid_w, &layout);
+                validCount += process_simplified_yolo_i8((int8_t *)_outputs[i]->virt_addr, grid_h, grid_w, band.row_begin, band.row_end, model_in_h, model_in_w, stride, filterBoxes, objProbs,
+                                                        classId, conf_threshold, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale,
+                                                        layout);
             } else {
-                printf("RV1106/1103 only support quantization mode\n");
+                LOGE("RV1106/1103 only support quantization mode\n");
                 return -1;
             }
 #elif defined(RKNPU1)
@@ -1133,10 +1986,10 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
             int stride = model_in_h / grid_h;
 
             if (app_ctx->is_quant) {
-                validCount += process_simplified_yolo_u8((uint8_t *)_outputs[i].buf, grid_h, grid_w, model_in_h, model_in_w, stride, filterBoxes, objProbs,
+                validCount += process_simplified_yolo_u8((uint8_t *)_outputs[i].buf, grid_h, grid_w, band.row_begin, band.row_end, model_in_h, model_in_w, stride, filterBoxes, objProbs,
                                                         classId, conf_threshold, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale);
             } else {
-                validCount += process_simplified_yolo_fp32((float *)_outputs[i].buf, grid_h, grid_w, model_in_h, model_in_w, stride, filterBoxes, objProbs,
+                validCount += process_simplified_yolo_fp32((float *)_outputs[i].buf, grid_h, grid_w, band.row_begin, band.row_end, model_in_h, model_in_w, stride, filterBoxes, objProbs,
                                                           classId, conf_threshold);
             }
 #else
@@ -1145,10 +1998,16 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
             int stride = model_in_h / grid_h;
 
             if (app_ctx->is_quant) {
-                validCount += process_simplified_yolo_i8((int8_t *)_outputs[i].buf, grid_h, grid_w, model_in_h, model_in_w, stride, filterBoxes, objProbs,
-                                                        classId, conf_threshold, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale);
+                tensor_layout_t layout;
+                if (output_layout(app_ctx, i, 5 + OBJ_CLASS_NUM, grid_h, grid_w, &layout) != 0) {
+                    LOGE("unsupported layout for output %d\n", i);
+                    return -1;
+                }
+                validCount += process_simplified_yolo_i8((int8_t *)_outputs[i].buf, grid_h, grid_w, band.row_begin, band.row_end, model_in_h, model_in_w, stride, filterBoxes, objProbs,
+                                                        classId, conf_threshold, app_ctx->output_attrs[i].zp, app_ctx->output_attrs[i].scale,
+                                                        layout);
             } else {
-                validCount += process_simplified_yolo_fp32((float *)_outputs[i].buf, grid_h, grid_w, model_in_h, model_in_w, stride, filterBoxes, objProbs,
+                validCount += process_simplified_yolo_fp32((float *)_outputs[i].buf, grid_h, grid_w, band.row_begin, band.row_end, model_in_h, model_in_w, stride, filterBoxes, objProbs,
                                                           classId, conf_threshold);
             }
 #endif
@@ -1160,24 +2019,49 @@ static int process_simplified_yolo_outputs(rknn_app_context_t *app_ctx, void *ou
 int init_post_process()
 {
     int ret = 0;
-    printf("Loading labels from: %s\n", LABEL_NALE_TXT_PATH);
+    LOGI("Loading labels from: %s\n", LABEL_NALE_TXT_PATH);
     ret = loadLabelName(LABEL_NALE_TXT_PATH, labels);
     if (ret < 0)
     {
-        printf("Load %s failed!\n", LABEL_NALE_TXT_PATH);
+        LOGE("Load %s failed!\n", LABEL_NALE_TXT_PATH);
         return -1;
     }
-    printf("Successfully loaded %d labels\n", ret);
+    LOGI("Successfully loaded %d labels\n", ret);
     
     // Debug: print first few labels
     for (int i = 0; i < 10 && i < OBJ_CLASS_NUM; i++) {
-        printf("Label %d: %s\n", i, labels[i] ? labels[i] : "NULL");
+        LOGD("Label %d: %s\n", i, labels[i] ? labels[i] : "NULL");
     }
     
     return 0;
 }
 
 static char null_label[] = "null";
+
+object_detect_result_t object_detect_result_list::at(int i) const
+{
+    object_detect_result_t result;
+    result.box = boxes[i];
+    result.prop = props[i];
+    result.cls_id = cls_ids[i];
+    result.name = coco_cls_to_name(cls_ids[i]);
+    return result;
+}
+
+int export_detect_results(const object_detect_result_list *list, object_detect_result_array *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->count = std::min(list->count, OBJ_NUMB_MAX_SIZE);
+    for (int i = 0; i < out->count; i++) {
+        object_detect_result_fixed_t *result = &out->results[i];
+        result->box = list->boxes[i];
+        result->prop = list->props[i];
+        result->cls_id = list->cls_ids[i];
+        snprintf(result->name, sizeof(result->name), "%s", coco_cls_to_name(list->cls_ids[i]));
+    }
+    return out->count;
+}
+
 char *coco_cls_to_name(int cls_id)
 {
     if (cls_id < 0 || cls_id >= OBJ_CLASS_NUM)
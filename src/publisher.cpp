@@ -1,64 +1,233 @@
 #include "publisher.h"
+#include "latency_report.h"
+#include "log.h"
+#include "metrics.h"
 
-#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <thread>
 
+// Serialize detection i of a list as a result object
+static json detectionToJson(const object_detect_result_list& detections, int i) {
+    const object_detect_result_t detection = detections.at(i);
+    json detection_obj;
+
+    // Box coordinates
+    detection_obj["box"] = {
+        {"left", detection.box.left},
+        {"top", detection.box.top}, 
+        {"right", detection.box.right},
+        {"bottom", detection.box.bottom}
+    };
+
+    // Detection properties
+    detection_obj["score"] = detection.prop;
+    detection_obj["class_id"] = detection.cls_id;
+    detection_obj["name"] = detection.name;
+
+    // Tracker state, when a TrackerStage ran on this result
+    if ((int)detections.tracks.size() == detections.count) {
+        const track_info_t& track = detections.tracks[i];
+        detection_obj["track_id"] = track.id;
+        detection_obj["age"] = track.age;
+        detection_obj["dwell"] = track.dwell_s;
+    }
+    return detection_obj;
+}
+
+// Serialize a detection list as {"count": N, "results": [...]}
+json detectionsToJson(const object_detect_result_list& detections, bool suppress_empty) {
+    json detection_results;
+    json results_array = json::array();
+
+    // With suppress_empty, only the detections the shared filter kept
+    if (suppress_empty) {
+        for (int i : detections.aggregates(AGGREGATE_NONEMPTY).nonempty) {
+            results_array.push_back(detectionToJson(detections, i));
+        }
+    } else {
+        for (int i = 0; i < detections.count; ++i) {
+            results_array.push_back(detectionToJson(detections, i));
+        }
+    }
+    
+    // Set the count to the number of valid detections
+    detection_results["count"] = results_array.size();
+    detection_results["results"] = results_array;
+    return detection_results;
+}
+
+// Wall clock milliseconds of a result: its capture time when the producer
+// recorded one, else when it was produced
+static int64_t timestampMs(const InferenceResult& result) {
+    int64_t capture_ms = result.detections.timing.capture_wall_ms;
+    return capture_ms > 0 ? capture_ms : wall_clock_ms(result.timestamp);
+}
+
+// Monotonic nanosecond timestamps of a result, see frame_timing_t
+static json timingToJson(const frame_timing_t& timing) {
+    return {
+        {"capture_ns", timing.capture_ns},
+        {"inference_start_ns", timing.inference_start_ns},
+        {"inference_end_ns", timing.inference_end_ns},
+        {"publish_ns", timing.publish_ns}
+    };
+}
+
+// Indices of the detections a message reports, in message order
+static std::vector<int> reportedDetections(const object_detect_result_list& detections, bool suppress_empty) {
+    if (suppress_empty) {
+        return detections.aggregates(AGGREGATE_NONEMPTY).nonempty;
+    }
+    std::vector<int> indices(detections.count);
+    for (int i = 0; i < detections.count; ++i) {
+        indices[i] = i;
+    }
+    return indices;
+}
+
+// Largest distance any edge moved between two boxes
+static int boxDistance(const box_rect_t& a, const box_rect_t& b) {
+    return std::max(std::max(std::abs(a.left - b.left), std::abs(a.top - b.top)),
+                    std::max(std::abs(a.right - b.right), std::abs(a.bottom - b.bottom)));
+}
+
+// For each reported detection of current, the position among previous'
+// reported detections it continues, or -1 for a new one: the same track id
+// when both results are tracked, else the nearest unclaimed box of the same class
+static std::vector<int> matchDetections(const object_detect_result_list& previous, const std::vector<int>& previous_reported,
+                                        const object_detect_result_list& current, const std::vector<int>& current_reported) {
+    bool tracked = (int)previous.tracks.size() == previous.count && (int)current.tracks.size() == current.count;
+    std::vector<int> match(current_reported.size(), -1);
+    std::vector<bool> claimed(previous_reported.size(), false);
+    for (size_t c = 0; c < current_reported.size(); ++c) {
+        int i = current_reported[c];
+        int best = -1;
+        int best_distance = INT_MAX;
+        for (size_t p = 0; p < previous_reported.size(); ++p) {
+            int j = previous_reported[p];
+            if (claimed[p] || previous.cls_ids[j] != current.cls_ids[i]) {
+                continue;
+            }
+            if (tracked) {
+                if (previous.tracks[j].id == current.tracks[i].id) {
+                    best = p;
+                    break;
+                }
+                continue;
+            }
+            int distance = boxDistance(previous.boxes[j], current.boxes[i]);
+            if (distance < best_distance) {
+                best = p;
+                best_distance = distance;
+            }
+        }
+        if (best >= 0) {
+            match[c] = best;
+            claimed[best] = true;
+        }
+    }
+    return match;
+}
+
+bool MessageFormatter::changed(const InferenceResult& previous, const InferenceResult& current,
+                               const ChangeOptions& options) {
+    return std::abs(current.detections.count - previous.detections.count) > options.count_hysteresis;
+}
+
 // Implementation of the JsonMessageFormatter
 std::string JsonMessageFormatter::formatMessage(const InferenceResult& result) {
     json j;
     
     // Add timestamp
     j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+    j["timestamp_ms"] = timestampMs(result);
+    j["timing"] = timingToJson(result.detections.timing);
     
-    // Serialize the detection results
-    json detection_results;
-    json results_array = json::array();
-    int valid_count = 0;
+    // Set the complete detection results as the main object
+    j["object_detect_result_list"] = detectionsToJson(result.detections, suppress_empty);
     
-    // Filter and serialize only valid detections if suppress_empty is enabled
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        
-        // If suppress_empty is enabled, filter out detections with prop 0 or cls_id 0
-        if (suppress_empty && (detection.prop == 0.0f || detection.cls_id == 0)) {
+    return j.dump();
+}
+
+bool JsonMessageFormatter::changed(const InferenceResult& previous, const InferenceResult& current,
+                                   const ChangeOptions& options) {
+    std::vector<int> previous_reported = reportedDetections(previous.detections, suppress_empty);
+    std::vector<int> current_reported = reportedDetections(current.detections, suppress_empty);
+    std::vector<int> match = matchDetections(previous.detections, previous_reported,
+                                             current.detections, current_reported);
+
+    // Boxes that appeared or disappeared, against count_hysteresis
+    int matched = 0;
+    for (size_t c = 0; c < match.size(); ++c) {
+        if (match[c] < 0) {
             continue;
         }
-        
-        json detection_obj;
-        
-        // Box coordinates
-        detection_obj["box"] = {
-            {"left", detection.box.left},
-            {"top", detection.box.top}, 
-            {"right", detection.box.right},
-            {"bottom", detection.box.bottom}
+        matched++;
+        const box_rect_t& before = previous.detections.boxes[previous_reported[match[c]]];
+        if (boxDistance(before, current.detections.boxes[current_reported[c]]) > options.box_hysteresis_px) {
+            return true;
+        }
+    }
+    int appeared = (int)current_reported.size() - matched;
+    int disappeared = (int)previous_reported.size() - matched;
+    return appeared + disappeared > options.count_hysteresis;
+}
+
+std::string JsonMessageFormatter::formatDelta(const InferenceResult& previous, const InferenceResult& current) {
+    std::vector<int> previous_reported = reportedDetections(previous.detections, suppress_empty);
+    std::vector<int> current_reported = reportedDetections(current.detections, suppress_empty);
+    std::vector<int> match = matchDetections(previous.detections, previous_reported,
+                                             current.detections, current_reported);
+
+    const object_detect_result_list& detections = current.detections;
+    bool tracked = (int)detections.tracks.size() == detections.count;
+    json results_array = json::array();
+    for (size_t c = 0; c < current_reported.size(); ++c) {
+        int i = current_reported[c];
+        if (match[c] < 0) {
+            results_array.push_back(detectionToJson(detections, i));
+            continue;
+        }
+        // Class, name and track id are those of the previous result
+        const box_rect_t& before = previous.detections.boxes[previous_reported[match[c]]];
+        const box_rect_t& box = detections.boxes[i];
+        json delta_obj;
+        delta_obj["prev"] = match[c];
+        delta_obj["box_delta"] = {
+            {"left", box.left - before.left},
+            {"top", box.top - before.top},
+            {"right", box.right - before.right},
+            {"bottom", box.bottom - before.bottom}
         };
-        
-        // Detection properties
-        detection_obj["score"] = detection.prop;
-        detection_obj["class_id"] = detection.cls_id;
-        detection_obj["name"] = std::string(detection.name);  // Convert char array to string
-        
-        results_array.push_back(detection_obj);
-        valid_count++;
+        delta_obj["score"] = detections.props[i];
+        if (tracked) {
+            delta_obj["age"] = detections.tracks[i].age;
+            delta_obj["dwell"] = detections.tracks[i].dwell_s;
+        }
+        results_array.push_back(delta_obj);
     }
-    
-    // Set the count to the number of valid detections
-    detection_results["count"] = valid_count;
-    detection_results["results"] = results_array;
-    
-    // Set the complete detection results as the main object
-    j["object_detect_result_list"] = detection_results;
-    
+
+    json j;
+    j["timestamp"] = std::chrono::system_clock::to_time_t(current.timestamp);
+    j["timestamp_ms"] = timestampMs(current);
+    j["timing"] = timingToJson(current.detections.timing);
+    j["delta"] = true;
+    j["object_detect_result_list"] = {
+        {"count", results_array.size()},
+        {"results", results_array}
+    };
     return j.dump();
 }
 
 // Implementation of the BSVariableMessageFormatter
 std::string BSVariableMessageFormatter::formatMessage(const InferenceResult& result) {
-    // format the message as a string like detection_count:2!!timestamp:1746732409
+    // format the message as a string like detection_count:2!!timestamp:1746732409!!timestamp_ms:1746732409123
     std::string message = 
         "detection_count:" + std::to_string(result.detections.count) + "!!" +
-        "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
+        "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp)) + "!!" +
+        "timestamp_ms:" + std::to_string(timestampMs(result));
     return message;
 }
 
@@ -66,42 +235,53 @@ std::string BSVariableMessageFormatter::formatMessage(const InferenceResult& res
 std::string FacesJsonMessageFormatter::formatMessage(const InferenceResult& result) {
     json j;
     
-    // Count people (class_id == 0)
-    int people_count = 0;
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        if (detection.cls_id == 0) { // "person" class
-            people_count++;
-        }
-    }
+    // People (class_id == 0) in frame, and how many of them are attending.
+    // With tracking, only confirmed tracks count as attending so the value
+    // does not flicker with single-frame detections; otherwise it equals the total.
+    const DetectionAggregates& people = result.detections.aggregates(aggregatesNeeded());
     
-    // Map people count to faces properties (doubling up as requested)
-    j["faces_in_frame_total"] = people_count;
-    j["faces_attending"] = people_count;
+    // Map people counts to faces properties
+    j["faces_in_frame_total"] = people.people_in_frame;
+    j["faces_attending"] = people.people_attending;
+    j["faces_dwell_max"] = people.people_max_dwell_s;
     j["timestamp"] = std::chrono::system_clock::to_time_t(result.timestamp);
+    j["timestamp_ms"] = timestampMs(result);
     
     return j.dump();
 }
 
+// Changed when people in frame or attending move by more than count_hysteresis
+static bool peopleChanged(const InferenceResult& previous, const InferenceResult& current,
+                          const ChangeOptions& options) {
+    const DetectionAggregates& before = previous.detections.aggregates(AGGREGATE_PEOPLE);
+    const DetectionAggregates& now = current.detections.aggregates(AGGREGATE_PEOPLE);
+    return std::abs(now.people_in_frame - before.people_in_frame) > options.count_hysteresis ||
+           std::abs(now.people_attending - before.people_attending) > options.count_hysteresis;
+}
+
+bool FacesJsonMessageFormatter::changed(const InferenceResult& previous, const InferenceResult& current,
+                                        const ChangeOptions& options) {
+    return peopleChanged(previous, current, options);
+}
+
 // Implementation of the FacesBSMessageFormatter  
 std::string FacesBSMessageFormatter::formatMessage(const InferenceResult& result) {
-    // Count people (class_id == 0)
-    int people_count = 0;
-    for (int i = 0; i < result.detections.count; ++i) {
-        const auto& detection = result.detections.results[i];
-        if (detection.cls_id == 0) { // "person" class
-            people_count++;
-        }
-    }
+    const DetectionAggregates& people = result.detections.aggregates(aggregatesNeeded());
     
-    // Map people count to faces properties in BrightScript format
+    // Map people counts to faces properties in BrightScript format
     std::string message = 
-        "faces_in_frame_total:" + std::to_string(people_count) + "!!" +
-        "faces_attending:" + std::to_string(people_count) + "!!" +
-        "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp));
+        "faces_in_frame_total:" + std::to_string(people.people_in_frame) + "!!" +
+        "faces_attending:" + std::to_string(people.people_attending) + "!!" +
+        "timestamp:" + std::to_string(std::chrono::system_clock::to_time_t(result.timestamp)) + "!!" +
+        "timestamp_ms:" + std::to_string(timestampMs(result));
     return message;
 }
 
+bool FacesBSMessageFormatter::changed(const InferenceResult& previous, const InferenceResult& current,
+                                      const ChangeOptions& options) {
+    return peopleChanged(previous, current, options);
+}
+
 // Generic Publisher implementation
 Publisher::Publisher(
         std::shared_ptr<Transport> transport,
@@ -110,30 +290,101 @@ Publisher::Publisher(
         std::shared_ptr<MessageFormatter> formatter,
         int messages_per_second)
     : transport(transport),
-      resultQueue(queue), 
+      nextResult([&queue](InferenceResult& result) { return queue.pop(result); }),
       running(isRunning), 
       target_mps(messages_per_second),
       formatter(formatter) {
 }
 
+Publisher::Publisher(
+        std::shared_ptr<Transport> transport,
+        ResultBroadcast& broadcast,
+        std::atomic<bool>& isRunning,
+        std::shared_ptr<MessageFormatter> formatter,
+        int messages_per_second)
+    : transport(transport),
+      running(isRunning),
+      target_mps(messages_per_second),
+      formatter(formatter) {
+    int subscriber = broadcast.subscribe(formatter->aggregatesNeeded());
+    nextResult = [&broadcast, subscriber](InferenceResult& result) { return broadcast.take(subscriber, result); };
+}
+
 void Publisher::operator()() {
     InferenceResult result;
-    while (resultQueue.pop(result)) {
+    int sent = 0;
+
+    // Change-only state: the last result sent and when the last keyframe went out
+    InferenceResult last_sent;
+    bool have_last_sent = false;
+    std::chrono::steady_clock::time_point last_keyframe;
+
+    while (nextResult(result)) {
         if (!transport->isConnected()) {
-            std::cerr << "Transport not connected, skipping message" << std::endl;
+            LOGW("Transport not connected, skipping message\n");
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        bool keyframe = !have_last_sent ||
+                        (change.keyframe_interval_ms > 0 &&
+                         now - last_keyframe >= std::chrono::milliseconds(change.keyframe_interval_ms));
+        if (change.enabled && !keyframe && !formatter->changed(last_sent, result, change)) {
+            // Nothing to say; check the next frame without waiting out the rate limit
+            Metrics::instance().add(Counter::MessagesSuppressed);
             continue;
         }
         
-        std::string message = formatter->formatMessage(result);
+        result.detections.timing.publish_ns = monotonic_ns();
+        std::string message;
+        {
+            ScopedStageTimer timer(Stage::Format);
+            if (change.enabled && change.box_deltas && !keyframe) {
+                message = formatter->formatDelta(last_sent, result);
+            } else {
+                message = formatter->formatMessage(result);
+            }
+        }
         
-        if (!transport->send(message)) {
-            std::cerr << "Failed to send message via transport" << std::endl;
+        bool sent_ok;
+        {
+            ScopedStageTimer timer(Stage::Send);
+            sent_ok = transport->send(message);
+        }
+        if (!sent_ok) {
+            LOGW("Failed to send message via transport\n");
+        } else {
+            Metrics::instance().add(Counter::MessagesSent);
+        }
+        // A message the receiver never got is not a baseline for changes or deltas
+        if (change.enabled && sent_ok) {
+            last_sent = result;
+            have_last_sent = true;
+            if (keyframe) {
+                last_keyframe = now;
+            }
+        }
+
+        if (message_limit > 0 && ++sent >= message_limit) {
+            break;
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / target_mps));
+        // Rate limit, but wake immediately on stop()
+        std::unique_lock<std::mutex> lock(stop_mutex);
+        if (stop_cv.wait_for(lock, std::chrono::milliseconds(1000 / target_mps), [this] { return stopping; })) {
+            break;
+        }
     }
 }
 
+void Publisher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex);
+        stopping = true;
+    }
+    stop_cv.notify_all();
+}
+
 // UDPPublisher backward compatibility wrapper
 UDPPublisher::UDPPublisher(
         const std::string& ip,
@@ -143,4 +394,14 @@ UDPPublisher::UDPPublisher(
         std::shared_ptr<MessageFormatter> formatter,
         int messages_per_second)
     : Publisher(std::make_shared<UDPTransport>(ip, port), queue, isRunning, formatter, messages_per_second) {
+}
+
+UDPPublisher::UDPPublisher(
+        const std::string& ip,
+        const int port,
+        ResultBroadcast& broadcast,
+        std::atomic<bool>& isRunning,
+        std::shared_ptr<MessageFormatter> formatter,
+        int messages_per_second)
+    : Publisher(std::make_shared<UDPTransport>(ip, port), broadcast, isRunning, formatter, messages_per_second) {
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <string.h>
+#include <thread>
+
+#include "image_utils.h"
+#include "latency_report.h"
+#include "log.h"
+#include "metrics.h"
+#include "postprocess.h"
+#include "yolo.h"
+
+bool isVideoFile(const std::string& path) {
+    static const char* extensions[] = {".mp4", ".mkv", ".avi", ".mov", ".webm", ".h264", ".h265", ".ts"};
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string ext = path.substr(dot);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return tolower(c); });
+    for (const char* candidate : extensions) {
+        if (ext == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RecordedVideoSource::RecordedVideoSource(const std::string& path, const ReplayOptions& options)
+    : capture(path), options(options) {
+    double fps = capture.isOpened() ? capture.get(cv::CAP_PROP_FPS) : 0.0;
+    if (fps <= 0.0 || fps > 240.0) {
+        fps = 30.0;
+    }
+    frame_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / fps));
+}
+
+bool RecordedVideoSource::grab() {
+    if (capture.grab()) {
+        return true;
+    }
+    if (!options.loop) {
+        return false;
+    }
+    capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+    return capture.grab();
+}
+
+bool RecordedVideoSource::read(cv::Mat& frame) {
+    if (options.realtime) {
+        auto now = std::chrono::steady_clock::now();
+        if (!started) {
+            next_due = now;
+            started = true;
+        }
+        // A consumer slower than the frame rate misses frames, as with a camera
+        while (now >= next_due + frame_interval) {
+            if (!grab()) {
+                return false;
+            }
+            skipped++;
+            Metrics::instance().add(Counter::DroppedFrames);
+            next_due += frame_interval;
+        }
+        std::this_thread::sleep_until(next_due);
+        next_due += frame_interval;
+    }
+    return grab() && capture.retrieve(frame) && !frame.empty();
+}
+
+ReplayInferenceThread::ReplayInferenceThread(
+        const std::string& model_path,
+        const std::string& video_path,
+        ThreadSafeQueue<InferenceResult>& outputQueue,
+        std::atomic<bool>& isRunning,
+        const ReplayOptions& options,
+        std::shared_ptr<AsyncFrameWriter> frameWriter,
+        std::function<void()> onFinished)
+    : model_path(model_path),
+      video_path(video_path),
+      outputQueue(outputQueue),
+      running(isRunning),
+      options(options),
+      frameWriter(frameWriter),
+      onFinished(onFinished) {
+}
+
+void ReplayInferenceThread::operator()() {
+    RecordedVideoSource source(video_path, options);
+    rknn_app_context_t app_ctx;
+    memset(&app_ctx, 0, sizeof(app_ctx));
+
+    if (!source.isOpened()) {
+        LOGE("Replay: cannot open video %s\n", video_path.c_str());
+    } else if (init_yolo_model(model_path.c_str(), &app_ctx) != 0) {
+        LOGE("Replay: init_yolo_model fail! model_path=%s\n", model_path.c_str());
+    } else {
+        init_post_process();
+        LOGI("Replay: %s (%s, %s)\n", video_path.c_str(),
+             options.realtime ? "real time" : "as fast as possible", options.loop ? "looping" : "once");
+
+        // Capture start to result queued, and time blocked on the output queue
+        LatencyHistogram frame_latency;
+        LatencyHistogram queue_wait;
+        uint64_t frames = 0;
+        uint64_t failed = 0;
+        auto replay_start = std::chrono::steady_clock::now();
+
+        cv::Mat bgr;
+        cv::Mat rgb;
+        while (running && (options.max_frames <= 0 || frames < (uint64_t)options.max_frames)) {
+            auto frame_start = std::chrono::steady_clock::now();
+            int64_t capture_wall_ms = wall_clock_ms();
+            {
+                ScopedStageTimer timer(Stage::Capture);
+                if (!source.read(bgr)) {
+                    break;
+                }
+                cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+            }
+
+            image_buffer_t src_image;
+            memset(&src_image, 0, sizeof(src_image));
+            src_image.width = rgb.cols;
+            src_image.height = rgb.rows;
+            src_image.format = IMAGE_FORMAT_RGB888;
+            src_image.virt_addr = rgb.data;
+            src_image.size = rgb.cols * rgb.rows * 3;
+
+            InferenceResult result;
+            int64_t inference_start = monotonic_ns();
+            if (inference_yolo_model(&app_ctx, &src_image, &result.detections) < 0) {
+                failed++;
+                continue;
+            }
+            result.timestamp = std::chrono::system_clock::now();
+            frame_timing_t& timing = result.detections.timing;
+            timing.capture_ns = monotonic_ns(frame_start);
+            timing.inference_start_ns = inference_start;
+            timing.inference_end_ns = monotonic_ns();
+            timing.capture_wall_ms = capture_wall_ms;
+            if (frameWriter) {
+                frameWriter->writeFrame(bgr, result.detections);
+            }
+
+            auto push_start = std::chrono::steady_clock::now();
+            outputQueue.push(std::move(result));
+            auto done = std::chrono::steady_clock::now();
+            queue_wait.record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - push_start).count());
+            frame_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - frame_start).count());
+            frames++;
+        }
+
+        double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+        const LatencyHistogram& npu = Metrics::instance().histogram(Stage::Run);
+        LOGI("Replay: %llu frames (%llu failed, %llu skipped by the source) in %.2f s, %.1f fps\n",
+             (unsigned long long)frames, (unsigned long long)failed, (unsigned long long)source.skippedFrames(),
+             elapsed_s, elapsed_s > 0 ? frames / elapsed_s : 0.0);
+        LOGI("Replay: frame latency p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+             frame_latency.percentile(0.50) / 1e6, frame_latency.percentile(0.90) / 1e6,
+             frame_latency.percentile(0.99) / 1e6, frame_latency.max() / 1e6);
+        LOGI("Replay: npu run p50 %.1f ms, p99 %.1f ms; output queue wait p99 %.2f ms, max %.2f ms\n",
+             npu.percentile(0.50) / 1e6, npu.percentile(0.99) / 1e6,
+             queue_wait.percentile(0.99) / 1e6, queue_wait.max() / 1e6);
+        if (frameWriter) {
+            LOGI("Replay: preview frames written %llu, dropped %llu\n",
+                 (unsigned long long)frameWriter->writtenFrames(), (unsigned long long)frameWriter->droppedFrames());
+        }
+
+        deinit_post_process();
+        release_yolo_model(&app_ctx);
+    }
+
+    if (onFinished) {
+        onFinished();
+    }
+}
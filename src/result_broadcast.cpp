@@ -0,0 +1,61 @@
+#include "result_broadcast.h"
+
+#include "latency_report.h"
+
+int ResultBroadcast::subscribe(unsigned aggregates) {
+    std::lock_guard<std::mutex> lock(mutex);
+    aggregates_needed |= aggregates;
+    slots.emplace_back();
+    return (int)slots.size() - 1;
+}
+
+void ResultBroadcast::publish(const InferenceResult& result) {
+    unsigned needed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        needed = aggregates_needed;
+    }
+    if (needed) {
+        result.detections.aggregates(needed);   // Cached on result, shared by the copies below
+    }
+
+    // Once per result however many sinks, each with its own rate and changes, send it
+    frame_timing_t timing = result.detections.timing;
+    timing.publish_ns = monotonic_ns();
+    LatencyReport::instance().record(timing);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Slot& slot : slots) {
+            slot.result = result;
+            slot.full = true;
+        }
+    }
+    ready.notify_all();
+}
+
+void ResultBroadcast::pump(ThreadSafeQueue<InferenceResult>& queue) {
+    InferenceResult result;
+    while (queue.pop(result)) {
+        publish(result);
+    }
+}
+
+bool ResultBroadcast::take(int subscriber, InferenceResult& result) {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [&] { return shutdown || slots[subscriber].full; });
+    if (shutdown) {
+        return false;
+    }
+    Slot& slot = slots[subscriber];
+    result = std::move(slot.result);
+    slot.full = false;
+    return true;
+}
+
+void ResultBroadcast::signalShutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutdown = true;
+    }
+    ready.notify_all();
+}
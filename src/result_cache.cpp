@@ -0,0 +1,283 @@
+#include "result_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "log.h"
+#include "metrics.h"
+
+#define RESULT_CACHE_MAGIC "BSRCACHE"
+#define RESULT_CACHE_VERSION 1
+
+struct ResultCache::IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t slots;
+    uint64_t config_id;
+};
+
+struct IndexBox {
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+    float prop;
+    int32_t cls_id;
+};
+
+// key is written last, so a slot torn by a crash mid-write reads as empty
+struct ResultCache::IndexSlot {
+    uint64_t key;
+    uint32_t count;
+    uint32_t reserved;
+    IndexBox boxes[RESULT_CACHE_SLOT_BOXES];
+};
+
+ResultCache::ResultCache(const ResultCacheOptions& options, uint64_t config_id)
+    : options(options), config_id(config_id) {
+    if (!options.index_path.empty()) {
+        openIndex();
+    }
+}
+
+ResultCache::~ResultCache() {
+    if (index) {
+        munmap(index, index_size);
+    }
+}
+
+void ResultCache::openIndex() {
+    int slots = options.index_slots > 0 ? options.index_slots : 1;
+    size_t size = sizeof(IndexHeader) + (size_t)slots * sizeof(IndexSlot);
+    int fd = open(options.index_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOGW("Result cache: cannot open %s: %s, keeping results in memory only\n", options.index_path.c_str(),
+             strerror(errno));
+        return;
+    }
+    struct stat st;
+    bool fresh = fstat(fd, &st) != 0 || (size_t)st.st_size != size;
+    if (fresh && ftruncate(fd, size) != 0) {
+        LOGW("Result cache: cannot size %s: %s\n", options.index_path.c_str(), strerror(errno));
+        close(fd);
+        return;
+    }
+    void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        LOGW("Result cache: cannot map %s: %s\n", options.index_path.c_str(), strerror(errno));
+        return;
+    }
+    index = mapped;
+    index_size = size;
+
+    // An index from another model or configuration holds nothing usable
+    IndexHeader* header = (IndexHeader*)index;
+    if (fresh || memcmp(header->magic, RESULT_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != RESULT_CACHE_VERSION || header->slots != (uint32_t)slots ||
+        header->config_id != config_id) {
+        memset(index, 0, size);
+        memcpy(header->magic, RESULT_CACHE_MAGIC, sizeof(header->magic));
+        header->version = RESULT_CACHE_VERSION;
+        header->slots = slots;
+        header->config_id = config_id;
+        LOGI("Result cache: new index %s (%d slots)\n", options.index_path.c_str(), slots);
+    } else {
+        LOGI("Result cache: reusing index %s (%d slots)\n", options.index_path.c_str(), slots);
+    }
+}
+
+uint64_t ResultCache::key(uint64_t content_hash) const {
+    uint64_t k = hash64(&content_hash, sizeof(content_hash), config_id);
+    return k ? k : 1;   // 0 marks an empty index slot
+}
+
+ResultCache::IndexSlot* ResultCache::slot(uint64_t key) const {
+    IndexHeader* header = (IndexHeader*)index;
+    IndexSlot* slots = (IndexSlot*)((uint8_t*)index + sizeof(IndexHeader));
+    return &slots[key % header->slots];
+}
+
+bool ResultCache::readSlot(uint64_t key, object_detect_result_list* results) const {
+    const IndexSlot* s = slot(key);
+    if (s->key != key || s->count > RESULT_CACHE_SLOT_BOXES) {
+        return false;
+    }
+    results->clear();
+    results->reserve(s->count);
+    for (uint32_t i = 0; i < s->count; i++) {
+        const IndexBox& b = s->boxes[i];
+        box_rect_t box = {b.left, b.top, b.right, b.bottom};
+        results->push_back(box, b.prop, b.cls_id);
+    }
+    return true;
+}
+
+void ResultCache::writeSlot(uint64_t key, const object_detect_result_list& results) {
+    if (results.count > RESULT_CACHE_SLOT_BOXES) {
+        return;
+    }
+    IndexSlot* s = slot(key);
+    s->key = 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s->count = results.count;
+    for (int i = 0; i < results.count; i++) {
+        const box_rect_t& box = results.boxes[i];
+        s->boxes[i] = {box.left, box.top, box.right, box.bottom, results.props[i], results.cls_ids[i]};
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    s->key = key;
+}
+
+void ResultCache::remember(uint64_t key, const object_detect_result_list& results) {
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        found->second->second = results;
+        lru.splice(lru.begin(), lru, found->second);
+        return;
+    }
+    lru.emplace_front(key, results);
+    lru.front().second.tracks.clear();
+    lru.front().second.timing = {};
+    entries[key] = lru.begin();
+    while (lru.size() > options.capacity) {
+        entries.erase(lru.back().first);
+        lru.pop_back();
+    }
+}
+
+bool ResultCache::lookup(uint64_t content_hash, object_detect_result_list* results) {
+    if (options.capacity == 0) {
+        return false;
+    }
+    uint64_t k = key(content_hash);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = entries.find(k);
+    if (found != entries.end()) {
+        lru.splice(lru.begin(), lru, found->second);
+        *results = found->second->second;
+    } else if (!index || !readSlot(k, results)) {
+        miss_count++;
+        Metrics::instance().add(Counter::CacheMisses);
+        return false;
+    } else {
+        remember(k, *results);
+    }
+    hit_count++;
+    Metrics::instance().add(Counter::CacheHits);
+    return true;
+}
+
+void ResultCache::insert(uint64_t content_hash, const object_detect_result_list& results) {
+    if (options.capacity == 0) {
+        return;
+    }
+    uint64_t k = key(content_hash);
+    std::lock_guard<std::mutex> lock(mutex);
+    remember(k, results);
+    if (index) {
+        writeSlot(k, results);
+    }
+}
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t hash64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = xxh64_round(v1, read64(p));
+            v2 = xxh64_round(v2, read64(p + 8));
+            v3 = xxh64_round(v3, read64(p + 16));
+            v4 = xxh64_round(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += size;
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxh64_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hash_file(const std::string& path, uint64_t seed) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    std::vector<uint8_t> data(size > 0 ? size : 0);
+    size_t got = fread(data.data(), 1, data.size(), fp);
+    fclose(fp);
+    return got == data.size() ? hash64(data.data(), data.size(), seed) : 0;
+}
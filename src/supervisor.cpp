@@ -0,0 +1,92 @@
+#include "supervisor.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include "log.h"
+
+Supervisor::Supervisor() {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+
+    // Block the signals so they are only delivered through the signalfd
+    if (pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) {
+        LOGE("Supervisor: failed to block signals\n");
+        return;
+    }
+
+    signal_fd = signalfd(-1, &mask, SFD_CLOEXEC | SFD_NONBLOCK);
+    event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int fd = epoll_create1(EPOLL_CLOEXEC);
+    if (signal_fd < 0 || event_fd < 0 || fd < 0) {
+        LOGE("Supervisor: setup failed: %s\n", strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = signal_fd;
+    epoll_ctl(fd, EPOLL_CTL_ADD, signal_fd, &ev);
+    ev.data.fd = event_fd;
+    epoll_ctl(fd, EPOLL_CTL_ADD, event_fd, &ev);
+    epoll_fd = fd;
+}
+
+Supervisor::~Supervisor() {
+    if (epoll_fd >= 0) close(epoll_fd);
+    if (event_fd >= 0) close(event_fd);
+    if (signal_fd >= 0) close(signal_fd);
+}
+
+void Supervisor::notify() {
+    uint64_t one = 1;
+    if (event_fd >= 0 && write(event_fd, &one, sizeof(one)) < 0) {
+        LOGE("Supervisor: notify failed: %s\n", strerror(errno));
+    }
+}
+
+int Supervisor::wait(int timeout_ms) {
+    if (!isValid()) {
+        return -1;
+    }
+
+    while (true) {
+        struct epoll_event ev;
+        int n = epoll_wait(epoll_fd, &ev, 1, timeout_ms);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            return -1;  // timeout
+        }
+
+        if (ev.data.fd == signal_fd) {
+            struct signalfd_siginfo info;
+            if (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+                return (int)info.ssi_signo;
+            }
+        } else if (ev.data.fd == event_fd) {
+            uint64_t count;
+            if (read(event_fd, &count, sizeof(count)) == sizeof(count)) {
+                return 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#include "tensor_file.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+static const char TENSOR_FILE_MAGIC[8] = {'R', 'K', 'N', 'N', 'O', 'U', 'T', '1'};
+
+static bool write_i32(FILE *fp, int32_t v) { return fwrite(&v, sizeof(v), 1, fp) == 1; }
+static bool read_i32(FILE *fp, int32_t *v) { return fread(v, sizeof(*v), 1, fp) == 1; }
+
+int save_output_tensors(const char *path, const rknn_app_context_t *app_ctx, const rknn_output *outputs)
+{
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        LOGE("save_output_tensors: cannot open %s\n", path);
+        return -1;
+    }
+
+    bool ok = fwrite(TENSOR_FILE_MAGIC, sizeof(TENSOR_FILE_MAGIC), 1, fp) == 1 &&
+              write_i32(fp, app_ctx->io_num.n_output) &&
+              write_i32(fp, app_ctx->model_width) &&
+              write_i32(fp, app_ctx->model_height) &&
+              write_i32(fp, app_ctx->model_type) &&
+              write_i32(fp, app_ctx->is_quant);
+
+    for (uint32_t i = 0; ok && i < app_ctx->io_num.n_output; i++) {
+        const rknn_tensor_attr *attr = &app_ctx->output_attrs[i];
+        ok = write_i32(fp, attr->n_dims);
+        for (int d = 0; ok && d < 4; d++) {
+            ok = write_i32(fp, attr->dims[d]);
+        }
+        float scale = attr->scale;
+        ok = ok && write_i32(fp, attr->fmt) &&
+             write_i32(fp, app_ctx->is_quant ? attr->type : RKNN_TENSOR_FLOAT32) &&
+             write_i32(fp, attr->qnt_type) &&
+             write_i32(fp, attr->zp) &&
+             fwrite(&scale, sizeof(scale), 1, fp) == 1 &&
+             write_i32(fp, outputs[i].size) &&
+             fwrite(outputs[i].buf, 1, outputs[i].size, fp) == outputs[i].size;
+    }
+
+    fclose(fp);
+    if (!ok) {
+        LOGE("save_output_tensors: write to %s failed\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int load_output_tensors(const char *path, recorded_outputs_t *recorded)
+{
+    memset(recorded, 0, sizeof(*recorded));
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        LOGE("load_output_tensors: cannot open %s\n", path);
+        return -1;
+    }
+
+    char magic[8];
+    int32_t n_output = 0, model_type = 0, is_quant = 0;
+    bool ok = fread(magic, sizeof(magic), 1, fp) == 1 &&
+              memcmp(magic, TENSOR_FILE_MAGIC, sizeof(magic)) == 0 &&
+              read_i32(fp, &n_output) &&
+              read_i32(fp, &recorded->model_width) &&
+              read_i32(fp, &recorded->model_height) &&
+              read_i32(fp, &model_type) &&
+              read_i32(fp, &is_quant) &&
+              n_output > 0 && n_output <= 16;
+
+    if (ok) {
+        recorded->model_type = (yolo_model_type_t)model_type;
+        recorded->is_quant = is_quant != 0;
+        recorded->io_num.n_input = 1;
+        recorded->io_num.n_output = n_output;
+        recorded->output_attrs = (rknn_tensor_attr *)calloc(n_output, sizeof(rknn_tensor_attr));
+        recorded->buffers = (void **)calloc(n_output, sizeof(void *));
+    }
+
+    for (int i = 0; ok && i < n_output; i++) {
+        rknn_tensor_attr *attr = &recorded->output_attrs[i];
+        int32_t v[10];
+        float scale = 0;
+        for (int k = 0; ok && k < 5; k++) {
+            ok = read_i32(fp, &v[k]);
+        }
+        ok = ok && read_i32(fp, &v[5]) && read_i32(fp, &v[6]) && read_i32(fp, &v[7]) && read_i32(fp, &v[8]) &&
+             fread(&scale, sizeof(scale), 1, fp) == 1 && read_i32(fp, &v[9]) && v[9] > 0;
+        if (!ok) {
+            break;
+        }
+        attr->index = i;
+        attr->n_dims = v[0];
+        attr->n_elems = 1;
+        for (int d = 0; d < 4; d++) {
+            attr->dims[d] = v[1 + d];
+            attr->n_elems *= v[1 + d] > 0 ? v[1 + d] : 1;
+        }
+        attr->fmt = (rknn_tensor_format)v[5];
+        attr->type = (rknn_tensor_type)v[6];
+        attr->qnt_type = (rknn_tensor_qnt_type)v[7];
+        attr->zp = v[8];
+        attr->scale = scale;
+        attr->size = v[9];
+        recorded->buffers[i] = malloc(attr->size);
+        ok = recorded->buffers[i] != NULL && fread(recorded->buffers[i], 1, attr->size, fp) == attr->size;
+    }
+
+    fclose(fp);
+    if (!ok) {
+        LOGE("load_output_tensors: %s is not a valid recording\n", path);
+        release_output_tensors(recorded);
+        return -1;
+    }
+    return 0;
+}
+
+void release_output_tensors(recorded_outputs_t *recorded)
+{
+    if (recorded->buffers != NULL) {
+        for (uint32_t i = 0; i < recorded->io_num.n_output; i++) {
+            free(recorded->buffers[i]);
+        }
+        free(recorded->buffers);
+    }
+    free(recorded->output_attrs);
+    memset(recorded, 0, sizeof(*recorded));
+}
+
+void recorded_outputs_to_context(const recorded_outputs_t *recorded, rknn_app_context_t *app_ctx, rknn_output *outputs)
+{
+    memset(app_ctx, 0, sizeof(*app_ctx));
+    app_ctx->io_num = recorded->io_num;
+    app_ctx->output_attrs = recorded->output_attrs;
+    app_ctx->model_width = recorded->model_width;
+    app_ctx->model_height = recorded->model_height;
+    app_ctx->model_channel = 3;
+    app_ctx->is_quant = recorded->is_quant;
+    app_ctx->model_type = recorded->model_type;
+    app_ctx->max_detections = OBJ_NUMB_MAX_SIZE;
+
+    for (uint32_t i = 0; i < recorded->io_num.n_output; i++) {
+        memset(&outputs[i], 0, sizeof(outputs[i]));
+        outputs[i].index = i;
+        outputs[i].want_float = !recorded->is_quant;
+        outputs[i].buf = recorded->buffers[i];
+        outputs[i].size = recorded->output_attrs[i].size;
+    }
+}
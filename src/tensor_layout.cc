@@ -0,0 +1,205 @@
+#include "tensor_layout.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static size_t type_size(rknn_tensor_type type)
+{
+    switch (type) {
+    case RKNN_TENSOR_INT8:
+    case RKNN_TENSOR_UINT8:
+        return 1;
+    case RKNN_TENSOR_FLOAT16:
+    case RKNN_TENSOR_INT16:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+// Elements in the layout's buffer, padding included
+static size_t layout_elems(const tensor_layout_t *layout)
+{
+    size_t cells = (size_t)layout->grid_h * layout->grid_w;
+    switch (layout->fmt) {
+    case RKNN_TENSOR_NHWC:
+        return cells * layout->cell_step;
+    case RKNN_TENSOR_NC1HWC2: {
+        int c1 = (layout->channels + layout->cell_step - 1) / layout->cell_step;
+        return (size_t)c1 * cells * layout->cell_step;
+    }
+    default:
+        return cells * layout->channels;
+    }
+}
+
+void output_shape(const rknn_tensor_attr *attr, int *channels, int *grid_h, int *grid_w)
+{
+#ifdef RKNPU1
+    *channels = attr->dims[2];
+    *grid_h = attr->dims[1];
+    *grid_w = attr->dims[0];
+#else
+    *channels = attr->dims[1];
+    *grid_h = attr->dims[2];
+    *grid_w = attr->dims[3];
+#endif
+}
+
+int end2end_output_shape(const rknn_tensor_attr *attr, int *count, int *box_step, int *field_step)
+{
+    // Non-unit dims, outermost first
+    int dims[2];
+    int n = 0;
+    for (uint32_t d = 0; d < attr->n_dims; d++) {
+#ifdef RKNPU1
+        int size = attr->dims[attr->n_dims - 1 - d];
+#else
+        int size = attr->dims[d];
+#endif
+        if (size == 1) {
+            continue;
+        }
+        if (n == 2) {
+            return -1;
+        }
+        dims[n++] = size;
+    }
+    if (n != 2) {
+        return -1;
+    }
+    if (dims[1] == END2END_FIELDS) {
+        *count = dims[0];
+        *box_step = END2END_FIELDS;
+        *field_step = 1;
+        return 0;
+    }
+    if (dims[0] == END2END_FIELDS) {
+        *count = dims[1];
+        *box_step = 1;
+        *field_step = dims[1];
+        return 0;
+    }
+    return -1;
+}
+
+// Offsets assume rows of grid_w cells and planes of grid_h rows; the runtime
+// may pad either (w_stride / h_stride, 0 when not reported)
+static bool unpadded(const rknn_tensor_attr *attr, int grid_h, int grid_w)
+{
+    return (attr->w_stride == 0 || (int)attr->w_stride == grid_w) &&
+           (attr->h_stride == 0 || (int)attr->h_stride == grid_h);
+}
+
+int tensor_layout_init(const rknn_tensor_attr *layout_attr, int channels, int grid_h, int grid_w,
+                       tensor_layout_t *layout)
+{
+    layout->fmt = layout_attr ? layout_attr->fmt : RKNN_TENSOR_NCHW;
+    layout->channels = channels;
+    layout->grid_h = grid_h;
+    layout->grid_w = grid_w;
+    int grid_len = grid_h * grid_w;
+    if (channels <= 0 || channels > TENSOR_LAYOUT_MAX_CHANNELS) {
+        return -1;
+    }
+
+    switch (layout->fmt) {
+    case RKNN_TENSOR_NCHW:
+        layout->cell_step = 1;
+        for (int c = 0; c < channels; c++) {
+            layout->plane[c] = c * grid_len;
+        }
+        return 0;
+
+    case RKNN_TENSOR_NHWC:
+        layout->cell_step = layout_attr->dims[3];
+        if (layout->cell_step < channels || !unpadded(layout_attr, grid_h, grid_w)) {
+            return -1;
+        }
+        for (int c = 0; c < channels; c++) {
+            layout->plane[c] = c;
+        }
+        return 0;
+
+    case RKNN_TENSOR_NC1HWC2: {
+        int c2 = layout_attr->n_dims == 5 ? (int)layout_attr->dims[4] : 0;
+        if (c2 <= 0 || !unpadded(layout_attr, grid_h, grid_w)) {
+            return -1;
+        }
+        layout->cell_step = c2;
+        for (int c = 0; c < channels; c++) {
+            layout->plane[c] = (c / c2) * grid_len * c2 + c % c2;
+        }
+        return 0;
+    }
+
+    default:
+        return -1;
+    }
+}
+
+void native_output_attr(const rknn_tensor_attr *attr, rknn_tensor_format fmt, rknn_tensor_attr *native)
+{
+    int channels, grid_h, grid_w;
+    output_shape(attr, &channels, &grid_h, &grid_w);
+    size_t elem_size = type_size(attr->type);
+
+    *native = *attr;
+    native->fmt = fmt;
+    memset(native->dims, 0, sizeof(native->dims));
+    if (fmt == RKNN_TENSOR_NC1HWC2) {
+        int c2 = elem_size == 1 ? 16 : 8;
+        native->n_dims = 5;
+        native->dims[0] = 1;
+        native->dims[1] = (channels + c2 - 1) / c2;
+        native->dims[2] = grid_h;
+        native->dims[3] = grid_w;
+        native->dims[4] = c2;
+        native->n_elems = native->dims[1] * grid_h * grid_w * c2;
+    } else if (fmt == RKNN_TENSOR_NHWC) {
+        native->n_dims = 4;
+        native->dims[0] = 1;
+        native->dims[1] = grid_h;
+        native->dims[2] = grid_w;
+        native->dims[3] = channels;
+        native->n_elems = grid_h * grid_w * channels;
+    } else {
+        native->n_dims = 4;
+        native->dims[0] = 1;
+        native->dims[1] = channels;
+        native->dims[2] = grid_h;
+        native->dims[3] = grid_w;
+        native->n_elems = channels * grid_h * grid_w;
+    }
+    native->w_stride = grid_w;
+    native->h_stride = grid_h;
+    native->size = native->n_elems * elem_size;
+    native->size_with_stride = native->size;
+}
+
+void tensor_layout_to_nchw(const tensor_layout_t *layout, const void *src, void *dst, size_t elem_size)
+{
+    const uint8_t *in = (const uint8_t *)src;
+    uint8_t *out = (uint8_t *)dst;
+    int grid_len = layout->grid_h * layout->grid_w;
+    for (int c = 0; c < layout->channels; c++) {
+        for (int cell = 0; cell < grid_len; cell++) {
+            memcpy(out + ((size_t)c * grid_len + cell) * elem_size,
+                   in + ((size_t)layout->plane[c] + (size_t)cell * layout->cell_step) * elem_size, elem_size);
+        }
+    }
+}
+
+void tensor_layout_from_nchw(const tensor_layout_t *layout, const void *src, void *dst, size_t elem_size)
+{
+    const uint8_t *in = (const uint8_t *)src;
+    uint8_t *out = (uint8_t *)dst;
+    int grid_len = layout->grid_h * layout->grid_w;
+    memset(out, 0, layout_elems(layout) * elem_size);
+    for (int c = 0; c < layout->channels; c++) {
+        for (int cell = 0; cell < grid_len; cell++) {
+            memcpy(out + ((size_t)layout->plane[c] + (size_t)cell * layout->cell_step) * elem_size,
+                   in + ((size_t)c * grid_len + cell) * elem_size, elem_size);
+        }
+    }
+}
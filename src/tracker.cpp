@@ -0,0 +1,254 @@
+#include "tracker.h"
+
+#include <algorithm>
+
+namespace {
+
+// Kalman noise, in pixels
+const float PROCESS_NOISE_POS = 1.0f;
+const float PROCESS_NOISE_VEL = 0.5f;
+const float MEASUREMENT_NOISE = 4.0f;
+// Weight given to a new measurement of the box size
+const float SIZE_ALPHA = 0.3f;
+
+float iou(const box_rect_t& a, const box_rect_t& b) {
+    float w = std::max(0, std::min(a.right, b.right) - std::max(a.left, b.left));
+    float h = std::max(0, std::min(a.bottom, b.bottom) - std::max(a.top, b.top));
+    float inter = w * h;
+    float uni = (float)(a.right - a.left) * (a.bottom - a.top) +
+                (float)(b.right - b.left) * (b.bottom - b.top) - inter;
+    return uni <= 0.f ? 0.f : inter / uni;
+}
+
+}  // namespace
+
+ObjectTracker::ObjectTracker(const TrackerOptions& options)
+    : options(options),
+      pool(options.max_tracks) {
+    free_slots.reserve(options.max_tracks);
+    for (int i = options.max_tracks - 1; i >= 0; i--) {
+        free_slots.push_back(i);
+    }
+    active.reserve(options.max_tracks);
+    predicted.reserve(options.max_tracks);
+    track_match.reserve(options.max_tracks);
+    open_tracks.reserve(options.max_tracks);
+}
+
+void ObjectTracker::predictTrack(Track& track) {
+    for (Axis* axis : {&track.cx, &track.cy}) {
+        // x' = x + v, P' = F P F^T + Q with F = [1 1; 0 1]
+        axis->pos += axis->vel;
+        axis->p00 += 2 * axis->p01 + axis->p11 + PROCESS_NOISE_POS;
+        axis->p01 += axis->p11;
+        axis->p11 += PROCESS_NOISE_VEL;
+    }
+    track.age++;
+}
+
+void ObjectTracker::correctTrack(Track& track, const box_rect_t& box, float prop) {
+    float measured[2] = {
+        (box.left + box.right) * 0.5f,
+        (box.top + box.bottom) * 0.5f,
+    };
+    Axis* axes[2] = {&track.cx, &track.cy};
+    for (int i = 0; i < 2; i++) {
+        Axis* axis = axes[i];
+        // Position-only measurement, H = [1 0]
+        float s = axis->p00 + MEASUREMENT_NOISE;
+        float k0 = axis->p00 / s;
+        float k1 = axis->p01 / s;
+        float residual = measured[i] - axis->pos;
+        axis->pos += k0 * residual;
+        axis->vel += k1 * residual;
+        axis->p11 -= k1 * axis->p01;
+        axis->p01 -= k0 * axis->p01;
+        axis->p00 -= k0 * axis->p00;
+    }
+    track.w += SIZE_ALPHA * ((box.right - box.left) - track.w);
+    track.h += SIZE_ALPHA * ((box.bottom - box.top) - track.h);
+    track.prop = prop;
+    track.hits++;
+    track.missed = 0;
+}
+
+int ObjectTracker::startTrack(const box_rect_t& box, int cls_id, float prop, Clock::time_point now) {
+    if (free_slots.empty()) {
+        return -1;
+    }
+    int slot = free_slots.back();
+    free_slots.pop_back();
+
+    Track& track = pool[slot];
+    track.active = true;
+    track.id = next_id++;
+    track.cls_id = cls_id;
+    track.prop = prop;
+    track.age = 0;
+    track.hits = 1;
+    track.missed = 0;
+    track.cx = {(box.left + box.right) * 0.5f, 0.f, MEASUREMENT_NOISE, 0.f, 10.f};
+    track.cy = {(box.top + box.bottom) * 0.5f, 0.f, MEASUREMENT_NOISE, 0.f, 10.f};
+    track.w = (float)(box.right - box.left);
+    track.h = (float)(box.bottom - box.top);
+    track.first_seen = now;
+    return slot;
+}
+
+box_rect_t ObjectTracker::trackBox(const Track& track) const {
+    box_rect_t box;
+    box.left = (int)(track.cx.pos - track.w * 0.5f);
+    box.top = (int)(track.cy.pos - track.h * 0.5f);
+    box.right = (int)(track.cx.pos + track.w * 0.5f);
+    box.bottom = (int)(track.cy.pos + track.h * 0.5f);
+    return box;
+}
+
+track_info_t ObjectTracker::trackInfo(const Track& track, Clock::time_point now) const {
+    track_info_t info;
+    info.id = track.id;
+    info.age = track.age;
+    info.dwell_s = std::chrono::duration<float>(now - track.first_seen).count();
+    info.confirmed = track.hits >= options.min_hits;
+    return info;
+}
+
+void ObjectTracker::findCandidates(const object_detect_result_list& detections) {
+    // Sweep over left edges; only boxes whose x-extents overlap can have IoU > 0
+    sweep.clear();
+    for (size_t t = 0; t < active.size(); t++) {
+        sweep.emplace_back(predicted[t].left, (int)t);
+    }
+    for (int d = 0; d < detections.count; d++) {
+        sweep.emplace_back(detections.boxes[d].left, -1 - d);
+    }
+    std::sort(sweep.begin(), sweep.end());
+
+    candidates.clear();
+    open_tracks.clear();
+    open_detections.clear();
+    for (const auto& event : sweep) {
+        int left = event.first;
+        // Retire boxes that end before this one starts
+        open_tracks.erase(std::remove_if(open_tracks.begin(), open_tracks.end(),
+                              [&](int t) { return predicted[t].right <= left; }), open_tracks.end());
+        open_detections.erase(std::remove_if(open_detections.begin(), open_detections.end(),
+                              [&](int d) { return detections.boxes[d].right <= left; }), open_detections.end());
+
+        if (event.second >= 0) {
+            int t = event.second;
+            const Track& track = pool[active[t]];
+            for (int d : open_detections) {
+                if (detections.cls_ids[d] != track.cls_id) continue;
+                float overlap = iou(predicted[t], detections.boxes[d]);
+                if (overlap >= options.iou_threshold) {
+                    candidates.push_back({overlap, t, d});
+                }
+            }
+            open_tracks.push_back(t);
+        } else {
+            int d = -1 - event.second;
+            for (int t : open_tracks) {
+                if (pool[active[t]].cls_id != detections.cls_ids[d]) continue;
+                float overlap = iou(predicted[t], detections.boxes[d]);
+                if (overlap >= options.iou_threshold) {
+                    candidates.push_back({overlap, t, d});
+                }
+            }
+            open_detections.push_back(d);
+        }
+    }
+}
+
+void ObjectTracker::update(object_detect_result_list& detections, Clock::time_point now) {
+    active.clear();
+    predicted.clear();
+    for (int slot = 0; slot < (int)pool.size(); slot++) {
+        if (pool[slot].active) {
+            predictTrack(pool[slot]);
+            active.push_back(slot);
+            predicted.push_back(trackBox(pool[slot]));
+        }
+    }
+
+    findCandidates(detections);
+
+    // Greedy assignment, best overlap first; ties broken by index for determinism
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if (a.iou != b.iou) return a.iou > b.iou;
+        if (a.track != b.track) return a.track < b.track;
+        return a.detection < b.detection;
+    });
+    track_match.assign(active.size(), -1);
+    detection_match.assign(detections.count, -1);
+    for (const Candidate& c : candidates) {
+        if (track_match[c.track] < 0 && detection_match[c.detection] < 0) {
+            track_match[c.track] = c.detection;
+            detection_match[c.detection] = active[c.track];
+        }
+    }
+
+    for (size_t t = 0; t < active.size(); t++) {
+        Track& track = pool[active[t]];
+        int d = track_match[t];
+        if (d >= 0) {
+            correctTrack(track, detections.boxes[d], detections.props[d]);
+        } else if (++track.missed > options.max_missed) {
+            track.active = false;
+            free_slots.push_back(active[t]);
+        }
+    }
+
+    detections.invalidateAggregates();
+    detections.tracks.resize(detections.count);
+    for (int d = 0; d < detections.count; d++) {
+        int slot = detection_match[d];
+        if (slot < 0) {
+            slot = startTrack(detections.boxes[d], detections.cls_ids[d], detections.props[d], now);
+        }
+        if (slot >= 0) {
+            detections.tracks[d] = trackInfo(pool[slot], now);
+        } else {
+            // Pool exhausted: report the detection untracked
+            detections.tracks[d] = {-1, 0, 0.f, false};
+        }
+    }
+}
+
+void ObjectTracker::predict(object_detect_result_list& out, Clock::time_point now) {
+    out.clear();
+    for (int slot = 0; slot < (int)pool.size(); slot++) {
+        Track& track = pool[slot];
+        if (!track.active) {
+            continue;
+        }
+        predictTrack(track);
+        if (track.missed == 0) {
+            out.push_back(trackBox(track), track.prop, track.cls_id);
+            out.tracks.push_back(trackInfo(track, now));
+        }
+    }
+}
+
+TrackerStage::TrackerStage(
+        ThreadSafeQueue<InferenceResult>& input,
+        ThreadSafeQueue<InferenceResult>& output,
+        std::atomic<bool>& isRunning,
+        const TrackerOptions& options)
+    : inputQueue(input),
+      outputQueue(output),
+      running(isRunning),
+      tracker(options) {
+}
+
+void TrackerStage::operator()() {
+    InferenceResult result;
+    while (running && inputQueue.pop(result)) {
+        if (result.detections.reused) {
+            tracker.predict(result.detections, ObjectTracker::Clock::now());
+        } else {
+            tracker.update(result.detections, ObjectTracker::Clock::now());
+        }
+        outputQueue.push(std::move(result));
+    }
+}
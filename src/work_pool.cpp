@@ -0,0 +1,107 @@
+#include "work_pool.h"
+
+#include <algorithm>
+
+WorkPool::WorkPool(int threads) {
+    threads = std::max(0, threads);
+    for (int i = 0; i <= threads; i++) {
+        queues.emplace_back(new Queue());
+    }
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&WorkPool::workerLoop, this, i);
+    }
+}
+
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkPool::run(int n_tasks, const std::function<void(int task, int slot)>& fn) {
+    if (n_tasks <= 0) {
+        return;
+    }
+    int caller = threads();
+    if (caller == 0 || n_tasks == 1) {
+        for (int task = 0; task < n_tasks; task++) {
+            fn(task, caller);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+    job = &fn;
+    pending.store(n_tasks);
+    // Contiguous shares keep neighbouring rows on one core
+    int slots = (int)queues.size();
+    for (int slot = 0; slot < slots; slot++) {
+        std::lock_guard<std::mutex> lock(queues[slot]->mutex);
+        for (int task = n_tasks * slot / slots; task < n_tasks * (slot + 1) / slots; task++) {
+            queues[slot]->tasks.push_back(task);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    while (runOne(caller)) {
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return pending.load() == 0; });
+    job = nullptr;
+}
+
+// Run the next task of slot's queue, or one stolen from another queue.
+// Returns false when every queue is empty.
+bool WorkPool::runOne(int slot) {
+    int slots = (int)queues.size();
+    int task = -1;
+    for (int k = 0; k < slots && task < 0; k++) {
+        Queue& queue = *queues[(slot + k) % slots];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (k == 0) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        } else {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+    }
+    if (task < 0) {
+        return false;
+    }
+
+    (*job)(task, slot);
+    if (pending.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+    }
+    return true;
+}
+
+void WorkPool::workerLoop(int slot) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        while (runOne(slot)) {
+        }
+    }
+}
@@ -17,21 +17,117 @@
 #include <string.h>
 #include <math.h>
 
+#include <memory>
+#include <vector>
+
 #include "common.h"
-#include "file_utils.h"
 #include "image_utils.h"
+#include "inference_backend.h"
+#include "log.h"
+#include "metrics.h"
+#include "motion_gate.h"
 #include "yolo.h"
 #include "postprocess.h"
+#include "tensor_file.h"
+#include "tensor_layout.h"
+#include "yuv_letterbox.h"
+
+static int default_max_detections = OBJ_NUMB_MAX_SIZE;
+static bool default_integer_decode = false;
+static bool default_native_outputs = false;
+static char output_recording_dir[256];
+static int output_recording_left = 0;
+static int output_recording_index = 0;
+
+void set_default_max_detections(int max_detections)
+{
+    default_max_detections = max_detections > 0 ? max_detections : 0;
+}
+
+void set_default_integer_decode(bool enabled)
+{
+    default_integer_decode = enabled;
+}
+
+void set_default_native_outputs(bool enabled)
+{
+    default_native_outputs = enabled;
+}
+
+void set_output_recording(const char *dir, int max_frames)
+{
+    snprintf(output_recording_dir, sizeof(output_recording_dir), "%s", dir ? dir : "");
+    output_recording_left = (dir && dir[0]) ? max_frames : 0;
+}
 
 static void dump_tensor_attr(rknn_tensor_attr *attr)
 {
-    printf("  index=%d, name=%s, n_dims=%d, dims=[%d, %d, %d, %d], n_elems=%d, size=%d, fmt=%s, type=%s, qnt_type=%s, "
+    LOGI("  index=%d, name=%s, n_dims=%d, dims=[%d, %d, %d, %d], n_elems=%d, size=%d, fmt=%s, type=%s, qnt_type=%s, "
            "zp=%d, scale=%f\n",
            attr->index, attr->name, attr->n_dims, attr->dims[0], attr->dims[1], attr->dims[2], attr->dims[3],
            attr->n_elems, attr->size, get_format_string(attr->fmt), get_type_string(attr->type),
            get_qnt_type_string(attr->qnt_type), attr->zp, attr->scale);
 }
 
+static void release_native_outputs(rknn_app_context_t *app_ctx)
+{
+    if (app_ctx->native_output_mems != NULL) {
+        for (uint32_t i = 0; i < app_ctx->io_num.n_output; i++) {
+            if (app_ctx->native_output_mems[i] != NULL) {
+                app_ctx->backend->destroyMem(app_ctx->native_output_mems[i]);
+            }
+        }
+        free(app_ctx->native_output_mems);
+        app_ctx->native_output_mems = NULL;
+    }
+    if (app_ctx->native_output_attrs != NULL) {
+        free(app_ctx->native_output_attrs);
+        app_ctx->native_output_attrs = NULL;
+    }
+}
+
+// Let the NPU write the quantized outputs in its native layout, which
+// post_process() reads in place. Returns -1, leaving the standard outputs,
+// when the runtime or the model does not offer them.
+static int bind_native_outputs(rknn_app_context_t *app_ctx)
+{
+#ifdef RKNPU1
+    return -1;
+#else
+    uint32_t n_output = app_ctx->io_num.n_output;
+    app_ctx->native_output_attrs = (rknn_tensor_attr *)calloc(n_output, sizeof(rknn_tensor_attr));
+    app_ctx->native_output_mems = (rknn_tensor_mem **)calloc(n_output, sizeof(rknn_tensor_mem *));
+    if (app_ctx->native_output_attrs == NULL || app_ctx->native_output_mems == NULL) {
+        release_native_outputs(app_ctx);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < n_output; i++) {
+        rknn_tensor_attr *attr = &app_ctx->native_output_attrs[i];
+        attr->index = i;
+        int ret = app_ctx->backend->query(RKNN_QUERY_NATIVE_OUTPUT_ATTR, attr, sizeof(rknn_tensor_attr));
+        tensor_layout_t layout;
+        int channels, grid_h, grid_w;
+        output_shape(&app_ctx->output_attrs[i], &channels, &grid_h, &grid_w);
+        if (ret != RKNN_SUCC || attr->type != app_ctx->output_attrs[i].type ||
+            tensor_layout_init(attr, channels, grid_h, grid_w, &layout) != 0) {
+            release_native_outputs(app_ctx);
+            return -1;
+        }
+        dump_tensor_attr(attr);
+
+        uint32_t size = attr->size_with_stride > attr->size ? attr->size_with_stride : attr->size;
+        app_ctx->native_output_mems[i] = app_ctx->backend->createMem(size);
+        if (app_ctx->native_output_mems[i] == NULL ||
+            app_ctx->backend->setIoMem(app_ctx->native_output_mems[i], attr) != RKNN_SUCC) {
+            release_native_outputs(app_ctx);
+            return -1;
+        }
+    }
+    return 0;
+#endif
+}
+
 yolo_model_type_t detect_yolo_model_type(rknn_app_context_t *app_ctx)
 {
     if (!app_ctx || !app_ctx->output_attrs) {
@@ -44,10 +140,19 @@ yolo_model_type_t detect_yolo_model_type(rknn_app_context_t *app_ctx)
     //   * 3 box regression outputs (64 channels each): [1, 64, H, W]  
     //   * 3 class prediction outputs (80 channels each): [1, 80, H, W]
     //   * 3 objectness outputs (1 channel each): [1, 1, H, W]
+    // - End-to-end YOLO (YOLOv10 one-to-one head): 1 output of top-K boxes,
+    //   [1, K, 6] or [1, 6, K] (x1, y1, x2, y2, score, class)
     
     int n_outputs = app_ctx->io_num.n_output;
     
-    if (n_outputs == 3) {
+    if (n_outputs == 1) {
+        int count, box_step, field_step;
+        if (end2end_output_shape(&app_ctx->output_attrs[0], &count, &box_step, &field_step) == 0) {
+            LOGI("Model type detection: End-to-end YOLO format detected (1 output, top %d boxes)\n", count);
+            return YOLO_END2END;
+        }
+    }
+    else if (n_outputs == 3) {
         // Standard YOLO (YOLOX) pattern: 3 outputs with 85 channels each
         // Check if all outputs have 85 channels (4 box + 1 obj + 80 classes)
         bool all_have_85_channels = true;
@@ -66,7 +171,7 @@ yolo_model_type_t detect_yolo_model_type(rknn_app_context_t *app_ctx)
         }
         
         if (all_have_85_channels) {
-            printf("Model type detection: Standard YOLO format detected (3 outputs, 85 channels each)\n");
+            LOGI("Model type detection: Standard YOLO format detected (3 outputs, 85 channels each)\n");
             return YOLO_STANDARD;
         }
     }
@@ -93,70 +198,82 @@ yolo_model_type_t detect_yolo_model_type(rknn_app_context_t *app_ctx)
         }
         
         if (is_yolov8_pattern) {
-            printf("Model type detection: Simplified YOLO format detected (9 outputs, YoloV8 pattern)\n");
+            LOGI("Model type detection: Simplified YOLO format detected (9 outputs, YoloV8 pattern)\n");
             return YOLO_SIMPLIFIED;
         }
     }
     
-    printf("Model type detection: Unable to determine model type (outputs: %d), defaulting to Standard YOLO\n", n_outputs);
+    LOGI("Model type detection: Unable to determine model type (outputs: %d), defaulting to Standard YOLO\n", n_outputs);
     return YOLO_STANDARD;  // Default to Standard YOLO for backwards compatibility
 }
 
+// Recordings are always NCHW, whatever layout the outputs were decoded from
+static int record_outputs(const char *path, rknn_app_context_t *app_ctx, rknn_output *outputs)
+{
+    if (!app_ctx->native_output_attrs) {
+        return save_output_tensors(path, app_ctx, outputs);
+    }
+
+    uint32_t n_output = app_ctx->io_num.n_output;
+    std::vector<std::vector<uint8_t>> nchw(n_output);
+    std::vector<rknn_output> standard(outputs, outputs + n_output);
+    for (uint32_t i = 0; i < n_output; i++) {
+        const rknn_tensor_attr *attr = &app_ctx->output_attrs[i];
+        tensor_layout_t layout;
+        int channels, grid_h, grid_w;
+        output_shape(attr, &channels, &grid_h, &grid_w);
+        tensor_layout_init(&app_ctx->native_output_attrs[i], channels, grid_h, grid_w, &layout);
+        nchw[i].resize(attr->size);
+        tensor_layout_to_nchw(&layout, outputs[i].buf, nchw[i].data(), attr->size / attr->n_elems);
+        standard[i].buf = nchw[i].data();
+        standard[i].size = attr->size;
+    }
+    return save_output_tensors(path, app_ctx, standard.data());
+}
+
 int init_yolo_model(const char *model_path, rknn_app_context_t *app_ctx)
 {
     int ret;
-    int model_len = 0;
-    char *model;
-    rknn_context ctx = 0;
 
     // Load RKNN Model
-    model_len = read_data_from_file(model_path, &model);
-    if (model == NULL)
-    {
-        printf("load_model fail!\n");
-        return -1;
-    }
-
-    ret = rknn_init(&ctx, model, model_len, 0, NULL);
-    free(model);
-    if (ret < 0)
+    std::unique_ptr<InferenceBackend> backend = create_inference_backend();
+    if (!backend || backend->init(model_path) < 0)
     {
-        printf("rknn_init fail! ret=%d\n", ret);
         return -1;
     }
 
     // Get Model Input Output Number
     rknn_input_output_num io_num;
-    ret = rknn_query(ctx, RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
+    ret = backend->query(RKNN_QUERY_IN_OUT_NUM, &io_num, sizeof(io_num));
     if (ret != RKNN_SUCC) {
-        printf("rknn_query fail! ret=%d\n", ret);
+        LOGE("rknn_query fail! ret=%d\n", ret);
         return -1;
     }
-    printf("model input num: %d, output num: %d\n", io_num.n_input, io_num.n_output);
+    LOGI("model input num: %d, output num: %d\n", io_num.n_input, io_num.n_output);
 
     // Get Model Input Info
-    printf("input tensors:\n");
+    LOGI("input tensors:\n");
     rknn_tensor_attr input_attrs[io_num.n_input];
     memset(input_attrs, 0, sizeof(input_attrs));
     for (int i = 0; i < io_num.n_input; i++) {
         input_attrs[i].index = i;
-        ret = rknn_query(ctx, RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
+        ret = backend->query(RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
         if (ret != RKNN_SUCC) {
-            printf("rknn_query fail! ret=%d\n", ret);
+            LOGE("rknn_query fail! ret=%d\n", ret);
             return -1;
         }
         dump_tensor_attr(&(input_attrs[i]));
     }
 
     // Get Model Output Info
-    printf("output tensors:\n");
+    LOGI("output tensors:\n");
     rknn_tensor_attr output_attrs[io_num.n_output];
     memset(output_attrs, 0, sizeof(output_attrs));
     for (int i = 0; i < io_num.n_output; i++) {
         output_attrs[i].index = i;
-        ret = rknn_query(ctx, RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
+        ret = backend->query(RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
         if (ret != RKNN_SUCC) {
-            printf("rknn_query fail! ret=%d\n", ret);
+            LOGE("rknn_query fail! ret=%d\n", ret);
             return -1;
         }
         dump_tensor_attr(&(output_attrs[i]));
@@ -164,7 +281,8 @@ int init_yolo_model(const char *model_path, rknn_app_context_t *app_ctx)
 
 
     // Set to context
-    app_ctx->rknn_ctx = ctx;
+    app_ctx->rknn_ctx = backend->context();
+    app_ctx->backend = backend.release();
 
     // Check if the model is quantized
     if (output_attrs[0].qnt_type == RKNN_TENSOR_QNT_AFFINE_ASYMMETRIC && output_attrs[0].type == RKNN_TENSOR_INT8) {
@@ -180,25 +298,70 @@ int init_yolo_model(const char *model_path, rknn_app_context_t *app_ctx)
     memcpy(app_ctx->output_attrs, output_attrs, io_num.n_output * sizeof(rknn_tensor_attr));
 
     if (input_attrs[0].fmt == RKNN_TENSOR_NCHW) {
-        printf("model is NCHW input fmt\n");
+        LOGI("model is NCHW input fmt\n");
         app_ctx->model_channel = input_attrs[0].dims[1];
         app_ctx->model_height = input_attrs[0].dims[2];
         app_ctx->model_width = input_attrs[0].dims[3];
     } else {
-        printf("model is NHWC input fmt\n");
+        LOGI("model is NHWC input fmt\n");
         app_ctx->model_height = input_attrs[0].dims[1];
         app_ctx->model_width = input_attrs[0].dims[2];
         app_ctx->model_channel = input_attrs[0].dims[3];
     }
 
-    printf("model input height=%d, width=%d, channel=%d\n",
+    LOGI("model input height=%d, width=%d, channel=%d\n",
            app_ctx->model_height, app_ctx->model_width, app_ctx->model_channel);
 
     // Detect YOLO model type based on output tensor characteristics
     app_ctx->model_type = detect_yolo_model_type(app_ctx);
     const char* model_type_str = (app_ctx->model_type == YOLO_STANDARD) ? "Standard YOLO" : 
-                                (app_ctx->model_type == YOLO_SIMPLIFIED) ? "Simplified YOLO" : "Unknown";
-    printf("Detected model type: %s\n", model_type_str);
+                                (app_ctx->model_type == YOLO_SIMPLIFIED) ? "Simplified YOLO" :
+                                (app_ctx->model_type == YOLO_END2END) ? "End-to-end YOLO (NMS-free)" : "Unknown";
+    LOGI("Detected model type: %s\n", model_type_str);
+
+    app_ctx->max_detections = default_max_detections;
+    LOGI("max detections per frame: %d%s\n", app_ctx->max_detections,
+           app_ctx->max_detections == 0 ? " (unlimited)" : "");
+
+    const MotionGateOptions *gate_options = get_default_motion_gate();
+    if (gate_options) {
+        app_ctx->motion_gate = new MotionGate(*gate_options);
+        LOGI("motion gate enabled: threshold=%d, min changed blocks=%d, max interval=%d ms\n",
+               gate_options->threshold, gate_options->min_changed_blocks, gate_options->max_interval_ms);
+    } else {
+        app_ctx->motion_gate = NULL;
+    }
+    app_ctx->yuv_letterbox = NULL;
+
+    app_ctx->native_output_attrs = NULL;
+    app_ctx->native_output_mems = NULL;
+    // The end-to-end output is a short list of boxes, not a grid the native layouts apply to
+    if (app_ctx->is_quant && default_native_outputs && app_ctx->model_type != YOLO_END2END) {
+        LOGI("native output tensors:\n");
+        if (bind_native_outputs(app_ctx) == 0) {
+            LOGI("decoding outputs in the NPU's native layout\n");
+        } else {
+            LOGI("native outputs unavailable, using rknn_outputs_get()\n");
+        }
+    }
+
+    app_ctx->decode_tables = NULL;
+    app_ctx->integer_decode = default_integer_decode && app_ctx->model_type != YOLO_END2END;
+    if (app_ctx->integer_decode) {
+        if (prepare_decode_tables(app_ctx, BOX_THRESH) == 0) {
+            LOGI("integer-domain decode of quantized outputs enabled\n");
+        } else {
+            LOGW("integer-domain decode needs int8/uint8 YOLOX or YOLOv8 outputs, using the float decode\n");
+            app_ctx->integer_decode = false;
+        }
+    }
+
+    // One scale for coordinates, scores and class ids leaves the scores a few levels
+    if (app_ctx->model_type == YOLO_END2END && app_ctx->is_quant) {
+        LOGE("quantized end-to-end outputs are not supported, convert the model with a float output\n");
+        release_yolo_model(app_ctx);
+        return -1;
+    }
 
     return 0;
 }
@@ -215,70 +378,64 @@ int release_yolo_model(rknn_app_context_t *app_ctx)
         free(app_ctx->output_attrs);
         app_ctx->output_attrs = NULL;
     }
-    if (app_ctx->rknn_ctx != 0)
+    if (app_ctx->motion_gate != NULL)
     {
-        rknn_destroy(app_ctx->rknn_ctx);
+        delete app_ctx->motion_gate;
+        app_ctx->motion_gate = NULL;
+    }
+    if (app_ctx->yuv_letterbox != NULL)
+    {
+        delete app_ctx->yuv_letterbox;
+        app_ctx->yuv_letterbox = NULL;
+    }
+    release_decode_tables(app_ctx);
+    if (app_ctx->backend != NULL)
+    {
+        release_native_outputs(app_ctx);
+        delete app_ctx->backend;
+        app_ctx->backend = NULL;
         app_ctx->rknn_ctx = 0;
     }
     return 0;
 }
 
-int inference_yolo_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results) {
+// Run the model on a letterboxed RGB888 input and post-process the outputs
+static int run_yolo_model(rknn_app_context_t *app_ctx, image_buffer_t *dst_img, letterbox_t *letter_box,
+                          object_detect_result_list *od_results)
+{
     int ret;
-    image_buffer_t dst_img;
-    letterbox_t letter_box;
     rknn_input inputs[app_ctx->io_num.n_input];
     rknn_output outputs[app_ctx->io_num.n_output];
     const float nms_threshold = NMS_THRESH;      // Default NMS threshold
     const float box_conf_threshold = BOX_THRESH; // Default confidence threshold
-    int bg_color = 114;  // Default letterbox background color for YOLO models
-    
-    if ((!app_ctx) || !(img) || (!od_results)) {
-        return -1;
-    }
-    memset(od_results, 0x00, sizeof(*od_results));
-    memset(&letter_box, 0, sizeof(letterbox_t));
-    memset(&dst_img, 0, sizeof(image_buffer_t));
+
     memset(inputs, 0, sizeof(inputs));
     memset(outputs, 0, sizeof(outputs));
 
-    // Pre Process
-    dst_img.width = app_ctx->model_width;
-    dst_img.height = app_ctx->model_height;
-    dst_img.format = IMAGE_FORMAT_RGB888;
-    dst_img.size = get_image_size(&dst_img);
-    dst_img.virt_addr = (unsigned char *)malloc(dst_img.size);
-    if (dst_img.virt_addr == NULL) {
-        printf("malloc buffer size:%d fail!\n", dst_img.size);
-        return -1;
-    }
-
-    // letterbox - maintain aspect ratio when resizing
-    ret = convert_image_with_letterbox(img, &dst_img, &letter_box, bg_color);
-    if (ret < 0) {
-        printf("convert_image_with_letterbox fail! ret=%d\n", ret);
-        goto out;
-    }
-
     // Set Input Data
     inputs[0].index = 0;
     inputs[0].type = RKNN_TENSOR_UINT8;
     inputs[0].fmt = RKNN_TENSOR_NHWC;
     inputs[0].size = app_ctx->model_width * app_ctx->model_height * app_ctx->model_channel;
-    inputs[0].buf = dst_img.virt_addr;
+    inputs[0].buf = dst_img->virt_addr;
 
-    ret = rknn_inputs_set(app_ctx->rknn_ctx, app_ctx->io_num.n_input, inputs);
+    {
+        ScopedStageTimer timer(Stage::InputsSet);
+        ret = app_ctx->backend->inputsSet(app_ctx->io_num.n_input, inputs);
+    }
     if (ret < 0) {
-        printf("rknn_input_set fail! ret=%d\n", ret);
-        goto out;
+        LOGE("rknn_input_set fail! ret=%d\n", ret);
+        return ret;
     }
 
     // Run
-    printf("rknn_run\n");
-    ret = rknn_run(app_ctx->rknn_ctx, nullptr);
+    {
+        ScopedStageTimer timer(Stage::Run);
+        ret = app_ctx->backend->run();
+    }
     if (ret < 0) {
-        printf("rknn_run fail! ret=%d\n", ret);
-        goto out;
+        LOGE("rknn_run fail! ret=%d\n", ret);
+        return ret;
     }
 
     // Get Output
@@ -287,22 +444,141 @@ int inference_yolo_model(rknn_app_context_t *app_ctx, image_buffer_t *img, objec
         outputs[i].index = i;
         outputs[i].want_float = (!app_ctx->is_quant);
     }
-    ret = rknn_outputs_get(app_ctx->rknn_ctx, app_ctx->io_num.n_output, outputs, NULL);
+    {
+        ScopedStageTimer timer(Stage::OutputsGet);
+        if (app_ctx->native_output_mems) {
+            // Already in the bound buffers, only the CPU cache needs syncing
+            ret = RKNN_SUCC;
+            for (int i = 0; i < app_ctx->io_num.n_output && ret >= 0; i++) {
+                ret = app_ctx->backend->memSync(app_ctx->native_output_mems[i]);
+                outputs[i].buf = app_ctx->native_output_mems[i]->virt_addr;
+                outputs[i].size = app_ctx->native_output_attrs[i].size;
+            }
+        } else {
+            ret = app_ctx->backend->outputsGet(app_ctx->io_num.n_output, outputs);
+        }
+    }
     if (ret < 0) {
-        printf("rknn_outputs_get fail! ret=%d\n", ret);
-        goto out;
+        LOGE("rknn_outputs_get fail! ret=%d\n", ret);
+        return ret;
+    }
+
+    // Keep raw outputs for offline post-processing benchmarks
+    if (output_recording_left > 0) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/frame_%06d.rkt", output_recording_dir, output_recording_index++);
+        if (record_outputs(path, app_ctx, outputs) == 0) {
+            output_recording_left--;
+        } else {
+            output_recording_left = 0;
+        }
     }
 
     // Post Process
-    post_process(app_ctx, outputs, &letter_box, box_conf_threshold, nms_threshold, od_results);
+    post_process(app_ctx, outputs, letter_box, box_conf_threshold, nms_threshold, od_results);
+    Metrics::instance().add(Counter::Frames);
+    if (app_ctx->motion_gate) {
+        app_ctx->motion_gate->remember(*od_results);
+    }
 
     // Remember to release rknn output
-    rknn_outputs_release(app_ctx->rknn_ctx, app_ctx->io_num.n_output, outputs);
+    if (!app_ctx->native_output_mems) {
+        app_ctx->backend->outputsRelease(app_ctx->io_num.n_output, outputs);
+    }
+    return ret;
+}
 
-out:
-    if (dst_img.virt_addr != NULL) {
-        free(dst_img.virt_addr);
+// RGB888 buffer of the model input size
+static int alloc_model_input(rknn_app_context_t *app_ctx, image_buffer_t *dst_img)
+{
+    memset(dst_img, 0, sizeof(image_buffer_t));
+    dst_img->width = app_ctx->model_width;
+    dst_img->height = app_ctx->model_height;
+    dst_img->format = IMAGE_FORMAT_RGB888;
+    dst_img->size = get_image_size(dst_img);
+    dst_img->virt_addr = (unsigned char *)malloc(dst_img->size);
+    if (dst_img->virt_addr == NULL) {
+        LOGE("malloc buffer size:%d fail!\n", dst_img->size);
+        return -1;
     }
+    return 0;
+}
+
+int inference_yolo_model(rknn_app_context_t *app_ctx, image_buffer_t *img, object_detect_result_list *od_results) {
+    int ret;
+    image_buffer_t dst_img;
+    letterbox_t letter_box;
+    int bg_color = 114;  // Default letterbox background color for YOLO models
     
+    if ((!app_ctx) || !(img) || (!od_results)) {
+        return -1;
+    }
+    // Static scene: reuse the last results without touching the NPU
+    if (app_ctx->motion_gate && !app_ctx->motion_gate->shouldInfer(img, MotionGate::Clock::now())) {
+        *od_results = app_ctx->motion_gate->lastResults();
+        od_results->reused = true;
+        return 0;
+    }
+
+    od_results->clear();
+    memset(&letter_box, 0, sizeof(letterbox_t));
+
+    // Pre Process
+    if (alloc_model_input(app_ctx, &dst_img) < 0) {
+        return -1;
+    }
+
+    // letterbox - maintain aspect ratio when resizing
+    {
+        ScopedStageTimer timer(Stage::Letterbox);
+        ret = convert_image_with_letterbox(img, &dst_img, &letter_box, bg_color);
+    }
+    if (ret < 0) {
+        LOGE("convert_image_with_letterbox fail! ret=%d\n", ret);
+    } else {
+        ret = run_yolo_model(app_ctx, &dst_img, &letter_box, od_results);
+    }
+
+    free(dst_img.virt_addr);
     return ret;
-}
\ No newline at end of file
+}
+
+int inference_yolo_model_yuv(rknn_app_context_t *app_ctx, const YuvFrame *frame, object_detect_result_list *od_results)
+{
+    int ret;
+    image_buffer_t dst_img;
+    letterbox_t letter_box;
+    int bg_color = 114;
+
+    if ((!app_ctx) || !(frame) || (!od_results)) {
+        return -1;
+    }
+    if (app_ctx->motion_gate && !app_ctx->motion_gate->shouldInfer(frame, MotionGate::Clock::now())) {
+        *od_results = app_ctx->motion_gate->lastResults();
+        od_results->reused = true;
+        return 0;
+    }
+
+    od_results->clear();
+    memset(&letter_box, 0, sizeof(letterbox_t));
+    if (alloc_model_input(app_ctx, &dst_img) < 0) {
+        return -1;
+    }
+    if (app_ctx->yuv_letterbox == NULL) {
+        app_ctx->yuv_letterbox = new YuvLetterbox();
+    }
+
+    // Scale, convert and pad in one pass over the camera frame
+    {
+        ScopedStageTimer timer(Stage::Letterbox);
+        ret = app_ctx->yuv_letterbox->convert(*frame, &dst_img, &letter_box, bg_color);
+    }
+    if (ret < 0) {
+        LOGE("YUV letterbox of a %dx%d frame fail! ret=%d\n", frame->width, frame->height, ret);
+    } else {
+        ret = run_yolo_model(app_ctx, &dst_img, &letter_box, od_results);
+    }
+
+    free(dst_img.virt_addr);
+    return ret;
+}
@@ -0,0 +1,325 @@
+#include "yuv_letterbox.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// BT.601 limited range in 6-bit fixed point:
+//   R = 1.164 (Y - 16) + 1.596 (V - 128)
+//   G = 1.164 (Y - 16) - 0.391 (U - 128) - 0.813 (V - 128)
+//   B = 1.164 (Y - 16) + 2.018 (U - 128)
+// Every term fits in int16. Only B can exceed it, and then it saturates to
+// 255 either way, so the scalar and the saturating vector code agree.
+static const int YG = 74;
+static const int VR = 102;
+static const int UG = 25;
+static const int VG = 52;
+static const int UB = 129;
+static const int Y_ROUND = 32;
+
+static inline uint8_t clamp_u8(int v) {
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline uint8_t lerp_u8(uint8_t a, uint8_t b, int weight) {
+    return (uint8_t)((a * (128 - weight) + b * weight + 64) >> 7);
+}
+
+// out[i] = lerp(a[i], b[i], weight) with a 7-bit weight
+static void blend_rows(const uint8_t* a, const uint8_t* b, int weight, uint8_t* out, int len) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    uint8x8_t wa = vdup_n_u8((uint8_t)(128 - weight));
+    uint8x8_t wb = vdup_n_u8((uint8_t)weight);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t va = vld1q_u8(a + i);
+        uint8x16_t vb = vld1q_u8(b + i);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+        vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, 7), vrshrn_n_u16(hi, 7)));
+    }
+#elif defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i wa = _mm_set1_epi16((short)(128 - weight));
+    __m128i wb = _mm_set1_epi16((short)weight);
+    __m128i round = _mm_set1_epi16(64);
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 7);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 7);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < len; i++) {
+        out[i] = lerp_u8(a[i], b[i], weight);
+    }
+}
+
+// Row of planar Y, U, V to packed RGB888
+static void yuv_to_rgb_row(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* rgb, int len) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    int16x8_t y_offset = vdupq_n_s16(16);
+    int16x8_t uv_offset = vdupq_n_s16(128);
+    int16x8_t y_round = vdupq_n_s16(Y_ROUND);
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t vy = vld1q_u8(y + i);
+        uint8x16_t vu = vld1q_u8(u + i);
+        uint8x16_t vv = vld1q_u8(v + i);
+        uint8x8_t r[2], g[2], b[2];
+        for (int half = 0; half < 2; half++) {
+            uint8x8_t y8 = half ? vget_high_u8(vy) : vget_low_u8(vy);
+            uint8x8_t u8 = half ? vget_high_u8(vu) : vget_low_u8(vu);
+            uint8x8_t v8 = half ? vget_high_u8(vv) : vget_low_u8(vv);
+            int16x8_t yy = vreinterpretq_s16_u16(vmovl_u8(y8));
+            int16x8_t uu = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), uv_offset);
+            int16x8_t vvv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), uv_offset);
+            yy = vaddq_s16(vmulq_n_s16(vsubq_s16(yy, y_offset), YG), y_round);
+            int16x8_t rr = vqaddq_s16(yy, vmulq_n_s16(vvv, VR));
+            int16x8_t gg = vqaddq_s16(vqaddq_s16(yy, vmulq_n_s16(uu, -UG)), vmulq_n_s16(vvv, -VG));
+            int16x8_t bb = vqaddq_s16(yy, vmulq_n_s16(uu, UB));
+            r[half] = vqshrun_n_s16(rr, 6);
+            g[half] = vqshrun_n_s16(gg, 6);
+            b[half] = vqshrun_n_s16(bb, 6);
+        }
+        uint8x16x3_t out;
+        out.val[0] = vcombine_u8(r[0], r[1]);
+        out.val[1] = vcombine_u8(g[0], g[1]);
+        out.val[2] = vcombine_u8(b[0], b[1]);
+        vst3q_u8(rgb + i * 3, out);
+    }
+#elif defined(__SSE2__)
+    __m128i zero = _mm_setzero_si128();
+    __m128i y_offset = _mm_set1_epi16(16);
+    __m128i uv_offset = _mm_set1_epi16(128);
+    __m128i y_round = _mm_set1_epi16(Y_ROUND);
+    __m128i yg = _mm_set1_epi16(YG);
+    __m128i vr = _mm_set1_epi16(VR);
+    __m128i ug = _mm_set1_epi16(-UG);
+    __m128i vg = _mm_set1_epi16(-VG);
+    __m128i ub = _mm_set1_epi16(UB);
+    alignas(16) uint8_t r[16], g[16], b[16];
+    for (; i + 16 <= len; i += 16) {
+        __m128i vy = _mm_loadu_si128((const __m128i*)(y + i));
+        __m128i vu = _mm_loadu_si128((const __m128i*)(u + i));
+        __m128i vv = _mm_loadu_si128((const __m128i*)(v + i));
+        __m128i rr[2], gg[2], bb[2];
+        for (int half = 0; half < 2; half++) {
+            __m128i yy = half ? _mm_unpackhi_epi8(vy, zero) : _mm_unpacklo_epi8(vy, zero);
+            __m128i uu = _mm_sub_epi16(half ? _mm_unpackhi_epi8(vu, zero) : _mm_unpacklo_epi8(vu, zero), uv_offset);
+            __m128i vvv = _mm_sub_epi16(half ? _mm_unpackhi_epi8(vv, zero) : _mm_unpacklo_epi8(vv, zero), uv_offset);
+            yy = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(yy, y_offset), yg), y_round);
+            rr[half] = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(vvv, vr)), 6);
+            gg[half] = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(uu, ug)),
+                                                     _mm_mullo_epi16(vvv, vg)), 6);
+            bb[half] = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(uu, ub)), 6);
+        }
+        _mm_store_si128((__m128i*)r, _mm_packus_epi16(rr[0], rr[1]));
+        _mm_store_si128((__m128i*)g, _mm_packus_epi16(gg[0], gg[1]));
+        _mm_store_si128((__m128i*)b, _mm_packus_epi16(bb[0], bb[1]));
+        // SSE2 has no 3-way interleaving store
+        uint8_t* p = rgb + i * 3;
+        for (int k = 0; k < 16; k++) {
+            p[k * 3] = r[k];
+            p[k * 3 + 1] = g[k];
+            p[k * 3 + 2] = b[k];
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        int yy = (y[i] - 16) * YG + Y_ROUND;
+        int uu = u[i] - 128;
+        int vv = v[i] - 128;
+        rgb[i * 3] = clamp_u8((yy + VR * vv) >> 6);
+        rgb[i * 3 + 1] = clamp_u8((yy - UG * uu - VG * vv) >> 6);
+        rgb[i * 3 + 2] = clamp_u8((yy + UB * uu) >> 6);
+    }
+}
+
+// Bilinear tap at source position src of a row of n samples: the first
+// sample and the 7-bit weight of the one after it. Edges clamp.
+static void bilinear_position(float src, int n, int* first, int* weight) {
+    src = std::min(std::max(src, 0.0f), (float)(n - 1));
+    int i = std::min((int)src, n - 2);
+    *first = i;
+    *weight = (int)lrintf((src - i) * 128);
+}
+
+YuvLetterbox::Tap YuvLetterbox::verticalTap(int dst_row, float scale, int src_rows, int subsample) {
+    float sy = (dst_row + 0.5f) / scale - 0.5f;
+    if (subsample > 1) {
+        sy = (sy + 0.5f) / subsample - 0.5f;
+    }
+    Tap tap;
+    bilinear_position(sy, src_rows, &tap.offset, &tap.weight);
+    return tap;
+}
+
+void YuvLetterbox::prepare(const YuvFrame& src, int dst_width, int dst_height) {
+    if (src.width == src_width && src.height == src_height && src.format == src_format &&
+        dst_width == target_width && dst_height == target_height) {
+        return;
+    }
+    src_width = src.width;
+    src_height = src.height;
+    src_format = src.format;
+    target_width = dst_width;
+    target_height = dst_height;
+
+    float scale_w = (float)dst_width / src.width;
+    float scale_h = (float)dst_height / src.height;
+    scale = std::min(scale_w, scale_h);
+    resize_width = scale_w <= scale_h ? dst_width : std::min(dst_width, (int)(src.width * scale + 0.5f));
+    resize_height = scale_h <= scale_w ? dst_height : std::min(dst_height, (int)(src.height * scale + 0.5f));
+
+    bool packed = src.format == YuvFormat::YUYV;
+    int luma_step = packed ? 2 : 1;
+    chroma_step = packed ? 4 : 2;
+    luma_taps.resize(resize_width);
+    chroma_taps.resize(resize_width);
+    for (int x = 0; x < resize_width; x++) {
+        float sx = (x + 0.5f) / scale - 0.5f;
+        int first, weight;
+        bilinear_position(sx, src.width, &first, &weight);
+        luma_taps[x] = {first * luma_step, weight};
+        bilinear_position((sx + 0.5f) / 2 - 0.5f, src.width / 2, &first, &weight);
+        chroma_taps[x] = {first * chroma_step + (packed ? 1 : 0), weight};
+    }
+
+    blended_luma.resize(packed ? src.width * 2 : src.width);
+    blended_chroma.resize(packed ? 0 : src.width);
+    row_y.resize(resize_width);
+    row_u.resize(resize_width);
+    row_v.resize(resize_width);
+}
+
+int YuvLetterbox::convert(const YuvFrame& src, image_buffer_t* dst, letterbox_t* letter_box, int bg_color) {
+    // Chroma is subsampled in pairs, and every tap needs two source samples
+    if (!src.data || src.width < 4 || src.height < 2 || src.width % 2 != 0 ||
+        (src.format == YuvFormat::NV12 && (src.height < 4 || src.height % 2 != 0))) {
+        return -1;
+    }
+    if (!dst || !dst->virt_addr || dst->format != IMAGE_FORMAT_RGB888 || dst->width <= 0 || dst->height <= 0) {
+        return -1;
+    }
+    int dst_stride = (dst->width_stride > 0 ? dst->width_stride : dst->width) * 3;
+    if (dst->size > 0 && dst->size < dst_stride * dst->height) {
+        return -1;
+    }
+
+    prepare(src, dst->width, dst->height);
+    int x_pad = (dst->width - resize_width) / 2;
+    int y_pad = (dst->height - resize_height) / 2;
+    if (letter_box) {
+        letter_box->x_pad = x_pad;
+        letter_box->y_pad = y_pad;
+        letter_box->scale = scale;
+    }
+
+    bool packed = src.format == YuvFormat::YUYV;
+    int stride = src.stride > 0 ? src.stride : src.width * (packed ? 2 : 1);
+    const uint8_t* uv_plane = src.uv ? src.uv : src.data + (size_t)stride * src.height;
+    int uv_stride = src.uv_stride > 0 ? src.uv_stride : src.width;
+    int luma_step = packed ? 2 : 1;
+    int v_offset = packed ? 2 : 1;
+    uint8_t bg = (uint8_t)bg_color;
+
+    for (int y = 0; y < dst->height; y++) {
+        uint8_t* out = dst->virt_addr + (size_t)y * dst_stride;
+        if (y < y_pad || y >= y_pad + resize_height) {
+            memset(out, bg, dst->width * 3);
+            continue;
+        }
+        memset(out, bg, x_pad * 3);
+        memset(out + (x_pad + resize_width) * 3, bg, (dst->width - x_pad - resize_width) * 3);
+
+        // Blend the two source rows once, skipping the blend when one row has all the weight
+        int row = y - y_pad;
+        Tap ty = verticalTap(row, scale, src.height, 1);
+        const uint8_t* top = src.data + (size_t)ty.offset * stride;
+        const uint8_t* luma = top;
+        if (ty.weight == 128) {
+            luma = top + stride;
+        } else if (ty.weight > 0) {
+            blend_rows(top, top + stride, ty.weight, blended_luma.data(), (int)blended_luma.size());
+            luma = blended_luma.data();
+        }
+        const uint8_t* chroma = luma;
+        if (!packed) {
+            Tap tc = verticalTap(row, scale, src.height / 2, 2);
+            const uint8_t* uv_top = uv_plane + (size_t)tc.offset * uv_stride;
+            chroma = uv_top;
+            if (tc.weight == 128) {
+                chroma = uv_top + uv_stride;
+            } else if (tc.weight > 0) {
+                blend_rows(uv_top, uv_top + uv_stride, tc.weight, blended_chroma.data(), src.width);
+                chroma = blended_chroma.data();
+            }
+        }
+
+        // Resample only the pixels of the model input
+        for (int x = 0; x < resize_width; x++) {
+            const Tap& l = luma_taps[x];
+            const Tap& c = chroma_taps[x];
+            row_y[x] = lerp_u8(luma[l.offset], luma[l.offset + luma_step], l.weight);
+            row_u[x] = lerp_u8(chroma[c.offset], chroma[c.offset + chroma_step], c.weight);
+            row_v[x] = lerp_u8(chroma[c.offset + v_offset], chroma[c.offset + v_offset + chroma_step], c.weight);
+        }
+        yuv_to_rgb_row(row_y.data(), row_u.data(), row_v.data(), out + x_pad * 3, resize_width);
+    }
+    return 0;
+}
+
+size_t yuv_frame_size(YuvFormat format, int width, int height) {
+    return format == YuvFormat::YUYV ? (size_t)width * height * 2 : (size_t)width * height * 3 / 2;
+}
+
+int parse_yuv_format(const char* name, YuvFormat* format) {
+    if (strcasecmp(name, "yuyv") == 0) {
+        *format = YuvFormat::YUYV;
+    } else if (strcasecmp(name, "nv12") == 0) {
+        *format = YuvFormat::NV12;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int load_yuv_frame(const char* path, YuvFormat format, int width, int height, std::vector<uint8_t>* data,
+                   YuvFrame* frame) {
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+    size_t size = yuv_frame_size(format, width, height);
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return -1;
+    }
+    // A multi-frame capture yields its first frame
+    data->resize(size);
+    size_t got = fread(data->data(), 1, size, fp);
+    fclose(fp);
+    if (got != size) {
+        return -1;
+    }
+
+    *frame = YuvFrame();
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    frame->data = data->data();
+    return 0;
+}
@@ -4,6 +4,12 @@ import cv2
 import numpy as np
 import json
 
+# Native streaming COCO evaluator (python/bsext_postprocess.cpp), optional
+try:
+    import bsext_postprocess
+except ImportError:
+    bsext_postprocess = None
+
 class Letter_Box_Info():
     def __init__(self, shape, new_shape, w_ratio, h_ratio, dw, dh, pad_color) -> None:
         self.origin_shape = shape
@@ -16,6 +22,8 @@ class Letter_Box_Info():
 
 
 def coco_eval_with_json(anno_json, pred_json):
+    if bsext_postprocess is not None:
+        return coco_eval_native(anno_json, pred_json)
     from pycocotools.coco import COCO
     from pycocotools.cocoeval import COCOeval
     anno = COCO(anno_json)
@@ -36,8 +44,82 @@ def coco_eval_with_json(anno_json, pred_json):
     print('map85--> ', eval.stats[-2])
     print('map95--> ', eval.stats[-1])
 
+
+class COCO_stream_evaluator():
+    """Bounding-box mAP/AR computed by the native evaluator while images are
+    processed; same numbers as pycocotools COCOeval without collecting every
+    prediction or writing JSON. Memory holds the ground truth and a few
+    bytes per counted detection."""
+
+    def __init__(self, anno_json) -> None:
+        with open(anno_json) as f:
+            anno = json.load(f)
+        self.category_ids = sorted(c['id'] for c in anno['categories'])
+        self.image_ids = {img['file_name']: img['id'] for img in anno['images']}
+
+        grouped = {img['id']: [] for img in anno['images']}
+        for a in anno['annotations']:
+            grouped[a['image_id']].append(a)
+        del anno
+        # image id -> (boxes xywh, categories, areas, iscrowd)
+        self.ground_truth = {}
+        for image_id, annotations in grouped.items():
+            self.ground_truth[image_id] = (
+                np.array([a['bbox'] for a in annotations], dtype=np.float32).reshape(-1, 4),
+                np.array([a['category_id'] for a in annotations], dtype=np.int32),
+                np.array([a.get('area', a['bbox'][2] * a['bbox'][3]) for a in annotations], dtype=np.float32),
+                np.array([a.get('iscrowd', 0) for a in annotations], dtype=np.int32))
+        self.evaluator = bsext_postprocess.CocoEvaluator(self.category_ids)
+
+    def add_image(self, image_id, boxes, scores, category_ids, in_format='xyxy'):
+        """All detections of one image, in source image pixels, with COCO category ids."""
+        gt = self.ground_truth.pop(image_id, None)
+        if gt is None:
+            return
+        boxes = np.array(boxes, dtype=np.float32).reshape(-1, 4)
+        if in_format == 'xyxy':
+            boxes[:, 2:] -= boxes[:, :2]
+        self.evaluator.evaluate_image(*gt, boxes, np.asarray(scores, dtype=np.float32),
+                                      np.asarray(category_ids, dtype=np.int32))
+
+    def summarize(self, all_images=False):
+        """COCOeval stats; all_images also counts annotated images never
+        added, as pycocotools does for a prediction file covering a subset."""
+        if all_images:
+            empty = np.zeros((0, 4), dtype=np.float32)
+            for image_id in list(self.ground_truth):
+                self.add_image(image_id, empty, [], [], in_format='xywh')
+        stats = self.evaluator.summarize()
+        print(stats)
+        return stats.stats
+
+
+def coco_eval_native(anno_json, pred_json):
+    """coco_eval_with_json() on the native evaluator."""
+    evaluator = COCO_stream_evaluator(anno_json)
+    with open(pred_json) as f:
+        records = json.load(f)
+    by_image = {}
+    for r in records:
+        by_image.setdefault(r['image_id'], []).append(r)
+    for image_id, rs in by_image.items():
+        evaluator.add_image(image_id, [r['bbox'] for r in rs], [r['score'] for r in rs],
+                            [r['category_id'] for r in rs], in_format='xywh')
+    stats = evaluator.summarize(all_images=True)
+
+    print('map  --> ', stats[0])
+    print('map50--> ', stats[1])
+    print('map75--> ', stats[2])
+    print('map85--> ', stats[-2])
+    print('map95--> ', stats[-1])
+    return stats
+
 class COCO_test_helper():
-    def __init__(self, enable_letter_box = False) -> None:
+    def __init__(self, enable_letter_box = False, evaluator = None) -> None:
+        # With a COCO_stream_evaluator, records are scored per image instead of kept in record_list
+        self.evaluator = evaluator
+        self.pending_image_id = None
+        self.pending = []
         self.record_list = []
         self.enable_ltter_box = enable_letter_box
         if self.enable_ltter_box is True:
@@ -155,6 +237,13 @@ class COCO_test_helper():
             rle["counts"] = rle["counts"].decode("utf-8")
             return rle
 
+        if self.evaluator is not None and pred_masks is None:
+            if image_id != self.pending_image_id:
+                self.flush_records()
+                self.pending_image_id = image_id
+            self.pending.append((bbox, score, category_id))
+            return
+
         if pred_masks is None:
             self.record_list.append({"image_id": image_id,
                                     "category_id": category_id,
@@ -170,6 +259,14 @@ class COCO_test_helper():
                                     'segmentation': rles,
                                     })
     
+    def flush_records(self):
+        """Hand the buffered records of the last image to the evaluator."""
+        if self.evaluator is not None and self.pending_image_id is not None:
+            self.evaluator.add_image(self.pending_image_id, [p[0] for p in self.pending],
+                                     [p[1] for p in self.pending], [p[2] for p in self.pending], in_format='xywh')
+        self.pending_image_id = None
+        self.pending = []
+
     def export_to_json(self, path):
         with open(path, 'w') as f:
             json.dump(self.record_list, f)
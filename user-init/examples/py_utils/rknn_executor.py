@@ -12,18 +12,67 @@ API Adaptation:
   (RKNNLite always runs locally on the device's NPU)
 - All other methods (load_rknn, inference, release) are API-compatible
 
+Pipelined inference:
+- When the bsext_rknn extension (python/bsext_rknn.cpp) is importable, the
+  model runs on C++ worker threads with preallocated input buffers instead
+  of RKNNLite. submit() returns a future at once so the next frame can be
+  preprocessed while the NPU works; run() stays synchronous for the
+  model_zoo examples. Inputs must then be uint8 HWC/NHWC arrays.
+- contexts / in_flight (or BSEXT_RKNN_CONTEXTS / BSEXT_RKNN_IN_FLIGHT) set
+  the number of model instances (up to 3 NPU cores on RK3588) and the
+  number of requests queued before submit() blocks.
+- BSEXT_RKNN=0 forces the plain RKNNLite path.
+
 Usage:
 1. Copy this file to player
 2. In model_zoo directory: cp /path/to/rknn_executor_patched.py py_utils/rknn_executor.py
 3. Run model_zoo examples normally - they will use RKNNLite automatically
 """
 
+import os
+
 import numpy as np
 from rknnlite.api import RKNNLite
 
+try:
+    import bsext_rknn
+except ImportError:
+    bsext_rknn = None
+
+# NPU core per context when running several, as RKNNLite.NPU_CORE_0/1/2
+CORE_MASKS = [1, 2, 4]
+
+
+class _DoneFuture():
+    """Future-like result of a synchronous RKNNLite inference."""
+
+    def __init__(self, outputs):
+        self._outputs = outputs
+
+    def done(self):
+        return True
+
+    def wait(self, timeout=None):
+        return True
+
+    def result(self, timeout=None):
+        return self._outputs
+
 
 class RKNN_model_container():
-    def __init__(self, model_path, target=None, device_id=None) -> None:
+    def __init__(self, model_path, target=None, device_id=None, contexts=None, in_flight=None) -> None:
+        self.rknn = None
+        self.runner = None
+        if bsext_rknn is not None and os.environ.get("BSEXT_RKNN", "1") != "0":
+            contexts = int(contexts or os.environ.get("BSEXT_RKNN_CONTEXTS", 1))
+            in_flight = in_flight or os.environ.get("BSEXT_RKNN_IN_FLIGHT")
+            print(f'--> Init pipelined runtime ({contexts} context(s))')
+            self.runner = bsext_rknn.Runner(model_path, contexts=contexts,
+                                            in_flight=int(in_flight) if in_flight else None,
+                                            core_masks=CORE_MASKS[:contexts] if contexts > 1 else [])
+            print('done')
+            return
+
         # Use RKNNLite for on-device inference
         # Note: target and device_id parameters are accepted for compatibility
         # but ignored since RKNNLite always runs locally on the device
@@ -53,28 +102,36 @@ class RKNN_model_container():
     # def __del__(self):
     #     self.release()
 
+    def submit(self, inputs):
+        """Start an inference; returns a future with done() and result()."""
+        if self.runner is not None:
+            # The runner copies HWC or NHWC uint8 data as is, no batch dimension needed
+            return self.runner.submit(inputs)
+        return _DoneFuture(self.run(inputs))
+
     def run(self, inputs):
+        if self.runner is not None:
+            return self.runner.run(inputs)
+
         if self.rknn is None:
             print("ERROR: rknn has been released")
             return []
 
-        if isinstance(inputs, list) or isinstance(inputs, tuple):
-            pass
-        else:
+        if not isinstance(inputs, (list, tuple)):
             inputs = [inputs]
 
         # RKNNLite requires explicit batch dimension (full RKNN auto-adds it)
         # Add batch dimension to 3D inputs: (H,W,C) -> (1,H,W,C)
-        processed_inputs = []
-        for inp in inputs:
-            if isinstance(inp, np.ndarray) and len(inp.shape) == 3:
-                inp = np.expand_dims(inp, axis=0)
-            processed_inputs.append(inp)
+        if any(isinstance(inp, np.ndarray) and inp.ndim == 3 for inp in inputs):
+            inputs = [inp[np.newaxis] if isinstance(inp, np.ndarray) and inp.ndim == 3 else inp
+                      for inp in inputs]
 
-        result = self.rknn.inference(inputs=processed_inputs)
-
-        return result
+        return self.rknn.inference(inputs=inputs)
 
     def release(self):
-        self.rknn.release()
-        self.rknn = None
+        if self.runner is not None:
+            self.runner.shutdown()
+            self.runner = None
+        if self.rknn is not None:
+            self.rknn.release()
+            self.rknn = None
@@ -15,6 +15,12 @@ import cv2
 import numpy as np
 from rknnlite.api import RKNNLite
 
+# C++ decoder (python/bsext_postprocess.cpp) when built, NumPy otherwise
+try:
+    import bsext_postprocess
+except ImportError:
+    bsext_postprocess = None
+
 # YOLOX parameters
 OBJ_THRESH = 0.25
 NMS_THRESH = 0.45
@@ -246,7 +252,12 @@ def main():
     # Post-process results
     print("Post-processing detections...")
     print(f"  Output shapes: {[out.shape for out in outputs]}")
-    boxes, classes, scores = post_process(outputs, orig_shape, IMG_SIZE, ratio, pad)
+    if bsext_postprocess is not None:
+        decoder = bsext_postprocess.Decoder(IMG_SIZE[1], IMG_SIZE[0], OBJ_THRESH, NMS_THRESH)
+        boxes, scores, classes = decoder.process(outputs, scale=ratio, pad=pad)
+        print("  Using the C++ decoder (bsext_postprocess)")
+    else:
+        boxes, classes, scores = post_process(outputs, orig_shape, IMG_SIZE, ratio, pad)
 
     # Print results
     print("=" * 60)